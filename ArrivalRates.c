@@ -0,0 +1,233 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>         // Needed for I/O functions
+#include <math.h>          // Needed for HUGE_VAL
+#include "ArrivalRates.h"  // Arrival rate types and prototypes
+
+//===========================================================================
+//=  This function fills the schedule of a constant arrival rate: no steps  =
+//=  and no bursts.                                                         =
+//===========================================================================
+void defaultSchedule(RATE_SCHEDULE *schedule)
+{
+	schedule->NumberOfSteps = 0;
+	schedule->Period = 0.0;
+	schedule->BurstFactor = BURST_FACTOR;
+	schedule->BurstLength = 0.0;
+	schedule->BurstGap = BURST_GAP;
+}
+
+//===========================================================================
+//=  This function tells whether the arrival rate of the schedule is ever   =
+//=  other than the constant base rate. A single step with a factor other   =
+//=  than 1 also scales the rate, so it counts as well.                     =
+//===========================================================================
+int scheduleVaries(const RATE_SCHEDULE *schedule)
+{
+	int i;  // Step counter
+
+	for (i = 0; i < schedule->NumberOfSteps; i++)
+	{
+		if (schedule->Factors[i] != 1.0)
+		{
+			return(1);
+		}
+	}
+
+	return(schedule->BurstLength > 0.0);
+}
+
+//===========================================================================
+//=  This function sets up the factor of the arrival rate at time 0. The    =
+//=  schedule is a list of steps, each with its start and its factor,       =
+//=  repeated every Period. Without a period the last step lasts forever.   =
+//=  Bursts turn the schedule into a two-state Markov-modulated process:    =
+//=  the gaps between the bursts and the bursts themselves last exponential =
+//=  times with the means BurstGap and BurstLength, and a burst multiplies  =
+//=  the factor of the step by BurstFactor. The arrivals must not stop for  =
+//=  good, so the last step of a schedule without a period has a positive   =
+//=  factor.                                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: rates    - arrival rate to set up                              =
+//=          schedule - steps and bursts                                    =
+//=          stream   - random stream of the bursts                         =
+//=  Returns: 0 on success, -1 if the schedule is not valid                 =
+//===========================================================================
+int arrivalRatesInit(ARRIVAL_RATES *rates, const RATE_SCHEDULE *schedule, RANDOM_STREAM *stream)
+{
+	double positive = 0.0;  // Largest factor of the steps
+	int    last;            // Last step
+	int    i;               // Step counter
+
+	last = schedule->NumberOfSteps - 1;
+	if ((schedule->NumberOfSteps < 0) || (schedule->NumberOfSteps > MAX_RATE_STEPS))
+	{
+		printf("ERROR! The schedule of the arrival rate has at most %d steps\n", MAX_RATE_STEPS);
+		return(-1);
+	}
+	for (i = 0; i <= last; i++)
+	{
+		if ((i == 0) ? (schedule->Times[i] != 0.0) : (schedule->Times[i] <= schedule->Times[i - 1]))
+		{
+			printf("ERROR! The steps of the arrival rate start at 0 and follow each other in time\n");
+			return(-1);
+		}
+		if (schedule->Factors[i] < 0.0)
+		{
+			printf("ERROR! The factors of the arrival rate must not be negative\n");
+			return(-1);
+		}
+		positive = (schedule->Factors[i] > positive) ? schedule->Factors[i] : positive;
+	}
+	if ((last >= 0) && ((schedule->Period < 0.0) ||
+		((schedule->Period > 0.0) && (schedule->Period <= schedule->Times[last]))))
+	{
+		printf("ERROR! The period of the schedule must be longer than the start of its last step\n");
+		return(-1);
+	}
+	if ((last >= 0) && ((positive == 0.0) || ((schedule->Period == 0.0) && (schedule->Factors[last] == 0.0))))
+	{
+		printf("ERROR! The arrivals must not stop for good, so the schedule needs a positive factor at the end\n");
+		return(-1);
+	}
+	if ((schedule->BurstFactor < 0.0) || (schedule->BurstLength < 0.0) ||
+		((schedule->BurstLength > 0.0) && (schedule->BurstGap <= 0.0)))
+	{
+		printf("ERROR! Bursts need a factor of at least 0, and a positive length and gap\n");
+		return(-1);
+	}
+
+	// A schedule without steps is one step of the factor 1
+	rates->Schedule = *schedule;
+	if (schedule->NumberOfSteps == 0)
+	{
+		rates->Schedule.NumberOfSteps = 1;
+		rates->Schedule.Times[0] = 0.0;
+		rates->Schedule.Factors[0] = 1.0;
+	}
+	rates->Step = 0;
+	rates->Burst = 0;
+	rates->PeriodStart = 0.0;
+	if (rates->Schedule.NumberOfSteps > 1)
+	{
+		rates->NextStep = rates->Schedule.Times[1];
+	}
+	else
+	{
+		rates->NextStep = HUGE_VAL;
+	}
+	rates->NextSwitch = (schedule->BurstLength > 0.0) ? randomExponential(stream, schedule->BurstGap) : HUGE_VAL;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function returns the current factor of the arrival rate.          =
+//===========================================================================
+double arrivalRatesFactor(const ARRIVAL_RATES *rates)
+{
+	return(rates->Schedule.Factors[rates->Step] * (rates->Burst ? rates->Schedule.BurstFactor : 1.0));
+}
+
+//===========================================================================
+//=  This function returns the time of the next change of the factor: the   =
+//=  next step of the schedule, or the start or the end of a burst. It is   =
+//=  HUGE_VAL if the factor never changes again.                            =
+//===========================================================================
+double arrivalRatesNextChange(const ARRIVAL_RATES *rates)
+{
+	return((rates->NextStep < rates->NextSwitch) ? rates->NextStep : rates->NextSwitch);
+}
+
+//===========================================================================
+//=  This function makes every change of the factor up to the given time.   =
+//=  The bursts are drawn when they start and end, so the time must not go  =
+//=  back from call to call.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: rates  - arrival rate                                          =
+//=          time   - new time of the rate                                  =
+//=          stream - random stream of the bursts                           =
+//=  Returns: None                                                          =
+//===========================================================================
+void arrivalRatesAdvance(ARRIVAL_RATES *rates, double time, RANDOM_STREAM *stream)
+{
+	RATE_SCHEDULE *schedule = &rates->Schedule;  // Steps and bursts
+
+	while (rates->NextStep <= time)
+	{
+		rates->Step++;
+		if (rates->Step == schedule->NumberOfSteps)
+		{
+			rates->Step = 0;
+			rates->PeriodStart += schedule->Period;
+		}
+		if (rates->Step + 1 < schedule->NumberOfSteps)
+		{
+			rates->NextStep = rates->PeriodStart + schedule->Times[rates->Step + 1];
+		}
+		else
+		{
+			rates->NextStep = (schedule->Period > 0.0) ? rates->PeriodStart + schedule->Period : HUGE_VAL;
+		}
+	}
+
+	while (rates->NextSwitch <= time)
+	{
+		rates->Burst = !rates->Burst;
+		rates->NextSwitch += randomExponential(stream, rates->Burst ? schedule->BurstLength : schedule->BurstGap);
+	}
+}
+
+//===========================================================================
+//=  This function returns the time of the next arrival of a process whose  =
+//=  rate is the base rate times the factor, by the inversion of the        =
+//=  integrated rate. The work is the interarrival time drawn at the base   =
+//=  rate, and it is used up at the speed of the factor, so a step which    =
+//=  doubles the factor halves the rest of the interarrival time. With a    =
+//=  constant factor 1 the arrival comes after the work exactly. The rates  =
+//=  move on to the arrival.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: rates  - arrival rate at the clock                             =
+//=          clock  - time of the previous arrival                          =
+//=          work   - interarrival time at the factor 1                     =
+//=          stream - random stream of the bursts                           =
+//=  Returns: time of the next arrival, HUGE_VAL if the rate stays 0        =
+//===========================================================================
+double arrivalRatesNextArrival(ARRIVAL_RATES *rates, double clock, double work, RANDOM_STREAM *stream)
+{
+	double factor;  // Factor until the next change
+	double change;  // Time of the next change
+
+	while (1)
+	{
+		factor = arrivalRatesFactor(rates);
+		change = arrivalRatesNextChange(rates);
+		if ((factor > 0.0) && (work / factor <= change - clock))
+		{
+			return(clock + work / factor);
+		}
+		if (change == HUGE_VAL)
+		{
+			return(HUGE_VAL);
+		}
+		work -= factor * (change - clock);
+		clock = change;
+		arrivalRatesAdvance(rates, clock, stream);
+	}
+}
+
+//===========================================================================
+//=  This function returns the current phase of the rates: the step of the  =
+//=  schedule, and NumberOfSteps more during a burst.                       =
+//===========================================================================
+int arrivalRatesPhase(const ARRIVAL_RATES *rates)
+{
+	return(rates->Step + (rates->Burst ? rates->Schedule.NumberOfSteps : 0));
+}
+
+//===========================================================================
+//=  This function returns the number of phases of the rates.               =
+//===========================================================================
+int arrivalRatesPhaseCount(const ARRIVAL_RATES *rates)
+{
+	return(rates->Schedule.NumberOfSteps * ((rates->Schedule.BurstLength > 0.0) ? 2 : 1));
+}
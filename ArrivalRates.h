@@ -0,0 +1,45 @@
+#ifndef ARRIVAL_RATES_H
+#define ARRIVAL_RATES_H
+
+//----- Includes --------------------------------------------------------------
+#include "RandomStreams.h"  // Random number streams
+
+//----- Constants -------------------------------------------------------------
+#define MAX_RATE_STEPS 64     // Longest schedule of the arrival rate
+#define BURST_FACTOR   3.0    // Default factor of the arrival rate during a burst
+#define BURST_GAP      100.0  // Default mean time from the end of a burst to the next one
+
+//------New types--------------------------------------------------------------
+typedef struct  // Arrival rate over time as factors of the base rate: a schedule of steps and bursts on top
+{
+	double Times[MAX_RATE_STEPS];    // Start of each step within the period, the first at 0
+	double Factors[MAX_RATE_STEPS];  // Factor of the arrival rate in each step
+	int    NumberOfSteps;            // Number of steps. 0 means the factor 1 at all times
+	double Period;                   // Period of the schedule, 0 if the last step lasts forever
+	double BurstFactor;              // Factor of the arrival rate during a burst
+	double BurstLength;              // Mean duration of a burst, 0 without bursts
+	double BurstGap;                 // Mean time from the end of a burst to the next one
+} RATE_SCHEDULE;
+
+typedef struct  // Current factor of the arrival rate, a Markov-modulated process of the schedule
+{
+	RATE_SCHEDULE Schedule;     // Steps and bursts, with at least one step
+	int           Step;         // Current step of the schedule
+	int           Burst;        // Whether a burst is going on
+	double        PeriodStart;  // Start of the current period
+	double        NextStep;     // Start of the next step, HUGE_VAL if the step lasts forever
+	double        NextSwitch;   // Start or end of the next burst, HUGE_VAL without bursts
+} ARRIVAL_RATES;
+
+//----- Prototypes ------------------------------------------------------------
+void   defaultSchedule(RATE_SCHEDULE *schedule);
+int    arrivalRatesInit(ARRIVAL_RATES *rates, const RATE_SCHEDULE *schedule, RANDOM_STREAM *stream);
+double arrivalRatesFactor(const ARRIVAL_RATES *rates);
+double arrivalRatesNextChange(const ARRIVAL_RATES *rates);
+void   arrivalRatesAdvance(ARRIVAL_RATES *rates, double time, RANDOM_STREAM *stream);
+double arrivalRatesNextArrival(ARRIVAL_RATES *rates, double clock, double work, RANDOM_STREAM *stream);
+int    arrivalRatesPhase(const ARRIVAL_RATES *rates);
+int    arrivalRatesPhaseCount(const ARRIVAL_RATES *rates);
+int    scheduleVaries(const RATE_SCHEDULE *schedule);
+
+#endif
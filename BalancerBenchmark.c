@@ -0,0 +1,471 @@
+//----- Includes --------------------------------------------------------------
+#include <stdatomic.h>           // Needed for the barrier of the threads
+#include <math.h>                // Needed for ceil()
+#include <stdio.h>               // Needed for I/O functions
+#include <stdlib.h>              // Needed for calloc(), free() and strtol()
+#include <string.h>              // Needed for strcmp()
+#include <time.h>                // Needed for clock_gettime()
+#include <unistd.h>              // Needed for sysconf()
+#include <sched.h>               // Needed for sched_yield()
+#include <pthread.h>             // Needed for the worker threads
+#include "ConcurrentBalancer.h"  // Balancers shared by the threads
+#include "Histogram.h"           // Percentiles of the decision latency
+
+//----- Constants -------------------------------------------------------------
+#define MAX_LIST_VALUES   64       // Largest number of values of a list option
+#define DEFAULT_DECISIONS 1000000  // Default decisions of each thread in each phase
+#define DEFAULT_LOAD      1.0      // Default customers in flight per server, over all threads
+#define DEFAULT_D         2        // Default servers sampled by Power-of-d
+#define TIMER_SAMPLES     100000   // Clock reads used to measure the timer overhead
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the benchmark
+{
+	enum CONCURRENT_POLICY Policies[NUMBER_OF_CONCURRENT_POLICIES];  // Load balancers
+	int                    NumberOfPolicies;                         // Number of load balancers
+	int                    ThreadCounts[MAX_LIST_VALUES];            // Numbers of threads
+	int                    NumberOfThreadCounts;                     // Number of numbers of threads
+	int                    ServerCounts[MAX_LIST_VALUES];            // Numbers of servers
+	int                    NumberOfServerCounts;                     // Number of numbers of servers
+	long long              Decisions;                                // Decisions of each thread in each phase
+	int                    Window;                                   // Customers in flight per thread, 0 for Load
+	double                 Load;                                     // Customers in flight per server, over all threads
+	int                    SampleSize;                               // Servers sampled by Power-of-d
+} BENCHMARK_CONFIG;
+
+typedef struct  // State shared by the threads of one measurement
+{
+	const BENCHMARK_CONFIG *Config;           // Parameters of the benchmark
+	CONCURRENT_BALANCER    *Balancer;         // Balancer under test
+	int                     NumberOfThreads;  // Number of threads
+	int                     Window;           // Customers each thread keeps in flight
+	atomic_int              Arrived;          // Threads which have reached the barrier, over both phases
+} BENCHMARK_RUN;
+
+typedef struct  // State of one thread
+{
+	BENCHMARK_RUN *Run;          // Shared state
+	pthread_t      Thread;       // Thread of the worker
+	RANDOM_STREAM  Random;       // Random stream of the thread
+	HISTOGRAM      Latency;      // Latency of each timed decision in ns
+	int           *InFlight;     // Ring of the servers of the customers in flight
+	double         ElapsedTime;  // Wall time of the untimed phase in ns
+	int            Broken;       // Whether the thread could not allocate its memory
+} BENCHMARK_THREAD;
+
+//----- Prototypes ------------------------------------------------------------
+int  parseArguments(int argc, char *argv[], BENCHMARK_CONFIG *config);
+int  parseList(const char *list, int *values, int maxValues, int minValue, int maxValue);
+int  runMeasurement(const BENCHMARK_CONFIG *config, enum CONCURRENT_POLICY policy, int numberOfServers,
+	int numberOfThreads);
+
+//===========================================================================
+//=  This function returns the monotonic clock in nanoseconds.              =
+//===========================================================================
+static double clockNanoseconds(void)
+{
+	struct timespec now;  // Current time
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return(now.tv_sec * 1e9 + now.tv_nsec);
+}
+
+//===========================================================================
+//=  Main program of the benchmark. It runs every load balancer of the      =
+//=  library with every number of servers and threads and prints the        =
+//=  decisions per second and the decision latency percentiles.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int main(int argc, char *argv[])
+{
+	BENCHMARK_CONFIG config;  // Parameters of the benchmark
+	double           start;   // Clock before the timer measurement
+	double           timer;   // Cost of one clock read in ns
+	int              p;       // Policy counter
+	int              s;       // Server count counter
+	int              t;       // Thread count counter
+	int              i;       // Clock read counter
+
+	if (parseArguments(argc, argv, &config) != 0)
+	{
+		printf("Usage: BalancerBenchmark [--policy LIST] [--threads LIST] [--servers LIST] [--decisions N]\n");
+		printf("       [--load X] [--window N] [--d N]   LIST is comma separated, e.g. --threads 1,2,4,8\n");
+		return(1);
+	}
+
+	// Every timed decision pays for one clock read
+	start = clockNanoseconds();
+	for (i = 0; i < TIMER_SAMPLES; i++)
+	{
+		clockNanoseconds();
+	}
+	timer = (clockNanoseconds() - start) / TIMER_SAMPLES;
+	if (config.Window > 0)
+	{
+		printf("Decisions per thread: %lld, customers in flight per thread: %d, clock read: %.1f ns (in the "
+			"latencies)\n\n", config.Decisions, config.Window, timer);
+	}
+	else
+	{
+		printf("Decisions per thread: %lld, customers in flight per server: %g, clock read: %.1f ns (in the "
+			"latencies)\n\n", config.Decisions, config.Load, timer);
+	}
+
+	printf("policy               threads  servers   window    decisions/s     p50 ns    p99 ns    p99.9 ns\n");
+	for (p = 0; p < config.NumberOfPolicies; p++)
+	{
+		for (s = 0; s < config.NumberOfServerCounts; s++)
+		{
+			for (t = 0; t < config.NumberOfThreadCounts; t++)
+			{
+				if (runMeasurement(&config, config.Policies[p], config.ServerCounts[s], config.ThreadCounts[t]) != 0)
+				{
+					return(1);
+				}
+			}
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a comma separated list of integers.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list      - list from the command line                         =
+//=          values    - place to store the values                          =
+//=          maxValues - capacity of values                                 =
+//=          minValue  - smallest allowed value                             =
+//=          maxValue  - largest allowed value                              =
+//=  Returns: number of values, -1 on error                                 =
+//===========================================================================
+int parseList(const char *list, int *values, int maxValues, int minValue, int maxValue)
+{
+	const char *position = list;  // Start of the current value
+	char       *end;              // End of the current value
+	long        value;            // Current value
+	int         count = 0;        // Number of values
+
+	while (1)
+	{
+		value = strtol(position, &end, 10);
+		if ((end == position) || (value < minValue) || (value > maxValue) || (count == maxValues))
+		{
+			printf("ERROR! Bad list %s, values must be from %d to %d\n", list, minValue, maxValue);
+			return(-1);
+		}
+		values[count++] = (int) value;
+		if (*end == '\0')
+		{
+			return(count);
+		}
+		if (*end != ',')
+		{
+			printf("ERROR! Bad list %s\n", list);
+			return(-1);
+		}
+		position = end + 1;
+	}
+}
+
+//===========================================================================
+//=  This function reads the command line. Options:                         =
+//=    --policy LIST   load balancers from 1 to 5: Random, Round Robin,     =
+//=                    Shortest Queue, Power-of-d, Join-Idle-Queue          =
+//=    --threads LIST  numbers of threads (1, 2, 4 ... up to the cores)     =
+//=    --servers LIST  numbers of servers (16, 256 and 4096)                =
+//=    --decisions N   decisions of each thread in each phase               =
+//=    --load X        customers in flight per server over all threads, 1.0 =
+//=                    by default, so every server is about busy and the    =
+//=                    Shortest Queue scan has to look for the idle one     =
+//=    --window N      customers each thread keeps in flight instead of     =
+//=                    --load                                               =
+//=    --d N           servers sampled by Power-of-d                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=          config     - place to store the parameters                     =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseArguments(int argc, char *argv[], BENCHMARK_CONFIG *config)
+{
+	int  policies[MAX_LIST_VALUES];  // Load balancer numbers given by the user
+	long cores;                      // Number of online cores
+	int  i;                          // Argument counter
+	int  j;                          // Policy counter
+
+	config->NumberOfPolicies = NUMBER_OF_CONCURRENT_POLICIES;
+	for (i = 0; i < NUMBER_OF_CONCURRENT_POLICIES; i++)
+	{
+		config->Policies[i] = (enum CONCURRENT_POLICY) i;
+	}
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	config->NumberOfThreadCounts = 0;
+	for (i = 1; (i < cores) && (config->NumberOfThreadCounts < MAX_LIST_VALUES - 1); i *= 2)
+	{
+		config->ThreadCounts[config->NumberOfThreadCounts++] = i;
+	}
+	config->ThreadCounts[config->NumberOfThreadCounts++] = (cores > 1) ? (int) cores : 1;
+	config->ServerCounts[0] = 16;
+	config->ServerCounts[1] = 256;
+	config->ServerCounts[2] = 4096;
+	config->NumberOfServerCounts = 3;
+	config->Decisions = DEFAULT_DECISIONS;
+	config->Window = 0;
+	config->Load = DEFAULT_LOAD;
+	config->SampleSize = DEFAULT_D;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--policy") == 0)
+		{
+			config->NumberOfPolicies = parseList(argv[i + 1], policies, NUMBER_OF_CONCURRENT_POLICIES, 1,
+				NUMBER_OF_CONCURRENT_POLICIES);
+			if (config->NumberOfPolicies < 0)
+			{
+				return(-1);
+			}
+			for (j = 0; j < config->NumberOfPolicies; j++)
+			{
+				config->Policies[j] = (enum CONCURRENT_POLICY) (policies[j] - 1);
+			}
+		}
+		else if (strcmp(argv[i], "--threads") == 0)
+		{
+			config->NumberOfThreadCounts = parseList(argv[i + 1], config->ThreadCounts, MAX_LIST_VALUES, 1, 4096);
+			if (config->NumberOfThreadCounts < 0)
+			{
+				return(-1);
+			}
+		}
+		else if (strcmp(argv[i], "--servers") == 0)
+		{
+			config->NumberOfServerCounts = parseList(argv[i + 1], config->ServerCounts, MAX_LIST_VALUES, 1,
+				1 << 24);
+			if (config->NumberOfServerCounts < 0)
+			{
+				return(-1);
+			}
+		}
+		else if (strcmp(argv[i], "--decisions") == 0)
+		{
+			config->Decisions = atoll(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--load") == 0)
+		{
+			config->Load = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--window") == 0)
+		{
+			config->Window = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--d") == 0)
+		{
+			config->SampleSize = atoi(argv[i + 1]);
+		}
+		else
+		{
+			printf("ERROR! Unknown option %s\n", argv[i]);
+			return(-1);
+		}
+	}
+
+	if (i < argc)
+	{
+		printf("ERROR! Option %s needs a value\n", argv[i]);
+		return(-1);
+	}
+	if ((config->Decisions < 1) || (config->Window < 0) || (config->Load <= 0.0) || (config->SampleSize < 1))
+	{
+		printf("ERROR! Decisions, load, window and d must be positive\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function waits until all threads have reached the barrier. The    =
+//=  counter is not reset, so the n-th barrier waits for n * threads.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: run    - shared state                                          =
+//=          target - value of Arrived when all threads are there           =
+//=  Returns: None                                                          =
+//===========================================================================
+static void waitForThreads(BENCHMARK_RUN *run, int target)
+{
+	atomic_fetch_add(&run->Arrived, 1);
+	while (atomic_load(&run->Arrived) < target)
+	{
+		sched_yield();
+	}
+}
+
+//===========================================================================
+//=  Worker thread. Every decision sends a customer to the chosen server    =
+//=  and completes the customer sent Window decisions ago, so the servers   =
+//=  keep a load. The first phase measures the throughput without clock     =
+//=  reads. The second phase times every decision.                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argument - state of the thread                                 =
+//=  Returns: NULL                                                          =
+//===========================================================================
+static void *benchmarkWorker(void *argument)
+{
+	BENCHMARK_THREAD *thread = (BENCHMARK_THREAD *) argument;   // State of the thread
+	BENCHMARK_RUN    *run = thread->Run;                        // Shared state
+	long long         decisions = run->Config->Decisions;       // Decisions in each phase
+	int               window = run->Window;                     // Customers in flight
+	double            start;                                    // Clock at the start of the phase or decision
+	long long         k;                                        // Decision counter
+	int               slot;                                     // Position of the decision in InFlight
+	int               phase;                                    // Phase counter
+
+	for (phase = 0; phase < 2; phase++)
+	{
+		waitForThreads(run, (phase + 1) * run->NumberOfThreads);
+		start = clockNanoseconds();
+		for (k = 0, slot = 0; k < decisions; k++)
+		{
+			if (k >= window)
+			{
+				concurrentBalancerComplete(run->Balancer, thread->InFlight[slot]);
+			}
+			if (phase == 0)
+			{
+				thread->InFlight[slot] = concurrentBalancerChoose(run->Balancer, &thread->Random);
+			}
+			else
+			{
+				start = clockNanoseconds();
+				thread->InFlight[slot] = concurrentBalancerChoose(run->Balancer, &thread->Random);
+				histogramRecord(&thread->Latency, clockNanoseconds() - start);
+			}
+			slot = (slot + 1 == window) ? 0 : slot + 1;
+		}
+		if (phase == 0)
+		{
+			thread->ElapsedTime = clockNanoseconds() - start;
+		}
+
+		// Complete the customers still in flight
+		for (k = 0; k < ((decisions < window) ? decisions : window); k++)
+		{
+			concurrentBalancerComplete(run->Balancer, thread->InFlight[k]);
+		}
+	}
+
+	return(NULL);
+}
+
+//===========================================================================
+//=  This function runs one load balancer with the given numbers of servers =
+//=  and threads and prints a row: decisions per second of all threads      =
+//=  together and the percentiles of the latency of a decision.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config          - parameters of the benchmark                  =
+//=          policy          - load balancer                                =
+//=          numberOfServers - number of servers                            =
+//=          numberOfThreads - number of threads                            =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runMeasurement(const BENCHMARK_CONFIG *config, enum CONCURRENT_POLICY policy, int numberOfServers,
+	int numberOfThreads)
+{
+	BENCHMARK_RUN     run;                // State shared by the threads
+	BENCHMARK_THREAD *threads;            // State of each thread
+	HISTOGRAM         latency;            // Latency of the decisions of all threads
+	RANDOM_STREAM     random;             // Stream which is jumped for every thread
+	double            elapsedTime = 0.0;  // Longest untimed phase of the threads
+	int               started = 0;        // Number of started threads
+	int               result = 0;         // Result of the measurement
+	int               i;                  // Thread counter
+
+	run.Config = config;
+	run.NumberOfThreads = numberOfThreads;
+	run.Window = config->Window;
+	if (run.Window == 0)
+	{
+		run.Window = (int) ceil(config->Load * numberOfServers / numberOfThreads);
+	}
+	atomic_init(&run.Arrived, 0);
+	run.Balancer = concurrentBalancerCreate(policy, numberOfServers, config->SampleSize);
+	threads = (BENCHMARK_THREAD *) calloc(numberOfThreads, sizeof(BENCHMARK_THREAD));
+	if ((run.Balancer == NULL) || (threads == NULL) || (histogramInit(&latency, 1.0, HISTOGRAM_PRECISION) != 0))
+	{
+		printf("Not enough memory for %d threads and %d servers\n", numberOfThreads, numberOfServers);
+		concurrentBalancerFree(run.Balancer);
+		free(threads);
+		return(-1);
+	}
+
+	// Every thread has its own stream, its own histogram and its own ring
+	randomStreamInit(&random, 1);
+	for (i = 0; i < numberOfThreads; i++)
+	{
+		threads[i].Run = &run;
+		threads[i].Random = random;
+		randomStreamJump(&random);
+		threads[i].InFlight = (int *) calloc(run.Window, sizeof(int));
+		threads[i].Broken = (threads[i].InFlight == NULL) ||
+			(histogramInit(&threads[i].Latency, 1.0, HISTOGRAM_PRECISION) != 0);
+		result |= threads[i].Broken ? -1 : 0;
+	}
+	if (result != 0)
+	{
+		printf("Not enough memory for %d threads\n", numberOfThreads);
+	}
+	for (i = 0; (i < numberOfThreads) && (result == 0); i++)
+	{
+		if (pthread_create(&threads[i].Thread, NULL, benchmarkWorker, &threads[i]) != 0)
+		{
+			printf("ERROR! Cannot start thread %d\n", i + 1);
+			result = -1;
+			break;
+		}
+		started++;
+	}
+	if (result != 0)
+	{
+		// The started threads wait at the first barrier until the others are counted as arrived
+		atomic_fetch_add(&run.Arrived, 2 * (numberOfThreads - started));
+	}
+	for (i = 0; i < started; i++)
+	{
+		pthread_join(threads[i].Thread, NULL);
+	}
+
+	if (result == 0)
+	{
+		for (i = 0; i < numberOfThreads; i++)
+		{
+			histogramAdd(&latency, &threads[i].Latency);
+			if (threads[i].ElapsedTime > elapsedTime)
+			{
+				elapsedTime = threads[i].ElapsedTime;
+			}
+		}
+		printf("%-20s %-8d %-9d %-9d %-15.0f %-10.1f %-9.1f %.1f\n", concurrentPolicyName(policy), numberOfThreads,
+			numberOfServers, run.Window,
+			(elapsedTime > 0.0) ? config->Decisions * numberOfThreads / (elapsedTime * 1e-9) : 0.0,
+			histogramPercentile(&latency, 0.5), histogramPercentile(&latency, 0.99),
+			histogramPercentile(&latency, 0.999));
+		fflush(stdout);
+	}
+
+	for (i = 0; i < numberOfThreads; i++)
+	{
+		if (threads[i].Latency.Counts != NULL)
+		{
+			histogramFree(&threads[i].Latency);
+		}
+		free(threads[i].InFlight);
+	}
+	histogramFree(&latency);
+	free(threads);
+	concurrentBalancerFree(run.Balancer);
+
+	return(result);
+}
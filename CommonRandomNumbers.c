@@ -0,0 +1,269 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>                 // Needed for I/O functions
+#include <stdlib.h>                // Needed for malloc() and free()
+#include <math.h>                  // Needed for fabs(), sqrt() and HUGE_VAL
+#include "CommonRandomNumbers.h"  // Common random numbers mode types and prototypes
+
+//----- Constants -------------------------------------------------------------
+#define WORKLOAD_SEED 0x5DEECE66DULL  // Is mixed into the seed, so the workload stream differs from the balancer streams
+
+//===========================================================================
+//=  This function runs one replication in lockstep. The arrival times and  =
+//=  service times are generated once and every customer is given to all    =
+//=  compared load balancers. Each load balancer has its own servers,       =
+//=  queues and tie-breaking stream, so only the workload is common. The    =
+//=  arrival rate follows a copy of the rates of the first load balancer,   =
+//=  whose bursts are the same in every state.                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: context      - parameters of the mode (CRN_CONFIG)             =
+//=          replication  - index of the replication                        =
+//=          values       - place to store response time statistic of each  =
+//=                         load balancer                                   =
+//=          eventCounter - place to store the number of processed events   =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+static int lockstepReplication(const void *context, int replication, double *values, long long *eventCounter)
+{
+	const CRN_CONFIG *config = (const CRN_CONFIG *) context;  // Parameters of the mode
+	SIMULATION_CONFIG simulationConfig;                       // Parameters of every load balancer
+	SIMULATION_STATE  states[NUMBER_OF_POLICIES];             // State of each load balancer
+	RANDOM_STREAM     workload;                               // Stream of arrival and service times
+	RANDOM_STREAM     load;                                   // Stream of the bursts of the arrival rate
+	ARRIVAL_RATES     rates;                                  // Arrival rate of the workload
+	double           *serviceTimes;                           // Service times of the current batch
+	double            arrivalClock = 0.0;                     // Arrival time of the current batch
+	long long         customers = 0;                          // Number of generated customers
+	int               initialized = 0;                        // Number of initialized states
+	int               result = 0;                             // Result of the replication
+	int               batchSize;                              // Number of customers in a batch
+	int               p;                                      // Load balancer counter
+	int               i;                                      // Loop counter
+
+	*eventCounter = 0;
+	simulationConfig = config->Replication.Simulation;
+	simulationConfig.Stream = replication;
+	simulationConfig.ExternalArrivals = 1;
+	batchSize = simulationConfig.BatchSize;
+
+	serviceTimes = (double *) malloc(sizeof(double) * batchSize);
+	if (serviceTimes == NULL)
+	{
+		return(-1);
+	}
+	for (p = 0; p < config->NumberOfPolicies; p++)
+	{
+		simulationConfig.LoadBalancer = config->Policies[p];
+		if (simulationInit(&states[p], &simulationConfig) != 0)
+		{
+			result = -1;
+			break;
+		}
+		initialized++;
+	}
+
+	if (result == 0)
+	{
+		rates = states[0].Rates;
+		load = states[0].Random[loadStream];
+	}
+
+	randomStreamInit(&workload, simulationConfig.Seed ^ WORKLOAD_SEED);
+	for (i = 0; i < replication; i++)
+	{
+		randomStreamJump(&workload);
+	}
+
+	// Generate the workload once and feed every load balancer with it
+	while ((result == 0) && (customers < simulationConfig.RunLength))
+	{
+		arrivalClock = arrivalRatesNextArrival(&rates, arrivalClock,
+			randomExponential(&workload, batchSize / simulationConfig.Lambda), &load);
+		if (arrivalClock == HUGE_VAL)
+		{
+			break;
+		}
+		serviceFill(&states[0].Service, &workload, serviceTimes, batchSize);
+		customers += batchSize;
+
+		for (p = 0; p < config->NumberOfPolicies; p++)
+		{
+			if ((advanceSimulation(&states[p], arrivalClock) != 0) ||
+				(dispatchCustomers(&states[p], serviceTimes, NULL, batchSize) != 0))
+			{
+				result = -1;
+				break;
+			}
+			states[p].EventCounter++;
+		}
+	}
+
+	for (p = 0; p < initialized; p++)
+	{
+		finishSimulation(&states[p]);
+		values[p] = responseTimeStatistic(&states[p]);
+		*eventCounter += states[p].EventCounter;
+		simulationFree(&states[p]);
+	}
+	free(serviceTimes);
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function calculates the confidence interval of the mean response  =
+//=  time of the load balancer or, if paired is set, of the paired          =
+//=  difference between the load balancer and the baseline (the first load  =
+//=  balancer).                                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config       - parameters of the mode                          =
+//=          values       - results of the replications                     =
+//=          replications - number of replications                          =
+//=          policy       - index of the load balancer in Policies          =
+//=          paired       - whether the baseline is subtracted              =
+//=          mean         - place to store the mean                         =
+//=          variance     - place to store the variance                     =
+//=  Returns: half-width of the interval, negative if it is not defined     =
+//===========================================================================
+static double pairedDifference(const CRN_CONFIG *config, const double *values, int replications, int policy,
+	int paired, double *mean, double *variance)
+{
+	int    stride = config->NumberOfPolicies;  // Number of values of one replication
+	double difference;                         // Difference of the current replication
+	int    r;                                  // Replication counter
+
+	*mean = 0.0;
+	*variance = 0.0;
+	for (r = 0; r < replications; r++)
+	{
+		*mean += values[r * stride + policy] - (paired ? values[r * stride] : 0.0);
+	}
+	*mean /= (replications > 0) ? replications : 1;
+	if (replications < 2)
+	{
+		return(-1.0);
+	}
+
+	for (r = 0; r < replications; r++)
+	{
+		difference = values[r * stride + policy] - (paired ? values[r * stride] : 0.0);
+		*variance += (difference - *mean) * (difference - *mean);
+	}
+	*variance /= replications - 1;
+
+	return(studentTQuantile(0.5 + config->Replication.Simulation.CiLevel / 2.0, replications - 1) *
+		sqrt(*variance / replications));
+}
+
+//===========================================================================
+//=  This function checks whether every paired difference is resolved: its  =
+//=  confidence interval either does not contain zero or is narrower than   =
+//=  ACCURACY times the mean response time of the baseline.                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: context      - parameters of the mode (CRN_CONFIG)             =
+//=          values       - results of the replications                     =
+//=          replications - number of replications                          =
+//=  Returns: 1 if the replications may stop, 0 otherwise                   =
+//===========================================================================
+static int differencesResolved(const void *context, const double *values, int replications)
+{
+	const CRN_CONFIG *config = (const CRN_CONFIG *) context;  // Parameters of the mode
+	double            baselineMean;                           // Mean response time of the baseline
+	double            mean;                                   // Mean difference
+	double            variance;                               // Variance of the difference
+	double            halfWidth;                              // Half-width of the interval
+	int               p;                                      // Load balancer counter
+
+	if (pairedDifference(config, values, replications, 0, 0, &baselineMean, &variance) < 0.0)
+	{
+		return(0);
+	}
+	for (p = 1; p < config->NumberOfPolicies; p++)
+	{
+		halfWidth = pairedDifference(config, values, replications, p, 1, &mean, &variance);
+		if ((fabs(mean) <= halfWidth) && (halfWidth > config->Replication.Simulation.Accuracy * baselineMean))
+		{
+			return(0);
+		}
+	}
+
+	return(1);
+}
+
+//===========================================================================
+//=  This function evaluates all chosen load balancers in a single pass     =
+//=  over common arrival and service times. Replications run in parallel    =
+//=  until every paired difference with the baseline is resolved.           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the mode                                =
+//=          result - place to store the results of the replications        =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runCommonRandomNumbers(const CRN_CONFIG *config, REPLICATION_RESULT *result)
+{
+	REPLICATION_EXPERIMENT experiment;  // Lockstep replication of all load balancers
+
+	experiment.Run = lockstepReplication;
+	experiment.Test = differencesResolved;
+	experiment.Context = config;
+	experiment.NumberOfValues = config->NumberOfPolicies;
+
+	return(runExperiment(&config->Replication, &experiment, result));
+}
+
+//===========================================================================
+//=  This function prints the mean response time of every load balancer and =
+//=  its paired difference with the baseline. Variance reduction is the     =
+//=  ratio of the variance of the difference of independent runs to the     =
+//=  variance of the paired difference, i.e. how many times fewer           =
+//=  replications the common random numbers need for the same interval.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the mode                                =
+//=          result - results of the replications                           =
+//=  Returns: None                                                          =
+//===========================================================================
+void printCommonRandomNumbersReport(const CRN_CONFIG *config, const REPLICATION_RESULT *result)
+{
+	double mean;              // Mean response time or mean difference
+	double variance;          // Variance of the mean response time or of the difference
+	double baselineVariance;  // Variance of the baseline mean response time
+	double halfWidth;         // Half-width of the interval
+	double ownVariance;       // Variance of the mean response time of the load balancer
+	int    p;                 // Load balancer counter
+
+	printf("Common random numbers: %d load balancers, baseline %s\n", config->NumberOfPolicies,
+		balancerName(config->Policies[0]));
+	printf("Threads: %d\n", config->Replication.NumberOfThreads);
+	printf("Customers per replication: %lld\n", config->Replication.Simulation.RunLength);
+	printf("Replications pooled: %d (started %d), %s\n", result->Replications, result->Started,
+		result->Converged ? "all differences resolved" : "not converged");
+	printf("Compared statistic: ");
+	printStatisticName(&config->Replication.Simulation);
+	printf("\n\n");
+
+	printf("load balancer                    response time             difference with baseline      var. red.\n");
+	pairedDifference(config, result->Values, result->Replications, 0, 0, &mean, &baselineVariance);
+	for (p = 0; p < config->NumberOfPolicies; p++)
+	{
+		halfWidth = pairedDifference(config, result->Values, result->Replications, p, 0, &mean, &ownVariance);
+		printf("%-32s %10.6f +/- %-10.6f", balancerName(config->Policies[p]), mean, halfWidth);
+
+		if (p > 0)
+		{
+			halfWidth = pairedDifference(config, result->Values, result->Replications, p, 1, &mean, &variance);
+			printf("  %+10.6f +/- %-10.6f %s", mean, halfWidth, (fabs(mean) > halfWidth) ? "*" : " ");
+			if (variance > 0.0)
+			{
+				printf("  %9.1f", (ownVariance + baselineVariance) / variance);
+			}
+		}
+		printf("\n");
+	}
+	printf("(* - the difference is significant at %.0f%% level)\n\n", config->Replication.Simulation.CiLevel * 100.0);
+
+	printf("Events processed: %lld\n", result->EventCounter);
+	printf("Wall time: %.3f s\n", result->WallTime);
+	if (result->WallTime > 0.0)
+	{
+		printf("Events per second: %.0f\n", result->EventCounter / result->WallTime);
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef COMMON_RANDOM_NUMBERS_H
+#define COMMON_RANDOM_NUMBERS_H
+
+//----- Includes --------------------------------------------------------------
+#include "Replications.h"  // Parallel independent replications
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the common random numbers mode
+{
+	REPLICATION_CONFIG Replication;                   // Parameters of the replications. LoadBalancer is ignored
+	int                NumberOfPolicies;              // Number of compared load balancers
+	enum BALANCER_TYPE Policies[NUMBER_OF_POLICIES];  // Compared load balancers. The first one is the baseline
+} CRN_CONFIG;
+
+//----- Prototypes ------------------------------------------------------------
+int  runCommonRandomNumbers(const CRN_CONFIG *config, REPLICATION_RESULT *result);
+void printCommonRandomNumbersReport(const CRN_CONFIG *config, const REPLICATION_RESULT *result);
+
+#endif
@@ -0,0 +1,308 @@
+//----- Includes --------------------------------------------------------------
+#include <stdatomic.h>           // Needed for the atomic counters
+#include <stdlib.h>              // Needed for aligned_alloc() and free()
+#include <string.h>              // Needed for memset()
+#include "ConcurrentBalancer.h"  // Concurrent balancer types and prototypes
+
+//----- Constants -------------------------------------------------------------
+#define IDLE_WORD_BITS 64  // Servers described by one word of the idle bitmap
+
+//------New types--------------------------------------------------------------
+typedef struct  // Load of one server. It fills a whole cache line, so the servers do not share lines
+{
+	_Alignas(CACHE_LINE_SIZE) atomic_int Load;  // Customers sent to the server and not completed
+} PADDED_COUNTER;
+
+struct CONCURRENT_BALANCER  // Balancer shared by the threads. The fields before Ticket are only read
+{
+	enum CONCURRENT_POLICY Policy;           // Load balancer
+	int                    NumberOfServers;  // Number of servers
+	int                    SampleSize;       // Servers sampled per decision by Power-of-d
+	int                    NumberOfWords;    // Number of words of IdleBitmap
+	PADDED_COUNTER        *Loads;            // Load of each server
+	atomic_ullong         *IdleBitmap;       // Bit of each idle server whose token is not taken (Join-Idle-Queue)
+	_Alignas(CACHE_LINE_SIZE) atomic_ullong Ticket;  // Next ticket of Round Robin. Has its own cache line
+};
+
+//===========================================================================
+//=  This function returns the number of the lowest set bit of x, which     =
+//=  must be positive. GCC and Clang have a single instruction for it.      =
+//===========================================================================
+static int lowestBit(unsigned long long x)
+{
+#if defined(__GNUC__)
+	return(__builtin_ctzll(x));
+#else
+	int bit = 0;  // Number of the lowest set bit
+
+	while ((x & 1) == 0)
+	{
+		x >>= 1;
+		bit++;
+	}
+
+	return(bit);
+#endif
+}
+
+//===========================================================================
+//=  This function allocates the balancer. All servers are idle and every   =
+//=  server has its token in the idle bitmap.                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: policy          - load balancer                                =
+//=          numberOfServers - number of servers                            =
+//=          sampleSize      - servers sampled per decision by Power-of-d   =
+//=  Returns: balancer, NULL on error                                       =
+//===========================================================================
+CONCURRENT_BALANCER *concurrentBalancerCreate(enum CONCURRENT_POLICY policy, int numberOfServers, int sampleSize)
+{
+	CONCURRENT_BALANCER *balancer;  // New balancer
+	unsigned long long   bits;      // Idle bits of the current word
+	int                  i;         // Server counter
+
+	if ((numberOfServers < 1) || (sampleSize < 1) || ((int) policy < 0) ||
+		((int) policy >= NUMBER_OF_CONCURRENT_POLICIES))
+	{
+		return(NULL);
+	}
+
+	balancer = (CONCURRENT_BALANCER *) aligned_alloc(CACHE_LINE_SIZE, sizeof(CONCURRENT_BALANCER));
+	if (balancer == NULL)
+	{
+		return(NULL);
+	}
+	memset(balancer, 0, sizeof(CONCURRENT_BALANCER));
+	balancer->Policy = policy;
+	balancer->NumberOfServers = numberOfServers;
+	balancer->SampleSize = sampleSize;
+	balancer->NumberOfWords = (numberOfServers + IDLE_WORD_BITS - 1) / IDLE_WORD_BITS;
+	balancer->Loads = (PADDED_COUNTER *) aligned_alloc(CACHE_LINE_SIZE, sizeof(PADDED_COUNTER) * numberOfServers);
+	balancer->IdleBitmap = (atomic_ullong *) calloc(balancer->NumberOfWords, sizeof(atomic_ullong));
+	if ((balancer->Loads == NULL) || (balancer->IdleBitmap == NULL))
+	{
+		concurrentBalancerFree(balancer);
+		return(NULL);
+	}
+
+	atomic_init(&balancer->Ticket, 0);
+	for (i = 0; i < numberOfServers; i++)
+	{
+		atomic_init(&balancer->Loads[i].Load, 0);
+	}
+	for (i = 0; i < balancer->NumberOfWords; i++)
+	{
+		bits = ((i + 1) * IDLE_WORD_BITS <= numberOfServers) ? ~0ULL :
+			(1ULL << (numberOfServers % IDLE_WORD_BITS)) - 1;
+		atomic_init(&balancer->IdleBitmap[i], bits);
+	}
+
+	return(balancer);
+}
+
+//===========================================================================
+//=  This function frees the balancer. No thread may use it any more.       =
+//===========================================================================
+void concurrentBalancerFree(CONCURRENT_BALANCER *balancer)
+{
+	if (balancer == NULL)
+	{
+		return;
+	}
+
+	free(balancer->Loads);
+	free(balancer->IdleBitmap);
+	free(balancer);
+}
+
+//===========================================================================
+//=  This function chooses the server with the least load. The scan starts  =
+//=  at a random server, so the ties do not all go to the same server, and  =
+//=  stops at the first idle one. The loads are read without a lock:        =
+//=  another thread may choose the same server at the same time.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: balancer - balancer                                            =
+//=          stream   - random stream of the calling thread                 =
+//=  Returns: serverID - ID of the least loaded server                      =
+//===========================================================================
+static int leastLoadedServer(CONCURRENT_BALANCER *balancer, RANDOM_STREAM *stream)
+{
+	int numberOfServers = balancer->NumberOfServers;  // Number of servers
+	int serverID;                                     // Current server
+	int bestServerID;                                 // Least loaded server so far
+	int bestLoad;                                     // Load of bestServerID
+	int load;                                         // Load of the current server
+	int i;                                            // Server counter
+
+	bestServerID = randomInteger(stream, 0, numberOfServers - 1);
+	bestLoad = atomic_load_explicit(&balancer->Loads[bestServerID].Load, memory_order_relaxed);
+	serverID = bestServerID;
+	for (i = 1; (i < numberOfServers) && (bestLoad > 0); i++)
+	{
+		serverID = (serverID + 1 == numberOfServers) ? 0 : serverID + 1;
+		load = atomic_load_explicit(&balancer->Loads[serverID].Load, memory_order_relaxed);
+		if (load < bestLoad)
+		{
+			bestLoad = load;
+			bestServerID = serverID;
+		}
+	}
+
+	return(bestServerID);
+}
+
+//===========================================================================
+//=  This function chooses the least loaded of SampleSize random servers.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: balancer - balancer                                            =
+//=          stream   - random stream of the calling thread                 =
+//=  Returns: serverID - ID of the chosen server                            =
+//===========================================================================
+static int powerOfDServer(CONCURRENT_BALANCER *balancer, RANDOM_STREAM *stream)
+{
+	int serverID;      // Sampled server
+	int bestServerID;  // Least loaded sampled server
+	int bestLoad;      // Load of bestServerID
+	int load;          // Load of the sampled server
+	int i;             // Sample counter
+
+	bestServerID = randomInteger(stream, 0, balancer->NumberOfServers - 1);
+	bestLoad = atomic_load_explicit(&balancer->Loads[bestServerID].Load, memory_order_relaxed);
+	for (i = 1; i < balancer->SampleSize; i++)
+	{
+		serverID = randomInteger(stream, 0, balancer->NumberOfServers - 1);
+		load = atomic_load_explicit(&balancer->Loads[serverID].Load, memory_order_relaxed);
+		if (load < bestLoad)
+		{
+			bestLoad = load;
+			bestServerID = serverID;
+		}
+	}
+
+	return(bestServerID);
+}
+
+//===========================================================================
+//=  This function takes the token of an idle server from the bitmap. The   =
+//=  search starts at a random word, so the threads do not all compete for  =
+//=  the same bits. A token is taken by clearing its bit with a compare and =
+//=  swap. The thread which loses the race retries with the bits it has     =
+//=  just read, so some thread always makes progress (lock-free).           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: balancer - balancer                                            =
+//=          stream   - random stream of the calling thread                 =
+//=  Returns: serverID - ID of the idle server, -1 if there is none         =
+//===========================================================================
+static int takeIdleServer(CONCURRENT_BALANCER *balancer, RANDOM_STREAM *stream)
+{
+	unsigned long long bits;  // Current word of the bitmap
+	unsigned long long bit;   // Lowest set bit of the word
+	int                word;  // Index of the current word
+	int                i;     // Word counter
+
+	word = randomInteger(stream, 0, balancer->NumberOfWords - 1);
+	for (i = 0; i < balancer->NumberOfWords; i++)
+	{
+		bits = atomic_load_explicit(&balancer->IdleBitmap[word], memory_order_relaxed);
+		while (bits != 0)
+		{
+			bit = bits & (~bits + 1);
+			if (atomic_compare_exchange_weak_explicit(&balancer->IdleBitmap[word], &bits, bits & ~bit,
+				memory_order_acquire, memory_order_relaxed))
+			{
+				return(word * IDLE_WORD_BITS + lowestBit(bit));
+			}
+		}
+		word = (word + 1 == balancer->NumberOfWords) ? 0 : word + 1;
+	}
+
+	return(-1);
+}
+
+//===========================================================================
+//=  This function chooses the server for a customer and adds the customer  =
+//=  to its load. It may be called by many threads at once and takes no     =
+//=  locks. Round Robin is wait-free: one fetch-and-add of the ticket. The  =
+//=  others read the loads without locks.                                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: balancer - balancer                                            =
+//=          stream   - random stream owned by the calling thread           =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int concurrentBalancerChoose(CONCURRENT_BALANCER *balancer, RANDOM_STREAM *stream)
+{
+	int serverID;  // Stores ID of the chosen server
+
+	switch (balancer->Policy)
+	{
+	case concurrentRoundRobinPolicy:
+		serverID = (int) (atomic_fetch_add_explicit(&balancer->Ticket, 1, memory_order_relaxed) %
+			(unsigned long long) balancer->NumberOfServers);
+		break;
+	case concurrentShortestQueuePolicy:
+		serverID = leastLoadedServer(balancer, stream);
+		break;
+	case concurrentPowerOfDPolicy:
+		serverID = powerOfDServer(balancer, stream);
+		break;
+	case concurrentJoinIdleQueuePolicy:
+		serverID = takeIdleServer(balancer, stream);
+		if (serverID < 0)
+		{
+			serverID = randomInteger(stream, 0, balancer->NumberOfServers - 1);
+		}
+		break;
+	default:
+		serverID = randomInteger(stream, 0, balancer->NumberOfServers - 1);
+		break;
+	}
+
+	atomic_fetch_add_explicit(&balancer->Loads[serverID].Load, 1, memory_order_relaxed);
+
+	return(serverID);
+}
+
+//===========================================================================
+//=  This function removes a completed customer from the load of its        =
+//=  server. At Join-Idle-Queue the server which becomes idle puts its      =
+//=  token back, unless the token has not been taken yet.                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: balancer - balancer                                            =
+//=          serverID - server of the completed customer                    =
+//=  Returns: None                                                          =
+//===========================================================================
+void concurrentBalancerComplete(CONCURRENT_BALANCER *balancer, int serverID)
+{
+	int previousLoad;  // Load before the completion
+
+	previousLoad = atomic_fetch_sub_explicit(&balancer->Loads[serverID].Load, 1, memory_order_relaxed);
+	if ((previousLoad == 1) && (balancer->Policy == concurrentJoinIdleQueuePolicy))
+	{
+		atomic_fetch_or_explicit(&balancer->IdleBitmap[serverID / IDLE_WORD_BITS],
+			1ULL << (serverID % IDLE_WORD_BITS), memory_order_release);
+	}
+}
+
+//===========================================================================
+//=  This function returns the current load of the server. Other threads    =
+//=  may change it at any time.                                             =
+//===========================================================================
+int concurrentBalancerLoad(const CONCURRENT_BALANCER *balancer, int serverID)
+{
+	return(atomic_load_explicit(&balancer->Loads[serverID].Load, memory_order_relaxed));
+}
+
+//===========================================================================
+//=  This function returns the name of the load balancer for the reports.   =
+//===========================================================================
+const char *concurrentPolicyName(enum CONCURRENT_POLICY policy)
+{
+	switch (policy)
+	{
+	case concurrentRandomPolicy:         return("Random");
+	case concurrentRoundRobinPolicy:     return("Round Robin");
+	case concurrentShortestQueuePolicy:  return("Shortest Queue");
+	case concurrentPowerOfDPolicy:       return("Power-of-d Choices");
+	case concurrentJoinIdleQueuePolicy:  return("Join-Idle-Queue");
+	default:                             return("Unknown");
+	}
+}
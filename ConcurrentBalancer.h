@@ -0,0 +1,41 @@
+#ifndef CONCURRENT_BALANCER_H
+#define CONCURRENT_BALANCER_H
+
+// The library is written in C11 and may be used from C++
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----- Includes --------------------------------------------------------------
+#include "RandomStreams.h"  // Random stream of the calling thread
+
+//----- Constants -------------------------------------------------------------
+#define CACHE_LINE_SIZE               64  // Bytes of a cache line. Every server load has its own line
+#define NUMBER_OF_CONCURRENT_POLICIES 5   // Number of load balancers of the library
+
+//------New types--------------------------------------------------------------
+enum CONCURRENT_POLICY  // Load balancer of the library
+{
+	concurrentRandomPolicy,         // Random server
+	concurrentRoundRobinPolicy,     // Servers in turn by a shared ticket
+	concurrentShortestQueuePolicy,  // Least loaded of all servers
+	concurrentPowerOfDPolicy,       // Least loaded of SampleSize random servers
+	concurrentJoinIdleQueuePolicy   // An idle server if there is one, a random server otherwise
+};
+
+// Balancer shared by the threads. Its fields are atomics, so it is only seen through the functions below
+typedef struct CONCURRENT_BALANCER CONCURRENT_BALANCER;
+
+//----- Prototypes ------------------------------------------------------------
+CONCURRENT_BALANCER *concurrentBalancerCreate(enum CONCURRENT_POLICY policy, int numberOfServers, int sampleSize);
+void        concurrentBalancerFree(CONCURRENT_BALANCER *balancer);
+int         concurrentBalancerChoose(CONCURRENT_BALANCER *balancer, RANDOM_STREAM *stream);
+void        concurrentBalancerComplete(CONCURRENT_BALANCER *balancer, int serverID);
+int         concurrentBalancerLoad(const CONCURRENT_BALANCER *balancer, int serverID);
+const char *concurrentPolicyName(enum CONCURRENT_POLICY policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,572 @@
+//----- Includes --------------------------------------------------------------
+#include <math.h>             // Needed for log()
+#include <stdio.h>            // Needed for I/O functions
+#include <stdlib.h>           // Needed for calloc(), free() and strtol()
+#include <string.h>           // Needed for strcmp() and memcpy()
+#include "StandaloneModel.h"  // Simulation state and chooseServer()
+#include "LoadBalancers.h"    // Batch Sampling, which chooseServer() does not handle
+#include "Replications.h"     // Needed for wallClock()
+
+//----- Constants -------------------------------------------------------------
+#define MAX_SERVER_COUNTS  32                      // Largest number of server counts
+#define CHUNK_DECISIONS    1000                    // Least number of decisions between two restores of the views
+#define MEASUREMENT_TIME   0.05                    // Default timed seconds of each policy and server count
+#define MEASUREMENT_ROUNDS 5                       // Rounds over all policies which share the timed seconds
+#define SYNTHETIC_LOAD     0.9                     // Queue lengths are geometric with mean load / (1 - load)
+#define CALIBRATION_DRAWS  10000                   // Draws of one timing of a random number, as short as a chunk
+#define CALIBRATION_RUNS   1000                    // Timings whose fastest gives the time of one random number
+#define MAX_DRAW_STEPS     100000000               // Largest number of draws counted for a chunk
+#define DEFAULT_TOLERANCE  2.0                     // Allowed slowdown against the baseline
+#define SLACK_DRAWS        2.0                     // Slowdown in random numbers which is always allowed
+#define DEFAULT_BASELINE   "DecisionBaseline.txt"  // Baseline which is checked by default
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the benchmark
+{
+	int         ServerCounts[MAX_SERVER_COUNTS];  // Numbers of servers
+	int         NumberOfServerCounts;             // Number of numbers of servers
+	double      MeasurementTime;                  // Timed seconds of each policy and server count
+	double      Tolerance;                        // Allowed slowdown against the baseline
+	const char *BaselinePath;                     // Baseline to check against
+	const char *OutputPath;                       // Baseline to write, NULL to check against BaselinePath
+} DECISION_CONFIG;
+
+typedef struct  // Cost of the decisions of one policy with one number of servers
+{
+	enum BALANCER_TYPE Policy;           // Load balancer
+	int                NumberOfServers;  // Number of servers
+	double             Cost;             // Time of one decision in ns
+	double             Draws;            // Random numbers drawn per decision, -1 if too many to count
+} DECISION_RESULT;
+
+//----- Prototypes ------------------------------------------------------------
+int parseArguments(int argc, char *argv[], DECISION_CONFIG *config);
+int measureServerCount(const DECISION_CONFIG *config, int numberOfServers, double drawTime, DECISION_RESULT *results);
+int writeBaseline(const char *path, double drawTime, const DECISION_RESULT *results, int count);
+int checkBaseline(const DECISION_CONFIG *config, double drawTime, const DECISION_RESULT *results, int count);
+
+//===========================================================================
+//=  Main program of the decision benchmark. It times every load balancer   =
+//=  of the standalone model on synthetic queues with every number of       =
+//=  servers. Then it writes the results as the new baseline or checks them =
+//=  against the stored one.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=  Returns: 0 on success, 1 on error or regression                        =
+//===========================================================================
+int main(int argc, char *argv[])
+{
+	DECISION_CONFIG  config;     // Parameters of the benchmark
+	DECISION_RESULT *results;    // Results of all policies and server counts
+	RANDOM_STREAM    stream;     // Stream of the calibration
+	double           drawTime;   // Time of one random number in ns
+	double           start;      // Clock at the start of the calibration
+	double           runTime;    // Time of one random number in the current timing
+	double           sum = 0.0;  // Sum of the calibration draws, so they are not optimized away
+	int              count;      // Number of results
+	int              result;     // Result of the check
+	int              run;        // Timing counter
+	int              i;          // Draw and server count counter
+
+	if (parseArguments(argc, argv, &config) != 0)
+	{
+		printf("Usage: DecisionBenchmark [--servers LIST] [--time X] [--tolerance X] [--baseline FILE]\n");
+		printf("       [--write-baseline FILE]   LIST is comma separated, e.g. --servers 5,500,100000\n");
+		return(1);
+	}
+
+	// The costs are compared in units of one random number, so a baseline from
+	// another machine still holds roughly. Every cost is divided by this time,
+	// so it is the fastest of several timings, like the cost of a decision
+	randomStreamInit(&stream, 1);
+	drawTime = 0.0;
+	for (run = 0; run < CALIBRATION_RUNS; run++)
+	{
+		start = wallClock();
+		for (i = 0; i < CALIBRATION_DRAWS; i++)
+		{
+			sum += randomUniform01(&stream);
+		}
+		runTime = (wallClock() - start) * 1e9 / CALIBRATION_DRAWS;
+		drawTime = ((run == 0) || (runTime < drawTime)) ? runTime : drawTime;
+	}
+	printf("Random number: %.2f ns (mean of the draws %.4f)\n\n", drawTime,
+		sum / ((double) CALIBRATION_DRAWS * CALIBRATION_RUNS));
+
+	count = config.NumberOfServerCounts * NUMBER_OF_POLICIES;
+	results = (DECISION_RESULT *) calloc(count, sizeof(DECISION_RESULT));
+	if (results == NULL)
+	{
+		printf("Not enough memory for the results\n");
+		return(1);
+	}
+
+	printf("policy                           servers  ns/decision  draws/decision  cost in draws\n");
+	for (i = 0; i < config.NumberOfServerCounts; i++)
+	{
+		if (measureServerCount(&config, config.ServerCounts[i], drawTime, results + i * NUMBER_OF_POLICIES) != 0)
+		{
+			free(results);
+			return(1);
+		}
+	}
+
+	if (config.OutputPath != NULL)
+	{
+		result = writeBaseline(config.OutputPath, drawTime, results, count);
+	}
+	else
+	{
+		result = checkBaseline(&config, drawTime, results, count);
+	}
+	free(results);
+
+	return((result == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function reads the command line. Options:                         =
+//=    --servers LIST        numbers of servers, 5 up to 100000 by default  =
+//=    --time X              timed seconds of each policy and server count  =
+//=    --tolerance X         allowed slowdown against the baseline, 2.0     =
+//=    --baseline FILE       baseline to check, DecisionBaseline.txt        =
+//=    --write-baseline FILE write the results as a new baseline            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=          config     - place to store the parameters                     =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseArguments(int argc, char *argv[], DECISION_CONFIG *config)
+{
+	static const int defaultCounts[] = { 5, 50, 500, 5000, 50000, 100000 };  // Default numbers of servers
+	char            *position;                                             // Current value of the list
+	char            *end;                                                  // End of the current value
+	long             value;                                                // Current value
+	int              i;                                                    // Argument counter
+
+	config->NumberOfServerCounts = (int) (sizeof(defaultCounts) / sizeof(defaultCounts[0]));
+	memcpy(config->ServerCounts, defaultCounts, sizeof(defaultCounts));
+	config->MeasurementTime = MEASUREMENT_TIME;
+	config->Tolerance = DEFAULT_TOLERANCE;
+	config->BaselinePath = DEFAULT_BASELINE;
+	config->OutputPath = NULL;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--servers") == 0)
+		{
+			config->NumberOfServerCounts = 0;
+			position = argv[i + 1];
+			do
+			{
+				value = strtol(position, &end, 10);
+				if ((end == position) || (value < 1) || (value > 10000000) ||
+					(config->NumberOfServerCounts == MAX_SERVER_COUNTS) || ((*end != ',') && (*end != '\0')))
+				{
+					printf("ERROR! Bad list of servers %s\n", argv[i + 1]);
+					return(-1);
+				}
+				config->ServerCounts[config->NumberOfServerCounts++] = (int) value;
+				position = end + 1;
+			} while (*end == ',');
+		}
+		else if (strcmp(argv[i], "--time") == 0)
+		{
+			config->MeasurementTime = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0)
+		{
+			config->Tolerance = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--baseline") == 0)
+		{
+			config->BaselinePath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--write-baseline") == 0)
+		{
+			config->OutputPath = argv[i + 1];
+		}
+		else
+		{
+			printf("ERROR! Unknown option %s\n", argv[i]);
+			return(-1);
+		}
+	}
+
+	if (i < argc)
+	{
+		printf("ERROR! Option %s needs a value\n", argv[i]);
+		return(-1);
+	}
+	if ((config->MeasurementTime <= 0.0) || (config->Tolerance < 1.0))
+	{
+		printf("ERROR! Time must be positive and tolerance at least 1\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function gives the views of the load balancers the synthetic      =
+//=  queue lengths again: the reports of the stale balancers, the           =
+//=  predictions of Predictive and a token of every idle server. The        =
+//=  decisions of Improved, Speed Improved, Predictive and Join-Idle-Queue  =
+//=  change them. The heap of Predictive and the speed index are only       =
+//=  rebuilt for the balancers which keep them, as rebuilding the speed     =
+//=  index costs more than a chunk of Improved with 100000 servers.         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state   - simulation state                                     =
+//=          lengths - synthetic queue length of each server                =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int restoreViews(SIMULATION_STATE *state, const int *lengths)
+{
+	DISPATCHER *dispatcher = state->Dispatcher;  // The only dispatcher
+	int         i;                               // Server counter
+
+	dispatcher->IdleHead = 0;
+	dispatcher->IdleCount = 0;
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		dispatcher->QueueLength[i] = lengths[i];
+		dispatcher->ReportClock[i] = state->Clock;
+		dispatcher->EmptyClock[i] = state->Clock + lengths[i] / (state->Config.Mu * state->Speed[i]);
+		state->HasIdleToken[i] = (lengths[i] == 0);
+		if (lengths[i] == 0)
+		{
+			dispatcher->IdleTokens[dispatcher->IdleCount++] = i;
+		}
+	}
+
+	if (queueIndexRebuild(&dispatcher->StaleIndex, dispatcher->QueueLength) != 0)
+	{
+		return(-1);
+	}
+	if (usesEmptyHeap(&state->Config))
+	{
+		serverHeapRebuild(&dispatcher->EmptyHeap);
+	}
+	if (usesStaleSpeedIndex(&state->Config))
+	{
+		return(speedIndexRebuild(&dispatcher->StaleSpeedIndex, dispatcher->QueueLength));
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function makes count decisions of the current load balancer.      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          count - number of decisions                                    =
+//=  Returns: 0 on success, -1 if the load balancer has failed              =
+//===========================================================================
+static int makeDecisions(SIMULATION_STATE *state, int count)
+{
+	int i;  // Decision counter
+
+	for (i = 0; i < count; i++)
+	{
+		if (state->Config.LoadBalancer == batchSamplingPolicy)
+		{
+			batchSamplingLoadBalancer(state, state->BatchServerIDs, 1);
+		}
+		else if (chooseServer(state) < 0)
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function counts the random numbers drawn between two states of a  =
+//=  stream by drawing them again from the first state. Every function of   =
+//=  RandomStreams draws 64 bits at a time, so the count is exact.          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: before - stream before the decisions                           =
+//=          after  - stream after the decisions                            =
+//=  Returns: number of draws, -1 if there are more than MAX_DRAW_STEPS     =
+//===========================================================================
+static long long countDraws(const RANDOM_STREAM *before, const RANDOM_STREAM *after)
+{
+	RANDOM_STREAM stream = *before;  // Stream which follows the decisions
+	long long     draws = 0;         // Number of draws
+
+	while (!randomStreamSameState(&stream, after))
+	{
+		if (draws == MAX_DRAW_STEPS)
+		{
+			return(-1);
+		}
+		randomUniform01(&stream);
+		draws++;
+	}
+
+	return(draws);
+}
+
+//===========================================================================
+//=  This function times every load balancer with one number of servers.    =
+//=  The servers get geometric queue lengths with the mean of an M/M/1      =
+//=  queue at SYNTHETIC_LOAD, and the views of the stale balancers show     =
+//=  the same lengths. The decisions run in chunks. The views are restored  =
+//=  between the chunks, outside of the timed part, for the balancers which =
+//=  change them. The cost is the one of the fastest chunk, which is the    =
+//=  least disturbed by the other processes of the machine. The timed       =
+//=  seconds of a policy are spread over MEASUREMENT_ROUNDS rounds over all =
+//=  policies, so a slow period of the machine cannot spoil all of its      =
+//=  chunks. Every round of a policy starts from the same random stream,    =
+//=  and its first chunk counts the random numbers drawn, so the draws do   =
+//=  not depend on the timing.                                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config          - parameters of the benchmark                  =
+//=          numberOfServers - number of servers                            =
+//=          drawTime        - time of one random number in ns              =
+//=          results         - place for the results of every policy        =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int measureServerCount(const DECISION_CONFIG *config, int numberOfServers, double drawTime, DECISION_RESULT *results)
+{
+	SIMULATION_CONFIG  simulationConfig;  // Parameters of the state
+	SIMULATION_STATE   state;             // State which the load balancers work on
+	RANDOM_STREAM      synthetic;         // Stream of the synthetic queue lengths
+	RANDOM_STREAM      initial;           // Stream which every policy starts from
+	RANDOM_STREAM      before;            // Stream before the first chunk
+	DECISION_RESULT   *result;            // Result of the current policy
+	int               *lengths;           // Synthetic queue length of each server
+	double             elapsed;           // Timed seconds of the current policy
+	double             start;             // Clock at the start of the chunk
+	double             chunkTime;         // Seconds of the current chunk
+	double             bestTime;          // Seconds of the fastest chunk
+	long long          decisions;         // Decisions of the current policy so far
+	long long          draws;             // Draws of the first chunk
+	int                chunk;             // Decisions in a chunk
+	int                restore;           // Whether the policy changes the views
+	int                round;             // Round counter
+	int                p;                 // Policy counter
+	int                i;                 // Server and job counter
+
+	defaultConfig(&simulationConfig);
+	simulationConfig.NumberOfServers = numberOfServers;
+	lengths = (int *) calloc(numberOfServers, sizeof(int));
+	if ((lengths == NULL) || (simulationInit(&state, &simulationConfig) != 0))
+	{
+		printf("Not enough memory for %d servers\n", numberOfServers);
+		free(lengths);
+		return(-1);
+	}
+
+	// Queues of placeholder jobs give the synthetic lengths to the balancers which read the real queues
+	randomStreamInit(&synthetic, 12345);
+	for (i = 0; i < numberOfServers; i++)
+	{
+		lengths[i] = (int) (log(randomUniform01(&synthetic)) / log(SYNTHETIC_LOAD));
+		while (state.Servers[i].Count < lengths[i])
+		{
+			if (serverQueuePush(&state.Servers[i], 0) != 0)
+			{
+				printf("Not enough memory for the synthetic queues\n");
+				simulationFree(&state);
+				free(lengths);
+				return(-1);
+			}
+		}
+	}
+	if ((queueIndexRebuild(&state.ServerIndex, lengths) != 0) || (speedIndexRebuild(&state.SpeedIndex, lengths) != 0))
+	{
+		printf("Not enough memory for the synthetic queues\n");
+		simulationFree(&state);
+		free(lengths);
+		return(-1);
+	}
+
+	chunk = (numberOfServers / 16 > CHUNK_DECISIONS) ? numberOfServers / 16 : CHUNK_DECISIONS;
+	initial = state.Random[decisionStream];
+	for (round = 0; round < MEASUREMENT_ROUNDS; round++)
+	{
+		for (p = 0; p < NUMBER_OF_POLICIES; p++)
+		{
+			result = &results[p];
+			result->Policy = (enum BALANCER_TYPE) p;
+			result->NumberOfServers = numberOfServers;
+			state.Config.LoadBalancer = result->Policy;
+			restore = (result->Policy == improvedPolicy) || (result->Policy == joinIdleQueuePolicy) ||
+				(result->Policy == predictivePolicy) || (result->Policy == speedImprovedPolicy);
+			state.Random[decisionStream] = initial;
+			elapsed = 0.0;
+			bestTime = (round == 0) ? 0.0 : result->Cost * chunk / 1e9;
+			decisions = 0;
+			draws = 0;
+
+			do
+			{
+				if (((decisions == 0) || restore) && (restoreViews(&state, lengths) != 0))
+				{
+					printf("Not enough memory for the views\n");
+					simulationFree(&state);
+					free(lengths);
+					return(-1);
+				}
+				before = state.Random[decisionStream];
+				start = wallClock();
+				if (makeDecisions(&state, chunk) != 0)
+				{
+					printf("ERROR! %s has failed\n", balancerName(result->Policy));
+					simulationFree(&state);
+					free(lengths);
+					return(-1);
+				}
+				chunkTime = wallClock() - start;
+				elapsed += chunkTime;
+				if ((decisions == 0) && (round == 0))
+				{
+					draws = countDraws(&before, &state.Random[decisionStream]);
+					result->Draws = (draws >= 0) ? (double) draws / chunk : -1.0;
+					bestTime = chunkTime;
+				}
+				bestTime = (chunkTime < bestTime) ? chunkTime : bestTime;
+				decisions += chunk;
+			} while (elapsed < config->MeasurementTime / MEASUREMENT_ROUNDS);
+
+			result->Cost = bestTime * 1e9 / chunk;
+		}
+	}
+
+	for (p = 0; p < NUMBER_OF_POLICIES; p++)
+	{
+		printf("%-32s %-8d %-12.2f %-15.3f %.2f\n", balancerName(results[p].Policy), numberOfServers,
+			results[p].Cost, results[p].Draws, results[p].Cost / drawTime);
+	}
+	fflush(stdout);
+
+	simulationFree(&state);
+	free(lengths);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function writes the results as the baseline. The first line       =
+//=  holds the time of one random number, every other line is "policy       =
+//=  servers ns/decision draws/decision" with the policy from 1.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: path     - baseline file                                       =
+//=          drawTime - time of one random number in ns                     =
+//=          results  - results of all policies and server counts           =
+//=          count    - number of results                                   =
+//=  Returns: 0 on success, -1 if the file cannot be written                =
+//===========================================================================
+int writeBaseline(const char *path, double drawTime, const DECISION_RESULT *results, int count)
+{
+	FILE *file;  // Baseline file
+	int   i;     // Result counter
+
+	file = fopen(path, "w");
+	if (file == NULL)
+	{
+		printf("ERROR! Cannot write the baseline %s\n", path);
+		return(-1);
+	}
+
+	fprintf(file, "random-number-ns %.3f\n", drawTime);
+	for (i = 0; i < count; i++)
+	{
+		fprintf(file, "%d %d %.3f %.4f\n", results[i].Policy + 1, results[i].NumberOfServers, results[i].Cost,
+			results[i].Draws);
+	}
+
+	if (fclose(file) != 0)
+	{
+		printf("ERROR! Cannot write the baseline %s\n", path);
+		return(-1);
+	}
+	printf("\nBaseline of %d results is written to %s\n", count, path);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function checks the results against the baseline. A result has    =
+//=  regressed if its cost in random numbers is more than Tolerance times   =
+//=  the cost in the baseline and more than SLACK_DRAWS above it, since the =
+//=  cheapest decisions take a few ns and are within the noise of the       =
+//=  clock. It has also regressed if it draws more random numbers. The      =
+//=  draws do not depend on the machine, so any increase counts. Results    =
+//=  which are not in the baseline are not checked. A missing baseline is   =
+//=  an error, so a run from another directory cannot pass unchecked.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config   - parameters with BaselinePath and Tolerance          =
+//=          drawTime - time of one random number in ns on this machine     =
+//=          results  - results of all policies and server counts           =
+//=          count    - number of results                                   =
+//=  Returns: 0 if nothing has regressed, -1 else                           =
+//===========================================================================
+int checkBaseline(const DECISION_CONFIG *config, double drawTime, const DECISION_RESULT *results, int count)
+{
+	FILE                  *file;              // Baseline file
+	const DECISION_RESULT *result;            // Result of the baseline line
+	double                 baselineDrawTime;  // Time of one random number on the baseline machine
+	double                 cost;              // Cost of the baseline line in ns
+	double                 draws;             // Draws of the baseline line
+	double                 allowed;           // Largest cost in random numbers which has not regressed
+	int                    policy;            // Policy of the baseline line, from 1
+	int                    numberOfServers;   // Number of servers of the baseline line
+	int                    checked = 0;       // Number of checked results
+	int                    regressions = 0;   // Number of regressed results
+	int                    i;                 // Result counter
+
+	file = fopen(config->BaselinePath, "r");
+	if (file == NULL)
+	{
+		printf("\nERROR! No baseline %s, give it with --baseline or write one with --write-baseline\n",
+			config->BaselinePath);
+		return(-1);
+	}
+	if ((fscanf(file, " random-number-ns %lf", &baselineDrawTime) != 1) || (baselineDrawTime <= 0.0))
+	{
+		printf("ERROR! %s is not a baseline\n", config->BaselinePath);
+		fclose(file);
+		return(-1);
+	}
+
+	printf("\n");
+	while (fscanf(file, "%d %d %lf %lf", &policy, &numberOfServers, &cost, &draws) == 4)
+	{
+		for (i = 0, result = NULL; (i < count) && (result == NULL); i++)
+		{
+			if (((int) results[i].Policy + 1 == policy) && (results[i].NumberOfServers == numberOfServers))
+			{
+				result = &results[i];
+			}
+		}
+		if (result == NULL)
+		{
+			continue;
+		}
+
+		checked++;
+		allowed = config->Tolerance * cost / baselineDrawTime;
+		allowed = (allowed < cost / baselineDrawTime + SLACK_DRAWS) ? cost / baselineDrawTime + SLACK_DRAWS : allowed;
+		if (result->Cost / drawTime > allowed)
+		{
+			printf("REGRESSION! %s with %d servers: %.2f random numbers per decision, baseline %.2f\n",
+				balancerName(result->Policy), numberOfServers, result->Cost / drawTime, cost / baselineDrawTime);
+			regressions++;
+		}
+		if ((result->Draws < 0.0) || ((draws >= 0.0) && (result->Draws > draws + 0.001)))
+		{
+			printf("REGRESSION! %s with %d servers: %.3f draws per decision, baseline %.3f\n",
+				balancerName(result->Policy), numberOfServers, result->Draws, draws);
+			regressions++;
+		}
+	}
+	fclose(file);
+
+	printf("Checked %d results against %s (tolerance %g): %d regressions\n", checked, config->BaselinePath,
+		config->Tolerance, regressions);
+
+	return((regressions == 0) ? 0 : -1);
+}
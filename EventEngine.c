@@ -0,0 +1,357 @@
+//----- Includes --------------------------------------------------------------
+#include <stdlib.h>       // Needed for malloc(), realloc() and free()
+#include "EventEngine.h"  // Event list, job pool and server queue types
+
+//===========================================================================
+//=  This function compares two events. An event is earlier if its time is  =
+//=  less. Events with the same time are ordered by the sequence number, so =
+//=  the simulation does not depend on the heap layout.                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: a, b - events to compare                                       =
+//=  Returns: 1 if event a happens before event b, 0 otherwise              =
+//===========================================================================
+static int eventBefore(const EVENT *a, const EVENT *b)
+{
+	if (a->Time != b->Time)
+	{
+		return(a->Time < b->Time);
+	}
+
+	return(a->Sequence < b->Sequence);
+}
+
+//===========================================================================
+//=  This function allocates the future event list. The capacity should be  =
+//=  the expected number of simultaneously scheduled events. The list grows =
+//=  if the capacity is exceeded.                                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list     - event list to initialize                            =
+//=          capacity - initial capacity of the list                        =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int eventListInit(EVENT_LIST *list, int capacity)
+{
+	list->Heap = (EVENT *) malloc(sizeof(EVENT) * capacity);
+	list->Count = 0;
+	list->Capacity = capacity;
+	list->NextSequence = 0;
+
+	return((list->Heap == NULL) ? -1 : 0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the event list.                      =
+//===========================================================================
+void eventListFree(EVENT_LIST *list)
+{
+	free(list->Heap);
+	list->Heap = NULL;
+	list->Count = 0;
+	list->Capacity = 0;
+}
+
+//===========================================================================
+//=  This function schedules a new event. The event is put to the bottom of =
+//=  the heap and then is moved up until the heap order is restored.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list     - event list                                          =
+//=          time     - time of the event                                   =
+//=          type     - type of the event                                   =
+//=          serverID - server the event belongs to                         =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int scheduleEvent(EVENT_LIST *list, double time, int type, int serverID)
+{
+	EVENT *newHeap;  // Reallocated heap storage
+	EVENT  event;    // New event
+	int    child;    // Current position of the new event
+	int    parent;   // Position of the parent of the current position
+
+	// Grow the heap if it is full
+	if (list->Count == list->Capacity)
+	{
+		newHeap = (EVENT *) realloc(list->Heap, sizeof(EVENT) * list->Capacity * 2);
+		if (newHeap == NULL)
+		{
+			return(-1);
+		}
+		list->Heap = newHeap;
+		list->Capacity *= 2;
+	}
+
+	event.Time = time;
+	event.Sequence = list->NextSequence++;
+	event.Type = type;
+	event.ServerID = serverID;
+
+	// Sift the new event up
+	child = list->Count++;
+	while (child > 0)
+	{
+		parent = (child - 1) / 2;
+		if (!eventBefore(&event, &list->Heap[parent]))
+		{
+			break;
+		}
+		list->Heap[child] = list->Heap[parent];
+		child = parent;
+	}
+	list->Heap[child] = event;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function removes the earliest event from the event list. The last =
+//=  event of the heap is moved to the top and then is moved down until the =
+//=  heap order is restored.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list  - event list                                             =
+//=          event - place to store the removed event                       =
+//=  Returns: 1 if the event was removed, 0 if the list is empty            =
+//===========================================================================
+int nextEvent(EVENT_LIST *list, EVENT *event)
+{
+	EVENT last;    // Last event of the heap which is moved down
+	int   parent;  // Current position of the moved event
+	int   child;   // Position of the earliest child of the current position
+
+	if (list->Count == 0)
+	{
+		return(0);
+	}
+
+	*event = list->Heap[0];
+	last = list->Heap[--list->Count];
+
+	// Sift the last event down from the top
+	parent = 0;
+	child = 1;
+	while (child < list->Count)
+	{
+		// Take the earliest of two children
+		if ((child + 1 < list->Count) && eventBefore(&list->Heap[child + 1], &list->Heap[child]))
+		{
+			child++;
+		}
+		if (!eventBefore(&list->Heap[child], &last))
+		{
+			break;
+		}
+		list->Heap[parent] = list->Heap[child];
+		parent = child;
+		child = 2 * parent + 1;
+	}
+	list->Heap[parent] = last;
+
+	return(1);
+}
+
+//===========================================================================
+//=  This function allocates the job pool and links all jobs into the free  =
+//=  list. More memory is only allocated when all jobs are in use.          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: pool     - job pool to initialize                              =
+//=          capacity - usual number of jobs in the system                  =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int jobPoolInit(JOB_POOL *pool, int capacity)
+{
+	int i;  // Loop counter
+
+	pool->Jobs = (JOB *) malloc(sizeof(JOB) * capacity);
+	if (pool->Jobs == NULL)
+	{
+		return(-1);
+	}
+
+	for (i = 0; i < capacity; i++)
+	{
+		pool->Jobs[i].NextFree = (i + 1 < capacity) ? i + 1 : NO_JOB;
+	}
+	pool->Capacity = capacity;
+	pool->FreeHead = (capacity > 0) ? 0 : NO_JOB;
+	pool->InUse = 0;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the job pool.                        =
+//===========================================================================
+void jobPoolFree(JOB_POOL *pool)
+{
+	free(pool->Jobs);
+	pool->Jobs = NULL;
+	pool->Capacity = 0;
+	pool->FreeHead = NO_JOB;
+}
+
+//===========================================================================
+//=  This function doubles the pool. The jobs are addressed by their index, =
+//=  so the jobs in use stay valid when the storage moves.                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: pool - job pool without free jobs                              =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int growJobPool(JOB_POOL *pool)
+{
+	JOB *jobs;                                                       // New storage
+	int  capacity = (pool->Capacity > 0) ? 2 * pool->Capacity : 16;  // New number of jobs
+	int  i;                                                          // Loop counter
+
+	jobs = (JOB *) realloc(pool->Jobs, sizeof(JOB) * capacity);
+	if (jobs == NULL)
+	{
+		return(-1);
+	}
+
+	for (i = pool->Capacity; i < capacity; i++)
+	{
+		jobs[i].NextFree = (i + 1 < capacity) ? i + 1 : pool->FreeHead;
+	}
+	pool->FreeHead = pool->Capacity;
+	pool->Jobs = jobs;
+	pool->Capacity = capacity;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function takes a free job from the pool. The pool grows if all    =
+//=  jobs are in use.                                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: pool - job pool                                                =
+//=  Returns: index of the job or NO_JOB if there is not enough memory      =
+//===========================================================================
+int allocateJob(JOB_POOL *pool)
+{
+	int jobIndex;  // Index of the taken job
+
+	if ((pool->FreeHead == NO_JOB) && (growJobPool(pool) != 0))
+	{
+		return(NO_JOB);
+	}
+
+	jobIndex = pool->FreeHead;
+	if (jobIndex != NO_JOB)
+	{
+		pool->FreeHead = pool->Jobs[jobIndex].NextFree;
+		pool->InUse++;
+	}
+
+	return(jobIndex);
+}
+
+//===========================================================================
+//=  This function returns the job to the pool, so it can be reused by the  =
+//=  next customer.                                                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: pool     - job pool                                            =
+//=          jobIndex - index of the job to return                          =
+//=  Returns: None                                                          =
+//===========================================================================
+void releaseJob(JOB_POOL *pool, int jobIndex)
+{
+	pool->Jobs[jobIndex].NextFree = pool->FreeHead;
+	pool->FreeHead = jobIndex;
+	pool->InUse--;
+}
+
+//===========================================================================
+//=  This function allocates the ring buffer of the server queue and makes  =
+//=  the queue empty.                                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: queue - server queue to initialize                             =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int serverQueueInit(SERVER_QUEUE *queue)
+{
+	queue->Jobs = (int *) malloc(sizeof(int) * INITIAL_QUEUE_SIZE);
+	queue->Mask = INITIAL_QUEUE_SIZE - 1;
+	queue->Head = 0;
+	queue->Count = 0;
+
+	return((queue->Jobs == NULL) ? -1 : 0);
+}
+
+//===========================================================================
+//=  This function frees the ring buffer of the server queue.               =
+//===========================================================================
+void serverQueueFree(SERVER_QUEUE *queue)
+{
+	free(queue->Jobs);
+	queue->Jobs = NULL;
+	queue->Count = 0;
+}
+
+//===========================================================================
+//=  This function puts the job to the tail of the server queue. A full     =
+//=  ring buffer is doubled, so the queue itself has no limit: the model    =
+//=  decides how many customers a server admits.                            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: queue    - server queue                                        =
+//=          jobIndex - index of the job in the pool                        =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int serverQueuePush(SERVER_QUEUE *queue, int jobIndex)
+{
+	int *jobs;  // New ring buffer
+	int  i;     // Position in the queue
+
+	if (queue->Count > queue->Mask)
+	{
+		// Unwrap the queue into the start of the new buffer
+		jobs = (int *) malloc(sizeof(int) * 2 * (queue->Mask + 1));
+		if (jobs == NULL)
+		{
+			return(-1);
+		}
+		for (i = 0; i < queue->Count; i++)
+		{
+			jobs[i] = queue->Jobs[(queue->Head + i) & queue->Mask];
+		}
+		free(queue->Jobs);
+		queue->Jobs = jobs;
+		queue->Mask = 2 * queue->Mask + 1;
+		queue->Head = 0;
+	}
+
+	queue->Jobs[(queue->Head + queue->Count) & queue->Mask] = jobIndex;
+	queue->Count++;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function removes the head job (the one in service) from the queue.=
+//=-------------------------------------------------------------------------=
+//=  Inputs: queue - server queue                                           =
+//=  Returns: index of the removed job or NO_JOB if the queue is empty      =
+//===========================================================================
+int serverQueuePop(SERVER_QUEUE *queue)
+{
+	int jobIndex;  // Index of the removed job
+
+	if (queue->Count == 0)
+	{
+		return(NO_JOB);
+	}
+
+	jobIndex = queue->Jobs[queue->Head];
+	queue->Head = (queue->Head + 1) & queue->Mask;
+	queue->Count--;
+
+	return(jobIndex);
+}
+
+//===========================================================================
+//=  This function returns the head job (the one in service) of the queue.  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: queue - server queue                                           =
+//=  Returns: index of the head job or NO_JOB if the queue is empty         =
+//===========================================================================
+int serverQueueHead(const SERVER_QUEUE *queue)
+{
+	return((queue->Count == 0) ? NO_JOB : queue->Jobs[queue->Head]);
+}
@@ -0,0 +1,71 @@
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+//----- Constants -------------------------------------------------------------
+#define QUEUE_CAPACITY     200  // Default number of places at each server (same as in the CSIM model)
+#define INITIAL_QUEUE_SIZE 16   // Initial size of the ring buffer of a server queue. Power of two
+#define NO_JOB             -1   // Index which marks the absence of a job
+
+//------New types--------------------------------------------------------------
+typedef struct  // One scheduled event of the simulation
+{
+	double             Time;      // Simulation time when the event happens
+	unsigned long long Sequence;  // Insertion number. Keeps events with equal time in FIFO order
+	int                Type;      // Model specific type of the event
+	int                ServerID;  // Server the event belongs to (if any)
+} EVENT;
+
+typedef struct  // Future event list. Binary min-heap ordered by (Time, Sequence)
+{
+	EVENT             *Heap;          // Heap storage
+	int                Count;         // Number of scheduled events
+	int                Capacity;      // Allocated size of the heap
+	unsigned long long NextSequence;  // Sequence number of the next scheduled event
+} EVENT_LIST;
+
+typedef struct  // One customer of the system
+{
+	double ArrivalTime;  // Time when the customer entered the system
+	double ServiceTime;  // Time which is required to serve the customer
+	int    Class;        // Request class of the customer, 0 if the workload has no classes
+	int    Retries;      // Number of times the customer has been rejected and has tried again
+	int    Dispatcher;   // Dispatcher which has sent the customer
+	int    Phase;        // Phase of the arrival rate when the customer entered the system
+	int    ServerID;     // Server chosen for the customer while it is on the way to it (parallel runs)
+	int    NextFree;     // Next job in the free list of the pool
+} JOB;
+
+typedef struct  // Pool of jobs. Jobs are recycled, and the pool only grows when all jobs are in use
+{
+	JOB *Jobs;      // Storage for all jobs
+	int  Capacity;  // Number of jobs in the pool
+	int  FreeHead;  // First free job or NO_JOB
+	int  InUse;     // Number of jobs taken from the pool
+} JOB_POOL;
+
+typedef struct  // FIFO queue of a single server. The head job is the one in service
+{
+	int *Jobs;   // Ring buffer with indices of the jobs in the pool. Doubles when it is full
+	int  Mask;   // Size of the ring buffer minus one
+	int  Head;   // Position of the job in service
+	int  Count;  // Number of jobs at the server (waiting and in service)
+} SERVER_QUEUE;
+
+//----- Prototypes ------------------------------------------------------------
+int   eventListInit(EVENT_LIST *list, int capacity);
+void  eventListFree(EVENT_LIST *list);
+int   scheduleEvent(EVENT_LIST *list, double time, int type, int serverID);
+int   nextEvent(EVENT_LIST *list, EVENT *event);
+
+int   jobPoolInit(JOB_POOL *pool, int capacity);
+void  jobPoolFree(JOB_POOL *pool);
+int   allocateJob(JOB_POOL *pool);
+void  releaseJob(JOB_POOL *pool, int jobIndex);
+
+int   serverQueueInit(SERVER_QUEUE *queue);
+void  serverQueueFree(SERVER_QUEUE *queue);
+int   serverQueuePush(SERVER_QUEUE *queue, int jobIndex);
+int   serverQueuePop(SERVER_QUEUE *queue);
+int   serverQueueHead(const SERVER_QUEUE *queue);
+
+#endif
@@ -0,0 +1,423 @@
+//----- Includes --------------------------------------------------------------
+#include <stdlib.h>     // Needed for calloc() and free()
+#include <string.h>     // Needed for memset()
+#include "Histogram.h"  // Histogram types and prototypes
+
+//===========================================================================
+//=  This function returns the number of the highest set bit of x, which    =
+//=  must be positive. GCC and Clang have a single instruction for it.      =
+//===========================================================================
+static int highestBit(unsigned long long x)
+{
+#if defined(__GNUC__)
+	return(63 - __builtin_clzll(x));
+#else
+	int bit = 0;  // Number of the highest set bit
+	int shift;    // Step of the binary search
+
+	for (shift = 32; shift > 0; shift /= 2)
+	{
+		if (x >= (1ULL << shift))
+		{
+			x >>= shift;
+			bit += shift;
+		}
+	}
+
+	return(bit);
+#endif
+}
+
+//===========================================================================
+//=  This function finds the bucket of the value. Values below 2^Bits units =
+//=  have a bucket per unit. Above that every power of two is split into    =
+//=  2^(Bits - 1) buckets, so the bucket is value >> magnitude placed after =
+//=  magnitude * 2^(Bits - 1) buckets of the lower powers.                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram - histogram                                          =
+//=          value     - observation                                        =
+//=  Returns: index of the bucket                                           =
+//===========================================================================
+static int bucketIndex(const HISTOGRAM *histogram, double value)
+{
+	double             scaled;     // Value in units
+	unsigned long long units;      // Whole number of units
+	int                magnitude;  // Power of two of the bucket width
+
+	scaled = value * histogram->InverseUnit;
+	if (!(scaled > 0.0))
+	{
+		return(0);
+	}
+	if (scaled >= histogram->Limit)
+	{
+		return(histogram->NumberOfBuckets - 1);
+	}
+
+	units = (unsigned long long) scaled;
+	if (units < (1ULL << histogram->SubBucketBits))
+	{
+		return((int) units);
+	}
+	magnitude = highestBit(units) - histogram->SubBucketBits + 1;
+
+	return((magnitude << (histogram->SubBucketBits - 1)) + (int) (units >> magnitude));
+}
+
+//===========================================================================
+//=  This function finds the range of the bucket in units.                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram - histogram                                          =
+//=          index     - index of the bucket                                =
+//=          width     - place to store the width of the bucket             =
+//=  Returns: lower bound of the bucket                                     =
+//===========================================================================
+static double bucketLowerBound(const HISTOGRAM *histogram, int index, double *width)
+{
+	int magnitude;  // Power of two of the bucket width
+
+	if (index < (1 << histogram->SubBucketBits))
+	{
+		*width = 1.0;
+		return((double) index);
+	}
+
+	magnitude = (index >> (histogram->SubBucketBits - 1)) - 1;
+	*width = (double) (1ULL << magnitude);
+
+	return((double) ((unsigned long long) (index - (magnitude << (histogram->SubBucketBits - 1))) << magnitude));
+}
+
+//===========================================================================
+//=  This function counts the observation in the bucket.                    =
+//===========================================================================
+static void addObservation(HISTOGRAM *histogram, int index, double value)
+{
+	histogram->Counts[index]++;
+	histogram->Count++;
+	if (index > histogram->MaxIndex)
+	{
+		histogram->MaxIndex = index;
+	}
+	if (value > histogram->Max)
+	{
+		histogram->Max = value;
+	}
+}
+
+//===========================================================================
+//=  This function allocates an empty histogram. Observations from 0 to     =
+//=  2^subBucketBits units are counted exactly to a unit, larger ones with  =
+//=  the relative error below 2^(1 - subBucketBits), up to                  =
+//=  2^(subBucketBits + HISTOGRAM_MAGNITUDES) units.                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram     - histogram to initialize                        =
+//=          unit          - width of the buckets of the linear range       =
+//=          subBucketBits - precision of the histogram, from 2 to 20       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int histogramInit(HISTOGRAM *histogram, double unit, int subBucketBits)
+{
+	histogram->Unit = unit;
+	histogram->InverseUnit = 1.0 / unit;
+	histogram->SubBucketBits = subBucketBits;
+	histogram->Limit = (double) (1ULL << (subBucketBits + HISTOGRAM_MAGNITUDES));
+	histogram->NumberOfBuckets = (HISTOGRAM_MAGNITUDES + 2) << (subBucketBits - 1);
+	histogram->Count = 0;
+	histogram->MaxIndex = 0;
+	histogram->Max = 0.0;
+	histogram->Counts = (long long *) calloc(histogram->NumberOfBuckets, sizeof(long long));
+
+	return((histogram->Counts != NULL) ? 0 : -1);
+}
+
+//===========================================================================
+//=  This function frees the memory of the histogram.                       =
+//===========================================================================
+void histogramFree(HISTOGRAM *histogram)
+{
+	free(histogram->Counts);
+	histogram->Counts = NULL;
+}
+
+//===========================================================================
+//=  This function removes all observations from the histogram.             =
+//===========================================================================
+void histogramClear(HISTOGRAM *histogram)
+{
+	memset(histogram->Counts, 0, sizeof(long long) * (histogram->MaxIndex + 1));
+	histogram->Count = 0;
+	histogram->MaxIndex = 0;
+	histogram->Max = 0.0;
+}
+
+//===========================================================================
+//=  This function records the observation. It costs a few shifts and one   =
+//=  increment, so it can be called for every customer.                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram - histogram                                          =
+//=          value     - observation                                        =
+//=  Returns: None                                                          =
+//===========================================================================
+void histogramRecord(HISTOGRAM *histogram, double value)
+{
+	addObservation(histogram, bucketIndex(histogram, value), value);
+}
+
+//===========================================================================
+//=  This function adds all observations of other histogram, which must     =
+//=  have the same unit and precision.                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram - histogram to add to                                =
+//=          other     - added histogram                                    =
+//=  Returns: None                                                          =
+//===========================================================================
+void histogramAdd(HISTOGRAM *histogram, const HISTOGRAM *other)
+{
+	int i;  // Bucket counter
+
+	for (i = 0; i <= other->MaxIndex; i++)
+	{
+		histogram->Counts[i] += other->Counts[i];
+	}
+	histogram->Count += other->Count;
+	if (other->MaxIndex > histogram->MaxIndex)
+	{
+		histogram->MaxIndex = other->MaxIndex;
+	}
+	if (other->Max > histogram->Max)
+	{
+		histogram->Max = other->Max;
+	}
+}
+
+//===========================================================================
+//=  This function estimates the percentile. The buckets are walked down    =
+//=  from the largest observation, which is short for the tail percentiles, =
+//=  and the value is interpolated inside the bucket.                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: histogram  - histogram                                         =
+//=          percentile - percentile from (0, 1), e.g. 0.99                 =
+//=  Returns: estimate of the percentile, 0 if the histogram is empty       =
+//===========================================================================
+double histogramPercentile(const HISTOGRAM *histogram, double percentile)
+{
+	double rank;           // Number of observations up to the percentile
+	double below;          // Number of observations below the current bucket
+	double lower;          // Lower bound of the current bucket in units
+	double width;          // Width of the current bucket in units
+	double value;          // Estimate of the percentile
+	long long above = 0;   // Number of observations above the current bucket
+	int    i;              // Bucket counter
+
+	if (histogram->Count == 0)
+	{
+		return(0.0);
+	}
+
+	rank = percentile * histogram->Count;
+	for (i = histogram->MaxIndex; i > 0; i--)
+	{
+		below = (double) (histogram->Count - above - histogram->Counts[i]);
+		if (below < rank)
+		{
+			break;
+		}
+		above += histogram->Counts[i];
+	}
+
+	below = (double) (histogram->Count - above - histogram->Counts[i]);
+	lower = bucketLowerBound(histogram, i, &width);
+	value = (histogram->Counts[i] > 0) ?
+		(lower + width * (rank - below) / histogram->Counts[i]) * histogram->Unit : lower * histogram->Unit;
+
+	return((value < histogram->Max) ? value : histogram->Max);
+}
+
+//===========================================================================
+//=  This function makes the table empty. The batch histograms are only     =
+//=  allocated if the percentile is controlled. The first batch is long     =
+//=  enough to have MIN_TAIL_OBSERVATIONS observations beyond the           =
+//=  percentile, otherwise the batch percentiles would be meaningless.      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table      - percentile table to initialize                    =
+//=          unit       - width of the finest buckets                       =
+//=          percentile - controlled percentile from (0, 1), 0 if none      =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int percentileTableInit(PERCENTILE_TABLE *table, double unit, double percentile)
+{
+	double tail;  // Share of observations beyond the percentile
+	int    i;     // Batch counter
+
+	table->Percentile = percentile;
+	table->NumberOfBatches = 0;
+	table->CurrentBatchCount = 0;
+	table->BatchSize = INITIAL_BATCH_SIZE;
+	table->Batches = NULL;
+	if (histogramInit(&table->Total, unit, HISTOGRAM_PRECISION) != 0)
+	{
+		return(-1);
+	}
+	if (percentile <= 0.0)
+	{
+		return(0);
+	}
+
+	tail = (percentile < 0.5) ? percentile : 1.0 - percentile;
+	while (table->BatchSize * tail < MIN_TAIL_OBSERVATIONS)
+	{
+		table->BatchSize *= 2;
+	}
+
+	table->Batches = (HISTOGRAM *) calloc(2 * BATCH_COUNT, sizeof(HISTOGRAM));
+	if (table->Batches == NULL)
+	{
+		percentileTableFree(table);
+		return(-1);
+	}
+	for (i = 0; i < 2 * BATCH_COUNT; i++)
+	{
+		if (histogramInit(&table->Batches[i], unit, HISTOGRAM_PRECISION) != 0)
+		{
+			percentileTableFree(table);
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the table.                           =
+//===========================================================================
+void percentileTableFree(PERCENTILE_TABLE *table)
+{
+	int i;  // Batch counter
+
+	histogramFree(&table->Total);
+	if (table->Batches != NULL)
+	{
+		for (i = 0; i < 2 * BATCH_COUNT; i++)
+		{
+			histogramFree(&table->Batches[i]);
+		}
+		free(table->Batches);
+		table->Batches = NULL;
+	}
+}
+
+//===========================================================================
+//=  This function records the observation in the table. As in the delay    =
+//=  table, there are 2 * BATCH_COUNT batches at most: then the             =
+//=  neighbouring batch histograms are merged and the batch size doubles.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table - percentile table                                       =
+//=          value - observation                                            =
+//=  Returns: 1 if a batch has been completed, 0 otherwise                  =
+//===========================================================================
+int percentileTableRecord(PERCENTILE_TABLE *table, double value)
+{
+	HISTOGRAM *batches = table->Batches;  // Batch histograms
+	int        index;                     // Bucket of the observation
+	int        i;                         // Batch counter
+
+	index = bucketIndex(&table->Total, value);
+	addObservation(&table->Total, index, value);
+	if (batches == NULL)
+	{
+		return(0);
+	}
+
+	addObservation(&batches[table->NumberOfBatches], index, value);
+	if (++table->CurrentBatchCount < table->BatchSize)
+	{
+		return(0);
+	}
+
+	// The batch is complete
+	table->NumberOfBatches++;
+	table->CurrentBatchCount = 0;
+
+	// Merge the neighbouring batches if there is no place for the next one
+	if (table->NumberOfBatches == 2 * BATCH_COUNT)
+	{
+		for (i = 0; i < BATCH_COUNT; i++)
+		{
+			if (i > 0)
+			{
+				histogramClear(&batches[i]);
+				histogramAdd(&batches[i], &batches[2 * i]);
+			}
+			histogramAdd(&batches[i], &batches[2 * i + 1]);
+		}
+		for (i = BATCH_COUNT; i < 2 * BATCH_COUNT; i++)
+		{
+			histogramClear(&batches[i]);
+		}
+		table->NumberOfBatches = BATCH_COUNT;
+		table->BatchSize *= 2;
+	}
+
+	return(1);
+}
+
+//===========================================================================
+//=  This function returns the estimate of the percentile over all          =
+//=  recorded observations.                                                 =
+//===========================================================================
+double percentileTableValue(const PERCENTILE_TABLE *table)
+{
+	return(histogramPercentile(&table->Total, table->Percentile));
+}
+
+//===========================================================================
+//=  This function calculates the half-width of the confidence interval of  =
+//=  the percentile. The percentiles of the batches are treated as          =
+//=  independent observations (batch quantiles method).                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table   - percentile table                                     =
+//=          ciLevel - confidence level                                     =
+//=  Returns: half-width of the confidence interval or a negative value if  =
+//=           there are not enough batches                                  =
+//===========================================================================
+double percentileTableHalfWidth(const PERCENTILE_TABLE *table, double ciLevel)
+{
+	double batchPercentiles[2 * BATCH_COUNT];  // Percentile of each completed batch
+	double mean;                               // Mean of the batch percentiles
+	int    i;                                  // Batch counter
+
+	if ((table->Batches == NULL) || (table->NumberOfBatches < BATCH_COUNT))
+	{
+		return(-1.0);
+	}
+
+	for (i = 0; i < table->NumberOfBatches; i++)
+	{
+		batchPercentiles[i] = histogramPercentile(&table->Batches[i], table->Percentile);
+	}
+
+	return(sampleHalfWidth(batchPercentiles, table->NumberOfBatches, ciLevel, &mean));
+}
+
+//===========================================================================
+//=  This function checks whether the desired relative accuracy of the      =
+//=  percentile is achieved with the desired probability.                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table    - percentile table                                    =
+//=          accuracy - target relative half-width of the interval          =
+//=          ciLevel  - confidence level                                    =
+//=  Returns: 1 if the table has converged, 0 otherwise                     =
+//===========================================================================
+int percentileTableConverged(const PERCENTILE_TABLE *table, double accuracy, double ciLevel)
+{
+	double halfWidth;  // Half-width of the confidence interval
+
+	halfWidth = percentileTableHalfWidth(table, ciLevel);
+	if (halfWidth < 0.0)
+	{
+		return(0);
+	}
+
+	return(halfWidth <= accuracy * percentileTableValue(table));
+}
@@ -0,0 +1,50 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+//----- Includes --------------------------------------------------------------
+#include "Statistics.h"  // BATCH_COUNT, INITIAL_BATCH_SIZE and the Student t quantile
+
+//----- Constants -------------------------------------------------------------
+#define HISTOGRAM_MAGNITUDES  32  // Number of powers of two covered above the linear range of a histogram
+#define HISTOGRAM_PRECISION   7   // Default log2 of the number of linear buckets, relative bucket width below 1/64
+#define MIN_TAIL_OBSERVATIONS 10  // Observations beyond the percentile needed in every batch
+
+//------New types--------------------------------------------------------------
+typedef struct  // Log-linear histogram of non-negative observations (HDR histogram). Uses constant memory
+{
+	double     Unit;             // Width of the buckets of the linear range
+	double     InverseUnit;      // 1 / Unit
+	double     Limit;            // Observations of Limit units or more go to the last bucket
+	int        SubBucketBits;    // log2 of the number of buckets in the linear range
+	int        NumberOfBuckets;  // Number of buckets
+	long long *Counts;           // Number of observations in each bucket
+	long long  Count;            // Number of recorded observations
+	int        MaxIndex;         // Largest non-empty bucket
+	double     Max;              // Largest recorded observation
+} HISTOGRAM;
+
+typedef struct  // Histogram with batch percentiles run length control
+{
+	HISTOGRAM  Total;              // All recorded observations
+	HISTOGRAM *Batches;            // Completed batches and the current one. NULL if the percentile is not controlled
+	double     Percentile;         // Controlled percentile from (0, 1)
+	int        NumberOfBatches;    // Number of completed batches
+	long long  BatchSize;          // Current number of observations in a batch
+	long long  CurrentBatchCount;  // Number of observations in the current batch
+} PERCENTILE_TABLE;
+
+//----- Prototypes ------------------------------------------------------------
+int    histogramInit(HISTOGRAM *histogram, double unit, int subBucketBits);
+void   histogramFree(HISTOGRAM *histogram);
+void   histogramClear(HISTOGRAM *histogram);
+void   histogramRecord(HISTOGRAM *histogram, double value);
+void   histogramAdd(HISTOGRAM *histogram, const HISTOGRAM *other);
+double histogramPercentile(const HISTOGRAM *histogram, double percentile);
+int    percentileTableInit(PERCENTILE_TABLE *table, double unit, double percentile);
+void   percentileTableFree(PERCENTILE_TABLE *table);
+int    percentileTableRecord(PERCENTILE_TABLE *table, double value);
+double percentileTableValue(const PERCENTILE_TABLE *table);
+double percentileTableHalfWidth(const PERCENTILE_TABLE *table, double ciLevel);
+int    percentileTableConverged(const PERCENTILE_TABLE *table, double accuracy, double ciLevel);
+
+#endif
@@ -0,0 +1,418 @@
+//----- Includes --------------------------------------------------------------
+#include <math.h>           // Needed for sqrt()
+#include "LoadBalancers.h"  // Load balancer prototypes
+
+//===========================================================================
+//=  This function samples count different servers uniformly at random and  =
+//=  stores them in ProbeServerIDs in random order. A repeated server is    =
+//=  drawn again, which is cheap because count is much less than the number =
+//=  of servers. If count is not less than the number of servers, all       =
+//=  servers are taken in a shuffled order. Only the active servers of an   =
+//=  elastic pool are sampled.                                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          count - number of servers to sample                            =
+//=  Returns: number of sampled servers                                     =
+//===========================================================================
+static int sampleServers(SIMULATION_STATE *state, int count)
+{
+	int *probes = state->ProbeServerIDs;                   // Sampled servers
+	int  numberOfServers = state->ActiveServers;           // Number of servers which take customers
+	int  serverID;                                         // Candidate server
+	int  repeated;                                         // Whether the candidate is already sampled
+	int  i;                                                // Sample counter
+	int  j;                                                // Loop counter
+
+	// Take all servers and shuffle them
+	if (count >= numberOfServers)
+	{
+		for (i = 0; i < numberOfServers; i++)
+		{
+			probes[i] = i;
+		}
+		for (i = numberOfServers - 1; i > 0; i--)
+		{
+			j = randomInteger(&state->Random[decisionStream], 0, i);
+			serverID = probes[i];
+			probes[i] = probes[j];
+			probes[j] = serverID;
+		}
+		return(numberOfServers);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		do
+		{
+			serverID = randomInteger(&state->Random[decisionStream], 0, numberOfServers - 1);
+			repeated = 0;
+			for (j = 0; j < i; j++)
+			{
+				if (probes[j] == serverID)
+				{
+					repeated = 1;
+					break;
+				}
+			}
+		} while (repeated);
+		probes[i] = serverID;
+	}
+
+	return(count);
+}
+
+//===========================================================================
+//=  This is a Random Load Balancer. It returns a uniformly distributed     =
+//=  random ID of an active server.                                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int randomLoadBalancer(SIMULATION_STATE *state)
+{
+	return(randomInteger(&state->Random[decisionStream], 0, state->ActiveServers - 1));
+}
+
+//===========================================================================
+//=  This is a Round Robin Load Balancer. The first customer goes to the    =
+//=  server 1, the second to the server 2 and so on. Information about the  =
+//=  last choice is stored in RoundRobinServerIDCounter of the dispatcher.  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int roundRobinLoadBalancer(SIMULATION_STATE *state)
+{
+	int serverID;  // Stores ID of the chosen server
+
+	serverID = (int) (state->Dispatcher->RoundRobinServerIDCounter % state->ActiveServers);
+	state->Dispatcher->RoundRobinServerIDCounter++;
+
+	return(serverID);
+}
+
+//===========================================================================
+//=  This is an Up-to-Date Shortest Queue Load Balancer. It chooses the     =
+//=  shortest queue according to the real queue lengths. The ServerIndex is =
+//=  updated on every arrival and departure, so the decision does not scan  =
+//=  the servers. If several servers have the same queue length which is    =
+//=  also the minimum queue length, one of them is chosen uniformly at      =
+//=  random with a single random number.                                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int shortestQueueLoadBalancer(SIMULATION_STATE *state)
+{
+	return(queueIndexPickShortest(&state->ServerIndex, &state->Random[decisionStream]));
+}
+
+//===========================================================================
+//=  This is a Stale Shortest Queue Load Balancer. It chooses the shortest  =
+//=  queue according to the information which is updated by the             =
+//=  updateInformation function every StalePeriod time. The StaleIndex of   =
+//=  the dispatcher is rebuilt together with its QueueLength array.         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int shortestQueueStaleLoadBalancer(SIMULATION_STATE *state)
+{
+	return(queueIndexPickShortest(&state->Dispatcher->StaleIndex, &state->Random[decisionStream]));
+}
+
+//===========================================================================
+//=  This is an Improved Load Balancer. It uses stale information but also  =
+//=  increments the length of the server's queue each time it schedules     =
+//=  the customer for this server. The updateInformation function writes    =
+//=  the new information over the history written by the load balancer.     =
+//=  Every dispatcher counts only its own customers.                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer, =
+//=           -1 if there is not enough memory                              =
+//===========================================================================
+int improvedLoadBalancer(SIMULATION_STATE *state)
+{
+	DISPATCHER *dispatcher = state->Dispatcher;  // Current dispatcher
+	int         shortestQueueServerID;           // The ID of the chosen server is stored here
+
+	shortestQueueServerID = queueIndexPickShortest(&dispatcher->StaleIndex, &state->Random[decisionStream]);
+
+	// Keep the history by incrementing the length of the server's queue
+	// every time we schedule the customer for this server.
+	dispatcher->QueueLength[shortestQueueServerID]++;
+	if (queueIndexIncrement(&dispatcher->StaleIndex, shortestQueueServerID) != 0)
+	{
+		return(-1);
+	}
+
+	return(shortestQueueServerID);
+}
+
+//===========================================================================
+//=  This is a Power-of-d Choices Load Balancer, JSQ(d). It samples         =
+//=  SampleSize servers at random and chooses the one with the shortest     =
+//=  queue. The sample is in random order, so taking the first of several   =
+//=  shortest queues is a uniform tie-breaking. Only SampleSize servers are =
+//=  looked at per decision.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int powerOfDLoadBalancer(SIMULATION_STATE *state)
+{
+	int count;                  // Number of sampled servers
+	int shortestQueueServerID;  // The ID of the chosen server is stored here
+	int i;                      // Sample counter
+
+	count = sampleServers(state, state->Config.SampleSize);
+
+	shortestQueueServerID = state->ProbeServerIDs[0];
+	for (i = 1; i < count; i++)
+	{
+		if (state->Servers[state->ProbeServerIDs[i]].Count < state->Servers[shortestQueueServerID].Count)
+		{
+			shortestQueueServerID = state->ProbeServerIDs[i];
+		}
+	}
+
+	return(shortestQueueServerID);
+}
+
+//===========================================================================
+//=  This is a Join-Idle-Queue Load Balancer. A server which becomes idle   =
+//=  leaves a token at one dispatcher (see releaseServer). A customer       =
+//=  goes to the server of the oldest token. If there are no tokens, the    =
+//=  customer goes to a random server. The load balancer does not look at   =
+//=  the queues at all. Tokens of servers which the autoscaler has drained  =
+//=  since are thrown away.                                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int joinIdleQueueLoadBalancer(SIMULATION_STATE *state)
+{
+	DISPATCHER *dispatcher = state->Dispatcher;  // Current dispatcher
+	int         serverID;                        // Stores ID of the chosen server
+
+	// Take the oldest token of an active server
+	while (dispatcher->IdleCount > 0)
+	{
+		serverID = dispatcher->IdleTokens[dispatcher->IdleHead];
+		dispatcher->IdleHead = (dispatcher->IdleHead + 1) % state->Config.NumberOfServers;
+		dispatcher->IdleCount--;
+		state->HasIdleToken[serverID] = 0;
+		if (serverID < state->ActiveServers)
+		{
+			return(serverID);
+		}
+	}
+
+	return(randomLoadBalancer(state));
+}
+
+//===========================================================================
+//=  This is a Batch Sampling Load Balancer. For a batch of customers it    =
+//=  samples SampleSize * batchSize servers and places the customers one by =
+//=  one on the sampled server with the least load, where the load counts   =
+//=  the customers of this batch already placed there. So the batch goes to =
+//=  the least loaded of the sampled servers.                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - simulation state                                   =
+//=          serverIDs - place to store the server of each customer         =
+//=          batchSize - number of customers in the batch                   =
+//=  Returns: None                                                          =
+//===========================================================================
+void batchSamplingLoadBalancer(SIMULATION_STATE *state, int *serverIDs, int batchSize)
+{
+	int count;  // Number of sampled servers
+	int best;   // Sample with the least load
+	int i;      // Customer counter
+	int j;      // Sample counter
+
+	count = sampleServers(state, state->Config.SampleSize * batchSize);
+	for (j = 0; j < count; j++)
+	{
+		state->ProbeLoad[j] = state->Servers[state->ProbeServerIDs[j]].Count;
+	}
+
+	for (i = 0; i < batchSize; i++)
+	{
+		best = 0;
+		for (j = 1; j < count; j++)
+		{
+			if (state->ProbeLoad[j] < state->ProbeLoad[best])
+			{
+				best = j;
+			}
+		}
+		serverIDs[i] = state->ProbeServerIDs[best];
+		state->ProbeLoad[best]++;
+	}
+}
+
+//===========================================================================
+//=  This is a Predictive Load Balancer. It keeps the time when each server =
+//=  is expected to become idle: a report of L customers sets it to L       =
+//=  service times after the report, and each own dispatch adds one more    =
+//=  service time. So the predicted backlog drains at the service rate of   =
+//=  the server between the reports instead of staying at the reported      =
+//=  length, and faster servers drain faster. The backlog is negative for a =
+//=  server which is expected to be idle for a while, so such a server is   =
+//=  preferred. The prediction gets less certain with the age of the        =
+//=  report: the number of services since then has the standard deviation   =
+//=  sqrt(rate * age). Each backlog is perturbed uniformly                  =
+//=  by PredictionNoise such deviations, so old reports give a more random  =
+//=  choice and the customers do not herd to the same server. Every         =
+//=  dispatcher predicts from its own reports and its own customers.        =
+//=  Without noise the least backlog is the earliest EmptyClock, so with    =
+//=  HEAP_SERVERS or more the dispatcher takes the top of its EmptyHeap in  =
+//=  O(log N) instead of scanning the servers. Servers with the same least  =
+//=  backlog, such as the idle servers of one snapshot, are ordered by      =
+//=  their random ranks in the heap, so the scan and the heap choose the    =
+//=  same one of them uniformly at random.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int predictiveLoadBalancer(SIMULATION_STATE *state)
+{
+	SERVER_HEAP        *heap = &state->Dispatcher->EmptyHeap;          // Heap of the predicted ends with their ranks
+	unsigned long long  rank;                                          // Rank of the current server
+	unsigned long long  bestRank = 0;                                  // Rank of the server with the least backlog
+	double              mu = state->Config.Mu;                         // Service rate of a server of the mean speed
+	double             *speed = state->Speed;                          // Speed of each server
+	double              noise = state->Config.PredictionNoise;         // Perturbation in standard deviations
+	double             *emptyClock = state->Dispatcher->EmptyClock;    // Predicted ends of the busy periods
+	double             *reportClock = state->Dispatcher->ReportClock;  // Times of the last reports
+	double              backlog;                                       // Predicted backlog of the current server
+	double              bestBacklog = 0.0;                             // Least predicted backlog
+	int                 serverID = 0;                                  // Server with the least predicted backlog
+	int                 i;                                             // Server counter
+
+	if (usesEmptyHeap(&state->Config))
+	{
+		serverID = serverHeapTop(heap);
+		emptyClock[serverID] = (emptyClock[serverID] > state->Clock) ? emptyClock[serverID] : state->Clock;
+		emptyClock[serverID] += 1.0 / (mu * speed[serverID]);
+		serverHeapUpdate(heap, serverID);
+		return(serverID);
+	}
+
+	for (i = 0; i < state->ActiveServers; i++)
+	{
+		backlog = mu * (emptyClock[i] - state->Clock);
+		if (noise > 0.0)
+		{
+			backlog += noise * sqrt(mu * speed[i] * (state->Clock - reportClock[i])) / speed[i] *
+				randomUniform(&state->Random[decisionStream], -1.0, 1.0);
+		}
+		if ((i == 0) || (backlog < bestBacklog))
+		{
+			bestBacklog = backlog;
+			bestRank = serverHeapRank(heap, i);
+			serverID = i;
+		}
+		else if ((backlog == bestBacklog) && ((rank = serverHeapRank(heap, i)) < bestRank))
+		{
+			bestRank = rank;
+			serverID = i;
+		}
+	}
+
+	// The customer extends the predicted busy period of the server
+	if (emptyClock[serverID] < state->Clock)
+	{
+		emptyClock[serverID] = state->Clock;
+	}
+	emptyClock[serverID] += 1.0 / (mu * speed[serverID]);
+
+	return(serverID);
+}
+
+//===========================================================================
+//=  This is a Speed-Aware Shortest Queue Load Balancer. It chooses the     =
+//=  server with the least expected wait (queue length + 1) / speed on the  =
+//=  real queue lengths, so a fast server gets a longer queue than a slow   =
+//=  one. The SpeedIndex keeps the servers of every speed sorted, so the    =
+//=  decision looks at one queue per speed.                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int speedShortestQueueLoadBalancer(SIMULATION_STATE *state)
+{
+	return(speedIndexPickFastest(&state->SpeedIndex, &state->Random[decisionStream]));
+}
+
+//===========================================================================
+//=  This is a Speed-Aware Stale Shortest Queue Load Balancer. It chooses   =
+//=  the least expected wait according to the reported queue lengths of     =
+//=  the dispatcher.                                                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int speedShortestQueueStaleLoadBalancer(SIMULATION_STATE *state)
+{
+	return(speedIndexPickFastest(&state->Dispatcher->StaleSpeedIndex, &state->Random[decisionStream]));
+}
+
+//===========================================================================
+//=  This is a Speed-Aware Improved Load Balancer. It counts its own        =
+//=  dispatches like the Improved balancer but chooses the least expected   =
+//=  wait instead of the shortest queue.                                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer, =
+//=           -1 if there is not enough memory                              =
+//===========================================================================
+int speedImprovedLoadBalancer(SIMULATION_STATE *state)
+{
+	DISPATCHER *dispatcher = state->Dispatcher;  // Current dispatcher
+	int         serverID;                        // The ID of the chosen server is stored here
+
+	serverID = speedIndexPickFastest(&dispatcher->StaleSpeedIndex, &state->Random[decisionStream]);
+
+	dispatcher->QueueLength[serverID]++;
+	if (speedIndexIncrement(&dispatcher->StaleSpeedIndex, serverID) != 0)
+	{
+		return(-1);
+	}
+
+	return(serverID);
+}
+
+//===========================================================================
+//=  This is a Speed-Aware Power-of-d Choices Load Balancer. It samples     =
+//=  SampleSize servers like JSQ(d) and chooses the least expected wait     =
+//=  (queue length + 1) / speed among them. The waits are compared as       =
+//=  cross products, so the decision needs no division.                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: serverID - ID of the server which is chosen for the customer  =
+//===========================================================================
+int speedPowerOfDLoadBalancer(SIMULATION_STATE *state)
+{
+	double *speed = state->Speed;  // Speed of each server
+	int     count;                 // Number of sampled servers
+	int     bestServerID;          // The ID of the chosen server is stored here
+	int     serverID;              // Current sampled server
+	int     i;                     // Sample counter
+
+	count = sampleServers(state, state->Config.SampleSize);
+
+	bestServerID = state->ProbeServerIDs[0];
+	for (i = 1; i < count; i++)
+	{
+		serverID = state->ProbeServerIDs[i];
+		if ((state->Servers[serverID].Count + 1) * speed[bestServerID] <
+			(state->Servers[bestServerID].Count + 1) * speed[serverID])
+		{
+			bestServerID = serverID;
+		}
+	}
+
+	return(bestServerID);
+}
@@ -0,0 +1,22 @@
+#ifndef LOAD_BALANCERS_H
+#define LOAD_BALANCERS_H
+
+//----- Includes --------------------------------------------------------------
+#include "StandaloneModel.h"  // Simulation state
+
+//----- Prototypes ------------------------------------------------------------
+int randomLoadBalancer(SIMULATION_STATE *state);
+int roundRobinLoadBalancer(SIMULATION_STATE *state);
+int shortestQueueLoadBalancer(SIMULATION_STATE *state);
+int shortestQueueStaleLoadBalancer(SIMULATION_STATE *state);
+int improvedLoadBalancer(SIMULATION_STATE *state);
+int powerOfDLoadBalancer(SIMULATION_STATE *state);
+int joinIdleQueueLoadBalancer(SIMULATION_STATE *state);
+void batchSamplingLoadBalancer(SIMULATION_STATE *state, int *serverIDs, int batchSize);
+int predictiveLoadBalancer(SIMULATION_STATE *state);
+int speedShortestQueueLoadBalancer(SIMULATION_STATE *state);
+int speedShortestQueueStaleLoadBalancer(SIMULATION_STATE *state);
+int speedImprovedLoadBalancer(SIMULATION_STATE *state);
+int speedPowerOfDLoadBalancer(SIMULATION_STATE *state);
+
+#endif
@@ -0,0 +1,294 @@
+//----- Includes --------------------------------------------------------------
+#include <stdatomic.h>  // Needed for the ring positions and the barrier
+#include <stdlib.h>     // Needed for aligned_alloc(), realloc() and free()
+#include <string.h>     // Needed for memset() and memmove()
+#include <sched.h>      // Needed for sched_yield()
+#include "Mailboxes.h"  // Mailbox types and prototypes
+
+//------New types--------------------------------------------------------------
+typedef struct  // Mailbox of one sender and one receiver. A lock-free ring with a single producer and a single consumer
+{
+	MESSAGE *Slots;                                // Ring of MAILBOX_CAPACITY messages
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t Tail;  // Messages written so far. Only the sender writes this line
+	size_t   CachedHead;                           // Head seen by the sender at its last look
+	long long Stalls;                              // Messages which have found the ring full
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t Head;  // Messages taken so far. Only the receiver writes this line
+	MESSAGE *Kept;                                 // Messages taken from the ring and not received yet, in order
+	int      KeptHead;                             // Index of the oldest kept message
+	int      KeptCount;                            // Number of kept messages
+	int      KeptCapacity;                         // Allocated kept messages
+} MAILBOX;
+
+struct MAILBOXES  // Mailboxes between every pair of shards and a barrier of the shards
+{
+	int      NumberOfShards;                            // Number of shards
+	MAILBOX *Boxes;                                     // Mailbox of each sender and receiver, sender by sender
+	_Alignas(CACHE_LINE_SIZE) atomic_int Arrived;       // Shards which have reached the barrier
+	_Alignas(CACHE_LINE_SIZE) atomic_int Generation;    // Times every shard has passed the barrier
+	_Alignas(CACHE_LINE_SIZE) atomic_int Failed;        // Whether a receiver could not keep its messages
+};
+
+//===========================================================================
+//=  This function allocates the mailboxes of every sender and receiver,    =
+//=  the mailbox of a shard to itself included, and the barrier.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: numberOfShards - number of shards                              =
+//=  Returns: mailboxes, NULL on error                                      =
+//===========================================================================
+MAILBOXES *mailboxesCreate(int numberOfShards)
+{
+	MAILBOXES *mailboxes;  // New mailboxes
+	int        i;          // Mailbox counter
+
+	if (numberOfShards < 1)
+	{
+		return(NULL);
+	}
+
+	mailboxes = (MAILBOXES *) aligned_alloc(CACHE_LINE_SIZE, sizeof(MAILBOXES));
+	if (mailboxes == NULL)
+	{
+		return(NULL);
+	}
+	memset(mailboxes, 0, sizeof(MAILBOXES));
+	mailboxes->NumberOfShards = numberOfShards;
+	atomic_init(&mailboxes->Arrived, 0);
+	atomic_init(&mailboxes->Generation, 0);
+	atomic_init(&mailboxes->Failed, 0);
+	mailboxes->Boxes = (MAILBOX *) aligned_alloc(CACHE_LINE_SIZE,
+		sizeof(MAILBOX) * numberOfShards * numberOfShards);
+	if (mailboxes->Boxes == NULL)
+	{
+		free(mailboxes);
+		return(NULL);
+	}
+	memset(mailboxes->Boxes, 0, sizeof(MAILBOX) * numberOfShards * numberOfShards);
+
+	for (i = 0; i < numberOfShards * numberOfShards; i++)
+	{
+		atomic_init(&mailboxes->Boxes[i].Tail, 0);
+		atomic_init(&mailboxes->Boxes[i].Head, 0);
+		mailboxes->Boxes[i].Slots = (MESSAGE *) malloc(sizeof(MESSAGE) * MAILBOX_CAPACITY);
+		if (mailboxes->Boxes[i].Slots == NULL)
+		{
+			mailboxesFree(mailboxes);
+			return(NULL);
+		}
+	}
+
+	return(mailboxes);
+}
+
+//===========================================================================
+//=  This function frees the mailboxes. No shard may use them any more.     =
+//===========================================================================
+void mailboxesFree(MAILBOXES *mailboxes)
+{
+	int i;  // Mailbox counter
+
+	if (mailboxes == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < mailboxes->NumberOfShards * mailboxes->NumberOfShards; i++)
+	{
+		free(mailboxes->Boxes[i].Slots);
+		free(mailboxes->Boxes[i].Kept);
+	}
+	free(mailboxes->Boxes);
+	free(mailboxes);
+}
+
+//===========================================================================
+//=  This function takes every message of the rings of the receiver and     =
+//=  keeps it until it is received, so the senders find room again. Only    =
+//=  the receiver may call it. The messages of a window are only received   =
+//=  after the next barrier, so a sender which waited for the receiver to   =
+//=  receive them would never reach it. Instead the receiver keeps at most  =
+//=  MAILBOX_KEPT messages of every sender. Beyond that the mailboxes fail, =
+//=  and the senders stop waiting for the receiver.                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: mailboxes - mailboxes                                          =
+//=          receiver  - shard whose mailboxes are emptied                  =
+//=  Returns: 0 on success, -1 if the messages are too many or there is not =
+//=           enough memory                                                 =
+//===========================================================================
+int mailboxesCollect(MAILBOXES *mailboxes, int receiver)
+{
+	MAILBOX *box;          // Current mailbox
+	MESSAGE *newKept;      // Reallocated kept messages
+	size_t   head;         // Messages taken from the ring
+	size_t   tail;         // Messages written to the ring
+	int      count;        // Messages in the ring
+	int      newCapacity;  // Capacity of the reallocated kept messages
+	int      sender;       // Sender counter
+
+	for (sender = 0; sender < mailboxes->NumberOfShards; sender++)
+	{
+		box = &mailboxes->Boxes[sender * mailboxes->NumberOfShards + receiver];
+		head = atomic_load_explicit(&box->Head, memory_order_relaxed);
+		tail = atomic_load_explicit(&box->Tail, memory_order_acquire);
+		count = (int) (tail - head);
+		if (count == 0)
+		{
+			continue;
+		}
+
+		if (box->KeptHead + box->KeptCount + count > box->KeptCapacity)
+		{
+			memmove(box->Kept, box->Kept + box->KeptHead, sizeof(MESSAGE) * box->KeptCount);
+			box->KeptHead = 0;
+		}
+		if (box->KeptCount + count > MAILBOX_KEPT)
+		{
+			atomic_store_explicit(&mailboxes->Failed, 1, memory_order_release);
+			return(-1);
+		}
+		if (box->KeptCount + count > box->KeptCapacity)
+		{
+			newCapacity = (box->KeptCapacity == 0) ? MAILBOX_CAPACITY : 2 * box->KeptCapacity;
+			while (box->KeptCount + count > newCapacity)
+			{
+				newCapacity *= 2;
+			}
+			newCapacity = (newCapacity < MAILBOX_KEPT) ? newCapacity : MAILBOX_KEPT;
+			newKept = (MESSAGE *) realloc(box->Kept, sizeof(MESSAGE) * newCapacity);
+			if (newKept == NULL)
+			{
+				atomic_store_explicit(&mailboxes->Failed, 1, memory_order_release);
+				return(-1);
+			}
+			box->Kept = newKept;
+			box->KeptCapacity = newCapacity;
+		}
+
+		for (; head != tail; head++)
+		{
+			box->Kept[box->KeptHead + box->KeptCount++] = box->Slots[head & (MAILBOX_CAPACITY - 1)];
+		}
+		atomic_store_explicit(&box->Head, head, memory_order_release);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function puts a message into the mailbox of the sender and the    =
+//=  receiver. It takes no locks. When the ring is full, the message counts =
+//=  as a stall and the sender waits for the receiver to collect its        =
+//=  messages. Meanwhile the sender collects its own mailboxes, so two      =
+//=  shards which send to each other cannot wait for each other forever.    =
+//=  It stops waiting when the mailboxes have failed.                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: mailboxes - mailboxes                                          =
+//=          sender    - shard which sends the message, the calling one     =
+//=          receiver  - shard which receives the message                   =
+//=          message   - message                                            =
+//=  Returns: 0 on success, -1 if the mailboxes have failed                 =
+//===========================================================================
+int mailboxSend(MAILBOXES *mailboxes, int sender, int receiver, const MESSAGE *message)
+{
+	MAILBOX *box;   // Mailbox of the sender and the receiver
+	size_t   tail;  // Messages written to the ring
+
+	box = &mailboxes->Boxes[sender * mailboxes->NumberOfShards + receiver];
+	tail = atomic_load_explicit(&box->Tail, memory_order_relaxed);
+	if (tail - box->CachedHead == MAILBOX_CAPACITY)
+	{
+		box->CachedHead = atomic_load_explicit(&box->Head, memory_order_acquire);
+		if (tail - box->CachedHead == MAILBOX_CAPACITY)
+		{
+			box->Stalls++;
+		}
+		while (tail - box->CachedHead == MAILBOX_CAPACITY)
+		{
+			if ((mailboxesCollect(mailboxes, sender) != 0) ||
+				atomic_load_explicit(&mailboxes->Failed, memory_order_acquire))
+			{
+				return(-1);
+			}
+			sched_yield();
+			box->CachedHead = atomic_load_explicit(&box->Head, memory_order_acquire);
+		}
+	}
+
+	box->Slots[tail & (MAILBOX_CAPACITY - 1)] = *message;
+	atomic_store_explicit(&box->Tail, tail + 1, memory_order_release);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function returns the oldest collected message of the sender to    =
+//=  the receiver, NULL if there is none. Only the receiver may call it.    =
+//===========================================================================
+const MESSAGE *mailboxPeek(const MAILBOXES *mailboxes, int receiver, int sender)
+{
+	const MAILBOX *box = &mailboxes->Boxes[sender * mailboxes->NumberOfShards + receiver];  // Mailbox
+
+	return((box->KeptCount > 0) ? &box->Kept[box->KeptHead] : NULL);
+}
+
+//===========================================================================
+//=  This function removes the message returned by mailboxPeek().           =
+//===========================================================================
+void mailboxPop(MAILBOXES *mailboxes, int receiver, int sender)
+{
+	MAILBOX *box = &mailboxes->Boxes[sender * mailboxes->NumberOfShards + receiver];  // Mailbox
+
+	box->KeptCount--;
+	box->KeptHead = (box->KeptCount > 0) ? box->KeptHead + 1 : 0;
+}
+
+//===========================================================================
+//=  This function waits until every shard has called it. The release and   =
+//=  acquire of the barrier make everything a shard has written before it   =
+//=  visible to the others after it. While waiting, the shard collects its  =
+//=  mailboxes, so no sender waits for a full ring of a waiting shard.      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: mailboxes - mailboxes                                          =
+//=          shard     - calling shard                                      =
+//=  Returns: 0 on success, -1 if the mailboxes have failed                 =
+//===========================================================================
+int mailboxesWait(MAILBOXES *mailboxes, int shard)
+{
+	int generation;  // Generation of the barrier when the shard has arrived
+	int result = 0;  // Return value
+
+	generation = atomic_load_explicit(&mailboxes->Generation, memory_order_acquire);
+	if (atomic_fetch_add_explicit(&mailboxes->Arrived, 1, memory_order_acq_rel) == mailboxes->NumberOfShards - 1)
+	{
+		atomic_store_explicit(&mailboxes->Arrived, 0, memory_order_relaxed);
+		atomic_fetch_add_explicit(&mailboxes->Generation, 1, memory_order_release);
+		return(result);
+	}
+
+	while (atomic_load_explicit(&mailboxes->Generation, memory_order_acquire) == generation)
+	{
+		if (mailboxesCollect(mailboxes, shard) != 0)
+		{
+			result = -1;
+		}
+		sched_yield();
+	}
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function returns the number of messages of the sender which have  =
+//=  found a ring full. It may only be called when the sender has stopped.  =
+//===========================================================================
+long long mailboxStalls(const MAILBOXES *mailboxes, int sender)
+{
+	long long stalls = 0;  // Sum of the stalls
+	int       receiver;    // Receiver counter
+
+	for (receiver = 0; receiver < mailboxes->NumberOfShards; receiver++)
+	{
+		stalls += mailboxes->Boxes[sender * mailboxes->NumberOfShards + receiver].Stalls;
+	}
+
+	return(stalls);
+}
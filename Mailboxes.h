@@ -0,0 +1,41 @@
+#ifndef MAILBOXES_H
+#define MAILBOXES_H
+
+//----- Constants -------------------------------------------------------------
+#define CACHE_LINE_SIZE  64    // Bytes of a cache line. The sender and the receiver of a mailbox use their own lines
+#define MAILBOX_CAPACITY 1024  // Messages in the ring of one mailbox. Power of two
+#define MAILBOX_KEPT     65536  // Messages of one sender which the receiver keeps at most until the next window
+
+//------New types--------------------------------------------------------------
+enum MESSAGE_TYPE  // What a message carries
+{
+	customerMessage,  // Customer on the way from its dispatcher to the chosen server
+	reportMessage     // Queue length on the way from a server to a dispatcher
+};
+
+typedef struct  // Customer or load report which goes from one shard of a parallel run to another
+{
+	double Time;         // Arrival time of the customer, or delivery time of the report
+	double ServiceTime;  // Service demand of the customer
+	double ReportClock;  // Clock of the last report of the chosen server at the dispatcher of the customer
+	int    Type;         // Message type from enum MESSAGE_TYPE
+	int    ServerID;     // Server chosen for the customer, or reporting server
+	int    Dispatcher;   // Dispatcher of the customer, or receiver of the report
+	int    Class;        // Request class of the customer
+	int    Length;       // Reported queue length
+} MESSAGE;
+
+// Mailboxes between every pair of shards. The rings are atomics, so they are only seen through the functions below
+typedef struct MAILBOXES MAILBOXES;
+
+//----- Prototypes ------------------------------------------------------------
+MAILBOXES     *mailboxesCreate(int numberOfShards);
+void           mailboxesFree(MAILBOXES *mailboxes);
+int            mailboxSend(MAILBOXES *mailboxes, int sender, int receiver, const MESSAGE *message);
+int            mailboxesCollect(MAILBOXES *mailboxes, int receiver);
+const MESSAGE *mailboxPeek(const MAILBOXES *mailboxes, int receiver, int sender);
+void           mailboxPop(MAILBOXES *mailboxes, int receiver, int sender);
+int            mailboxesWait(MAILBOXES *mailboxes, int shard);
+long long      mailboxStalls(const MAILBOXES *mailboxes, int sender);
+
+#endif
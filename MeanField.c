@@ -0,0 +1,1261 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>          // Needed for I/O functions
+#include <stdlib.h>         // Needed for calloc() and free()
+#include <string.h>         // Needed for memset() and memcpy()
+#include <math.h>           // Needed for pow(), exp(), log(), lgamma() and fabs()
+#include "MeanField.h"      // Mean-field types and prototypes
+#include "Replications.h"   // Needed for wallClock()
+
+//----- Constants -------------------------------------------------------------
+#define MEAN_FIELD_TOLERANCE     1e-10  // Largest derivative of a steady state, in customers per mean service time
+#define MEAN_FIELD_STEP          0.02   // Largest probability of an event of a server in one step of the integration
+#define MEAN_FIELD_TAIL          1e-6   // Fraction of the servers at the longest queue which makes it too short
+#define MEAN_FIELD_NEGLIGIBLE    1e-30  // Fraction of the servers below which a longer queue is not integrated yet
+#define STALE_TOLERANCE          1e-7   // Largest relative change of the mean queue length of a settled period
+#define MAX_STALE_PERIODS        400    // Most snapshot periods of the stale models, which may not settle
+#define MAX_BINOMIAL_DISPATCHERS 16     // Most dispatchers of the binomial arrivals of Improved, more are Poisson
+#define POISSON_CHUNK            50.0   // Largest mean of one Poisson shift of the stale queues
+
+//===========================================================================
+//=  This function checks whether all servers have the same speed.          =
+//===========================================================================
+static int equalSpeeds(const SIMULATION_CONFIG *config)
+{
+	int i;  // Speed counter
+
+	for (i = 1; i < config->NumberOfSpeeds; i++)
+	{
+		if (config->Speeds[i] != config->Speeds[0])
+		{
+			return(0);
+		}
+	}
+
+	return(1);
+}
+
+//===========================================================================
+//=  This function returns the squared coefficient of variation of the      =
+//=  service demands, -1 if it is infinite.                                 =
+//===========================================================================
+static double serviceVariation(const SIMULATION_CONFIG *config)
+{
+	double sum = 0.0;      // Sum of the empirical demands
+	double squares = 0.0;  // Sum of the squares of the empirical demands
+	int    i;              // Demand counter
+
+	switch (config->Service)
+	{
+	case exponentialService:
+		return(1.0);
+	case deterministicService:
+		return(0.0);
+	case hyperexponentialService:
+	case lognormalService:
+		return(config->ServiceVariation);
+	case paretoService:
+		return((config->ParetoShape > 2.0) ? 1.0 / (config->ParetoShape * (config->ParetoShape - 2.0)) : -1.0);
+	case empiricalService:
+		for (i = 0; i < config->EmpiricalCount; i++)
+		{
+			sum += config->EmpiricalValues[i];
+			squares += config->EmpiricalValues[i] * config->EmpiricalValues[i];
+		}
+		return(squares * config->EmpiricalCount / (sum * sum) - 1.0);
+	}
+
+	return(-1.0);
+}
+
+//===========================================================================
+//=  This function returns the longest queue of the mean-field states: the  =
+//=  capacity of the servers, or MEAN_FIELD_LENGTH if they are unbounded or =
+//=  admit more.                                                            =
+//===========================================================================
+static int queueLimit(const SIMULATION_CONFIG *config)
+{
+	return(((config->QueueCapacity > 0) && (config->QueueCapacity <= MEAN_FIELD_LENGTH)) ?
+		config->QueueCapacity : MEAN_FIELD_LENGTH);
+}
+
+//===========================================================================
+//=  This function raises x to a small positive integer power by squaring.  =
+//===========================================================================
+static double power(double x, int d)
+{
+	double result = 1.0;  // Product so far
+
+	while (d > 0)
+	{
+		if (d & 1)
+		{
+			result *= x;
+		}
+		x *= x;
+		d >>= 1;
+	}
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function returns the probability that the response time is longer =
+//=  than t. A customer who finds k customers at a server of rate mu leaves =
+//=  after k + 1 exponential services, so the response time is a mixture of =
+//=  Erlang distributions weighted by JoinLengths.                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: result - mean field with JoinLengths                           =
+//=          mu     - service rate of a server                              =
+//=          t      - response time                                         =
+//=  Returns: probability that the response time is longer than t           =
+//===========================================================================
+static double responseTail(const MEAN_FIELD_RESULT *result, double mu, double t)
+{
+	double x = mu * t;  // Mean number of services completed in t
+	double cdf = 0.0;   // Probability of at most k services in t
+	double tail = 0.0;  // Probability of the response time longer than t
+	int    k;           // Customers found by the arriving customer
+
+	if (x <= 0.0)
+	{
+		return(1.0);
+	}
+
+	for (k = 0; k < result->Length; k++)
+	{
+		cdf += exp(-x + k * log(x) - lgamma(k + 1.0));
+		tail += result->JoinLengths[k] * ((cdf < 1.0) ? cdf : 1.0);
+	}
+
+	return(tail);
+}
+
+//===========================================================================
+//=  This function completes the result from the queue length distributions =
+//=  of a model with exponential services: the mean queue length, the mean  =
+//=  response time and its percentiles. A model whose longest queue is      =
+//=  reached by more than MEAN_FIELD_TAIL of the servers without a capacity =
+//=  to stop it is too short, so it is not converged.                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - mean field with QueueLengths and JoinLengths          =
+//=  Returns: None                                                          =
+//===========================================================================
+static void finishDistributions(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	static const double percentiles[3] = { 0.5, 0.99, 0.999 };  // Reported percentiles
+	double              joined = 0.0;                           // Sum of JoinLengths
+	double              low;                                    // Response time below the percentile
+	double              high;                                   // Response time above the percentile
+	double              middle;                                 // Middle of low and high
+	int                 i;                                      // Percentile counter
+	int                 k;                                      // Queue length counter
+
+	result->MeanQueueLength = 0.0;
+	for (k = 0; k <= result->Length; k++)
+	{
+		result->MeanQueueLength += k * result->QueueLengths[k];
+	}
+	for (k = 0; k < result->Length; k++)
+	{
+		joined += result->JoinLengths[k];
+	}
+	result->MeanResponseTime = 0.0;
+	for (k = 0; (k < result->Length) && (joined > 0.0); k++)
+	{
+		result->JoinLengths[k] /= joined;
+		result->MeanResponseTime += result->JoinLengths[k] * (k + 1) / config->Mu;
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		low = 0.0;
+		high = 1.0 / config->Mu;
+		for (k = 0; (k < 64) && (responseTail(result, config->Mu, high) > 1.0 - percentiles[i]); k++)
+		{
+			high *= 2.0;
+		}
+		for (k = 0; k < 60; k++)
+		{
+			middle = 0.5 * (low + high);
+			if (responseTail(result, config->Mu, middle) > 1.0 - percentiles[i])
+			{
+				low = middle;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		result->Percentiles[i] = 0.5 * (low + high);
+	}
+
+	if (((config->QueueCapacity == 0) || (config->QueueCapacity > MEAN_FIELD_LENGTH)) &&
+		(result->QueueLengths[result->Length] > MEAN_FIELD_TAIL))
+	{
+		result->Converged = 0;
+	}
+}
+
+//===========================================================================
+//=  Random balancer. Every server gets a Poisson stream of rate lambda / N =
+//=  whatever the number of dispatchers, so the model is exact for any N.   =
+//=  Exponential servers of one speed are M/M/1 queues with the capacity.   =
+//=  Otherwise every server is an M/G/1 queue of its own speed, and the     =
+//=  Pollaczek-Khinchine formula gives the mean response time only.         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if the model is unstable                     =
+//===========================================================================
+static int solveRandom(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	double lambda = config->Lambda / config->NumberOfServers;  // Arrival rate of a server
+	double rho = lambda / config->Mu;                          // Utilization of a server
+	double variation = serviceVariation(config);               // Squared coefficient of variation of the demands
+	double speedSum = 0.0;                                     // Sum of the speeds of all servers
+	double speed;                                              // Relative speed of the current server
+	double rate;                                               // Service rate of the current server
+	double weight = 1.0;                                       // Unnormalized probability of the current length
+	double sum = 0.0;                                          // Sum of the unnormalized probabilities
+	int    limit = queueLimit(config);                         // Longest queue
+	int    i;                                                  // Server counter
+	int    k;                                                  // Queue length counter
+
+	if ((config->Service == exponentialService) && equalSpeeds(config))
+	{
+		if ((config->QueueCapacity == 0) && (rho >= 1.0))
+		{
+			printf("ERROR! The utilization is at least 1, so the unbounded queues of %s grow forever\n",
+				balancerName(config->LoadBalancer));
+			return(-1);
+		}
+		for (k = 0; k <= limit; k++)
+		{
+			result->QueueLengths[k] = weight;
+			sum += weight;
+			weight *= rho;
+		}
+		for (k = 0; k <= limit; k++)
+		{
+			result->QueueLengths[k] /= sum;
+			result->JoinLengths[k] = (k < limit) ? result->QueueLengths[k] : 0.0;
+		}
+		result->LossRate = result->QueueLengths[limit];
+		result->Length = limit;
+		result->Method = "closed form, M/M/1 queues";
+		result->Exact = 1;
+		result->Converged = 1;
+		return(0);
+	}
+
+	if (variation < 0.0)
+	{
+		printf("ERROR! The service demands have an infinite variance, so the mean response time is infinite\n");
+		return(-1);
+	}
+	for (i = 0; i < config->NumberOfServers; i++)
+	{
+		speedSum += (config->NumberOfSpeeds > 0) ? config->Speeds[i % config->NumberOfSpeeds] : 1.0;
+	}
+	for (i = 0; i < config->NumberOfServers; i++)
+	{
+		speed = (config->NumberOfSpeeds > 0) ? config->Speeds[i % config->NumberOfSpeeds] : 1.0;
+		rate = config->Mu * speed * config->NumberOfServers / speedSum;
+		if (lambda >= rate)
+		{
+			printf("ERROR! Server %d gets more customers than it can serve\n", i);
+			return(-1);
+		}
+		result->MeanResponseTime += 1.0 / rate + lambda * (1.0 + variation) / (2.0 * rate * (rate - lambda));
+	}
+	result->MeanResponseTime /= config->NumberOfServers;
+	result->MeanQueueLength = lambda * result->MeanResponseTime;
+	result->Method = "closed form, M/G/1 queues (Pollaczek-Khinchine)";
+	result->Exact = (config->QueueCapacity == 0);
+	result->Converged = 1;
+
+	return(0);
+}
+
+//===========================================================================
+//=  Round Robin balancer. One dispatcher sends every N-th customer to a    =
+//=  server, so the server is an E_N/M/1 queue, exact for one dispatcher.   =
+//=  The streams of several dispatchers are merged with the superposition   =
+//=  rule of the Queueing Network Analyzer, and the merged stream is fitted =
+//=  by an Erlang distribution of the same variation. The customer finds a  =
+//=  geometric queue (1 - sigma) sigma^k, where sigma is the smallest root  =
+//=  of sigma = A*(mu (1 - sigma)) and A* is the transform of the           =
+//=  interarrival time.                                                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if the model is unstable                     =
+//===========================================================================
+static int solveRoundRobin(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	double lambda = config->Lambda / config->NumberOfServers;  // Arrival rate of a server
+	double rho = lambda / config->Mu;                          // Utilization of a server
+	double variation = 1.0 / config->NumberOfServers;          // Variation of the interarrivals of one dispatcher
+	double weight;                                             // Weight of the dispatchers in the superposition
+	double phaseRate;                                          // Rate of one Erlang phase of the interarrivals
+	double low = 0.0;                                          // Root is above
+	double high = 1.0 - 1e-12;                                 // Root is below
+	double sigma;                                              // Geometric ratio of the found queue lengths
+	int    dispatchers = config->DispatcherCount;              // Number of merged streams
+	int    phases;                                             // Erlang phases of the merged interarrivals
+	int    limit = queueLimit(config);                         // Longest queue
+	int    i;                                                  // Iteration counter
+	int    k;                                                  // Queue length counter
+
+	if (rho >= 1.0)
+	{
+		printf("ERROR! The mean field of %s needs a utilization below 1\n", balancerName(config->LoadBalancer));
+		return(-1);
+	}
+
+	if (dispatchers > 1)
+	{
+		weight = 1.0 / (1.0 + 4.0 * (1.0 - rho) * (1.0 - rho) * (dispatchers - 1));
+		variation = weight * variation + 1.0 - weight;
+	}
+	phases = (int) (1.0 / variation + 0.5);
+	phases = (phases < 1) ? 1 : phases;
+	phaseRate = phases * lambda;
+
+	for (i = 0; i < 200; i++)
+	{
+		sigma = 0.5 * (low + high);
+		if (pow(phaseRate / (phaseRate + config->Mu * (1.0 - sigma)), phases) > sigma)
+		{
+			low = sigma;
+		}
+		else
+		{
+			high = sigma;
+		}
+	}
+	sigma = 0.5 * (low + high);
+
+	result->QueueLengths[0] = 1.0 - rho;
+	for (k = 1; k <= limit; k++)
+	{
+		result->QueueLengths[k] = rho * (1.0 - sigma) * pow(sigma, k - 1);
+		result->JoinLengths[k - 1] = (1.0 - sigma) * pow(sigma, k - 1);
+	}
+	// The longest queue holds every longer one
+	result->QueueLengths[limit] = rho * pow(sigma, limit - 1);
+	result->LossRate = pow(sigma, limit);
+	result->Length = limit;
+	result->Method = "closed form, GI/M/1 queues with Erlang interarrivals";
+	result->Exact = (dispatchers == 1) && (config->QueueCapacity == 0);
+	result->Converged = 1;
+
+	return(0);
+}
+
+//===========================================================================
+//=  Up-to-Date Shortest Queue balancer. In the limit of many servers below =
+//=  the utilization 1 there is always an idle server, so every customer    =
+//=  is served at once and a fraction rho of the servers is busy with one   =
+//=  customer. Small systems queue more, the cross-check shows how much.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if the model is unstable                     =
+//===========================================================================
+static int solveShortestQueue(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	double rho = config->Lambda / (config->NumberOfServers * config->Mu);  // Utilization of a server
+
+	if (rho >= 1.0)
+	{
+		printf("ERROR! The mean field of %s needs a utilization below 1\n", balancerName(config->LoadBalancer));
+		return(-1);
+	}
+
+	result->QueueLengths[0] = 1.0 - rho;
+	result->QueueLengths[1] = rho;
+	result->JoinLengths[0] = 1.0;
+	result->Length = queueLimit(config);
+	result->Method = "fluid limit, every customer finds an idle server";
+	result->Converged = 1;
+
+	return(0);
+}
+
+//===========================================================================
+//=  Power-of-d Choices balancer. s_k is the fraction of the servers with   =
+//=  at least k customers. A customer joins a queue of k customers when the =
+//=  shortest of its d samples has k, so the mean field is                  =
+//=    ds_k/dt = lambda (s_{k-1}^d - s_k^d) - mu (s_k - s_{k+1}),           =
+//=  integrated from empty servers until no s_k changes faster than         =
+//=  MEAN_FIELD_TOLERANCE. Below capacity its fixed point is                =
+//=  s_k = rho^((d^k - 1) / (d - 1)).                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int solvePowerOfD(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	double  lambda = config->Lambda / config->NumberOfServers;  // Arrival rate of a server
+	double  step;                                               // Time step of the integration
+	double  startTime = wallClock();                            // Wall clock at the start
+	double *tails;                                              // s_k
+	double *powers;                                             // s_k^d
+	double  change;                                             // Derivative of the current s_k
+	int     d = config->SampleSize;                             // Sampled servers
+	int     limit = queueLimit(config);                         // Longest queue
+	int     active = 1;                                         // Longest queue with customers
+	int     k;                                                  // Queue length counter
+
+	tails = (double *) calloc(limit + 2, sizeof(double));
+	powers = (double *) calloc(limit + 2, sizeof(double));
+	if ((tails == NULL) || (powers == NULL))
+	{
+		printf("Not enough memory for the mean field\n");
+		free(tails);
+		free(powers);
+		return(-1);
+	}
+
+	tails[0] = 1.0;
+	step = MEAN_FIELD_STEP / (lambda * d + config->Mu);
+	result->Method = "ODE of the fraction of servers with at least k customers";
+	while (1)
+	{
+		for (k = 0; k <= active + 1; k++)
+		{
+			powers[k] = power(tails[k], d);
+		}
+		result->Residual = 0.0;
+		for (k = 1; k <= active; k++)
+		{
+			change = lambda * (powers[k - 1] - powers[k]) - config->Mu * (tails[k] - tails[k + 1]);
+			tails[k] += step * change;
+			result->Residual = (fabs(change) > result->Residual) ? fabs(change) : result->Residual;
+		}
+		if ((active < limit) && (tails[active] > MEAN_FIELD_NEGLIGIBLE))
+		{
+			active++;
+		}
+		result->Steps++;
+		result->Residual /= config->Mu;
+		if (result->Residual < MEAN_FIELD_TOLERANCE)
+		{
+			result->Converged = 1;
+			break;
+		}
+		if ((result->Steps % 65536 == 0) && (wallClock() - startTime > config->MaxTime))
+		{
+			break;
+		}
+	}
+	result->ModelTime = result->Steps * step;
+
+	for (k = 0; k <= limit; k++)
+	{
+		result->QueueLengths[k] = tails[k] - tails[k + 1];
+		result->JoinLengths[k] = (k < limit) ? power(tails[k], d) - power(tails[k + 1], d) : 0.0;
+	}
+	result->LossRate = power(tails[limit], d);
+	result->Length = limit;
+
+	free(tails);
+	free(powers);
+
+	return(0);
+}
+
+//===========================================================================
+//=  Join-Idle-Queue balancer. A server which becomes idle leaves a token   =
+//=  at one of M random dispatchers, and the token stays until a customer   =
+//=  takes it, even if a random customer has reached the server meanwhile.  =
+//=  T_k and U_k are the fractions of the servers with k customers with and =
+//=  without a token. The tokens of a dispatcher are taken to be geometric, =
+//=  so a dispatcher has none with the probability 1 / (1 + r T), where     =
+//=  r = N / M and T is the sum of T_k. A customer with a token goes to a   =
+//=  uniform token server, one without a token to a uniform server:         =
+//=    dT_k/dt = -lambda (1 - p0) T_k / T + lambda p0 (T_{k-1} - T_k)       =
+//=              + mu (T_{k+1} - T_k) + [k = 0] mu U_1                      =
+//=    dU_k/dt = lambda (1 - p0) T_{k-1} / T + lambda p0 (U_{k-1} - U_k)    =
+//=              + mu (U_{k+1} - U_k), where U_1 loses mu U_1 to T_0.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int solveJoinIdleQueue(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	double  lambda = config->Lambda / config->NumberOfServers;                // Arrival rate of a server
+	double  ratio = (double) config->NumberOfServers / config->DispatcherCount;  // Servers per dispatcher
+	double  mu = config->Mu;                                                  // Service rate of a server
+	double  startTime = wallClock();                                          // Wall clock at the start
+	double *tokens;                                                           // T_k
+	double *others;                                                           // U_k
+	double *tokenChanges;                                                     // Derivatives of T_k
+	double *otherChanges;                                                     // Derivatives of U_k
+	double  tokenSum;                                                         // T
+	double  empty;                                                            // p0
+	double  tokenRate;                                                        // Customers per token server
+	double  randomRate;                                                       // Random customers per server
+	double  step;                                                             // Time step of the integration
+	int     limit = queueLimit(config);                                       // Longest queue
+	int     active = 1;                                                       // Longest queue with customers
+	int     k;                                                                // Queue length counter
+
+	tokens = (double *) calloc(limit + 2, sizeof(double));
+	others = (double *) calloc(limit + 2, sizeof(double));
+	tokenChanges = (double *) calloc(limit + 2, sizeof(double));
+	otherChanges = (double *) calloc(limit + 2, sizeof(double));
+	if ((tokens == NULL) || (others == NULL) || (tokenChanges == NULL) || (otherChanges == NULL))
+	{
+		printf("Not enough memory for the mean field\n");
+		free(tokens);
+		free(others);
+		free(tokenChanges);
+		free(otherChanges);
+		return(-1);
+	}
+
+	tokens[0] = 1.0;
+	result->Method = "ODE of the servers with and without a token";
+	while (1)
+	{
+		tokenSum = 0.0;
+		for (k = 0; k <= active; k++)
+		{
+			tokenSum += tokens[k];
+		}
+		empty = 1.0 / (1.0 + ratio * tokenSum);
+		tokenRate = (tokenSum > 0.0) ? lambda * (1.0 - empty) / tokenSum : 0.0;
+		randomRate = lambda * empty;
+		step = MEAN_FIELD_STEP / (tokenRate + randomRate + mu);
+
+		result->Residual = 0.0;
+		for (k = 0; k <= active; k++)
+		{
+			tokenChanges[k] = -tokenRate * tokens[k] + ((k < limit) ? -randomRate * tokens[k] : 0.0) +
+				((k > 0) ? randomRate * tokens[k - 1] - mu * tokens[k] : mu * others[1]) +
+				((k < limit) ? mu * tokens[k + 1] : 0.0);
+			otherChanges[k] = (k == 0) ? 0.0 : tokenRate * tokens[k - 1] +
+				((k == limit) ? tokenRate * tokens[k] : -randomRate * others[k]) +
+				((k > 1) ? randomRate * others[k - 1] : 0.0) - mu * others[k] +
+				((k < limit) ? mu * others[k + 1] : 0.0);
+			result->Residual = (fabs(tokenChanges[k]) > result->Residual) ? fabs(tokenChanges[k]) : result->Residual;
+			result->Residual = (fabs(otherChanges[k]) > result->Residual) ? fabs(otherChanges[k]) : result->Residual;
+		}
+		for (k = 0; k <= active; k++)
+		{
+			tokens[k] += step * tokenChanges[k];
+			others[k] += step * otherChanges[k];
+		}
+		if ((active < limit) && (tokens[active] + others[active] > MEAN_FIELD_NEGLIGIBLE))
+		{
+			active++;
+		}
+		result->Steps++;
+		result->ModelTime += step;
+		result->Residual /= mu;
+		if (result->Residual < MEAN_FIELD_TOLERANCE)
+		{
+			result->Converged = 1;
+			break;
+		}
+		if ((result->Steps % 65536 == 0) && (wallClock() - startTime > config->MaxTime))
+		{
+			break;
+		}
+	}
+
+	for (k = 0; k <= limit; k++)
+	{
+		result->QueueLengths[k] = tokens[k] + others[k];
+		result->JoinLengths[k] = (k < limit) ? tokenRate * tokens[k] + randomRate * (tokens[k] + others[k]) : 0.0;
+	}
+	result->LossRate = (tokenRate * tokens[limit] + randomRate * (tokens[limit] + others[limit])) / lambda;
+	result->Length = limit;
+
+	free(tokens);
+	free(others);
+	free(tokenChanges);
+	free(otherChanges);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function gives every server of a row of the stale model a Poisson =
+//=  number of customers with the given mean, e.g. the customers of a time  =
+//=  step which go to the servers below the level. The found queue lengths  =
+//=  and the customers who find a full queue are counted.                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: row     - fractions of the servers by their real queue length  =
+//=          shifted - place for the shifted row                            =
+//=          top     - longest queue of the row with servers                =
+//=          limit   - longest queue                                        =
+//=          mean    - customers per server                                 =
+//=          joined  - counts of the customers by the found queue length    =
+//=          lost    - count of the customers who find a full queue         =
+//=  Returns: longest queue of the shifted row with servers                 =
+//===========================================================================
+static int shiftRow(double *row, double *shifted, int top, int limit, double mean, double *joined, double *lost)
+{
+	double none = exp(-mean);  // Probability of no customer
+	double probability;        // Probability of i customers
+	double below;              // Probability of less than i customers
+	double above;              // Probability of more than i customers
+	double found;              // Customers who find a queue below limit
+	int    longest = top;      // Longest queue of the shifted row
+	int    i;                  // Customers of the server
+	int    j;                  // Queue length before the customers
+
+	memset(shifted, 0, sizeof(double) * (limit + 1));
+	for (j = 0; j <= top; j++)
+	{
+		if (row[j] <= MEAN_FIELD_NEGLIGIBLE)
+		{
+			shifted[j] += row[j];
+			continue;
+		}
+		probability = none;
+		below = 0.0;
+		found = 0.0;
+		for (i = 0; j + i < limit; i++)
+		{
+			above = 1.0 - below - probability;
+			shifted[j + i] += row[j] * probability;
+			joined[j + i] += row[j] * above;
+			found += above;
+			below += probability;
+			probability *= mean / (i + 1);
+			if (above < 1e-16)
+			{
+				break;
+			}
+		}
+		if (j + i >= limit)
+		{
+			shifted[limit] += row[j] * (1.0 - below);
+			*lost += row[j] * (mean - found);
+		}
+		longest = (j + i > longest) ? ((j + i < limit) ? j + i : limit) : longest;
+	}
+	memcpy(row, shifted, sizeof(double) * (longest + 1));
+
+	return(longest);
+}
+
+//===========================================================================
+//=  This function gives the servers of a row of the stale model a          =
+//=  binomial number of the n customers which each of them still gets in    =
+//=  the current level. A server which gets k customers moves k rows on,    =
+//=  as the row is the number of customers got in the level. The found      =
+//=  queue lengths and the customers who find a full queue are counted.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: row     - fractions of the servers by their real queue length, =
+//=                    followed by the rows of more customers got           =
+//=          width   - length of a row                                      =
+//=          tops    - longest queue with servers of the row and the next   =
+//=          limit   - longest queue                                        =
+//=          n       - customers each server still gets in the level        =
+//=          chance  - probability of each of them to come in this step     =
+//=          joined  - counts of the customers by the found queue length    =
+//=          lost    - count of the customers who find a full queue         =
+//=  Returns: None                                                          =
+//===========================================================================
+static void binomialRow(double *row, int width, int *tops, int limit, int n, double chance, double *joined,
+	double *lost)
+{
+	double probabilities[MAX_BINOMIAL_DISPATCHERS + 1];  // Probability of k customers
+	double above[MAX_BINOMIAL_DISPATCHERS + 1];          // Probability of more than k customers
+	double mass;                                         // Fraction of the servers of the current queue length
+	int    target;                                       // Queue length after k customers
+	int    k;                                            // Customers of the server
+	int    j;                                            // Queue length before the customers
+
+	for (k = 0; k <= n; k++)
+	{
+		probabilities[k] = (chance < 1.0) ? exp(lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0) +
+			k * log(chance) + (n - k) * log(1.0 - chance)) : ((k == n) ? 1.0 : 0.0);
+	}
+	above[n] = 0.0;
+	for (k = n - 1; k >= 0; k--)
+	{
+		above[k] = above[k + 1] + probabilities[k + 1];
+	}
+
+	for (j = 0; j <= tops[0]; j++)
+	{
+		mass = row[j];
+		if (mass <= MEAN_FIELD_NEGLIGIBLE)
+		{
+			continue;
+		}
+		row[j] = mass * probabilities[0];
+		for (k = 1; k <= n; k++)
+		{
+			target = (j + k < limit) ? j + k : limit;
+			row[k * width + target] += mass * probabilities[k];
+			tops[k] = (target > tops[k]) ? target : tops[k];
+		}
+		for (k = 0; k < n; k++)
+		{
+			if (j + k < limit)
+			{
+				joined[j + k] += mass * above[k];
+			}
+			else
+			{
+				*lost += mass * above[k];
+			}
+		}
+	}
+}
+
+//===========================================================================
+//=  This function lets the servers of a row of the stale model serve one   =
+//=  time step and adds the step to the integral of the queue lengths.      =
+//=  Negligible servers above the longest queue are left behind.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: row     - fractions of the servers by their real queue length  =
+//=          top     - longest queue of the row with servers                =
+//=          chance  - probability of a departure in the step               =
+//=          step    - length of the time step                              =
+//=          lengths - integral of the real queue lengths                   =
+//=  Returns: None                                                          =
+//===========================================================================
+static void departRow(double *row, int *top, double chance, double step, double *lengths)
+{
+	double moved;        // Fraction of the servers which serve a customer
+	int    longest = 0;  // Longest queue with more than negligible servers
+	int    j;            // Queue length
+
+	for (j = 1; j <= *top; j++)
+	{
+		moved = row[j] * chance;
+		row[j] -= moved;
+		row[j - 1] += moved;
+	}
+	for (j = 0; j <= *top; j++)
+	{
+		lengths[j] += row[j] * step;
+		longest = (row[j] > MEAN_FIELD_NEGLIGIBLE) ? j : longest;
+	}
+	*top = longest;
+}
+
+//===========================================================================
+//=  Stale Shortest Queue and Improved balancers with periodic snapshots.   =
+//=  Between two snapshots a dispatcher sees the reported queue plus its    =
+//=  own dispatches, which the departures do not change, so Improved fills  =
+//=  the reported queues from below like water. While the level is L, each  =
+//=  server reported with at most L customers gets one customer of each of  =
+//=  the M dispatchers at a uniform time of the level, and the level rises  =
+//=  when all have got them. The dispatchers fill at the same pace but pick =
+//=  the servers on their own, so a server gets a binomial number of its M  =
+//=  customers in each step, which is the herding of several dispatchers.   =
+//=  Stale Shortest Queue never raises the level, so its servers below the  =
+//=  level get Poisson arrivals, as do those of more than                   =
+//=  MAX_BINOMIAL_DISPATCHERS dispatchers. The servers below the level are  =
+//=  kept by the customers got in the level and the real queue, the others  =
+//=  by the reported and the real queue. The first level has at least half  =
+//=  a server, smaller ones are empty in a system of N servers. The periods =
+//=  are integrated until the mean queue length of a period settles.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          raises - whether the own dispatches raise the view (Improved)  =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int solveStale(const SIMULATION_CONFIG *config, int raises, MEAN_FIELD_RESULT *result)
+{
+	double  lambda = config->Lambda / config->NumberOfServers;  // Arrival rate of a server
+	double  period = config->StalePeriod;                       // Time between two snapshots
+	double  smallest = 0.5 / config->NumberOfServers;           // Smallest first level which has servers
+	double  startTime = wallClock();                            // Wall clock at the start
+	double *waiting;                                            // Servers above the level by their real queue
+	double *departures;                                         // Departures since the snapshot of a long queue
+	double *filling;                                            // Servers below the level by customers got and queue
+	double *snapshot;                                           // Real queue lengths at the last snapshot
+	double *scratch;                                            // Row after a Poisson shift
+	double *lengths;                                            // Integral of the real queue lengths in the period
+	double *joined;                                             // Customers of the period by the found queue length
+	double *windowLengths;                                      // Sum of lengths over the last half of the periods
+	double *windowJoined;                                       // Sum of joined over the last half of the periods
+	double  windowLost = 0.0;                                   // Sum of lost over the last half of the periods
+	double  lost;                                               // Customers of the period who find a full queue
+	double  filled;                                             // Fraction of the servers below the level
+	double  duration = 0.0;                                     // Length of the current level
+	double  elapsed = 0.0;                                      // Time since the start of the current level
+	double  clock;                                              // Time since the last snapshot
+	double  step;                                               // Time step of the integration
+	double  rate;                                               // Arrival rate of a server below the level
+	double  chunk;                                              // Customers per server of the step left to shift
+	double  moved;                                              // Servers of the new level with an empty queue
+	double  mean = 0.0;                                         // Mean queue length of the period
+	double  previous;                                           // Mean queue length of the previous period
+	int     waitingTop;                                         // Longest real queue with servers above the level
+	int     departureTop;                                       // Most departures with more than negligible servers
+	int     fillingTops[MAX_BINOMIAL_DISPATCHERS + 1];          // Longest real queue with servers of each row
+	int     dispatchers = config->DispatcherCount;              // Customers each server gets in a level
+	int     rows;                                               // Rows of filling, 1 for Poisson arrivals
+	int     limit = queueLimit(config);                         // Longest queue
+	int     width;                                              // Length of a row
+	int     level;                                              // Longest reported queue below the level
+	int     levelEnds;                                          // Whether the current step ends the level
+	int     periodEnds;                                         // Whether the current step ends the period
+	int     periods = 0;                                        // Integrated periods
+	int     windowPeriods = 0;                                  // Periods of the window sums
+	int     r;                                                  // Row counter
+	int     s;                                                  // Reported queue length
+	int     k;                                                  // Departure counter
+	int     j;                                                  // Real queue length
+
+	width = limit + 1;
+	rows = (raises && (dispatchers <= MAX_BINOMIAL_DISPATCHERS)) ? dispatchers + 1 : 1;
+	waiting = (double *) calloc(width, sizeof(double));
+	departures = (double *) calloc(width, sizeof(double));
+	filling = (double *) calloc((size_t) rows * width, sizeof(double));
+	snapshot = (double *) calloc(width, sizeof(double));
+	scratch = (double *) calloc(width, sizeof(double));
+	lengths = (double *) calloc(width, sizeof(double));
+	joined = (double *) calloc(width, sizeof(double));
+	windowLengths = (double *) calloc(width, sizeof(double));
+	windowJoined = (double *) calloc(width, sizeof(double));
+	if ((waiting == NULL) || (departures == NULL) || (filling == NULL) || (snapshot == NULL) || (scratch == NULL) ||
+		(lengths == NULL) || (joined == NULL) || (windowLengths == NULL) || (windowJoined == NULL))
+	{
+		printf("Not enough memory for the mean field\n");
+		free(waiting);
+		free(departures);
+		free(filling);
+		free(snapshot);
+		free(scratch);
+		free(lengths);
+		free(joined);
+		free(windowLengths);
+		free(windowJoined);
+		return(-1);
+	}
+
+	snapshot[0] = 1.0;
+	result->Method = "ODE of the real queue lengths over the levels of the snapshot periods";
+	while (1)
+	{
+		// Snapshot: the first level is the shortest reported queue with half a server below it
+		memset(waiting, 0, sizeof(double) * width);
+		memset(departures, 0, sizeof(double) * width);
+		memset(filling, 0, sizeof(double) * rows * width);
+		memset(fillingTops, 0, sizeof(fillingTops));
+		filled = 0.0;
+		for (level = 0; level <= limit; level++)
+		{
+			filled += snapshot[level];
+			filling[level] = snapshot[level];
+			if ((filled >= smallest) || (level == limit))
+			{
+				break;
+			}
+		}
+		fillingTops[0] = level;
+		waitingTop = 0;
+		for (s = level + 1; s <= limit; s++)
+		{
+			waiting[s] = snapshot[s];
+			waitingTop = (snapshot[s] > MEAN_FIELD_NEGLIGIBLE) ? s : waitingTop;
+		}
+		departures[0] = 1.0;
+		departureTop = 0;
+		duration = dispatchers * filled / lambda;
+		elapsed = 0.0;
+
+		memset(lengths, 0, sizeof(double) * width);
+		memset(joined, 0, sizeof(double) * width);
+		lost = 0.0;
+		for (clock = 0.0, periodEnds = 0; !periodEnds; clock += step)
+		{
+			rate = lambda / filled;
+			step = MEAN_FIELD_STEP / (lambda + config->Mu);
+			periodEnds = (period - clock <= step);
+			step = periodEnds ? period - clock : step;
+			levelEnds = raises && (duration - elapsed <= step);
+			if (levelEnds)
+			{
+				step = duration - elapsed;
+				periodEnds = 0;
+			}
+
+			// Arrivals at the servers below the level
+			if (rows == 1)
+			{
+				for (chunk = rate * step; chunk > 0.0; chunk -= POISSON_CHUNK)
+				{
+					fillingTops[0] = shiftRow(filling, scratch, fillingTops[0], limit,
+						(chunk < POISSON_CHUNK) ? chunk : POISSON_CHUNK, joined, &lost);
+				}
+			}
+			else
+			{
+				for (r = rows - 2; r >= 0; r--)
+				{
+					binomialRow(&filling[r * width], width, &fillingTops[r], limit, dispatchers - r,
+						levelEnds ? 1.0 : step / (duration - elapsed), joined, &lost);
+				}
+			}
+			elapsed += step;
+
+			// Departures of all servers
+			for (r = 0; r < rows; r++)
+			{
+				departRow(&filling[r * width], &fillingTops[r], config->Mu * step, step, lengths);
+			}
+			departRow(waiting, &waitingTop, config->Mu * step, step, lengths);
+			departureTop = (departureTop < limit) ? departureTop + 1 : limit;
+			departures[limit] += departures[limit - 1] * config->Mu * step;
+			for (k = (departureTop < limit) ? departureTop : limit - 1; k > 0; k--)
+			{
+				departures[k] = departures[k] * (1.0 - config->Mu * step) + departures[k - 1] * config->Mu * step;
+			}
+			departures[0] *= 1.0 - config->Mu * step;
+			result->Steps++;
+
+			// Next level: the servers start again with no customer got and the next report joins them
+			if (levelEnds)
+			{
+				for (r = 1; r < rows; r++)
+				{
+					for (j = 0; j <= fillingTops[r]; j++)
+					{
+						filling[j] += filling[r * width + j];
+						filling[r * width + j] = 0.0;
+					}
+					fillingTops[0] = (fillingTops[r] > fillingTops[0]) ? fillingTops[r] : fillingTops[0];
+					fillingTops[r] = 0;
+				}
+				if (level < limit)
+				{
+					// The servers reported with level customers have served as many as a long queue, at most all
+					level++;
+					moved = snapshot[level];
+					for (k = 0; (k < level) && (k <= departureTop); k++)
+					{
+						filling[level - k] += snapshot[level] * departures[k];
+						waiting[level - k] -= snapshot[level] * departures[k];
+						waiting[level - k] = (waiting[level - k] > 0.0) ? waiting[level - k] : 0.0;
+						moved -= snapshot[level] * departures[k];
+					}
+					filling[0] += moved;
+					waiting[0] = (waiting[0] > moved) ? waiting[0] - moved : 0.0;
+					filled += snapshot[level];
+					fillingTops[0] = (level > fillingTops[0]) ? level : fillingTops[0];
+				}
+				duration = dispatchers * filled / lambda;
+				elapsed = 0.0;
+			}
+		}
+
+		// Snapshot: every dispatcher sees the real queue lengths
+		memset(snapshot, 0, sizeof(double) * width);
+		for (r = 0; r < rows; r++)
+		{
+			for (j = 0; j <= limit; j++)
+			{
+				snapshot[j] += filling[r * width + j];
+			}
+		}
+		for (j = 0; j <= limit; j++)
+		{
+			snapshot[j] += waiting[j];
+		}
+
+		previous = mean;
+		mean = 0.0;
+		for (j = 0; j <= limit; j++)
+		{
+			mean += j * lengths[j] / period;
+		}
+		result->ModelTime += period;
+		result->Residual = fabs(mean - previous);
+		if ((periods > 0) && (result->Residual < STALE_TOLERANCE * (1.0 + mean)))
+		{
+			result->Converged = 1;
+			break;
+		}
+		if (++periods > MAX_STALE_PERIODS / 2)
+		{
+			for (j = 0; j <= limit; j++)
+			{
+				windowLengths[j] += lengths[j];
+				windowJoined[j] += joined[j];
+			}
+			windowLost += lost;
+			windowPeriods++;
+		}
+		if ((periods == MAX_STALE_PERIODS) || (wallClock() - startTime > config->MaxTime))
+		{
+			break;
+		}
+	}
+
+	// A period map which does not settle, e.g. herding that jumps between the levels of few servers,
+	// is described by its average over the last half of the periods
+	if (!result->Converged && (windowPeriods > 0))
+	{
+		for (j = 0; j <= limit; j++)
+		{
+			lengths[j] = windowLengths[j] / windowPeriods;
+			joined[j] = windowJoined[j] / windowPeriods;
+		}
+		lost = windowLost / windowPeriods;
+	}
+	for (j = 0; j <= limit; j++)
+	{
+		result->QueueLengths[j] = lengths[j] / period;
+		result->JoinLengths[j] = (j < limit) ? joined[j] : 0.0;
+	}
+	result->LossRate = lost / (lambda * period);
+	result->Length = limit;
+
+	free(waiting);
+	free(departures);
+	free(filling);
+	free(snapshot);
+	free(scratch);
+	free(lengths);
+	free(joined);
+	free(windowLengths);
+	free(windowJoined);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function finds the steady state of the mean-field model of the    =
+//=  load balancer with the parameters of a simulation run. The models are  =
+//=  the limits of many servers at the same utilization, except where the   =
+//=  result says that they are exact. A speed-aware balancer on servers of  =
+//=  one speed is its plain version. A customer who finds a full queue is   =
+//=  dropped, as with the Reject overload.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - place to store the steady state                       =
+//=  Returns: 0 on success, -1 if the balancer or parameters have no mean   =
+//=           field                                                         =
+//===========================================================================
+int meanFieldSolve(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result)
+{
+	enum BALANCER_TYPE policy = config->LoadBalancer;  // Balancer of the model
+	double             startTime = wallClock();        // Wall clock at the start
+	int                status;                         // Result of the solver
+
+	memset(result, 0, sizeof(MEAN_FIELD_RESULT));
+	result->Percentiles[0] = -1.0;
+	result->Percentiles[1] = -1.0;
+	result->Percentiles[2] = -1.0;
+
+	if (equalSpeeds(config))
+	{
+		switch (policy)
+		{
+		case speedShortestQueuePolicy:      policy = shortestQueuePolicy;      break;
+		case speedShortestQueueStalePolicy: policy = shortestQueueStalePolicy; break;
+		case speedImprovedPolicy:           policy = improvedPolicy;           break;
+		case speedPowerOfDPolicy:           policy = powerOfDPolicy;           break;
+		default:                            break;
+		}
+	}
+
+	if (config->BatchSize > 1)
+	{
+		printf("ERROR! The mean field has single arrivals only, not batches\n");
+		return(-1);
+	}
+	if (scheduleVaries(&config->Schedule) || config->Autoscale)
+	{
+		printf("ERROR! The mean field has a constant arrival rate and a fixed number of servers\n");
+		return(-1);
+	}
+	if ((policy != randomPolicy) && ((config->Service != exponentialService) || !equalSpeeds(config)))
+	{
+		printf("ERROR! The mean field of %s needs exponential service demands and servers of one speed\n",
+			balancerName(config->LoadBalancer));
+		return(-1);
+	}
+	if ((config->QueueCapacity > 0) && (config->Overload != rejectOverload))
+	{
+		printf("ERROR! The mean field drops the customers who find a full queue, as the Reject overload\n");
+		return(-1);
+	}
+	if (((policy == shortestQueueStalePolicy) || (policy == improvedPolicy)) &&
+		((config->Update != snapshotUpdate) || (config->NetworkDelay > 0.0)))
+	{
+		printf("ERROR! The mean field of %s has snapshot reports without delay only\n",
+			balancerName(config->LoadBalancer));
+		return(-1);
+	}
+
+	switch (policy)
+	{
+	case randomPolicy:
+		status = solveRandom(config, result);
+		break;
+	case roundRobinPolicy:
+		status = solveRoundRobin(config, result);
+		break;
+	case shortestQueuePolicy:
+		status = solveShortestQueue(config, result);
+		break;
+	case shortestQueueStalePolicy:
+		status = solveStale(config, 0, result);
+		break;
+	case improvedPolicy:
+		status = solveStale(config, 1, result);
+		break;
+	case powerOfDPolicy:
+		status = solvePowerOfD(config, result);
+		break;
+	case joinIdleQueuePolicy:
+		status = solveJoinIdleQueue(config, result);
+		break;
+	default:
+		printf("ERROR! There is no mean field of %s\n", balancerName(config->LoadBalancer));
+		return(-1);
+	}
+	if (status != 0)
+	{
+		return(-1);
+	}
+
+	if (result->Length > 0)
+	{
+		finishDistributions(config, result);
+	}
+	result->SolveTime = wallClock() - startTime;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function prints the steady state of the mean field: the method,   =
+//=  the mean queue length and response time, the percentiles and the       =
+//=  queue length distribution seen by the servers and by the customers.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=          result - steady state of meanFieldSolve()                      =
+//=  Returns: None                                                          =
+//===========================================================================
+void printMeanFieldReport(const SIMULATION_CONFIG *config, const MEAN_FIELD_RESULT *result)
+{
+	double rest = 1.0;  // Fraction of the servers with longer queues than printed
+	int    k;           // Queue length counter
+
+	printf("Load balancer: %s\n", balancerName(config->LoadBalancer));
+	printf("Servers: %d, utilization: %.5f\n", config->NumberOfServers,
+		config->Lambda / (config->NumberOfServers * config->Mu));
+	printf("Method: %s, %s\n", result->Method,
+		result->Exact ? "exact for this number of servers" : "limit of many servers");
+	if (result->Steps > 0)
+	{
+		printf("Integrated to time %.3f in %lld steps, last change %.3g\n", result->ModelTime, result->Steps,
+			result->Residual);
+	}
+	if (!result->Converged)
+	{
+		printf("WARNING! The steady state has not been reached or the queues are longer than %d\n", result->Length);
+	}
+	printf("Solved in %.6f seconds\n\n", result->SolveTime);
+
+	printf("Mean queue length: %.6f\n", result->MeanQueueLength);
+	printf("Mean response time: %.6f\n", result->MeanResponseTime);
+	if (result->Percentiles[0] >= 0.0)
+	{
+		printf("Response time p50: %.5f, p99: %.5f, p99.9: %.5f\n", result->Percentiles[0], result->Percentiles[1],
+			result->Percentiles[2]);
+	}
+	if (config->QueueCapacity > 0)
+	{
+		printf("Customers who find a full queue: %.3g\n", result->LossRate);
+	}
+
+	if (result->Length == 0)
+	{
+		return;
+	}
+	printf("\nQUEUE LENGTHS\n");
+	printf("length  servers     customers\n");
+	for (k = 0; (k <= result->Length) && (rest > MEAN_FIELD_TAIL); k++)
+	{
+		printf("%-7d %-11.6f %.6f\n", k, result->QueueLengths[k], result->JoinLengths[k]);
+		rest -= result->QueueLengths[k];
+	}
+}
+
+//===========================================================================
+//=  This function compares the mean field with short simulations of the    =
+//=  given numbers of servers at the utilization of the command line. The   =
+//=  limits of many servers should get closer as the servers grow. A gap    =
+//=  larger than the half-width of the simulation is marked.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: check - parameters of the cross-check                          =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runMeanFieldCheck(const MEAN_FIELD_CHECK *check)
+{
+	SIMULATION_CONFIG config;            // Parameters of the current size
+	SIMULATION_STATE  state;             // Simulation of the current size
+	MEAN_FIELD_RESULT result;            // Mean field of the current size
+	double            utilization;       // Utilization of a server
+	double            mean;              // Mean response time of the simulation
+	double            halfWidth;         // Half-width of its confidence interval
+	double            gap;               // Relative difference of the mean field and the simulation
+	int               broken;            // Whether the simulation has failed
+	int               i;                 // Size counter
+
+	utilization = check->Simulation.Lambda / (check->Simulation.NumberOfServers * check->Simulation.Mu);
+	printf("Load balancer: %s, utilization: %.5f\n\n", balancerName(check->Simulation.LoadBalancer), utilization);
+	printf("servers  mean field  simulation                 gap       p99 field   p99 sim     field s     sim s\n");
+
+	for (i = 0; i < check->NumberOfSizes; i++)
+	{
+		config = check->Simulation;
+		config.NumberOfServers = check->ServerCounts[i];
+		config.Lambda = utilization * config.NumberOfServers * config.Mu;
+		if (config.RunLength == 0)
+		{
+			config.RunLength = (long long) CHECK_SERVER_LENGTH * config.NumberOfServers;
+			config.RunLength = (config.RunLength > CHECK_RUN_LENGTH) ? config.RunLength : CHECK_RUN_LENGTH;
+		}
+		config.Stream = 0;
+		if (meanFieldSolve(&config, &result) != 0)
+		{
+			return(-1);
+		}
+		if (simulationInit(&state, &config) != 0)
+		{
+			return(-1);
+		}
+		broken = (runSimulation(&state) != 0);
+		mean = tableMean(&state.DelayTable);
+		halfWidth = tableHalfWidth(&state.DelayTable, config.CiLevel);
+		gap = (mean > 0.0) ? (result.MeanResponseTime - mean) / mean : 0.0;
+		printf("%-8d %-11.6f %-11.6f", config.NumberOfServers, result.MeanResponseTime, mean);
+		if (halfWidth >= 0.0)
+		{
+			printf(" +/- %-10.6f", halfWidth);
+		}
+		else
+		{
+			printf(" (no CI)       ");
+		}
+		printf(" %+7.2f%% %s %-11.5f %-11.5f %-11.6f %.3f%s\n", 100.0 * gap,
+			((halfWidth >= 0.0) && (fabs(result.MeanResponseTime - mean) > halfWidth)) ? "*" : " ",
+			result.Percentiles[1], histogramPercentile(&state.ResponseTimes.Total, 0.99), result.SolveTime,
+			state.CpuTime, broken ? " broken" : "");
+		simulationFree(&state);
+	}
+	printf("(* - the mean field is outside the confidence interval of the simulation)\n");
+
+	return(0);
+}
@@ -0,0 +1,44 @@
+#ifndef MEAN_FIELD_H
+#define MEAN_FIELD_H
+
+//----- Includes --------------------------------------------------------------
+#include "StandaloneModel.h"  // Simulation model and its parameters
+
+//----- Constants -------------------------------------------------------------
+#define MEAN_FIELD_LENGTH   1024    // Longest queue of the mean-field states when the queues are unbounded
+#define MAX_CHECK_SIZES     16      // Longest list of the server counts of the cross-check
+#define CHECK_RUN_LENGTH    200000  // Fewest customers of a cross-check simulation without a given run length
+#define CHECK_SERVER_LENGTH 5000    // Customers per server of a cross-check simulation, so every queue warms up
+
+//------New types--------------------------------------------------------------
+typedef struct  // Steady state of the mean-field model of a load balancer
+{
+	double      MeanResponseTime;                     // Mean response time of the served customers
+	double      MeanQueueLength;                      // Mean number of customers at a server
+	double      Percentiles[3];                       // p50, p99 and p99.9 of the response time, -1 if unknown
+	double      LossRate;                             // Fraction of the customers who find the chosen queue full
+	double      QueueLengths[MEAN_FIELD_LENGTH + 1];  // Time average fraction of the servers with k customers
+	double      JoinLengths[MEAN_FIELD_LENGTH + 1];   // Fraction of the served customers who find k customers
+	int         Length;                               // Longest queue of the distributions, 0 if they are unknown
+	const char *Method;                               // How the steady state is found
+	long long   Steps;                                // Steps of the ODE integration, 0 for a closed form
+	double      ModelTime;                            // Model time integrated to reach the steady state
+	double      Residual;                             // Largest derivative, or change per period, at the end
+	int         Exact;                                // Whether the result holds for the given number of servers
+	int         Converged;                            // Whether the steady state has been reached
+	double      SolveTime;                            // Wall clock time of the solver in seconds
+} MEAN_FIELD_RESULT;
+
+typedef struct  // Parameters of the cross-check of the mean field against short simulations
+{
+	SIMULATION_CONFIG Simulation;                     // Parameters of the runs. Lambda is scaled with the servers
+	int               ServerCounts[MAX_CHECK_SIZES];  // Numbers of servers of the simulations
+	int               NumberOfSizes;                  // Number of ServerCounts
+} MEAN_FIELD_CHECK;
+
+//----- Prototypes ------------------------------------------------------------
+int  meanFieldSolve(const SIMULATION_CONFIG *config, MEAN_FIELD_RESULT *result);
+void printMeanFieldReport(const SIMULATION_CONFIG *config, const MEAN_FIELD_RESULT *result);
+int  runMeanFieldCheck(const MEAN_FIELD_CHECK *check);
+
+#endif
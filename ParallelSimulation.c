@@ -0,0 +1,506 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>               // Needed for I/O functions
+#include <stdlib.h>              // Needed for calloc() and free()
+#include <math.h>                // Needed for sqrt() and fabs()
+#include <pthread.h>             // Needed for the threads of the shards
+#include "ParallelSimulation.h"  // Parallel mode types and prototypes
+#include "Replications.h"        // Wall clock
+
+//------New types--------------------------------------------------------------
+typedef struct PARALLEL_RUN PARALLEL_RUN;
+
+typedef struct  // One shard of a parallel run and its thread
+{
+	PARALLEL_RUN     *Run;     // Run of the shard
+	int               Index;   // Number of the shard
+	SIMULATION_STATE  State;   // Dispatchers and servers of the shard
+	pthread_t         Thread;  // Thread of the shard
+	int               Broken;  // Whether the shard has stopped with an error. Written before the second barrier
+} SHARD;
+
+struct PARALLEL_RUN  // State shared by the threads of a parallel run
+{
+	SHARD           *Shards;          // Shards of the run
+	int              NumberOfShards;  // Number of shards
+	MAILBOXES       *Mailboxes;       // Mailboxes and barrier of the shards
+	double           Lookahead;       // Length of the windows
+	int             *Positions;       // Next logged customer of each shard when the window is recorded
+	long long        Windows;         // Number of recorded windows
+	double           StartTime;       // Wall clock at the start of the run
+	int              Stop;            // Whether the run ends. Written by the first shard before the first barrier
+	pthread_mutex_t  Mutex;           // Protects Started
+	pthread_cond_t   StartSignal;     // Signals the threads that every thread exists or that the run is aborted
+	int              Started;         // Whether the threads may start
+};
+
+//===========================================================================
+//=  This function checks whether the configuration can run on shards and   =
+//=  finds the lookahead of the run, the length of its windows. A customer  =
+//=  goes to its server at once, so the shards can only run ahead of each   =
+//=  other where the queue lengths take time to reach the dispatchers: the  =
+//=  NetworkDelay of the reports of single servers, or the StalePeriod of   =
+//=  the snapshots. The balancers which read the real queues of all servers =
+//=  or get idle tokens at once, and the overload policies which pass the   =
+//=  customer on, have no lookahead.                                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config    - parameters of the run                              =
+//=          lookahead - place to store the length of the windows           =
+//=  Returns: 0 on success, -1 if the run cannot be parallel                =
+//===========================================================================
+int parallelLookahead(const SIMULATION_CONFIG *config, double *lookahead)
+{
+	*lookahead = 0.0;
+
+	switch (config->LoadBalancer)
+	{
+	case shortestQueuePolicy:
+	case powerOfDPolicy:
+	case joinIdleQueuePolicy:
+	case batchSamplingPolicy:
+	case speedShortestQueuePolicy:
+	case speedPowerOfDPolicy:
+		printf("ERROR! %s reads the current queues of all servers, so it cannot run on shards\n",
+			balancerName(config->LoadBalancer));
+		return(-1);
+	default:
+		break;
+	}
+	if ((config->QueueCapacity > 0) && (config->Overload != rejectOverload))
+	{
+		printf("ERROR! The %s overload cannot run on shards, use the reject overload or unbounded queues\n",
+			overloadName(config->Overload));
+		return(-1);
+	}
+	if (scheduleVaries(&config->Schedule) || config->Autoscale)
+	{
+		printf("ERROR! Time-varying load and the autoscaler cannot run on shards\n");
+		return(-1);
+	}
+
+	if (usesQueueReports(config) && (config->Update != snapshotUpdate))
+	{
+		*lookahead = config->NetworkDelay;
+		if (*lookahead <= 0.0)
+		{
+			printf("ERROR! The %s reports need a network delay, which is the lookahead of the shards\n",
+				updateName(config->Update));
+			return(-1);
+		}
+		return(0);
+	}
+
+	*lookahead = config->StalePeriod;
+	if (*lookahead <= 0.0)
+	{
+		printf("ERROR! The shards need a positive update period as their lookahead\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function records the customers which all shards have served in    =
+//=  the last window into the tables of the first shard, in the order of    =
+//=  their departures, as the sequential engine would. The run length       =
+//=  control decides after every customer, so the run stops at the same     =
+//=  point of the merged customers for any number of threads. The run also  =
+//=  stops when a shard is broken or MaxTime of wall clock time is spent.   =
+//=  The first shard calls it while the others run the dispatchers of the   =
+//=  next window, which do not touch the logs.                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: run - parallel run after the servers of the window             =
+//=  Returns: None                                                          =
+//===========================================================================
+static void recordWindow(PARALLEL_RUN *run)
+{
+	SIMULATION_STATE *first = &run->Shards[0].State;  // Tables of the run
+	SIMULATION_STATE *state;                          // State of the current shard
+	int               earliest;                       // Shard of the earliest departure
+	double            earliestTime = 0.0;             // Earliest departure
+	int               s;                              // Shard counter
+
+	for (s = 0; s < run->NumberOfShards; s++)
+	{
+		run->Positions[s] = 0;
+		if (run->Shards[s].Broken)
+		{
+			run->Stop = 1;
+		}
+	}
+
+	while (!run->Stop)
+	{
+		earliest = -1;
+		for (s = 0; s < run->NumberOfShards; s++)
+		{
+			state = &run->Shards[s].State;
+			if ((run->Positions[s] < state->CompletionCount) &&
+				((earliest < 0) || (state->Completions[2 * run->Positions[s]] < earliestTime)))
+			{
+				earliest = s;
+				earliestTime = state->Completions[2 * run->Positions[s]];
+			}
+		}
+		if (earliest < 0)
+		{
+			break;
+		}
+
+		state = &run->Shards[earliest].State;
+		recordResponseTime(first, state->Completions[2 * run->Positions[earliest] + 1]);
+		run->Positions[earliest]++;
+		if (runLengthReached(first))
+		{
+			first->Converged = 1;
+			run->Stop = 1;
+		}
+	}
+
+	for (s = 0; s < run->NumberOfShards; s++)
+	{
+		run->Shards[s].State.CompletionCount = 0;
+	}
+	run->Windows++;
+	if (wallClock() - run->StartTime > first->Config.MaxTime)
+	{
+		run->Stop = 1;
+	}
+}
+
+//===========================================================================
+//=  Thread of one shard. The shards run in windows of Lookahead time. In   =
+//=  every window the dispatchers of all shards run first and post their    =
+//=  customers, then, after a barrier, the servers of all shards serve them =
+//=  and post their reports, which are due in a later window. After the     =
+//=  second barrier the first shard records the served customers and        =
+//=  decides whether the run ends, while the others run the dispatchers of  =
+//=  the next window. A broken shard stops simulating but keeps passing the =
+//=  barriers until the run ends.                                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argument - shard                                               =
+//=  Returns: NULL                                                          =
+//===========================================================================
+static void *shardThread(void *argument)
+{
+	SHARD        *shard = (SHARD *) argument;  // Shard of the thread
+	PARALLEL_RUN *run = shard->Run;            // Run of the shard
+	double        windowEnd = 0.0;             // End of the current window
+	long long     window;                      // Number of the current window
+	int           broken = 0;                  // Whether the shard has stopped with an error
+
+	pthread_mutex_lock(&run->Mutex);
+	while (!run->Started)
+	{
+		pthread_cond_wait(&run->StartSignal, &run->Mutex);
+	}
+	pthread_mutex_unlock(&run->Mutex);
+	if (run->Stop)
+	{
+		return(NULL);
+	}
+
+	// The windows end where the snapshots are taken, at the same sums of the
+	// period. Stop is only read after the first barrier, when nobody writes it
+	for (window = 0; ; window++)
+	{
+		windowEnd += run->Lookahead;
+		if ((shard->Index == 0) && (window > 0))
+		{
+			recordWindow(run);
+		}
+		if (!broken && (advanceDispatchers(&shard->State, windowEnd) != 0))
+		{
+			broken = 1;
+		}
+		if (mailboxesWait(run->Mailboxes, shard->Index) != 0)
+		{
+			broken = 1;
+		}
+		if (run->Stop)
+		{
+			break;
+		}
+
+		if (!broken && (advanceServers(&shard->State, windowEnd) != 0))
+		{
+			broken = 1;
+		}
+		shard->Broken = broken;
+		if (mailboxesWait(run->Mailboxes, shard->Index) != 0)
+		{
+			broken = 1;
+		}
+	}
+
+	return(NULL);
+}
+
+//===========================================================================
+//=  This function runs the model on numberOfShards threads. Every thread   =
+//=  simulates a block of the servers and a share of the dispatchers, with  =
+//=  its own event lists and random streams. The customers and reports go   =
+//=  between the shards through lock-free mailboxes. The result does not    =
+//=  depend on the timing of the threads, but it differs from the           =
+//=  sequential run because the shards draw from other streams.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config         - parameters of the run                         =
+//=          numberOfShards - number of shards and threads                  =
+//=          result         - place to store the result of the run          =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runParallel(const SIMULATION_CONFIG *config, int numberOfShards, PARALLEL_RESULT *result)
+{
+	PARALLEL_RUN      run;                // State shared by the threads
+	SIMULATION_CONFIG shardConfig;        // Parameters of the current shard
+	SIMULATION_STATE *first;              // State with the tables of the run
+	int               initialized = 0;    // Number of initialized shards
+	int               started = 0;        // Number of started threads
+	int               status = 0;         // Result of the run
+	int               s;                  // Shard counter
+
+	result->ShardCount = numberOfShards;
+	result->Windows = 0;
+	result->Customers = 0;
+	result->Statistic = 0.0;
+	result->HalfWidth = -1.0;
+	result->Tail = 0.0;
+	result->EventCounter = 0;
+	result->Stalls = 0;
+	result->WallTime = 0.0;
+	result->Converged = 0;
+	if (parallelLookahead(config, &run.Lookahead) != 0)
+	{
+		return(-1);
+	}
+	if ((numberOfShards < 1) || (numberOfShards > MAX_SHARDS) || (numberOfShards > config->NumberOfServers))
+	{
+		printf("ERROR! A parallel run has 1 to %d shards and at most one per server\n", MAX_SHARDS);
+		return(-1);
+	}
+
+	run.NumberOfShards = numberOfShards;
+	run.Windows = 0;
+	run.Stop = 0;
+	run.Started = 0;
+	run.Shards = (SHARD *) calloc(numberOfShards, sizeof(SHARD));
+	run.Positions = (int *) calloc(numberOfShards, sizeof(int));
+	run.Mailboxes = mailboxesCreate(numberOfShards);
+	if ((run.Shards == NULL) || (run.Positions == NULL) || (run.Mailboxes == NULL))
+	{
+		printf("Not enough memory for the shards\n");
+		status = -1;
+	}
+	for (s = 0; (status == 0) && (s < numberOfShards); s++)
+	{
+		shardConfig = *config;
+		shardConfig.ShardCount = numberOfShards;
+		shardConfig.Shard = s;
+		run.Shards[s].Run = &run;
+		run.Shards[s].Index = s;
+		if (simulationInit(&run.Shards[s].State, &shardConfig) != 0)
+		{
+			printf("Not enough memory for the shard %d\n", s + 1);
+			status = -1;
+			break;
+		}
+		simulationAttachMailboxes(&run.Shards[s].State, run.Mailboxes);
+		initialized++;
+	}
+
+	if (status == 0)
+	{
+		pthread_mutex_init(&run.Mutex, NULL);
+		pthread_cond_init(&run.StartSignal, NULL);
+		for (s = 1; s < numberOfShards; s++)
+		{
+			if (pthread_create(&run.Shards[s].Thread, NULL, shardThread, &run.Shards[s]) != 0)
+			{
+				printf("ERROR! Cannot start the thread of the shard %d\n", s + 1);
+				run.Stop = 1;
+				status = -1;
+				break;
+			}
+			started++;
+		}
+
+		// The first shard runs in this thread
+		run.StartTime = wallClock();
+		pthread_mutex_lock(&run.Mutex);
+		run.Started = 1;
+		pthread_cond_broadcast(&run.StartSignal);
+		pthread_mutex_unlock(&run.Mutex);
+		if (status == 0)
+		{
+			shardThread(&run.Shards[0]);
+		}
+		for (s = 1; s <= started; s++)
+		{
+			pthread_join(run.Shards[s].Thread, NULL);
+		}
+		result->WallTime = wallClock() - run.StartTime;
+		pthread_cond_destroy(&run.StartSignal);
+		pthread_mutex_destroy(&run.Mutex);
+	}
+
+	if (status == 0)
+	{
+		first = &run.Shards[0].State;
+		for (s = 0; s < numberOfShards; s++)
+		{
+			result->EventCounter += run.Shards[s].State.EventCounter;
+			result->Stalls += mailboxStalls(run.Mailboxes, s);
+			if (run.Shards[s].Broken)
+			{
+				status = -1;
+			}
+		}
+		result->Windows = run.Windows;
+		result->Customers = first->DelayTable.Count;
+		result->Statistic = responseTimeStatistic(first);
+		result->HalfWidth = (config->Percentile > 0.0) ? percentileTableHalfWidth(&first->ResponseTimes,
+			config->CiLevel) : tableHalfWidth(&first->DelayTable, config->CiLevel);
+		result->Tail = histogramPercentile(&first->ResponseTimes.Total, 0.99);
+		result->Converged = first->Converged;
+	}
+
+	for (s = 0; s < initialized; s++)
+	{
+		simulationFree(&run.Shards[s].State);
+	}
+	mailboxesFree(run.Mailboxes);
+	free(run.Positions);
+	free(run.Shards);
+
+	return(status);
+}
+
+//===========================================================================
+//=  This function runs the sequential engine with the same parameters, so  =
+//=  the parallel runs have a reference for their results and their time.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the run                                 =
+//=          result - place to store the result of the run                  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+static int runSequential(const SIMULATION_CONFIG *config, PARALLEL_RESULT *result)
+{
+	SIMULATION_CONFIG sequentialConfig = *config;  // Parameters without shards
+	SIMULATION_STATE  state;                       // State of the run
+	double            startTime;                   // Wall clock at the start of the run
+	int               status;                      // Result of the run
+
+	sequentialConfig.ShardCount = 0;
+	sequentialConfig.Shard = 0;
+	result->ShardCount = 0;
+	result->Windows = 0;
+	result->Stalls = 0;
+	if (simulationInit(&state, &sequentialConfig) != 0)
+	{
+		printf("Not enough memory for the simulation\n");
+		return(-1);
+	}
+
+	startTime = wallClock();
+	status = runSimulation(&state);
+	result->WallTime = wallClock() - startTime;
+	result->Customers = state.DelayTable.Count;
+	result->Statistic = responseTimeStatistic(&state);
+	result->HalfWidth = (config->Percentile > 0.0) ? percentileTableHalfWidth(&state.ResponseTimes,
+		config->CiLevel) : tableHalfWidth(&state.DelayTable, config->CiLevel);
+	result->Tail = histogramPercentile(&state.ResponseTimes.Total, 0.99);
+	result->EventCounter = state.EventCounter;
+	result->Converged = state.Converged;
+
+	simulationFree(&state);
+
+	return(status);
+}
+
+//===========================================================================
+//=  This function runs the model once for every thread count of the list,  =
+//=  0 meaning the sequential engine. Every run has the same parameters and =
+//=  the same stopping rule.                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config  - parameters of the mode                               =
+//=          results - place to store the result of each run                =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runParallelMode(const PARALLEL_CONFIG *config, PARALLEL_RESULT *results)
+{
+	int i;  // Run counter
+
+	for (i = 0; i < config->NumberOfRuns; i++)
+	{
+		if (((config->ShardCounts[i] == 0) ? runSequential(&config->Simulation, &results[i]) :
+			runParallel(&config->Simulation, config->ShardCounts[i], &results[i])) != 0)
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function prints the results of the runs of the parallel mode: the =
+//=  response time statistic with its confidence interval and the speedup   =
+//=  of the wall clock time over the first run. A statistic which differs   =
+//=  from the first run by more than the combined half-widths is marked.    =
+//=  The shards are a different model only in their random streams, so the  =
+//=  marks should be as rare as the CI level says.                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config  - parameters of the mode                               =
+//=          results - result of each run                                   =
+//=  Returns: None                                                          =
+//===========================================================================
+void printParallelReport(const PARALLEL_CONFIG *config, const PARALLEL_RESULT *results)
+{
+	const PARALLEL_RESULT *result;          // Current run
+	const PARALLEL_RESULT *reference;       // First run
+	double                 lookahead;       // Length of the windows
+	double                 combined;        // Combined half-width of the run and the first run
+	int                    different;       // Whether the statistic differs from the first run
+	int                    i;               // Run counter
+
+	reference = &results[0];
+	parallelLookahead(&config->Simulation, &lookahead);
+	printf("Load balancer: %s\n", balancerName(config->Simulation.LoadBalancer));
+	printf("Servers: %d, dispatchers: %d, lambda: %g\n", config->Simulation.NumberOfServers,
+		config->Simulation.DispatcherCount, config->Simulation.Lambda);
+	printf("Lookahead of the shards: %g\n", lookahead);
+	printf("Compared statistic: ");
+	printStatisticName(&config->Simulation);
+	printf("\n\n");
+
+	printf("engine      threads   windows   customers  response time               p99       stalls   wall time  speedup\n");
+	for (i = 0; i < config->NumberOfRuns; i++)
+	{
+		result = &results[i];
+		combined = sqrt(result->HalfWidth * result->HalfWidth + reference->HalfWidth * reference->HalfWidth);
+		different = (i > 0) && (result->HalfWidth >= 0.0) && (reference->HalfWidth >= 0.0) &&
+			(fabs(result->Statistic - reference->Statistic) > combined);
+		printf("%-10s  %7d  %8lld  %10lld  %10.6f", (result->ShardCount == 0) ? "sequential" : "parallel",
+			(result->ShardCount == 0) ? 1 : result->ShardCount, result->Windows, result->Customers, result->Statistic);
+		if (result->HalfWidth >= 0.0)
+		{
+			printf(" +/- %-10.6f %s", result->HalfWidth, different ? "*" : " ");
+		}
+		else
+		{
+			printf(" (no CI)          ");
+		}
+		printf(" %9.4f  %7lld  %8.3f s  %7.2f\n", result->Tail, result->Stalls, result->WallTime,
+			(result->WallTime > 0.0) ? reference->WallTime / result->WallTime : 0.0);
+	}
+	printf("(* - differs from the first run by more than the combined %.0f%% half-widths)\n",
+		config->Simulation.CiLevel * 100.0);
+	for (i = 0; i < config->NumberOfRuns; i++)
+	{
+		if (!results[i].Converged)
+		{
+			printf("The run with %d threads has not converged\n", results[i].ShardCount);
+		}
+	}
+	printf("Cores: %d\n", numberOfCores());
+}
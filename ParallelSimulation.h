@@ -0,0 +1,39 @@
+#ifndef PARALLEL_SIMULATION_H
+#define PARALLEL_SIMULATION_H
+
+//----- Includes --------------------------------------------------------------
+#include "StandaloneModel.h"  // Simulation model
+
+//----- Constants -------------------------------------------------------------
+#define MAX_SHARD_RUNS 16   // Longest list of the thread counts of the parallel mode
+#define MAX_SHARDS     256  // Most shards of one parallel run
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the parallel mode
+{
+	SIMULATION_CONFIG Simulation;                   // Parameters of every run. ShardCount is set per run
+	int               ShardCounts[MAX_SHARD_RUNS];  // Threads of each run. 0 means the sequential engine
+	int               NumberOfRuns;                 // Number of ShardCounts
+} PARALLEL_CONFIG;
+
+typedef struct  // Result of one run of the parallel mode
+{
+	int       ShardCount;    // Threads of the run, 0 for the sequential engine
+	long long Windows;       // Number of windows of the run
+	long long Customers;     // Number of served customers in the statistic
+	double    Statistic;     // Response time statistic (mean or percentile)
+	double    HalfWidth;     // Half-width of the confidence interval of the statistic, -1 if there is none
+	double    Tail;          // 99th percentile of the response time
+	long long EventCounter;  // Number of events processed by all threads
+	long long Stalls;        // Messages which have found a mailbox full
+	double    WallTime;      // Wall clock time of the run in seconds
+	int       Converged;     // Whether the run length control has stopped the run
+} PARALLEL_RESULT;
+
+//----- Prototypes ------------------------------------------------------------
+int  parallelLookahead(const SIMULATION_CONFIG *config, double *lookahead);
+int  runParallel(const SIMULATION_CONFIG *config, int numberOfShards, PARALLEL_RESULT *result);
+int  runParallelMode(const PARALLEL_CONFIG *config, PARALLEL_RESULT *results);
+void printParallelReport(const PARALLEL_CONFIG *config, const PARALLEL_RESULT *results);
+
+#endif
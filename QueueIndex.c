@@ -0,0 +1,860 @@
+//----- Includes --------------------------------------------------------------
+#include <stdlib.h>      // Needed for malloc(), calloc(), realloc() and free()
+#include <string.h>      // Needed for memcpy()
+#include "QueueIndex.h"  // Queue index type and prototypes
+
+//----- Constants -------------------------------------------------------------
+#define INITIAL_MAX_LENGTH 64  // Largest length described by BucketStart after the initialization
+
+//===========================================================================
+//=  This function makes BucketStart describe lengths up to maxLength. All  =
+//=  new entries are NumberOfServers because no server is that long yet.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index     - queue index                                        =
+//=          maxLength - length which must be described                     =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int growBuckets(QUEUE_INDEX *index, int maxLength)
+{
+	int *newBucketStart;  // Reallocated BucketStart
+	int  newMaxLength;    // New largest described length
+	int  l;               // Length counter
+
+	if (maxLength <= index->MaxLength)
+	{
+		return(0);
+	}
+
+	newMaxLength = index->MaxLength;
+	while (newMaxLength < maxLength)
+	{
+		newMaxLength *= 2;
+	}
+
+	// BucketStart[MaxLength + 1] is needed to find the end of the last bucket
+	newBucketStart = (int *) realloc(index->BucketStart, sizeof(int) * (newMaxLength + 2));
+	if (newBucketStart == NULL)
+	{
+		return(-1);
+	}
+	for (l = index->MaxLength + 2; l < newMaxLength + 2; l++)
+	{
+		newBucketStart[l] = index->NumberOfServers;
+	}
+	index->BucketStart = newBucketStart;
+	index->MaxLength = newMaxLength;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function allocates the index. All servers have zero length.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index           - queue index to initialize                    =
+//=          numberOfServers - number of servers                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int queueIndexInit(QUEUE_INDEX *index, int numberOfServers)
+{
+	int i;  // Loop counter
+
+	index->NumberOfServers = numberOfServers;
+	index->MaxLength = INITIAL_MAX_LENGTH;
+	index->Length = (int *) calloc(numberOfServers, sizeof(int));
+	index->Order = (int *) malloc(sizeof(int) * numberOfServers);
+	index->Position = (int *) malloc(sizeof(int) * numberOfServers);
+	index->BucketStart = (int *) malloc(sizeof(int) * (INITIAL_MAX_LENGTH + 2));
+	if ((index->Length == NULL) || (index->Order == NULL) || (index->Position == NULL) ||
+		(index->BucketStart == NULL))
+	{
+		queueIndexFree(index);
+		return(-1);
+	}
+
+	for (i = 0; i < numberOfServers; i++)
+	{
+		index->Order[i] = i;
+		index->Position[i] = i;
+	}
+	index->BucketStart[0] = 0;
+	for (i = 1; i < INITIAL_MAX_LENGTH + 2; i++)
+	{
+		index->BucketStart[i] = numberOfServers;
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the index.                           =
+//===========================================================================
+void queueIndexFree(QUEUE_INDEX *index)
+{
+	free(index->Length);
+	free(index->Order);
+	free(index->Position);
+	free(index->BucketStart);
+	index->Length = NULL;
+	index->Order = NULL;
+	index->Position = NULL;
+	index->BucketStart = NULL;
+}
+
+//===========================================================================
+//=  This function loads new lengths of all servers with a counting sort.   =
+//=  It is used when the load balancer gets a snapshot of the queues.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index   - queue index                                          =
+//=          lengths - new queue length of each server                      =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int queueIndexRebuild(QUEUE_INDEX *index, const int *lengths)
+{
+	int maxLength = 0;  // Largest new length
+	int i;              // Server counter
+	int l;              // Length counter
+
+	for (i = 0; i < index->NumberOfServers; i++)
+	{
+		if (lengths[i] > maxLength)
+		{
+			maxLength = lengths[i];
+		}
+	}
+	if (growBuckets(index, maxLength + 1) != 0)
+	{
+		return(-1);
+	}
+
+	// Count servers of each length, then turn the counts into bucket starts
+	for (l = 0; l < index->MaxLength + 2; l++)
+	{
+		index->BucketStart[l] = 0;
+	}
+	for (i = 0; i < index->NumberOfServers; i++)
+	{
+		index->Length[i] = lengths[i];
+		index->BucketStart[lengths[i] + 1]++;
+	}
+	for (l = 1; l < index->MaxLength + 2; l++)
+	{
+		index->BucketStart[l] += index->BucketStart[l - 1];
+	}
+
+	// Place the servers. BucketStart[l] is used as the fill pointer of bucket l and
+	// ends up at the start of bucket l + 1, so the array is shifted back afterwards
+	for (i = 0; i < index->NumberOfServers; i++)
+	{
+		index->Position[i] = index->BucketStart[index->Length[i]]++;
+		index->Order[index->Position[i]] = i;
+	}
+	for (l = index->MaxLength + 1; l > 0; l--)
+	{
+		index->BucketStart[l] = index->BucketStart[l - 1];
+	}
+	index->BucketStart[0] = 0;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function swaps two positions of the Order array.                  =
+//===========================================================================
+static void swapPositions(QUEUE_INDEX *index, int a, int b)
+{
+	int serverA = index->Order[a];  // Server at position a
+	int serverB = index->Order[b];  // Server at position b
+
+	index->Order[a] = serverB;
+	index->Order[b] = serverA;
+	index->Position[serverB] = a;
+	index->Position[serverA] = b;
+}
+
+//===========================================================================
+//=  This function increments the length of the server by one. The server   =
+//=  is swapped with the last server of its bucket and the border of the    =
+//=  next bucket is moved down by one.                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - queue index                                         =
+//=          serverID - server                                              =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int queueIndexIncrement(QUEUE_INDEX *index, int serverID)
+{
+	int length = index->Length[serverID];  // Current length of the server
+
+	if (growBuckets(index, length + 1) != 0)
+	{
+		return(-1);
+	}
+
+	swapPositions(index, index->Position[serverID], index->BucketStart[length + 1] - 1);
+	index->BucketStart[length + 1]--;
+	index->Length[serverID]++;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function decrements the length of the server by one. The server   =
+//=  is swapped with the first server of its bucket and the border of the   =
+//=  bucket is moved up by one.                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - queue index                                         =
+//=          serverID - server with a positive length                       =
+//=  Returns: None                                                          =
+//===========================================================================
+void queueIndexDecrement(QUEUE_INDEX *index, int serverID)
+{
+	int length = index->Length[serverID];  // Current length of the server
+
+	swapPositions(index, index->Position[serverID], index->BucketStart[length]);
+	index->BucketStart[length]++;
+	index->Length[serverID]--;
+}
+
+//===========================================================================
+//=  This function sets the length of one server. The cost is proportional  =
+//=  to the change of the length.                                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - queue index                                         =
+//=          serverID - server                                              =
+//=          length   - new length of the server                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int queueIndexSet(QUEUE_INDEX *index, int serverID, int length)
+{
+	while (index->Length[serverID] < length)
+	{
+		if (queueIndexIncrement(index, serverID) != 0)
+		{
+			return(-1);
+		}
+	}
+	while (index->Length[serverID] > length)
+	{
+		queueIndexDecrement(index, serverID);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function adds a server to the index. The IDs in the index must be =
+//=  0 to NumberOfServers - 1, so the new server is the next ID. It starts  =
+//=  behind the last bucket and sinks to the bucket of its length.          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - queue index                                         =
+//=          serverID - server, NumberOfServers                             =
+//=          length   - queue length of the server                          =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int queueIndexAdd(QUEUE_INDEX *index, int serverID, int length)
+{
+	int l;  // Length counter
+
+	if (growBuckets(index, length + 1) != 0)
+	{
+		return(-1);
+	}
+
+	index->Order[index->NumberOfServers] = serverID;
+	index->Position[serverID] = index->NumberOfServers;
+	index->NumberOfServers++;
+	for (l = index->MaxLength + 1; l > length; l--)
+	{
+		swapPositions(index, index->Position[serverID], index->BucketStart[l]);
+		index->BucketStart[l]++;
+	}
+	index->Length[serverID] = length;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function removes the server with the largest ID from the index.   =
+//=  The server rises through the buckets above its own until it is behind  =
+//=  the last one, like a queue which grows without a bound.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - queue index                                         =
+//=          serverID - server, NumberOfServers - 1                         =
+//=  Returns: None                                                          =
+//===========================================================================
+void queueIndexRemove(QUEUE_INDEX *index, int serverID)
+{
+	int l;  // Length counter
+
+	for (l = index->Length[serverID] + 1; l <= index->MaxLength + 1; l++)
+	{
+		swapPositions(index, index->Position[serverID], index->BucketStart[l] - 1);
+		index->BucketStart[l]--;
+	}
+	index->NumberOfServers--;
+}
+
+//===========================================================================
+//=  This function returns the shortest queue length.                       =
+//===========================================================================
+int queueIndexShortestLength(const QUEUE_INDEX *index)
+{
+	return(index->Length[index->Order[0]]);
+}
+
+//===========================================================================
+//=  This function returns the number of servers with the shortest queue.   =
+//===========================================================================
+int queueIndexShortestCount(const QUEUE_INDEX *index)
+{
+	return(index->BucketStart[queueIndexShortestLength(index) + 1]);
+}
+
+//===========================================================================
+//=  This function chooses the server with the shortest queue. If several   =
+//=  servers have the shortest queue, one of them is chosen uniformly at    =
+//=  random. It takes one random number instead of one per server.          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index  - queue index                                           =
+//=          stream - random stream for the tie-breaking                    =
+//=  Returns: ID of the chosen server                                       =
+//===========================================================================
+int queueIndexPickShortest(const QUEUE_INDEX *index, RANDOM_STREAM *stream)
+{
+	int count;  // Number of servers with the shortest queue
+
+	count = queueIndexShortestCount(index);
+	if (count == 1)
+	{
+		return(index->Order[0]);
+	}
+
+	return(index->Order[randomInteger(stream, 0, count - 1)]);
+}
+
+//===========================================================================
+//=  This function groups the servers by their speeds and allocates a queue =
+//=  index for every group. Servers of the same speed form one class, and   =
+//=  the classes are ordered from the fastest. All servers have zero        =
+//=  length.                                                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index           - speed index to initialize                    =
+//=          speeds          - speed of each server                         =
+//=          numberOfServers - number of servers                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int speedIndexInit(SPEED_INDEX *index, const double *speeds, int numberOfServers)
+{
+	double speed;  // Speed of the class being moved
+	int    c;      // Class counter
+	int    i;      // Server counter
+
+	index->NumberOfServers = numberOfServers;
+	index->NumberOfClasses = 0;
+	index->ClassSpeed = (double *) malloc(sizeof(double) * numberOfServers);
+	index->ClassStart = (int *) calloc(numberOfServers + 1, sizeof(int));
+	index->Members = (int *) malloc(sizeof(int) * numberOfServers);
+	index->ClassOf = (int *) malloc(sizeof(int) * numberOfServers);
+	index->LocalID = (int *) malloc(sizeof(int) * numberOfServers);
+	index->Lengths = (int *) malloc(sizeof(int) * numberOfServers);
+	index->Classes = NULL;
+	if ((index->ClassSpeed == NULL) || (index->ClassStart == NULL) || (index->Members == NULL) ||
+		(index->ClassOf == NULL) || (index->LocalID == NULL) || (index->Lengths == NULL))
+	{
+		speedIndexFree(index);
+		return(-1);
+	}
+
+	// Distinct speeds sorted from the fastest. A fleet has few of them
+	for (i = 0; i < numberOfServers; i++)
+	{
+		c = 0;
+		while ((c < index->NumberOfClasses) && (index->ClassSpeed[c] != speeds[i]))
+		{
+			c++;
+		}
+		if (c < index->NumberOfClasses)
+		{
+			continue;
+		}
+		speed = speeds[i];
+		for (c = index->NumberOfClasses; (c > 0) && (index->ClassSpeed[c - 1] < speed); c--)
+		{
+			index->ClassSpeed[c] = index->ClassSpeed[c - 1];
+		}
+		index->ClassSpeed[c] = speed;
+		index->NumberOfClasses++;
+	}
+
+	// Count the servers of each class, then place them in the order of their IDs
+	for (i = 0; i < numberOfServers; i++)
+	{
+		c = 0;
+		while (index->ClassSpeed[c] != speeds[i])
+		{
+			c++;
+		}
+		index->ClassOf[i] = c;
+		index->ClassStart[c + 1]++;
+	}
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		index->ClassStart[c + 1] += index->ClassStart[c];
+	}
+	// Lengths counts the placed servers of each class here
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		index->Lengths[c] = 0;
+	}
+	for (i = 0; i < numberOfServers; i++)
+	{
+		c = index->ClassOf[i];
+		index->LocalID[i] = index->Lengths[c]++;
+		index->Members[index->ClassStart[c] + index->LocalID[i]] = i;
+	}
+
+	index->Classes = (QUEUE_INDEX *) calloc(index->NumberOfClasses, sizeof(QUEUE_INDEX));
+	if (index->Classes == NULL)
+	{
+		speedIndexFree(index);
+		return(-1);
+	}
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		if (queueIndexInit(&index->Classes[c], index->ClassStart[c + 1] - index->ClassStart[c]) != 0)
+		{
+			speedIndexFree(index);
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the speed index.                     =
+//===========================================================================
+void speedIndexFree(SPEED_INDEX *index)
+{
+	int c;  // Class counter
+
+	if (index->Classes != NULL)
+	{
+		for (c = 0; c < index->NumberOfClasses; c++)
+		{
+			queueIndexFree(&index->Classes[c]);
+		}
+	}
+	free(index->ClassSpeed);
+	free(index->ClassStart);
+	free(index->Members);
+	free(index->ClassOf);
+	free(index->LocalID);
+	free(index->Lengths);
+	free(index->Classes);
+	index->ClassSpeed = NULL;
+	index->ClassStart = NULL;
+	index->Members = NULL;
+	index->ClassOf = NULL;
+	index->LocalID = NULL;
+	index->Lengths = NULL;
+	index->Classes = NULL;
+}
+
+//===========================================================================
+//=  This function loads new lengths of all servers into the index of every =
+//=  class.                                                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index   - speed index                                          =
+//=          lengths - new queue length of each server                      =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int speedIndexRebuild(SPEED_INDEX *index, const int *lengths)
+{
+	int c;  // Class counter
+	int j;  // Entry counter
+
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		for (j = index->ClassStart[c]; j < index->ClassStart[c + 1]; j++)
+		{
+			index->Lengths[j - index->ClassStart[c]] = lengths[index->Members[j]];
+		}
+		if (queueIndexRebuild(&index->Classes[c], index->Lengths) != 0)
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function increments the length of the server by one.              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - speed index                                         =
+//=          serverID - server                                              =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int speedIndexIncrement(SPEED_INDEX *index, int serverID)
+{
+	return(queueIndexIncrement(&index->Classes[index->ClassOf[serverID]], index->LocalID[serverID]));
+}
+
+//===========================================================================
+//=  This function decrements the length of the server by one.              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - speed index                                         =
+//=          serverID - server with a positive length                       =
+//=  Returns: None                                                          =
+//===========================================================================
+void speedIndexDecrement(SPEED_INDEX *index, int serverID)
+{
+	queueIndexDecrement(&index->Classes[index->ClassOf[serverID]], index->LocalID[serverID]);
+}
+
+//===========================================================================
+//=  This function sets the length of one server.                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - speed index                                         =
+//=          serverID - server                                              =
+//=          length   - new length of the server                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int speedIndexSet(SPEED_INDEX *index, int serverID, int length)
+{
+	return(queueIndexSet(&index->Classes[index->ClassOf[serverID]], index->LocalID[serverID], length));
+}
+
+//===========================================================================
+//=  This function adds a server to the index of its class. The servers of  =
+//=  a class in the index must be the first ones of the class.              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - speed index                                         =
+//=          serverID - server                                              =
+//=          length   - queue length of the server                          =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int speedIndexAdd(SPEED_INDEX *index, int serverID, int length)
+{
+	index->NumberOfServers++;
+	return(queueIndexAdd(&index->Classes[index->ClassOf[serverID]], index->LocalID[serverID], length));
+}
+
+//===========================================================================
+//=  This function removes the last server of its class from the index.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index    - speed index                                         =
+//=          serverID - server                                              =
+//=  Returns: None                                                          =
+//===========================================================================
+void speedIndexRemove(SPEED_INDEX *index, int serverID)
+{
+	index->NumberOfServers--;
+	queueIndexRemove(&index->Classes[index->ClassOf[serverID]], index->LocalID[serverID]);
+}
+
+//===========================================================================
+//=  This function gives the server last the ID first and moves the         =
+//=  servers from first to last - 1 up by one ID, e.g. when a server is     =
+//=  put in front of others. None of them may be in the index. The servers  =
+//=  of every class are numbered again in the order of their IDs, so the    =
+//=  servers in the index stay the first ones of their class.               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index - speed index                                            =
+//=          first - new ID of the server last                              =
+//=          last  - moved server                                           =
+//=  Returns: None                                                          =
+//===========================================================================
+void speedIndexRotate(SPEED_INDEX *index, int first, int last)
+{
+	int moved = index->ClassOf[last];                          // Class of the moved server
+	int total = index->ClassStart[index->NumberOfClasses];     // Servers of all classes, in the index or not
+	int c;                                                     // Class counter
+	int i;                                                     // Server counter
+
+	for (i = last; i > first; i--)
+	{
+		index->ClassOf[i] = index->ClassOf[i - 1];
+	}
+	index->ClassOf[first] = moved;
+
+	// Lengths counts the numbered servers of each class here
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		index->Lengths[c] = 0;
+	}
+	for (i = 0; i < total; i++)
+	{
+		c = index->ClassOf[i];
+		index->LocalID[i] = index->Lengths[c]++;
+		index->Members[index->ClassStart[c] + index->LocalID[i]] = i;
+	}
+}
+
+//===========================================================================
+//=  This function chooses the server with the least expected wait, i.e.    =
+//=  the least (queue length + 1) / speed: the work before the customer is  =
+//=  done plus its own service. Within a class the shortest queue wins, so  =
+//=  only the shortest queue of every class is compared, and the cost is    =
+//=  proportional to the number of classes. Equal waits go to the faster    =
+//=  class. Several shortest queues of the class are chosen uniformly at    =
+//=  random with one random number.                                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: index  - speed index                                           =
+//=          stream - random stream for the tie-breaking                    =
+//=  Returns: ID of the chosen server                                       =
+//===========================================================================
+int speedIndexPickFastest(const SPEED_INDEX *index, RANDOM_STREAM *stream)
+{
+	double wait;            // Expected wait at the shortest queue of the current class
+	double bestWait = 0.0;  // Least expected wait
+	int    best;            // Class with the least expected wait
+	int    c;               // Class counter
+
+	// Classes without servers in the index are skipped
+	best = -1;
+	for (c = 0; c < index->NumberOfClasses; c++)
+	{
+		if (index->Classes[c].NumberOfServers == 0)
+		{
+			continue;
+		}
+		wait = (queueIndexShortestLength(&index->Classes[c]) + 1) / index->ClassSpeed[c];
+		if ((best < 0) || (wait < bestWait))
+		{
+			bestWait = wait;
+			best = c;
+		}
+	}
+
+	return(index->Members[index->ClassStart[best] + queueIndexPickShortest(&index->Classes[best], stream)]);
+}
+
+//===========================================================================
+//=  This function returns the rank of a server among the servers of the    =
+//=  same key: the SplitMix64 mix of the salt, the server and its current   =
+//=  key. The mix is a bijection, so the servers of one key get different   =
+//=  ranks in a random order, and a new key gives the server a new rank     =
+//=  without drawing a random number. A scan of the keys breaks its ties    =
+//=  with the same ranks as the heap.                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap     - server heap                                         =
+//=          serverID - server                                              =
+//=  Returns: rank of the server                                            =
+//===========================================================================
+unsigned long long serverHeapRank(const SERVER_HEAP *heap, int serverID)
+{
+	unsigned long long z;  // Mixed value
+
+	memcpy(&z, &heap->Key[serverID], sizeof(z));
+	z ^= heap->Salt + (unsigned long long) serverID * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return(z ^ (z >> 31));
+}
+
+//===========================================================================
+//=  This function tells whether server a comes before server b in the      =
+//=  heap: the lesser key first, and the lesser rank on equal keys. So the  =
+//=  top is one of the servers of the least key uniformly at random.        =
+//===========================================================================
+static int heapBefore(const SERVER_HEAP *heap, int a, int b)
+{
+	return((heap->Key[a] < heap->Key[b]) || ((heap->Key[a] == heap->Key[b]) && (heap->Rank[a] < heap->Rank[b])));
+}
+
+//===========================================================================
+//=  This function moves the server at the given position of the heap up    =
+//=  while it comes before its parent.                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap     - server heap                                         =
+//=          position - position of the server in Order                     =
+//=  Returns: new position of the server                                    =
+//===========================================================================
+static int siftUp(SERVER_HEAP *heap, int position)
+{
+	int serverID = heap->Order[position];  // Server which moves
+	int parent;                            // Position of the parent
+
+	while (position > 0)
+	{
+		parent = (position - 1) / 2;
+		if (!heapBefore(heap, serverID, heap->Order[parent]))
+		{
+			break;
+		}
+		heap->Order[position] = heap->Order[parent];
+		heap->Position[heap->Order[position]] = position;
+		position = parent;
+	}
+	heap->Order[position] = serverID;
+	heap->Position[serverID] = position;
+
+	return(position);
+}
+
+//===========================================================================
+//=  This function moves the server at the given position of the heap down  =
+//=  while one of its children comes before it.                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap     - server heap                                         =
+//=          position - position of the server in Order                     =
+//=  Returns: None                                                          =
+//===========================================================================
+static void siftDown(SERVER_HEAP *heap, int position)
+{
+	int serverID = heap->Order[position];  // Server which moves
+	int child;                             // Position of the first child of the two
+
+	while ((child = 2 * position + 1) < heap->NumberOfServers)
+	{
+		if ((child + 1 < heap->NumberOfServers) && heapBefore(heap, heap->Order[child + 1], heap->Order[child]))
+		{
+			child++;
+		}
+		if (!heapBefore(heap, heap->Order[child], serverID))
+		{
+			break;
+		}
+		heap->Order[position] = heap->Order[child];
+		heap->Position[heap->Order[position]] = position;
+		position = child;
+	}
+
+	heap->Order[position] = serverID;
+	heap->Position[serverID] = position;
+}
+
+//===========================================================================
+//=  This function allocates the heap of all servers and orders them by     =
+//=  their current keys.                                                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap            - server heap to initialize                    =
+//=          key             - key of each server, which must outlive heap  =
+//=          numberOfServers - number of servers                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int serverHeapInit(SERVER_HEAP *heap, const double *key, int numberOfServers)
+{
+	heap->NumberOfServers = numberOfServers;
+	heap->Key = key;
+	heap->Salt = 0;
+	heap->Order = (int *) malloc(sizeof(int) * numberOfServers);
+	heap->Position = (int *) malloc(sizeof(int) * numberOfServers);
+	heap->Rank = (unsigned long long *) malloc(sizeof(unsigned long long) * numberOfServers);
+	if ((heap->Order == NULL) || (heap->Position == NULL) || (heap->Rank == NULL))
+	{
+		serverHeapFree(heap);
+		return(-1);
+	}
+
+	serverHeapRebuild(heap);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the heap.                            =
+//===========================================================================
+void serverHeapFree(SERVER_HEAP *heap)
+{
+	free(heap->Order);
+	free(heap->Position);
+	free(heap->Rank);
+	heap->Order = NULL;
+	heap->Position = NULL;
+	heap->Rank = NULL;
+}
+
+//===========================================================================
+//=  This function draws the salt of the ranks and orders the heap again.   =
+//=  The owner calls it once before the first use, so a balancer which does =
+//=  not need the ranks draws no random number for them.                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap   - server heap                                           =
+//=          stream - random stream for the salt                            =
+//=  Returns: None                                                          =
+//===========================================================================
+void serverHeapSalt(SERVER_HEAP *heap, RANDOM_STREAM *stream)
+{
+	heap->Salt = (unsigned long long) (randomUniform01(stream) * 9007199254740992.0);
+	serverHeapRebuild(heap);
+}
+
+//===========================================================================
+//=  This function orders the heap again after the keys of many servers     =
+//=  have changed, in O(N). The IDs in the heap are 0 to                    =
+//=  NumberOfServers - 1.                                                   =
+//===========================================================================
+void serverHeapRebuild(SERVER_HEAP *heap)
+{
+	int i;  // Position counter
+
+	for (i = 0; i < heap->NumberOfServers; i++)
+	{
+		heap->Order[i] = i;
+		heap->Position[i] = i;
+		heap->Rank[i] = serverHeapRank(heap, i);
+	}
+	for (i = heap->NumberOfServers / 2 - 1; i >= 0; i--)
+	{
+		siftDown(heap, i);
+	}
+}
+
+//===========================================================================
+//=  This function restores the heap order after the key of one server has  =
+//=  changed.                                                               =
+//===========================================================================
+void serverHeapUpdate(SERVER_HEAP *heap, int serverID)
+{
+	heap->Rank[serverID] = serverHeapRank(heap, serverID);
+	siftDown(heap, siftUp(heap, heap->Position[serverID]));
+}
+
+//===========================================================================
+//=  This function adds a server to the heap. The IDs in the heap must be   =
+//=  0 to NumberOfServers - 1, so the new server is the next ID.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap     - server heap                                         =
+//=          serverID - server, NumberOfServers                             =
+//=  Returns: None                                                          =
+//===========================================================================
+void serverHeapAdd(SERVER_HEAP *heap, int serverID)
+{
+	heap->Rank[serverID] = serverHeapRank(heap, serverID);
+	heap->Order[heap->NumberOfServers] = serverID;
+	heap->Position[serverID] = heap->NumberOfServers;
+	heap->NumberOfServers++;
+	siftUp(heap, heap->Position[serverID]);
+}
+
+//===========================================================================
+//=  This function removes the server with the largest ID from the heap.    =
+//=  The last server of the heap takes its place.                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: heap     - server heap                                         =
+//=          serverID - server, NumberOfServers - 1                         =
+//=  Returns: None                                                          =
+//===========================================================================
+void serverHeapRemove(SERVER_HEAP *heap, int serverID)
+{
+	int position = heap->Position[serverID];  // Place of the removed server
+
+	heap->NumberOfServers--;
+	if (position < heap->NumberOfServers)
+	{
+		heap->Order[position] = heap->Order[heap->NumberOfServers];
+		heap->Position[heap->Order[position]] = position;
+		siftDown(heap, siftUp(heap, position));
+	}
+}
+
+//===========================================================================
+//=  This function returns the server with the least key.                   =
+//===========================================================================
+int serverHeapTop(const SERVER_HEAP *heap)
+{
+	return(heap->Order[0]);
+}
@@ -0,0 +1,73 @@
+#ifndef QUEUE_INDEX_H
+#define QUEUE_INDEX_H
+
+//----- Includes --------------------------------------------------------------
+#include "RandomStreams.h"  // Random stream for the tie-breaking
+
+//------New types--------------------------------------------------------------
+typedef struct  // Servers sorted by queue length. Every change of a length by one costs O(1)
+{
+	int  NumberOfServers;  // Number of servers in the index
+	int *Length;           // Queue length of each server as known to the index
+	int *Order;            // Server IDs sorted by queue length
+	int *Position;         // Position of each server in Order
+	int *BucketStart;      // BucketStart[l] - number of servers with queue length less than l
+	int  MaxLength;        // Largest length which BucketStart can describe
+} QUEUE_INDEX;
+
+typedef struct  // Servers grouped by speed, every group sorted by queue length
+{
+	int          NumberOfServers;  // Number of servers in the index
+	int          NumberOfClasses;  // Number of different speeds
+	double      *ClassSpeed;       // Speed of each class, the fastest first
+	int         *ClassStart;       // First entry of each class in Members, and the end of the last class
+	int         *Members;          // Server IDs grouped by class, in the order of their IDs within the class
+	int         *ClassOf;          // Class of each server
+	int         *LocalID;          // ID of each server within its class
+	int         *Lengths;          // Lengths of one class while the index is rebuilt
+	QUEUE_INDEX *Classes;          // Queue index of each class
+} SPEED_INDEX;
+
+typedef struct  // Servers in a binary min-heap by a key of each server. Every change of a key costs O(log N)
+{
+	int                 NumberOfServers;  // Number of servers in the heap
+	const double       *Key;              // Key of each server, kept up to date by the owner of the heap
+	int                *Order;            // Server IDs in heap order, the least key first
+	int                *Position;         // Position of each server in Order
+	unsigned long long *Rank;             // Order of each server among the servers of the same key
+	unsigned long long  Salt;             // Random number which the ranks are mixed from
+} SERVER_HEAP;
+
+//----- Prototypes ------------------------------------------------------------
+int  queueIndexInit(QUEUE_INDEX *index, int numberOfServers);
+void queueIndexFree(QUEUE_INDEX *index);
+int  queueIndexRebuild(QUEUE_INDEX *index, const int *lengths);
+int  queueIndexIncrement(QUEUE_INDEX *index, int serverID);
+void queueIndexDecrement(QUEUE_INDEX *index, int serverID);
+int  queueIndexSet(QUEUE_INDEX *index, int serverID, int length);
+int  queueIndexAdd(QUEUE_INDEX *index, int serverID, int length);
+void queueIndexRemove(QUEUE_INDEX *index, int serverID);
+int  queueIndexShortestLength(const QUEUE_INDEX *index);
+int  queueIndexShortestCount(const QUEUE_INDEX *index);
+int  queueIndexPickShortest(const QUEUE_INDEX *index, RANDOM_STREAM *stream);
+int  speedIndexInit(SPEED_INDEX *index, const double *speeds, int numberOfServers);
+void speedIndexFree(SPEED_INDEX *index);
+int  speedIndexRebuild(SPEED_INDEX *index, const int *lengths);
+int  speedIndexIncrement(SPEED_INDEX *index, int serverID);
+void speedIndexDecrement(SPEED_INDEX *index, int serverID);
+int  speedIndexSet(SPEED_INDEX *index, int serverID, int length);
+int  speedIndexAdd(SPEED_INDEX *index, int serverID, int length);
+void speedIndexRemove(SPEED_INDEX *index, int serverID);
+void speedIndexRotate(SPEED_INDEX *index, int first, int last);
+int  speedIndexPickFastest(const SPEED_INDEX *index, RANDOM_STREAM *stream);
+int  serverHeapInit(SERVER_HEAP *heap, const double *key, int numberOfServers);
+void serverHeapFree(SERVER_HEAP *heap);
+void serverHeapSalt(SERVER_HEAP *heap, RANDOM_STREAM *stream);
+unsigned long long serverHeapRank(const SERVER_HEAP *heap, int serverID);
+void serverHeapRebuild(SERVER_HEAP *heap);
+void serverHeapUpdate(SERVER_HEAP *heap, int serverID);
+void serverHeapAdd(SERVER_HEAP *heap, int serverID);
+void serverHeapRemove(SERVER_HEAP *heap, int serverID);
+int  serverHeapTop(const SERVER_HEAP *heap);
+
+#endif
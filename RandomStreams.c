@@ -0,0 +1,318 @@
+//----- Includes --------------------------------------------------------------
+#include <math.h>           // Needed for log()
+#include <string.h>         // Needed for memset() and memcmp()
+#include "RandomStreams.h"  // Random stream types and prototypes
+
+//----- Constants -------------------------------------------------------------
+#define PHILOX_BLOCKS (RANDOM_BLOCK_WORDS / 2)  // Blocks of 128 bits in the buffer
+#define PHILOX_ROUNDS 10                        // Rounds of Philox4x32-10
+#define PHILOX_M0     0xD2511F53ULL             // Multiplier of the first and second words
+#define PHILOX_M1     0xCD9E8D57ULL             // Multiplier of the third and fourth words
+#define PHILOX_W0     0x9E3779B9U               // Increment of the first key word in every round
+#define PHILOX_W1     0xBB67AE85U               // Increment of the second key word in every round
+
+//===========================================================================
+//=  This function advances the SplitMix64 generator. It is used only to    =
+//=  spread a single user seed over the whole Philox key.                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: seed - SplitMix64 state, advanced in place                     =
+//=  Returns: next 64-bit output of the generator                           =
+//===========================================================================
+static unsigned long long splitMix64(unsigned long long *seed)
+{
+	unsigned long long z;  // Mixed value
+
+	*seed += 0x9E3779B97F4A7C15ULL;
+	z = *seed;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return(z ^ (z >> 31));
+}
+
+//===========================================================================
+//=  This function generates the next RANDOM_BLOCK_WORDS words of the       =
+//=  stream into its buffer. The stream is a Philox4x32-10 generator: every =
+//=  block of 128 bits is its counter encrypted with the key in 10 rounds   =
+//=  of multiplications. The blocks do not depend on each other, so every   =
+//=  round runs over all blocks of the buffer at once and the processor     =
+//=  overlaps their multiplications. The loop over the blocks has no        =
+//=  branches, so a compiler may also vectorize it.                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=  Returns: None                                                          =
+//===========================================================================
+static void refillBuffer(RANDOM_STREAM *stream)
+{
+	unsigned int       x0[PHILOX_BLOCKS];    // First word of each block, counter at first
+	unsigned int       x1[PHILOX_BLOCKS];    // Second word of each block
+	unsigned int       x2[PHILOX_BLOCKS];    // Third word of each block
+	unsigned int       x3[PHILOX_BLOCKS];    // Fourth word of each block
+	unsigned int       k0 = stream->Key[0];  // First word of the round key
+	unsigned int       k1 = stream->Key[1];  // Second word of the round key
+	unsigned long long position;             // Position of the first block
+	unsigned long long p0;                   // Product of the first multiplier
+	unsigned long long p1;                   // Product of the second multiplier
+	int                round;                // Round counter
+	int                b;                    // Block counter
+
+	position = ((unsigned long long) stream->Counter[1] << 32) | stream->Counter[0];
+	for (b = 0; b < PHILOX_BLOCKS; b++)
+	{
+		x0[b] = (unsigned int) (position + b);
+		x1[b] = (unsigned int) ((position + b) >> 32);
+		x2[b] = stream->Counter[2];
+		x3[b] = stream->Counter[3];
+	}
+
+	for (round = 0; round < PHILOX_ROUNDS; round++)
+	{
+		for (b = 0; b < PHILOX_BLOCKS; b++)
+		{
+			p0 = PHILOX_M0 * x0[b];
+			p1 = PHILOX_M1 * x2[b];
+			x0[b] = (unsigned int) (p1 >> 32) ^ x1[b] ^ k0;
+			x1[b] = (unsigned int) p1;
+			x2[b] = (unsigned int) (p0 >> 32) ^ x3[b] ^ k1;
+			x3[b] = (unsigned int) p0;
+		}
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	for (b = 0; b < PHILOX_BLOCKS; b++)
+	{
+		stream->Buffer[2 * b] = ((unsigned long long) x1[b] << 32) | x0[b];
+		stream->Buffer[2 * b + 1] = ((unsigned long long) x3[b] << 32) | x2[b];
+	}
+	position += PHILOX_BLOCKS;
+	stream->Counter[0] = (unsigned int) position;
+	stream->Counter[1] = (unsigned int) (position >> 32);
+	stream->Next = 0;
+}
+
+//===========================================================================
+//=  This function returns next 64 random bits of the stream from its       =
+//=  buffer, which is refilled when it is used up.                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=  Returns: 64 random bits                                                =
+//===========================================================================
+static unsigned long long nextRandomBits(RANDOM_STREAM *stream)
+{
+	if (stream->Next == RANDOM_BLOCK_WORDS)
+	{
+		refillBuffer(stream);
+	}
+
+	return(stream->Buffer[stream->Next++]);
+}
+
+//===========================================================================
+//=  This function turns 64 random bits into a double in (0, 1). The upper  =
+//=  53 bits give the mantissa, 0.5 moves the value off zero.               =
+//===========================================================================
+static double bitsToUniform01(unsigned long long bits)
+{
+	return(((double) (bits >> 11) + 0.5) * (1.0 / 9007199254740992.0));
+}
+
+//===========================================================================
+//=  This function initializes the random stream from the seed. The seed    =
+//=  gives the key, so different seeds give unrelated streams. The stream   =
+//=  starts at substream 0 and stream 0 of the key.                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream to initialize                           =
+//=          seed   - seed of the stream                                    =
+//=  Returns: None                                                          =
+//===========================================================================
+void randomStreamInit(RANDOM_STREAM *stream, unsigned long long seed)
+{
+	unsigned long long key;  // Key made from the seed
+
+	key = splitMix64(&seed);
+	memset(stream, 0, sizeof(RANDOM_STREAM));
+	stream->Key[0] = (unsigned int) key;
+	stream->Key[1] = (unsigned int) (key >> 32);
+	stream->Next = RANDOM_BLOCK_WORDS;
+}
+
+//===========================================================================
+//=  This function moves the stream to the start of the next stream of the  =
+//=  same key. Each one has 2^64 blocks, so streams which are jumped a      =
+//=  different number of times never overlap, and every replication can     =
+//=  get its own stream. The jump only changes the counter.                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=  Returns: None                                                          =
+//===========================================================================
+void randomStreamJump(RANDOM_STREAM *stream)
+{
+	stream->Counter[0] = 0;
+	stream->Counter[1] = 0;
+	stream->Counter[3]++;
+	stream->Next = RANDOM_BLOCK_WORDS;
+}
+
+//===========================================================================
+//=  This function makes an independent child stream for one purpose, such  =
+//=  as arrivals or service times. The child has the key and the stream of  =
+//=  the parent and its own substream, so the numbers drawn for one purpose =
+//=  do not depend on how many were drawn for the others.                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream    - parent stream                                      =
+//=          substream - number of the child, the same number gives the     =
+//=                      same child                                         =
+//=          child     - place to store the child stream                    =
+//=  Returns: None                                                          =
+//===========================================================================
+void randomStreamSplit(const RANDOM_STREAM *stream, unsigned int substream, RANDOM_STREAM *child)
+{
+	*child = *stream;
+	child->Counter[0] = 0;
+	child->Counter[1] = 0;
+	child->Counter[2] = substream;
+	child->Next = RANDOM_BLOCK_WORDS;
+}
+
+//===========================================================================
+//=  This function checks whether two streams are at the same position, so  =
+//=  that they will draw the same numbers.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: first, second - random streams                                 =
+//=  Returns: 1 if the streams are at the same position, 0 otherwise        =
+//===========================================================================
+int randomStreamSameState(const RANDOM_STREAM *first, const RANDOM_STREAM *second)
+{
+	return((memcmp(first->Key, second->Key, sizeof(first->Key)) == 0) &&
+		(memcmp(first->Counter, second->Counter, sizeof(first->Counter)) == 0) && (first->Next == second->Next));
+}
+
+//===========================================================================
+//=  This function generates a uniformly distributed double in (0, 1).      =
+//=  Zero is never returned, so the value is safe to pass to log().         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=  Returns: random double from (0, 1)                                     =
+//===========================================================================
+double randomUniform01(RANDOM_STREAM *stream)
+{
+	return(bitsToUniform01(nextRandomBits(stream)));
+}
+
+//===========================================================================
+//=  This function generates a uniformly distributed double in the range    =
+//=  from minValue to maxValue. It is the analogue of CSIM uniform().       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream   - random stream                                       =
+//=          minValue - lower bound                                         =
+//=          maxValue - upper bound                                         =
+//=  Returns: random double                                                 =
+//===========================================================================
+double randomUniform(RANDOM_STREAM *stream, double minValue, double maxValue)
+{
+	return(minValue + (maxValue - minValue) * randomUniform01(stream));
+}
+
+//===========================================================================
+//=  This function generates an exponentially distributed double with the   =
+//=  given mean. It is the analogue of CSIM exponential().                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=          mean   - mean of the distribution                              =
+//=  Returns: random double                                                 =
+//===========================================================================
+double randomExponential(RANDOM_STREAM *stream, double mean)
+{
+	return(-mean * log(randomUniform01(stream)));
+}
+
+//===========================================================================
+//=  This function generates a random integer between minValue and maxValue =
+//=  (both inclusive). It is the analogue of generateRandomInteger() of the =
+//=  CSIM model, but needs no floating point: the upper 32 random bits      =
+//=  times the number of values give the value in the upper half of the     =
+//=  product (Lemire's method). The rare products whose lower half falls in =
+//=  the short first part of a value are drawn again, so every value has    =
+//=  the same probability. The test needs a division only in that case.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream   - random stream                                       =
+//=          minValue - minimum desired integer                             =
+//=          maxValue - maximum desired integer                             =
+//=  Returns: random integer                                                =
+//===========================================================================
+int randomInteger(RANDOM_STREAM *stream, int minValue, int maxValue)
+{
+	unsigned long long range;      // Number of values, from 1 to 2^32
+	unsigned long long product;    // 32 random bits times range
+	unsigned long long threshold;  // Lower halves below it are drawn again
+
+	range = (unsigned long long) ((long long) maxValue - minValue + 1);
+	product = (nextRandomBits(stream) >> 32) * range;
+	if ((product & 0xFFFFFFFFULL) < range)
+	{
+		threshold = (0x100000000ULL - range) % range;
+		while ((product & 0xFFFFFFFFULL) < threshold)
+		{
+			product = (nextRandomBits(stream) >> 32) * range;
+		}
+	}
+
+	return((int) ((long long) minValue + (long long) (product >> 32)));
+}
+
+//===========================================================================
+//=  This function fills an array with uniformly distributed doubles in     =
+//=  (0, 1). It converts whole runs of the buffer at once, and gives the    =
+//=  same values as count calls of randomUniform01().                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=          values - place for the values                                  =
+//=          count  - number of values                                      =
+//=  Returns: None                                                          =
+//===========================================================================
+void randomFillUniform01(RANDOM_STREAM *stream, double *values, int count)
+{
+	const unsigned long long *words;   // Unused words of the buffer
+	int                       length;  // Number of values taken from the buffer at once
+	int                       i;       // Value counter
+
+	while (count > 0)
+	{
+		if (stream->Next == RANDOM_BLOCK_WORDS)
+		{
+			refillBuffer(stream);
+		}
+		words = stream->Buffer + stream->Next;
+		length = (RANDOM_BLOCK_WORDS - stream->Next < count) ? RANDOM_BLOCK_WORDS - stream->Next : count;
+		for (i = 0; i < length; i++)
+		{
+			values[i] = bitsToUniform01(words[i]);
+		}
+		stream->Next += length;
+		values += length;
+		count -= length;
+	}
+}
+
+//===========================================================================
+//=  This function fills an array with exponentially distributed doubles    =
+//=  with the given mean. It gives the same values as count calls of        =
+//=  randomExponential().                                                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: stream - random stream                                         =
+//=          mean   - mean of the distribution                              =
+//=          values - place for the values                                  =
+//=          count  - number of values                                      =
+//=  Returns: None                                                          =
+//===========================================================================
+void randomFillExponential(RANDOM_STREAM *stream, double mean, double *values, int count)
+{
+	int i;  // Value counter
+
+	randomFillUniform01(stream, values, count);
+	for (i = 0; i < count; i++)
+	{
+		values[i] = -mean * log(values[i]);
+	}
+}
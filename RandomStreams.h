@@ -0,0 +1,28 @@
+#ifndef RANDOM_STREAMS_H
+#define RANDOM_STREAMS_H
+
+//----- Constants -------------------------------------------------------------
+#define RANDOM_BLOCK_WORDS 32  // 64-bit words generated at once (16 Philox blocks)
+
+//------New types--------------------------------------------------------------
+typedef struct  // State of one independent pseudo random number stream
+{
+	unsigned int       Key[2];                      // Philox key, made from the seed
+	unsigned int       Counter[4];                  // Next block: position (low, high), substream, stream
+	unsigned long long Buffer[RANDOM_BLOCK_WORDS];  // Generated words
+	int                Next;                        // Index of the next unused word of Buffer
+} RANDOM_STREAM;
+
+//----- Prototypes ------------------------------------------------------------
+void   randomStreamInit(RANDOM_STREAM *stream, unsigned long long seed);
+void   randomStreamJump(RANDOM_STREAM *stream);
+void   randomStreamSplit(const RANDOM_STREAM *stream, unsigned int substream, RANDOM_STREAM *child);
+int    randomStreamSameState(const RANDOM_STREAM *first, const RANDOM_STREAM *second);
+double randomUniform01(RANDOM_STREAM *stream);
+double randomUniform(RANDOM_STREAM *stream, double minValue, double maxValue);
+double randomExponential(RANDOM_STREAM *stream, double mean);
+int    randomInteger(RANDOM_STREAM *stream, int minValue, int maxValue);
+void   randomFillUniform01(RANDOM_STREAM *stream, double *values, int count);
+void   randomFillExponential(RANDOM_STREAM *stream, double mean, double *values, int count);
+
+#endif
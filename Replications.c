@@ -0,0 +1,344 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>         // Needed for I/O functions
+#include <stdlib.h>        // Needed for calloc() and free()
+#include <pthread.h>       // Needed for the worker threads
+#include <time.h>          // Needed for clock_gettime()
+#include <unistd.h>        // Needed for sysconf()
+#include "Replications.h"  // Replication mode types and prototypes
+
+//------New types--------------------------------------------------------------
+typedef struct  // State shared by the worker threads
+{
+	const REPLICATION_CONFIG     *Config;           // Parameters of the mode
+	const REPLICATION_EXPERIMENT *Experiment;       // What every replication computes
+	REPLICATION_RESULT           *Result;           // Pooled result
+	pthread_mutex_t               Mutex;            // Protects all fields below
+	char                         *Done;             // Whether each replication is finished
+	int                           NextReplication;  // Index of the next replication to start
+	int                           CompletedPrefix;  // Number of finished replications 0, 1, 2 ... without gaps
+	double                        StartTime;        // Wall clock at the start of the mode
+	int                           Stop;             // Whether the workers must not start new replications
+} REPLICATION_POOL;
+
+//===========================================================================
+//=  This function returns the wall clock time in seconds.                  =
+//===========================================================================
+double wallClock(void)
+{
+	struct timespec now;  // Current time
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return(now.tv_sec + now.tv_nsec * 1e-9);
+}
+
+//===========================================================================
+//=  This function returns the number of online processor cores.            =
+//===========================================================================
+int numberOfCores(void)
+{
+	long cores;  // Number of cores reported by the system
+
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return((cores > 0) ? (int) cores : 1);
+}
+
+//===========================================================================
+//=  This function fills the configuration of the replication mode with     =
+//=  the default values: one thread per core and REPLICATION_LENGTH         =
+//=  customers in every replication.                                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - configuration to fill                                 =
+//=  Returns: None                                                          =
+//===========================================================================
+void defaultReplicationConfig(REPLICATION_CONFIG *config)
+{
+	defaultConfig(&config->Simulation);
+	config->Simulation.RunLength = REPLICATION_LENGTH;
+	config->NumberOfThreads = numberOfCores();
+	config->MinReplications = MIN_REPLICATIONS;
+	config->MaxReplications = MAX_REPLICATIONS;
+}
+
+//===========================================================================
+//=  This function runs one replication of the simulation. Every            =
+//=  replication has its own simulation state (QueueLength, ArrivalCounter, =
+//=  RoundRobinServerIDCounter and so on) and its own random stream.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: context      - parameters of the mode (REPLICATION_CONFIG)     =
+//=          replication  - index of the replication                        =
+//=          values       - place to store the response time statistic      =
+//=          eventCounter - place to store the number of processed events   =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+static int meanResponseReplication(const void *context, int replication, double *values, long long *eventCounter)
+{
+	const REPLICATION_CONFIG *config = (const REPLICATION_CONFIG *) context;  // Parameters of the mode
+	SIMULATION_CONFIG         simulationConfig;                               // Parameters of the replication
+	SIMULATION_STATE          state;                                          // State of the replication
+	int                       result;                                         // Result of the replication
+
+	values[0] = 0.0;
+	*eventCounter = 0;
+	simulationConfig = config->Simulation;
+	simulationConfig.Stream = replication;
+	if (simulationInit(&state, &simulationConfig) != 0)
+	{
+		return(-1);
+	}
+
+	result = runSimulation(&state);
+	values[0] = responseTimeStatistic(&state);
+	*eventCounter = state.EventCounter;
+
+	simulationFree(&state);
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function checks whether the pooled confidence interval of the     =
+//=  response time statistic achieves the desired ACCURACY.                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: context      - parameters of the mode (REPLICATION_CONFIG)     =
+//=          values       - statistic of each replication                   =
+//=          replications - number of replications                          =
+//=  Returns: 1 if the replications may stop, 0 otherwise                   =
+//===========================================================================
+static int meanResponseConverged(const void *context, const double *values, int replications)
+{
+	const REPLICATION_CONFIG *config = (const REPLICATION_CONFIG *) context;  // Parameters of the mode
+	double                    halfWidth;                                      // Half-width of the interval
+	double                    mean;                                           // Pooled mean
+
+	halfWidth = sampleHalfWidth(values, replications, config->Simulation.CiLevel, &mean);
+
+	return((halfWidth >= 0.0) && (halfWidth <= config->Simulation.Accuracy * mean));
+}
+
+//===========================================================================
+//=  Worker thread. It takes the next replication index, runs the           =
+//=  replication and stores its results. After that it checks whether the   =
+//=  replications 0 .. k-1 without gaps pass the convergence test. The test =
+//=  uses only the prefix of replications, so the answer does not depend on =
+//=  the order in which the threads finish.                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argument - replication pool shared by the threads              =
+//=  Returns: NULL                                                          =
+//===========================================================================
+static void *replicationWorker(void *argument)
+{
+	REPLICATION_POOL             *pool = (REPLICATION_POOL *) argument;  // Shared state
+	const REPLICATION_CONFIG     *config = pool->Config;                 // Parameters of the mode
+	const REPLICATION_EXPERIMENT *experiment = pool->Experiment;         // What every replication computes
+	REPLICATION_RESULT           *result = pool->Result;                 // Pooled result
+	double                       *values;                                // Results of the current replication
+	int                           replication;                           // Index of the current replication
+	long long                     eventCounter;                          // Events of the current replication
+	int                           broken;                                // Whether the replication failed
+	int                           i;                                     // Loop counter
+
+	values = (double *) calloc(experiment->NumberOfValues, sizeof(double));
+	if (values == NULL)
+	{
+		return(NULL);
+	}
+
+	while (1)
+	{
+		// Take the next replication
+		pthread_mutex_lock(&pool->Mutex);
+		if (pool->Stop || (pool->NextReplication >= config->MaxReplications) ||
+			(wallClock() - pool->StartTime > config->Simulation.MaxTime))
+		{
+			pthread_mutex_unlock(&pool->Mutex);
+			break;
+		}
+		replication = pool->NextReplication++;
+		pthread_mutex_unlock(&pool->Mutex);
+
+		broken = (experiment->Run(experiment->Context, replication, values, &eventCounter) != 0);
+
+		// Store the result and check the convergence
+		pthread_mutex_lock(&pool->Mutex);
+		result->EventCounter += eventCounter;
+		if (broken)
+		{
+			result->Broken = 1;
+			pool->Stop = 1;
+		}
+		else if (!pool->Stop)
+		{
+			for (i = 0; i < experiment->NumberOfValues; i++)
+			{
+				result->Values[replication * experiment->NumberOfValues + i] = values[i];
+			}
+			pool->Done[replication] = 1;
+			// Test every new prefix length, so the stop point is the same for any number of threads
+			while (!pool->Stop && (pool->CompletedPrefix < config->MaxReplications) &&
+				pool->Done[pool->CompletedPrefix])
+			{
+				pool->CompletedPrefix++;
+				result->Replications = pool->CompletedPrefix;
+				if ((pool->CompletedPrefix >= config->MinReplications) &&
+					experiment->Test(experiment->Context, result->Values, pool->CompletedPrefix))
+				{
+					result->Converged = 1;
+					pool->Stop = 1;
+				}
+			}
+		}
+		pthread_mutex_unlock(&pool->Mutex);
+	}
+
+	free(values);
+
+	return(NULL);
+}
+
+//===========================================================================
+//=  This function runs independent replications of the experiment on       =
+//=  NumberOfThreads threads until the results of the replications pass     =
+//=  the convergence test, or MaxReplications are done, or MAX_TIME of wall =
+//=  clock time is spent.                                                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config     - parameters of the mode                            =
+//=          experiment - what every replication computes                   =
+//=          result     - place to store the pooled result                  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runExperiment(const REPLICATION_CONFIG *config, const REPLICATION_EXPERIMENT *experiment,
+	REPLICATION_RESULT *result)
+{
+	REPLICATION_POOL pool;     // State shared by the worker threads
+	pthread_t       *threads;  // Worker threads
+	int              started;  // Number of started threads
+	int              i;        // Loop counter
+
+	result->Replications = 0;
+	result->Started = 0;
+	result->Mean = 0.0;
+	result->HalfWidth = -1.0;
+	result->Converged = 0;
+	result->EventCounter = 0;
+	result->WallTime = 0.0;
+	result->Broken = 0;
+	result->NumberOfValues = experiment->NumberOfValues;
+	result->Values = (double *) calloc((size_t) config->MaxReplications * experiment->NumberOfValues, sizeof(double));
+	pool.Done = (char *) calloc(config->MaxReplications, sizeof(char));
+	threads = (pthread_t *) calloc(config->NumberOfThreads, sizeof(pthread_t));
+	if ((result->Values == NULL) || (pool.Done == NULL) || (threads == NULL))
+	{
+		free(pool.Done);
+		free(threads);
+		freeReplicationResult(result);
+		return(-1);
+	}
+
+	pool.Config = config;
+	pool.Experiment = experiment;
+	pool.Result = result;
+	pool.NextReplication = 0;
+	pool.CompletedPrefix = 0;
+	pool.Stop = 0;
+	pool.StartTime = wallClock();
+	pthread_mutex_init(&pool.Mutex, NULL);
+
+	started = 0;
+	for (i = 0; i < config->NumberOfThreads; i++)
+	{
+		if (pthread_create(&threads[i], NULL, replicationWorker, &pool) == 0)
+		{
+			started++;
+		}
+	}
+	// If no thread could be started run the replications in this thread
+	if (started == 0)
+	{
+		replicationWorker(&pool);
+	}
+	for (i = 0; i < started; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	result->Started = pool.NextReplication;
+	result->WallTime = wallClock() - pool.StartTime;
+
+	pthread_mutex_destroy(&pool.Mutex);
+	free(pool.Done);
+	free(threads);
+
+	return(result->Broken ? -1 : 0);
+}
+
+//===========================================================================
+//=  This function runs independent replications of the simulation until    =
+//=  the pooled confidence interval of the mean response time achieves the  =
+//=  desired ACCURACY with CI_LEVEL probability.                            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the mode                                =
+//=          result - place to store the pooled result                      =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runReplications(const REPLICATION_CONFIG *config, REPLICATION_RESULT *result)
+{
+	REPLICATION_EXPERIMENT experiment;  // Mean response time of every replication
+	int                    status;      // Result of the replications
+
+	experiment.Run = meanResponseReplication;
+	experiment.Test = meanResponseConverged;
+	experiment.Context = config;
+	experiment.NumberOfValues = 1;
+
+	status = runExperiment(config, &experiment, result);
+	if (result->Values != NULL)
+	{
+		result->HalfWidth = sampleHalfWidth(result->Values, result->Replications, config->Simulation.CiLevel,
+			&result->Mean);
+	}
+
+	return(status);
+}
+
+//===========================================================================
+//=  This function frees the memory of the pooled result.                   =
+//===========================================================================
+void freeReplicationResult(REPLICATION_RESULT *result)
+{
+	free(result->Values);
+	result->Values = NULL;
+}
+
+//===========================================================================
+//=  This function prints the pooled result of the replication mode.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the mode                                =
+//=          result - pooled result                                         =
+//=  Returns: None                                                          =
+//===========================================================================
+void printReplicationReport(const REPLICATION_CONFIG *config, const REPLICATION_RESULT *result)
+{
+	printf("Load balancer: %s\n", balancerName(config->Simulation.LoadBalancer));
+	printf("Threads: %d\n", config->NumberOfThreads);
+	printf("Customers per replication: %lld\n", config->Simulation.RunLength);
+	printf("Replications pooled: %d (started %d)\n", result->Replications, result->Started);
+	if (result->HalfWidth >= 0.0)
+	{
+		printStatisticName(&config->Simulation);
+		printf(": %.6f +/- %.6f (%.0f%% CI, %s)\n", result->Mean, result->HalfWidth,
+			config->Simulation.CiLevel * 100.0, result->Converged ? "converged" : "not converged");
+	}
+	else
+	{
+		printStatisticName(&config->Simulation);
+		printf(": %.6f (not enough replications for a CI)\n", result->Mean);
+	}
+	printf("Events processed: %lld\n", result->EventCounter);
+	printf("Wall time: %.3f s\n", result->WallTime);
+	if (result->WallTime > 0.0)
+	{
+		printf("Events per second: %.0f\n", result->EventCounter / result->WallTime);
+	}
+}
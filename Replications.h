@@ -0,0 +1,58 @@
+#ifndef REPLICATIONS_H
+#define REPLICATIONS_H
+
+//----- Includes --------------------------------------------------------------
+#include "StandaloneModel.h"  // Simulation model
+
+//----- Constants -------------------------------------------------------------
+#define MIN_REPLICATIONS   10       // Minimum number of replications before the convergence test
+#define MAX_REPLICATIONS   10000    // Default maximum number of replications
+#define REPLICATION_LENGTH 100000   // Default number of customers served in one replication
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the replication mode
+{
+	SIMULATION_CONFIG Simulation;       // Parameters of every replication. Stream is set per replication
+	int               NumberOfThreads;  // Number of worker threads
+	int               MinReplications;  // Minimum number of replications before the convergence test
+	int               MaxReplications;  // Maximum number of replications
+} REPLICATION_CONFIG;
+
+// Runs one replication and stores its NumberOfValues results. Returns 0 on success, -1 on error
+typedef int (*REPLICATION_FUNCTION)(const void *context, int replication, double *values, long long *eventCounter);
+// Checks the results of replications 0 .. replications-1. Returns 1 if the experiment may stop
+typedef int (*CONVERGENCE_TEST)(const void *context, const double *values, int replications);
+
+typedef struct  // What every replication computes and when the replications may stop
+{
+	REPLICATION_FUNCTION Run;             // Runs one replication
+	CONVERGENCE_TEST     Test;            // Convergence test of the pooled results
+	const void          *Context;         // Passed to Run and Test
+	int                  NumberOfValues;  // Number of results of one replication
+} REPLICATION_EXPERIMENT;
+
+typedef struct  // Pooled result of independent replications
+{
+	int       Replications;    // Number of replications in the pooled estimate
+	int       Started;         // Number of started replications (some may be discarded)
+	double    Mean;            // Pooled response time statistic (mean or percentile)
+	double    HalfWidth;       // Half-width of the confidence interval of the mean
+	int       Converged;       // Whether the convergence test has passed
+	long long EventCounter;    // Number of events processed by all replications
+	double    WallTime;        // Wall clock time of the whole mode in seconds
+	int       NumberOfValues;  // Number of results of one replication
+	double   *Values;          // Results of each replication in replication order
+	int       Broken;          // Whether some replication has stopped with an error
+} REPLICATION_RESULT;
+
+//----- Prototypes ------------------------------------------------------------
+void   defaultReplicationConfig(REPLICATION_CONFIG *config);
+int    runExperiment(const REPLICATION_CONFIG *config, const REPLICATION_EXPERIMENT *experiment,
+	REPLICATION_RESULT *result);
+int    runReplications(const REPLICATION_CONFIG *config, REPLICATION_RESULT *result);
+void   freeReplicationResult(REPLICATION_RESULT *result);
+void   printReplicationReport(const REPLICATION_CONFIG *config, const REPLICATION_RESULT *result);
+int    numberOfCores(void);
+double wallClock(void);
+
+#endif
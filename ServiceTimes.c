@@ -0,0 +1,269 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>         // Needed for I/O functions
+#include <stdlib.h>        // Needed for strtod(), realloc() and free()
+#include <math.h>          // Needed for log(), exp(), sqrt(), cos() and pow()
+#include "ServiceTimes.h"  // Service distribution type and prototypes
+
+//----- Constants -------------------------------------------------------------
+#define SERVICE_CHUNK  32                 // Demands whose random numbers are drawn at once
+#define LINE_LENGTH    256                // Longest line of the file of the empirical values
+#define INITIAL_VALUES 1024               // Values allocated for the file at first
+#define TWO_PI         6.283185307179586  // Period of cos() in the Box-Muller transform
+
+//===========================================================================
+//=  This function returns the human readable name of the distribution.     =
+//===========================================================================
+const char *serviceName(enum SERVICE_TYPE type)
+{
+	switch (type)
+	{
+	case exponentialService:      return("Exponential");
+	case deterministicService:    return("Deterministic");
+	case hyperexponentialService: return("Hyperexponential");
+	case lognormalService:        return("Lognormal");
+	case paretoService:           return("Pareto");
+	case empiricalService:        return("Empirical");
+	}
+
+	return("Unknown");
+}
+
+//===========================================================================
+//=  This function sets up the distribution with the given mean and derives =
+//=  the parameters of its draws. The hyperexponential distribution has two =
+//=  phases with balanced means, p1 / mu1 = p2 / mu2, which is the usual    =
+//=  fit of a variation of at least 1. The Pareto distribution starts at    =
+//=  mean * (shape - 1) / shape. The empirical values are scaled so that    =
+//=  their mean is the given mean, so they only give the shape.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: service        - distribution to set up                        =
+//=          type           - distribution                                  =
+//=          mean           - mean demand                                   =
+//=          variation      - squared coefficient of variation of the       =
+//=                           hyperexponential and lognormal distributions  =
+//=          shape          - shape of the Pareto distribution              =
+//=          values         - values of the empirical distribution          =
+//=          numberOfValues - number of values                              =
+//=  Returns: 0 on success, -1 if the parameters are not valid              =
+//===========================================================================
+int serviceInit(SERVICE_TIMES *service, enum SERVICE_TYPE type, double mean, double variation, double shape,
+	const double *values, int numberOfValues)
+{
+	double sum = 0.0;    // Sum of the empirical values
+	double logVariance;  // Variance of the logarithm of the lognormal demand
+	int    i;            // Value counter
+
+	service->Type = type;
+	service->Mean = mean;
+	service->Variation = variation;
+	service->Shape = shape;
+	service->Values = values;
+	service->NumberOfValues = numberOfValues;
+	service->FirstChance = 1.0;
+	service->FirstMean = mean;
+	service->SecondMean = mean;
+	service->LogMean = 0.0;
+	service->LogDeviation = 0.0;
+	service->Scale = 1.0;
+
+	switch (type)
+	{
+	case hyperexponentialService:
+		if (variation < 1.0)
+		{
+			printf("ERROR! The hyperexponential distribution needs a variation of at least 1\n");
+			return(-1);
+		}
+		service->FirstChance = 0.5 * (1.0 + sqrt((variation - 1.0) / (variation + 1.0)));
+		service->FirstMean = mean / (2.0 * service->FirstChance);
+		service->SecondMean = mean / (2.0 * (1.0 - service->FirstChance));
+		break;
+	case lognormalService:
+		if (variation <= 0.0)
+		{
+			printf("ERROR! The lognormal distribution needs a positive variation\n");
+			return(-1);
+		}
+		logVariance = log(1.0 + variation);
+		service->LogMean = log(mean) - 0.5 * logVariance;
+		service->LogDeviation = sqrt(logVariance);
+		break;
+	case paretoService:
+		if (shape <= 1.0)
+		{
+			printf("ERROR! The Pareto distribution needs a shape greater than 1, otherwise it has no mean\n");
+			return(-1);
+		}
+		service->Scale = mean * (shape - 1.0) / shape;
+		break;
+	case empiricalService:
+		for (i = 0; i < numberOfValues; i++)
+		{
+			sum += values[i];
+		}
+		if ((numberOfValues < 1) || (sum <= 0.0))
+		{
+			printf("ERROR! The empirical distribution needs values with a positive mean\n");
+			return(-1);
+		}
+		service->Scale = mean * numberOfValues / sum;
+		break;
+	default:
+		break;
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function fills an array with the service demands of count         =
+//=  customers. The random numbers of SERVICE_CHUNK demands are drawn at    =
+//=  once. Exponential demands are the same as those of                     =
+//=  randomFillExponential(), and deterministic demands draw nothing. The   =
+//=  hyperexponential and lognormal demands take two random numbers each    =
+//=  (the phase and the exponential, or the two of Box-Muller), the others  =
+//=  one.                                                                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: service - distribution                                         =
+//=          stream  - random stream of the service demands                 =
+//=          demands - place for the demands                                =
+//=          count   - number of demands                                    =
+//=  Returns: None                                                          =
+//===========================================================================
+void serviceFill(const SERVICE_TIMES *service, RANDOM_STREAM *stream, double *demands, int count)
+{
+	double uniforms[2 * SERVICE_CHUNK];  // Random numbers of the current chunk
+	double exponent;                     // Power of the uniform number which gives the Pareto demand
+	int    length;                       // Demands of the current chunk
+	int    index;                        // Drawn empirical value
+	int    i;                            // Demand counter
+
+	if (service->Type == exponentialService)
+	{
+		randomFillExponential(stream, service->Mean, demands, count);
+		return;
+	}
+	if (service->Type == deterministicService)
+	{
+		for (i = 0; i < count; i++)
+		{
+			demands[i] = service->Mean;
+		}
+		return;
+	}
+
+	exponent = -1.0 / service->Shape;
+	while (count > 0)
+	{
+		length = (count < SERVICE_CHUNK) ? count : SERVICE_CHUNK;
+		switch (service->Type)
+		{
+		case hyperexponentialService:
+			randomFillUniform01(stream, uniforms, 2 * length);
+			for (i = 0; i < length; i++)
+			{
+				demands[i] = -((uniforms[2 * i] < service->FirstChance) ? service->FirstMean : service->SecondMean) *
+					log(uniforms[2 * i + 1]);
+			}
+			break;
+		case lognormalService:
+			randomFillUniform01(stream, uniforms, 2 * length);
+			for (i = 0; i < length; i++)
+			{
+				demands[i] = exp(service->LogMean + service->LogDeviation * sqrt(-2.0 * log(uniforms[2 * i])) *
+					cos(TWO_PI * uniforms[2 * i + 1]));
+			}
+			break;
+		case paretoService:
+			randomFillUniform01(stream, uniforms, length);
+			for (i = 0; i < length; i++)
+			{
+				demands[i] = service->Scale * pow(uniforms[i], exponent);
+			}
+			break;
+		default:
+			randomFillUniform01(stream, uniforms, length);
+			for (i = 0; i < length; i++)
+			{
+				// The product may round up to NumberOfValues
+				index = (int) (uniforms[i] * service->NumberOfValues);
+				index = (index < service->NumberOfValues) ? index : service->NumberOfValues - 1;
+				demands[i] = service->Scale * service->Values[index];
+			}
+			break;
+		}
+		demands += length;
+		count -= length;
+	}
+}
+
+//===========================================================================
+//=  This function reads the values of an empirical distribution, e.g. the  =
+//=  measured service times of the requests. Every line which starts with a =
+//=  number gives one value, other lines (a header or comments) are         =
+//=  skipped, so the first column of a CSV file can be read as well.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: path           - file of the values                            =
+//=          values         - place to store the allocated values           =
+//=          numberOfValues - place to store the number of values           =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int serviceLoadValues(const char *path, double **values, int *numberOfValues)
+{
+	FILE   *file;               // File of the values
+	char    line[LINE_LENGTH];  // Current line
+	char   *end;                // End of the number of the line
+	double *newValues;          // Reallocated values
+	double  value;              // Value of the line
+	int     capacity = 0;       // Allocated values
+
+	*values = NULL;
+	*numberOfValues = 0;
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("ERROR! Cannot open the service time file %s\n", path);
+		return(-1);
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		value = strtod(line, &end);
+		if (end == line)
+		{
+			continue;
+		}
+		if (value < 0.0)
+		{
+			printf("ERROR! Negative service time %g in %s\n", value, path);
+			fclose(file);
+			free(*values);
+			*values = NULL;
+			return(-1);
+		}
+		if (*numberOfValues == capacity)
+		{
+			capacity = (capacity == 0) ? INITIAL_VALUES : 2 * capacity;
+			newValues = (double *) realloc(*values, sizeof(double) * capacity);
+			if (newValues == NULL)
+			{
+				printf("Not enough memory for the service times of %s\n", path);
+				fclose(file);
+				free(*values);
+				*values = NULL;
+				return(-1);
+			}
+			*values = newValues;
+		}
+		(*values)[(*numberOfValues)++] = value;
+	}
+	fclose(file);
+
+	if (*numberOfValues == 0)
+	{
+		printf("ERROR! No service times in %s\n", path);
+		return(-1);
+	}
+
+	return(0);
+}
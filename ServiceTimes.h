@@ -0,0 +1,46 @@
+#ifndef SERVICE_TIMES_H
+#define SERVICE_TIMES_H
+
+//----- Includes --------------------------------------------------------------
+#include "RandomStreams.h"  // Random number streams
+
+//----- Constants -------------------------------------------------------------
+#define NUMBER_OF_SERVICES 6    // Number of distributions in enum SERVICE_TYPE
+#define SERVICE_VARIATION  4.0  // Default squared coefficient of variation of the hyperexponential and lognormal
+#define PARETO_SHAPE       2.5  // Default shape of the Pareto distribution
+
+//------New types--------------------------------------------------------------
+enum SERVICE_TYPE  // Distribution of the service demands
+{
+	exponentialService,       // Exponential, as in the CSIM model
+	deterministicService,     // Every customer has the mean demand
+	hyperexponentialService,  // Two exponential phases with balanced means and the given variation
+	lognormalService,         // Lognormal with the given variation
+	paretoService,            // Pareto with the given shape. The tail has the power -shape
+	empiricalService          // Values of a file drawn uniformly and scaled to the mean
+};
+
+typedef struct  // Service demand distribution with the parameters derived from its mean and variation
+{
+	enum SERVICE_TYPE Type;            // Distribution
+	double            Mean;            // Mean demand
+	double            Variation;       // Squared coefficient of variation (hyperexponential and lognormal)
+	double            Shape;           // Shape of the Pareto distribution, greater than 1
+	const double     *Values;          // Values of the empirical distribution
+	int               NumberOfValues;  // Number of Values
+	double            FirstChance;     // Probability of the first hyperexponential phase
+	double            FirstMean;       // Mean of the first hyperexponential phase
+	double            SecondMean;      // Mean of the second hyperexponential phase
+	double            LogMean;         // Mean of the logarithm of the lognormal demand
+	double            LogDeviation;    // Standard deviation of the logarithm of the lognormal demand
+	double            Scale;           // Smallest Pareto demand, or factor of the empirical values
+} SERVICE_TIMES;
+
+//----- Prototypes ------------------------------------------------------------
+int  serviceInit(SERVICE_TIMES *service, enum SERVICE_TYPE type, double mean, double variation, double shape,
+	const double *values, int numberOfValues);
+void serviceFill(const SERVICE_TIMES *service, RANDOM_STREAM *stream, double *demands, int count);
+int  serviceLoadValues(const char *path, double **values, int *numberOfValues);
+const char *serviceName(enum SERVICE_TYPE type);
+
+#endif
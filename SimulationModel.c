@@ -3,6 +3,8 @@
 #include "csim.h"   // Needed for CSIM 20 for C stuff
 #include <stdio.h>  // Needed for I/O functions
 #include <conio.h>  // Needed to use getch() function to hold the output
+#include "Histogram.h"   // Needed for the streaming percentiles of the response time
+#include "Statistics.h"  // Needed for the warm-up truncation and the run length control
 
 //----- Constants -------------------------------------------------------------
 #define NUMBER_OF_SERVERS 5     // Number of servers in the system
@@ -10,6 +12,8 @@
 #define MAX_TIME          60.0  // Maximum simulation CPU time in seconds
 #define CI_LEVEL          0.95  // Confidence interval level
 #define ACCURACY          0.01  // Target accuracy
+#define HISTOGRAM_UNIT    1e-4  // Finest bucket of the response time histograms in mean service times
+#define QUEUE_CAPACITY    200   // Customers each server admits (waiting and in service)
 
 //------New types--------------------------------------------------------------
 enum BALANCER_TYPE  // Type of the load balancer
@@ -29,7 +33,16 @@ int                ArrivalCounter;					     // Stores total number of customers
 int				   RoundRobinServerIDCounter = 0;        // Stores counter value for Round Robin load balancer
 int				   QueueLength[NUMBER_OF_SERVERS];       // Stores the queue length of each server
 double			   PreviosUpdateClock;                   // Stores clock of previous balancer acknowldgement of server queue length
+long			   EventCounter;                         // Stores total number of arrivals, departures and updates
+long               DropCounter;                          // Stores number of customers rejected by a full server
 int				   StaleQueueLength[NUMBER_OF_SERVERS];  // Stores queue length of the servers which is not updated
+HISTOGRAM          ResponseHistogram[NUMBER_OF_SERVERS]; // Response time percentiles of each server
+HISTOGRAM          WaitingHistogram[NUMBER_OF_SERVERS];  // Waiting time percentiles of each server
+HISTOGRAM          SystemResponseHistogram;              // Response time percentiles of the system
+HISTOGRAM          SystemWaitingHistogram;               // Waiting time percentiles of the system
+DELAY_TABLE        RunLengthTable;                       // Response times with warm-up truncation for the run length control
+EVENT              Finished;                             // Is set when the run length control stops the simulation
+double             StartCpuTime;                         // CPU time at the start of customers generation
 
 //----- Prototypes ------------------------------------------------------------
 void generateCustomers(double lambda, double mu);
@@ -38,6 +51,7 @@ void (* server[NUMBER_OF_SERVERS])(int serverID, double serviceTime, double orgT
 int chooseBalancerDialog();
 int generateRandomInteger(int minValue, int maxValue);
 void updateInformation();
+void printPercentiles();
 int randomLoadBalancer();
 int roundRobinLoadBalancer();
 int shortestQueueLoadBalancer();
@@ -60,6 +74,7 @@ void sim()
 	double mu;               // Service rate for each server in the system    
 	double meanResponseTime; // Mean response time of the system
 	int    i;                // Loop counter. Service variable. 
+	double cpuTime;          // CPU time spent by the simulation in seconds
 	char   processName[15];  // Service char array. Is used to create different name for every process
 
 	// Ask user about load balancing strategy.
@@ -72,17 +87,21 @@ void sim()
 	// Simulation has been started
 	printf("\n*** BEGIN SIMULATION *** \n");
 
-	// Initialize global variable DelayTable
+	// Initialize global variable DelayTable. It is printed by report()
 	DelayTable = table("Delay Table");
-	// Implement run length control
-	// Run until we achive the desired ACCURACY with the desired probability
 	table_confidence(DelayTable);
-	table_run_length(DelayTable, ACCURACY, CI_LEVEL, MAX_TIME);
+	// Implement run length control
+	// Run until we achive the desired ACCURACY with the desired probability.
+	// The warm-up from the empty system is detected and discarded
+	tableInit(&RunLengthTable);
+	Finished = event("Finished");
 
 	// Initialize lambda, mu, ArrivalCounter
 	lambda = 3.5;
 	mu = 1.0;
 	ArrivalCounter = 0;
+	EventCounter = 0;
+	DropCounter = 0;
 
 	// Initialize facilities and queues
 	for (i = 0; i < NUMBER_OF_SERVERS; i++)
@@ -92,6 +111,19 @@ void sim()
 		ServerFacility[i] = facility(processName);
 		// Create queue for each server
 		server[i] = queueServer;
+		// Percentiles of each server. Constant memory however long the run is
+		if ((histogramInit(&ResponseHistogram[i], HISTOGRAM_UNIT / mu, HISTOGRAM_PRECISION) != 0) ||
+			(histogramInit(&WaitingHistogram[i], HISTOGRAM_UNIT / mu, HISTOGRAM_PRECISION) != 0))
+		{
+			printf("Not enough memory for the histograms\n");
+			return;
+		}
+	}
+	if ((histogramInit(&SystemResponseHistogram, HISTOGRAM_UNIT / mu, HISTOGRAM_PRECISION) != 0) ||
+		(histogramInit(&SystemWaitingHistogram, HISTOGRAM_UNIT / mu, HISTOGRAM_PRECISION) != 0))
+	{
+		printf("Not enough memory for the histograms\n");
+		return;
 	}
 
 	// If we need to start updating the data about servers
@@ -101,10 +133,12 @@ void sim()
 	}
 
 	// Start customers generation
+	StartCpuTime = cputime();
 	generateCustomers(lambda, mu);
 
-	// Simulation runs for SIMULATION_TIME
-	wait(converged);
+	// Simulation runs until the run length control stops it
+	wait(Finished);
+	cpuTime = cputime() - StartCpuTime;
 
 	// Calculate additional statistics
 	// Calculate the mean response time of the system as an average
@@ -120,7 +154,22 @@ void sim()
 	printf("\n");
 	report();
 	printf("Total arrivals: %d\n", ArrivalCounter);
+	printf("Dropped customers: %ld\n", DropCounter);
 	printf("Mean response time: %.6f\n", meanResponseTime);
+	if (tableHalfWidth(&RunLengthTable, CI_LEVEL) >= 0.0)
+	{
+		printf("Mean after the warm-up: %.6f +/- %.6f\n", tableMean(&RunLengthTable),
+			tableHalfWidth(&RunLengthTable, CI_LEVEL));
+		printf("Warm-up: %lld of %lld customers discarded\n", RunLengthTable.Truncated, RunLengthTable.Count);
+	}
+	printPercentiles();
+	// Speed of the simulation. Is compared with the standalone engine
+	printf("Events processed: %ld\n", EventCounter);
+	printf("CPU time: %.3f s\n", cpuTime);
+	if (cpuTime > 0.0)
+	{
+		printf("Events per second: %.0f\n", EventCounter / cpuTime);
+	}
 
 	// End of the simulation
 	printf("\n*** END SIMULATION *** \n");
@@ -158,6 +207,7 @@ void generateCustomers(double lambda, double mu)
 
 		// New customer has arrived. Increment ArrivalCounter
 		ArrivalCounter++;
+		EventCounter++;
 
 		// Service time for the current customer has exponential distribution
 		serviceTime = exponential(1.0 / mu);
@@ -193,7 +243,8 @@ void generateCustomers(double lambda, double mu)
 //=  Single server queue. This function put the customer into the server    =
 //=  queue. When time comes, it reserves the required server for the        =
 //=  customer and server serves it. When customer has recieved the service, =
-//=  the function releases the server and updates the DelayTable            =
+//=  the function releases the server and updates the DelayTable. A         =
+//=  customer who finds QUEUE_CAPACITY customers at the server is dropped.  =
 //=-------------------------------------------------------------------------=
 //=  Inputs: serverID    - ID of the server for the customer                =
 //=          serviceTime - time which is required to serve the customer     =
@@ -206,15 +257,11 @@ void queueServer(int serverID, double serviceTime, double orgTime)
 
 	create("Queue Server");
 
-	// Size of the server's queue is 200
-	// Error if there is no place in the queue for the current job
-	if (qlength(ServerFacility[serverID]) > 199)
+	// The customer leaves without service if there is no place in the queue
+	if (qlength(ServerFacility[serverID]) + num_busy(ServerFacility[serverID]) >= QUEUE_CAPACITY)
 	{
-		printf("!!! ERROR !!!\n");
-		printf("System is broken! Queue overflow on the Server %d\n", serverID + 1);
-		getch();
-
-		exit();
+		DropCounter++;
+		return;
 	}
 
 	// Reserve server, then wait while the service is provided, the release the server
@@ -225,8 +272,63 @@ void queueServer(int serverID, double serviceTime, double orgTime)
 	// Calculate the response time for the customer
 	responseTime = clock - orgTime;
 
-	// Record customer delay in the table for the convergence test
+	// Record customer delay in the tables. The convergence test is done
+	// when a batch is completed
 	record(responseTime, DelayTable);
+	if (tableRecord(&RunLengthTable, responseTime) &&
+		(tableConverged(&RunLengthTable, ACCURACY, CI_LEVEL) || (cputime() - StartCpuTime > MAX_TIME)))
+	{
+		set(Finished);
+	}
+
+	// Record the response and waiting time percentiles. The customer has
+	// waited for everything except its own service
+	histogramRecord(&ResponseHistogram[serverID], responseTime);
+	histogramRecord(&WaitingHistogram[serverID], responseTime - serviceTime);
+	histogramRecord(&SystemResponseHistogram, responseTime);
+	histogramRecord(&SystemWaitingHistogram, responseTime - serviceTime);
+	EventCounter++;
+}
+
+//===========================================================================
+//=  This function prints the response and waiting time percentiles of      =
+//=  each server and of the system. CSIM report() only has the means.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: None                                                           =
+//=  Returns: None                                                          =
+//===========================================================================
+void printPercentiles()
+{
+	double percentiles[3] = { 0.5, 0.99, 0.999 };  // Percentiles in the report
+	int    i;                                      // Server counter
+	int    j;                                      // Percentile counter
+
+	printf("\nRESPONSE TIME PERCENTILES\n");
+	printf("facility        response time                       waiting time\n");
+	printf("name            p50         p99         p99.9       p50         p99         p99.9\n");
+	for (i = 0; i < NUMBER_OF_SERVERS; i++)
+	{
+		printf("Server %-8d", i);
+		for (j = 0; j < 3; j++)
+		{
+			printf(" %-11.5f", histogramPercentile(&ResponseHistogram[i], percentiles[j]));
+		}
+		for (j = 0; j < 3; j++)
+		{
+			printf(" %-11.5f", histogramPercentile(&WaitingHistogram[i], percentiles[j]));
+		}
+		printf("\n");
+	}
+	printf("System         ");
+	for (j = 0; j < 3; j++)
+	{
+		printf(" %-11.5f", histogramPercentile(&SystemResponseHistogram, percentiles[j]));
+	}
+	for (j = 0; j < 3; j++)
+	{
+		printf(" %-11.5f", histogramPercentile(&SystemWaitingHistogram, percentiles[j]));
+	}
+	printf("\n\n");
 }
 
 //===========================================================================
@@ -321,6 +423,7 @@ void updateInformation()
 		{
 			QueueLength[i] = qlength(ServerFacility[i]) + num_busy(ServerFacility[i]);
 		}
+		EventCounter++;
 
 		// Wait STALE_PERIOD till next update
 		hold(STALE_PERIOD);
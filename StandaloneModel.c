@@ -0,0 +1,2908 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>            // Needed for I/O functions
+#include <math.h>             // Needed for sqrt(), ceil(), isfinite() and HUGE_VAL
+#include <stdlib.h>           // Needed for calloc(), realloc() and free()
+#include <string.h>           // Needed for memcpy() and memmove()
+#include <time.h>             // Needed for clock() and clock_gettime()
+#include "StandaloneModel.h"  // Simulation state and prototypes
+#include "LoadBalancers.h"    // Load balancers
+
+//----- Constants -------------------------------------------------------------
+#define CPU_CHECK_PERIOD 4096  // Number of events between the checks of MAX_TIME
+#define ALL_DISPATCHERS  -1    // Receiver of a report which goes to every dispatcher
+#define NO_DISPATCHER    -2    // No customer has left the server, so there is nobody to piggyback on
+#define COMPLETION_CHUNK 4096  // Customers allocated at first for the log of the served customers of a shard
+#define COLLECT_PERIOD   1024  // Number of events of a shard between two collections of its mailboxes
+
+//===========================================================================
+//=  This function returns the CPU time of the calling thread in seconds.   =
+//=  Runs share the process when they run in parallel, so clock() would     =
+//=  count the CPU time of all of them.                                     =
+//===========================================================================
+static double cpuClock(void)
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec now;  // CPU time of the thread
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+	{
+		return(now.tv_sec + now.tv_nsec * 1e-9);
+	}
+#endif
+
+	return((double) clock() / CLOCKS_PER_SEC);
+}
+
+//===========================================================================
+//=  This function fills the configuration with the parameters of the CSIM  =
+//=  model: lambda = 3.5, mu = 1.0, NUMBER_OF_SERVERS servers and so on.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - configuration to fill                                 =
+//=  Returns: None                                                          =
+//===========================================================================
+void defaultConfig(SIMULATION_CONFIG *config)
+{
+	config->LoadBalancer = randomPolicy;
+	config->NumberOfServers = NUMBER_OF_SERVERS;
+	config->Lambda = 3.5;
+	config->Mu = 1.0;
+	config->StalePeriod = STALE_PERIOD;
+	config->MaxTime = MAX_TIME;
+	config->CiLevel = CI_LEVEL;
+	config->Accuracy = ACCURACY;
+	config->Seed = 1;
+	config->Stream = 0;
+	config->RunLength = 0;
+	config->SampleSize = SAMPLE_SIZE;
+	config->BatchSize = 1;
+	config->ExternalArrivals = 0;
+	config->Percentile = 0.0;
+	config->QueueCapacity = QUEUE_CAPACITY;
+	config->Overload = rejectOverload;
+	config->RetryDelay = RETRY_DELAY;
+	config->MaxRetries = MAX_RETRIES;
+	config->Update = snapshotUpdate;
+	config->UpdateJitter = UPDATE_JITTER;
+	config->UpdateThreshold = UPDATE_THRESHOLD;
+	config->NetworkDelay = 0.0;
+	config->PredictionNoise = PREDICTION_NOISE;
+	config->DispatcherCount = 1;
+	config->TelemetryInterval = TELEMETRY_INTERVAL;
+	config->Service = exponentialService;
+	config->ServiceVariation = SERVICE_VARIATION;
+	config->ParetoShape = PARETO_SHAPE;
+	config->EmpiricalValues = NULL;
+	config->EmpiricalCount = 0;
+	config->NumberOfSpeeds = 0;
+	config->ShardCount = 0;
+	config->Shard = 0;
+	defaultSchedule(&config->Schedule);
+	config->Autoscale = 0;
+	config->MinServers = 1;
+	config->TargetUtilization = TARGET_UTILIZATION;
+	config->ScaleInterval = SCALE_INTERVAL;
+	config->ProvisionDelay = PROVISION_DELAY;
+}
+
+//===========================================================================
+//=  This function returns the human readable name of the load balancer.    =
+//===========================================================================
+const char *balancerName(enum BALANCER_TYPE loadBalancer)
+{
+	switch (loadBalancer)
+	{
+	case randomPolicy:                  return("Random");
+	case roundRobinPolicy:              return("Round Robin");
+	case shortestQueuePolicy:           return("Up-to-Date Shortest Queue");
+	case shortestQueueStalePolicy:      return("Stale Shortest Queue");
+	case improvedPolicy:                return("Improved");
+	case powerOfDPolicy:                return("Power-of-d Choices");
+	case joinIdleQueuePolicy:           return("Join-Idle-Queue");
+	case batchSamplingPolicy:           return("Batch Sampling");
+	case predictivePolicy:              return("Predictive");
+	case speedShortestQueuePolicy:      return("Speed-Aware Shortest Queue");
+	case speedShortestQueueStalePolicy: return("Speed-Aware Stale Shortest Queue");
+	case speedImprovedPolicy:           return("Speed-Aware Improved");
+	case speedPowerOfDPolicy:           return("Speed-Aware Power-of-d");
+	}
+
+	return("Unknown");
+}
+
+//===========================================================================
+//=  This function returns the human readable name of the overload policy.  =
+//===========================================================================
+const char *overloadName(enum OVERLOAD_TYPE overload)
+{
+	switch (overload)
+	{
+	case rejectOverload:   return("Reject");
+	case redirectOverload: return("Redirect");
+	case retryOverload:    return("Retry");
+	}
+
+	return("Unknown");
+}
+
+//===========================================================================
+//=  This function returns the human readable name of the dissemination     =
+//=  mode of the queue lengths.                                             =
+//===========================================================================
+const char *updateName(enum UPDATE_TYPE update)
+{
+	switch (update)
+	{
+	case snapshotUpdate:  return("Snapshot");
+	case jitterUpdate:    return("Jitter");
+	case piggybackUpdate: return("Piggyback");
+	case thresholdUpdate: return("Threshold");
+	}
+
+	return("Unknown");
+}
+
+//===========================================================================
+//=  This function tells whether the load balancer ranks the reported       =
+//=  queues by the expected wait. Only then the dispatchers keep the speed  =
+//=  index of their views.                                                  =
+//===========================================================================
+int usesStaleSpeedIndex(const SIMULATION_CONFIG *config)
+{
+	return((config->LoadBalancer == speedShortestQueueStalePolicy) || (config->LoadBalancer == speedImprovedPolicy));
+}
+
+//===========================================================================
+//=  This function tells whether the load balancer takes the earliest       =
+//=  predicted end of a busy period from a heap: Predictive without noise   =
+//=  and with enough servers that a heap beats a scan. Only then the        =
+//=  dispatchers keep the heap of their EmptyClock.                         =
+//===========================================================================
+int usesEmptyHeap(const SIMULATION_CONFIG *config)
+{
+	return((config->LoadBalancer == predictivePolicy) && (config->PredictionNoise == 0.0) &&
+		(config->NumberOfServers >= HEAP_SERVERS));
+}
+
+//===========================================================================
+//=  This function tells whether the load balancer works on the queue       =
+//=  lengths reported by the servers. Only then the servers send reports.   =
+//===========================================================================
+int usesQueueReports(const SIMULATION_CONFIG *config)
+{
+	return((config->LoadBalancer == shortestQueueStalePolicy) || (config->LoadBalancer == improvedPolicy) ||
+		(config->LoadBalancer == predictivePolicy) || usesStaleSpeedIndex(config));
+}
+
+//===========================================================================
+//=  This function tells whether the state simulates the dispatcher. A      =
+//=  shard of a parallel run has every ShardCount-th dispatcher, the        =
+//=  sequential engine all of them.                                         =
+//===========================================================================
+static int ownsDispatcher(const SIMULATION_STATE *state, int dispatcherID)
+{
+	return((state->Config.ShardCount <= 1) || (dispatcherID % state->Config.ShardCount == state->Config.Shard));
+}
+
+//===========================================================================
+//=  This function returns the shard of a parallel run which simulates the  =
+//=  server, the inverse of the blocks of FirstServer and LastServer.       =
+//===========================================================================
+static int serverShard(const SIMULATION_STATE *state, int serverID)
+{
+	return((int) (((long long) serverID * state->Config.ShardCount + state->Config.ShardCount - 1) /
+		state->Config.NumberOfServers));
+}
+
+//===========================================================================
+//=  This function returns the number of servers which are paid for: the    =
+//=  active ones, the ones being provisioned and the drained ones which     =
+//=  still serve their customers.                                           =
+//===========================================================================
+static int billedServers(const SIMULATION_STATE *state)
+{
+	return(state->ActiveServers + state->PendingServers + state->DrainingServers);
+}
+
+//===========================================================================
+//=  This function returns the number of active servers which the           =
+//=  autoscaler recommends for the arrival rate: enough servers of the mean =
+//=  speed to keep their utilization at TargetUtilization, at least         =
+//=  MinServers and at most NumberOfServers.                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          rate  - arrival rate of the customers                          =
+//=  Returns: recommended number of active servers                          =
+//===========================================================================
+static int recommendedServers(const SIMULATION_STATE *state, double rate)
+{
+	double servers;  // Servers at the target utilization
+
+	servers = ceil(rate / (state->Config.Mu * state->Config.TargetUtilization));
+	if (servers > state->Config.NumberOfServers)
+	{
+		return(state->Config.NumberOfServers);
+	}
+	if (servers < state->Config.MinServers)
+	{
+		return(state->Config.MinServers);
+	}
+
+	return((int) servers);
+}
+
+//===========================================================================
+//=  This function schedules the next batch of the dispatcher. Every        =
+//=  dispatcher has its own Poisson arrivals. Interarrival time of its      =
+//=  batches has exponential distribution with the mean BatchSize *         =
+//=  DispatcherCount / (lambda * factor), so lambda times the current       =
+//=  factor of the arrival rate stays the rate of the customers. While the  =
+//=  factor is 0 nothing is scheduled, and the next change of the rate      =
+//=  draws the arrival again.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state                                =
+//=          dispatcherID - dispatcher of the arrival                       =
+//=  Returns: None                                                          =
+//===========================================================================
+static void scheduleArrival(SIMULATION_STATE *state, int dispatcherID)
+{
+	DISPATCHER *dispatcher = &state->Dispatchers[dispatcherID];  // Dispatcher of the arrival
+	double      factor = arrivalRatesFactor(&state->Rates);      // Current factor of the arrival rate
+
+	if (factor <= 0.0)
+	{
+		dispatcher->NextArrivalClock = -1.0;
+		return;
+	}
+
+	dispatcher->NextArrivalClock = state->Clock + randomExponential(&state->Random[arrivalStream],
+		state->Config.BatchSize * state->Config.DispatcherCount / (state->Config.Lambda * factor));
+	scheduleEvent(state->DispatcherList, dispatcher->NextArrivalClock, arrivalEvent, dispatcherID);
+}
+
+//===========================================================================
+//=  This function takes the last active server out of the indexes of the   =
+//=  real queue lengths and of the views of the dispatchers, so the load    =
+//=  balancers do not choose it any more. Its customers stay and are        =
+//=  served, but they no longer count in the queue imbalance, so the caller =
+//=  accumulates the imbalance first.                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state with at least two active servers      =
+//=  Returns: None                                                          =
+//===========================================================================
+static void removeServer(SIMULATION_STATE *state)
+{
+	int serverID = state->ActiveServers - 1;               // Removed server
+	int length = state->Servers[serverID].Count;           // Its number of customers
+	int speedIndex = usesStaleSpeedIndex(&state->Config);  // Whether the speed indexes of the views are kept
+	int d;                                                 // Dispatcher counter
+
+	queueIndexRemove(&state->ServerIndex, serverID);
+	if (state->Config.LoadBalancer == speedShortestQueuePolicy)
+	{
+		speedIndexRemove(&state->SpeedIndex, serverID);
+	}
+	state->QueuedCustomers -= length;
+	state->LengthSquareSum -= (long long) length * length;
+	state->ActiveServers--;
+
+	for (d = 0; d < state->Config.DispatcherCount; d++)
+	{
+		if (!ownsDispatcher(state, d))
+		{
+			continue;
+		}
+		queueIndexRemove(&state->Dispatchers[d].StaleIndex, serverID);
+		if (speedIndex)
+		{
+			speedIndexRemove(&state->Dispatchers[d].StaleSpeedIndex, serverID);
+		}
+		if (usesEmptyHeap(&state->Config))
+		{
+			serverHeapRemove(&state->Dispatchers[d].EmptyHeap, serverID);
+		}
+	}
+}
+
+//===========================================================================
+//=  This function allocates and initializes everything which is needed for =
+//=  one simulation run: event list, job pool, server queues and the        =
+//=  statistics. The job pool starts with JOBS_PER_SERVER customers at      =
+//=  every server instead of the worst case of full queues. The pool and    =
+//=  the queues double when they are full, so memory is rarely allocated    =
+//=  while the simulation runs.                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state  - simulation state to initialize                        =
+//=          config - parameters of the run                                 =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int simulationInit(SIMULATION_STATE *state, const SIMULATION_CONFIG *config)
+{
+	double         unit = HISTOGRAM_UNIT / config->Mu;  // Finest bucket of the histograms
+	double         speedSum = 0.0;                      // Sum of the speeds of the servers
+	DISPATCHER    *dispatcher;                          // Current dispatcher
+	RANDOM_STREAM  stream;                              // Stream of the replication, split for each purpose
+	int            activeServers;                       // Servers which take customers at the start
+	int            d;                                   // Dispatcher counter
+	int            i;                                   // Loop counter
+
+	state->Config = *config;
+	state->Clock = 0.0;
+	state->ArrivalCounter = 0;
+	state->Drops = 0;
+	state->Redirects = 0;
+	state->Retries = 0;
+	state->Messages = 0;
+	state->ExternalGroups = 0;
+	state->PreviosUpdateClock = 0.0;
+	state->QueuedCustomers = 0;
+	state->LengthSquareSum = 0;
+	state->ImbalanceClock = 0.0;
+	state->VarianceArea = 0.0;
+	state->EventCounter = 0;
+	state->CpuTime = 0.0;
+	state->Converged = 0;
+	state->Telemetry = NULL;
+	state->Mailboxes = NULL;
+	state->Completions = NULL;
+	state->CompletionCount = 0;
+	state->CompletionCapacity = 0;
+	state->BatchCompleted = 0;
+	state->DelayBatchCompleted = 0;
+	state->Phases = NULL;
+	state->ActiveServers = config->NumberOfServers;
+	state->PendingServers = 0;
+	state->DrainingServers = 0;
+	state->ServerTime = 0.0;
+	state->ServerClock = 0.0;
+	state->Provisions = 0;
+	state->Reclaims = 0;
+	state->Drains = 0;
+	state->ScaleArrivals = 0;
+	state->ScaleDecisions = 0;
+	for (i = 0; i < MAX_CLASSES; i++)
+	{
+		state->Classes[i].Completions = 0;
+		state->Classes[i].ResponseTimeSum = 0.0;
+	}
+	for (i = 0; i < UPDATE_PHASES; i++)
+	{
+		state->SpreadArea[i] = 0.0;
+		state->PhaseTime[i] = 0.0;
+	}
+	randomStreamInit(&stream, config->Seed);
+	for (i = 0; i < config->Stream; i++)
+	{
+		randomStreamJump(&stream);
+	}
+	for (i = 0; i < NUMBER_OF_STREAMS; i++)
+	{
+		randomStreamSplit(&stream, config->Shard * NUMBER_OF_STREAMS + i, &state->Random[i]);
+	}
+	randomStreamSplit(&stream, SAMPLE_SUBSTREAM, &state->SampleRandom);
+	tableInit(&state->DelayTable);
+
+	// A shard of a parallel run simulates a block of neighbouring servers and every
+	// ShardCount-th dispatcher. The first shard has the streams of the sequential run
+	state->FirstServer = (config->ShardCount > 0) ?
+		(int) ((long long) config->Shard * config->NumberOfServers / config->ShardCount) : 0;
+	state->LastServer = (config->ShardCount > 0) ?
+		(int) ((long long) (config->Shard + 1) * config->NumberOfServers / config->ShardCount) :
+		config->NumberOfServers;
+	state->DispatcherList = (config->ShardCount > 0) ? &state->DispatcherEvents : &state->Events;
+
+	state->Servers = (SERVER_QUEUE *) calloc(config->NumberOfServers, sizeof(SERVER_QUEUE));
+	state->ServerStatistics = (SERVER_STATISTICS *) calloc(config->NumberOfServers, sizeof(SERVER_STATISTICS));
+	state->Dispatchers = (DISPATCHER *) calloc(config->DispatcherCount, sizeof(DISPATCHER));
+	state->ReportedLength = (int *) calloc(config->NumberOfServers, sizeof(int));
+	state->HasIdleToken = (char *) calloc(config->NumberOfServers, sizeof(char));
+	state->LastDispatcher = (int *) calloc(config->NumberOfServers, sizeof(int));
+	state->LastDispatchClock = (double *) calloc(config->NumberOfServers, sizeof(double));
+	state->ForeignDispatchClock = (double *) calloc(config->NumberOfServers, sizeof(double));
+	state->ProbeServerIDs = (int *) calloc(config->SampleSize * config->BatchSize, sizeof(int));
+	state->ProbeLoad = (int *) calloc(config->SampleSize * config->BatchSize, sizeof(int));
+	state->BatchServerIDs = (int *) calloc(config->BatchSize, sizeof(int));
+	state->BatchServiceTimes = (double *) calloc(config->BatchSize, sizeof(double));
+	state->Speed = (double *) calloc(config->NumberOfServers, sizeof(double));
+	state->ReadyClock = (double *) calloc(config->NumberOfServers, sizeof(double));
+	state->Events.Heap = NULL;
+	state->DispatcherEvents.Heap = NULL;
+	state->Pool.Jobs = NULL;
+	state->ServerIndex.Length = NULL;
+	state->SpeedIndex.ClassSpeed = NULL;
+	state->Reports.Jobs = NULL;
+	state->ResponseTimes.Total.Counts = NULL;
+	state->ResponseTimes.Batches = NULL;
+	state->WaitingTimes.Counts = NULL;
+	if ((state->Servers == NULL) || (state->ServerStatistics == NULL) || (state->Dispatchers == NULL) ||
+		(state->ReportedLength == NULL) || (state->HasIdleToken == NULL) || (state->LastDispatcher == NULL) ||
+		(state->LastDispatchClock == NULL) || (state->ForeignDispatchClock == NULL) ||
+		(state->ProbeServerIDs == NULL) || (state->ProbeLoad == NULL) || (state->BatchServerIDs == NULL) ||
+		(state->BatchServiceTimes == NULL) || (state->Speed == NULL) || (state->ReadyClock == NULL) ||
+		(serverQueueInit(&state->Reports) != 0) ||
+		(eventListInit(&state->Events, config->NumberOfServers + config->DispatcherCount + 16) != 0) ||
+		((config->ShardCount > 0) && (eventListInit(&state->DispatcherEvents, config->DispatcherCount + 16) != 0)) ||
+		(jobPoolInit(&state->Pool, (state->LastServer - state->FirstServer) * JOBS_PER_SERVER) != 0) ||
+		(queueIndexInit(&state->ServerIndex, config->NumberOfServers) != 0) ||
+		(percentileTableInit(&state->ResponseTimes, unit,
+			(config->RunLength == 0) ? config->Percentile : 0.0) != 0) ||
+		(histogramInit(&state->WaitingTimes, unit, HISTOGRAM_PRECISION) != 0))
+	{
+		simulationFree(state);
+		return(-1);
+	}
+	for (i = state->FirstServer; i < state->LastServer; i++)
+	{
+		if ((histogramInit(&state->ServerStatistics[i].ResponseTimes, unit, SERVER_PRECISION) != 0) ||
+			(histogramInit(&state->ServerStatistics[i].WaitingTimes, unit, SERVER_PRECISION) != 0) ||
+			(serverQueueInit(&state->Servers[i]) != 0))
+		{
+			simulationFree(state);
+			return(-1);
+		}
+	}
+
+	// The servers get the speeds of the list in turn. The speeds are divided by
+	// their mean, so Mu stays the mean service rate and the utilization is unchanged
+	for (i = 0; i < config->NumberOfServers; i++)
+	{
+		state->Speed[i] = (config->NumberOfSpeeds > 0) ? config->Speeds[i % config->NumberOfSpeeds] : 1.0;
+		speedSum += state->Speed[i];
+	}
+	for (i = 0; i < config->NumberOfServers; i++)
+	{
+		state->Speed[i] *= config->NumberOfServers / speedSum;
+	}
+	if ((serviceInit(&state->Service, config->Service, 1.0 / config->Mu, config->ServiceVariation,
+		config->ParetoShape, config->EmpiricalValues, config->EmpiricalCount) != 0) ||
+		(speedIndexInit(&state->SpeedIndex, state->Speed, config->NumberOfServers) != 0) ||
+		(arrivalRatesInit(&state->Rates, &config->Schedule, &state->Random[loadStream]) != 0))
+	{
+		simulationFree(state);
+		return(-1);
+	}
+
+	// Every phase of a varying arrival rate has its own statistics
+	if (scheduleVaries(&config->Schedule))
+	{
+		state->Phases = (PHASE_STATISTICS *) calloc(arrivalRatesPhaseCount(&state->Rates), sizeof(PHASE_STATISTICS));
+		if (state->Phases == NULL)
+		{
+			simulationFree(state);
+			return(-1);
+		}
+		for (i = 0; i < arrivalRatesPhaseCount(&state->Rates); i++)
+		{
+			if (histogramInit(&state->Phases[i].ResponseTimes, unit, SERVER_PRECISION) != 0)
+			{
+				simulationFree(state);
+				return(-1);
+			}
+		}
+	}
+
+	// Every dispatcher has its own view. Round Robin dispatchers start at different servers
+	for (d = 0; d < config->DispatcherCount; d++)
+	{
+		if (!ownsDispatcher(state, d))
+		{
+			continue;
+		}
+		dispatcher = &state->Dispatchers[d];
+		dispatcher->QueueLength = (int *) calloc(config->NumberOfServers, sizeof(int));
+		dispatcher->ReportClock = (double *) calloc(config->NumberOfServers, sizeof(double));
+		dispatcher->EmptyClock = (double *) calloc(config->NumberOfServers, sizeof(double));
+		dispatcher->IdleTokens = (int *) calloc(config->NumberOfServers, sizeof(int));
+		if ((dispatcher->QueueLength == NULL) || (dispatcher->ReportClock == NULL) ||
+			(dispatcher->EmptyClock == NULL) || (dispatcher->IdleTokens == NULL) ||
+			(queueIndexInit(&dispatcher->StaleIndex, config->NumberOfServers) != 0) ||
+			(speedIndexInit(&dispatcher->StaleSpeedIndex, state->Speed, config->NumberOfServers) != 0) ||
+			(serverHeapInit(&dispatcher->EmptyHeap, dispatcher->EmptyClock, config->NumberOfServers) != 0))
+		{
+			simulationFree(state);
+			return(-1);
+		}
+		if ((config->LoadBalancer == predictivePolicy) && (config->PredictionNoise == 0.0))
+		{
+			serverHeapSalt(&dispatcher->EmptyHeap, &state->Random[decisionStream]);
+		}
+		dispatcher->RoundRobinServerIDCounter = (long long) d * config->NumberOfServers / config->DispatcherCount;
+	}
+	state->Dispatcher = &state->Dispatchers[0];
+
+	// The autoscaler starts with the servers recommended for the first arrival
+	// rate. The others are taken out of the indexes from the last one
+	activeServers = config->Autoscale ?
+		recommendedServers(state, config->Lambda * arrivalRatesFactor(&state->Rates)) : config->NumberOfServers;
+	while (state->ActiveServers > activeServers)
+	{
+		removeServer(state);
+	}
+	state->PeakServers = activeServers;
+
+	// All active servers are idle at the start, so each has a token at
+	// Join-Idle-Queue. The tokens are dealt to the dispatchers in turn
+	for (i = 0; i < config->NumberOfServers; i++)
+	{
+		dispatcher = &state->Dispatchers[i % config->DispatcherCount];
+		if (ownsDispatcher(state, i % config->DispatcherCount) && (i < activeServers))
+		{
+			dispatcher->IdleTokens[dispatcher->IdleCount++] = i;
+		}
+		state->HasIdleToken[i] = (char) (i < activeServers);
+		state->ReadyClock[i] = -1.0;
+		state->LastDispatcher[i] = NO_DISPATCHER;
+		state->LastDispatchClock[i] = -1.0;
+		state->ForeignDispatchClock[i] = -1.0;
+	}
+
+	// The first customer of every dispatcher and, if the balancer needs it, the
+	// first update. The periodic reports of the servers start at random phases.
+	// The first change of the arrival rate and the first decision of the
+	// autoscaler are only scheduled if there are any
+	if (!config->ExternalArrivals)
+	{
+		for (d = 0; d < config->DispatcherCount; d++)
+		{
+			if (!ownsDispatcher(state, d))
+			{
+				continue;
+			}
+			scheduleArrival(state, d);
+		}
+	}
+	if (arrivalRatesNextChange(&state->Rates) < HUGE_VAL)
+	{
+		scheduleEvent(state->DispatcherList, arrivalRatesNextChange(&state->Rates), rateEvent, 0);
+	}
+	if (config->Autoscale)
+	{
+		scheduleEvent(&state->Events, config->ScaleInterval, scaleEvent, 0);
+	}
+	if (usesQueueReports(config) && (config->Update == snapshotUpdate))
+	{
+		scheduleEvent(&state->Events, 0.0, updateEvent, 0);
+	}
+	if (usesQueueReports(config) && (config->Update == jitterUpdate))
+	{
+		for (i = state->FirstServer; i < state->LastServer; i++)
+		{
+			scheduleEvent(&state->Events, randomUniform(&state->Random[delayStream], 0.0, config->StalePeriod),
+				reportEvent, i);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the memory of the simulation state.                =
+//===========================================================================
+void simulationFree(SIMULATION_STATE *state)
+{
+	int i;  // Loop counter
+
+	if (state->ServerStatistics != NULL)
+	{
+		for (i = 0; i < state->Config.NumberOfServers; i++)
+		{
+			histogramFree(&state->ServerStatistics[i].ResponseTimes);
+			histogramFree(&state->ServerStatistics[i].WaitingTimes);
+		}
+	}
+	if (state->Phases != NULL)
+	{
+		for (i = 0; i < arrivalRatesPhaseCount(&state->Rates); i++)
+		{
+			histogramFree(&state->Phases[i].ResponseTimes);
+		}
+	}
+	percentileTableFree(&state->ResponseTimes);
+	histogramFree(&state->WaitingTimes);
+	eventListFree(&state->Events);
+	eventListFree(&state->DispatcherEvents);
+	jobPoolFree(&state->Pool);
+	if (state->ServerIndex.Length != NULL)
+	{
+		queueIndexFree(&state->ServerIndex);
+	}
+	if (state->SpeedIndex.ClassSpeed != NULL)
+	{
+		speedIndexFree(&state->SpeedIndex);
+	}
+	if (state->Dispatchers != NULL)
+	{
+		for (i = 0; i < state->Config.DispatcherCount; i++)
+		{
+			if (state->Dispatchers[i].StaleIndex.Length != NULL)
+			{
+				queueIndexFree(&state->Dispatchers[i].StaleIndex);
+			}
+			speedIndexFree(&state->Dispatchers[i].StaleSpeedIndex);
+			serverHeapFree(&state->Dispatchers[i].EmptyHeap);
+			free(state->Dispatchers[i].QueueLength);
+			free(state->Dispatchers[i].ReportClock);
+			free(state->Dispatchers[i].EmptyClock);
+			free(state->Dispatchers[i].IdleTokens);
+		}
+	}
+	serverQueueFree(&state->Reports);
+	if (state->Servers != NULL)
+	{
+		for (i = 0; i < state->Config.NumberOfServers; i++)
+		{
+			serverQueueFree(&state->Servers[i]);
+		}
+	}
+	free(state->Servers);
+	free(state->ServerStatistics);
+	free(state->Dispatchers);
+	free(state->ReportedLength);
+	free(state->HasIdleToken);
+	free(state->LastDispatcher);
+	free(state->LastDispatchClock);
+	free(state->ForeignDispatchClock);
+	free(state->ProbeServerIDs);
+	free(state->ProbeLoad);
+	free(state->BatchServerIDs);
+	free(state->BatchServiceTimes);
+	free(state->Speed);
+	free(state->ReadyClock);
+	free(state->Phases);
+	free(state->Completions);
+	state->Servers = NULL;
+	state->ServerStatistics = NULL;
+	state->Dispatchers = NULL;
+	state->ReportedLength = NULL;
+	state->HasIdleToken = NULL;
+	state->LastDispatcher = NULL;
+	state->LastDispatchClock = NULL;
+	state->ForeignDispatchClock = NULL;
+	state->ProbeServerIDs = NULL;
+	state->ProbeLoad = NULL;
+	state->BatchServerIDs = NULL;
+	state->BatchServiceTimes = NULL;
+	state->Speed = NULL;
+	state->ReadyClock = NULL;
+	state->Phases = NULL;
+	state->Completions = NULL;
+}
+
+//===========================================================================
+//=  This function adds the time since the last change of the number of     =
+//=  customers at the server to the queue length integral.                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - server whose number of customers is about to change =
+//=  Returns: None                                                          =
+//===========================================================================
+static void accumulateQueueLength(SIMULATION_STATE *state, int serverID)
+{
+	SERVER_STATISTICS *statistics = &state->ServerStatistics[serverID];  // Statistics of the server
+
+	statistics->QueueLengthArea += state->Servers[serverID].Count * (state->Clock - statistics->LastChangeClock);
+	statistics->LastChangeClock = state->Clock;
+}
+
+//===========================================================================
+//=  This function adds the time since the last change of the queue lengths =
+//=  to the imbalance integrals: the longest minus the shortest queue (in   =
+//=  the current part of the update period) and the variance of the queue   =
+//=  lengths. Both come from the ServerIndex and the running sums, so this  =
+//=  costs O(1) per change.                                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state before the change                     =
+//=  Returns: None                                                          =
+//===========================================================================
+static void accumulateImbalance(SIMULATION_STATE *state)
+{
+	QUEUE_INDEX *index = &state->ServerIndex;              // Servers sorted by queue length
+	int          numberOfServers = index->NumberOfServers;  // Number of servers
+	double       elapsed;                                  // Time since the last change
+	double       mean;                                     // Mean queue length
+	int          phase = 0;                                // Part of the update period
+
+	elapsed = state->Clock - state->ImbalanceClock;
+	if (elapsed <= 0.0)
+	{
+		return;
+	}
+
+	// Parts of the update period are only known for the snapshot updates
+	if (usesQueueReports(&state->Config) && (state->Config.Update == snapshotUpdate))
+	{
+		phase = (int) ((state->ImbalanceClock - state->PreviosUpdateClock) * UPDATE_PHASES /
+			state->Config.StalePeriod);
+		phase = (phase < 0) ? 0 : ((phase >= UPDATE_PHASES) ? UPDATE_PHASES - 1 : phase);
+	}
+
+	mean = (double) state->QueuedCustomers / numberOfServers;
+	state->SpreadArea[phase] += elapsed * (index->Length[index->Order[numberOfServers - 1]] -
+		index->Length[index->Order[0]]);
+	state->PhaseTime[phase] += elapsed;
+	state->VarianceArea += elapsed * ((double) state->LengthSquareSum / numberOfServers - mean * mean);
+	state->ImbalanceClock = state->Clock;
+}
+
+//===========================================================================
+//=  This function adds the time since the last change of the billed        =
+//=  servers or of the phase of the arrival rate to the server time of the  =
+//=  run and of the phase.                                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state before the change                     =
+//=  Returns: None                                                          =
+//===========================================================================
+static void accumulateServerTime(SIMULATION_STATE *state)
+{
+	PHASE_STATISTICS *phase;                            // Statistics of the current phase
+	double            elapsed;                          // Time since the last change
+	int               billed = billedServers(state);    // Servers which are paid for
+
+	elapsed = state->Clock - state->ServerClock;
+	if (elapsed <= 0.0)
+	{
+		return;
+	}
+
+	state->ServerTime += elapsed * billed;
+	if (state->Phases != NULL)
+	{
+		phase = &state->Phases[arrivalRatesPhase(&state->Rates)];
+		phase->Time += elapsed;
+		phase->ServerTime += elapsed * billed;
+	}
+	state->ServerClock = state->Clock;
+}
+
+//===========================================================================
+//=  This function writes the reports at the head of Reports into the views =
+//=  of their dispatchers: the QueueLength array and the index of the stale =
+//=  queue lengths, and the speed index if the balancer uses it. A single   =
+//=  report moves one server in the indexes, unless the server has left the =
+//=  pool since, and a snapshot of all servers rebuilds them. The           =
+//=  Predictive balancer starts the prediction of the server from the       =
+//=  report, at the service rate of the server.                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          count - number of reports at the head of Reports               =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int deliverReports(SIMULATION_STATE *state, int count)
+{
+	DISPATCHER *dispatcher;                                        // Dispatcher which receives the report
+	int         speedIndex = usesStaleSpeedIndex(&state->Config);  // Whether the speed indexes are kept
+	int         emptyHeap = usesEmptyHeap(&state->Config);         // Whether the heaps of EmptyClock are kept
+	int         receiver;                                          // Dispatcher of the report or ALL_DISPATCHERS
+	int         first;                                             // First dispatcher which receives the report
+	int         last;                                              // Dispatcher after the last receiver
+	int         serverID;                                          // Server of the report
+	int         length;                                            // Reported queue length
+	int         d;                                                 // Dispatcher counter
+	int         i;                                                 // Report counter
+
+	for (i = 0; i < count; i++)
+	{
+		receiver = serverQueuePop(&state->Reports);
+		serverID = serverQueuePop(&state->Reports);
+		length = serverQueuePop(&state->Reports);
+		first = (receiver == ALL_DISPATCHERS) ? 0 : receiver;
+		last = (receiver == ALL_DISPATCHERS) ? state->Config.DispatcherCount : receiver + 1;
+		for (d = first; d < last; d++)
+		{
+			if (!ownsDispatcher(state, d))
+			{
+				continue;
+			}
+			dispatcher = &state->Dispatchers[d];
+			dispatcher->QueueLength[serverID] = length;
+			dispatcher->ReportClock[serverID] = state->Clock;
+			dispatcher->EmptyClock[serverID] = state->Clock + length / (state->Config.Mu * state->Speed[serverID]);
+			if ((count == 1) && (serverID < state->ActiveServers) &&
+				((queueIndexSet(&dispatcher->StaleIndex, serverID, length) != 0) ||
+				(speedIndex && (speedIndexSet(&dispatcher->StaleSpeedIndex, serverID, length) != 0))))
+			{
+				return(-1);
+			}
+			if ((count == 1) && (serverID < state->ActiveServers) && emptyHeap)
+			{
+				serverHeapUpdate(&dispatcher->EmptyHeap, serverID);
+			}
+		}
+	}
+
+	if (state->Config.Update == snapshotUpdate)
+	{
+		state->PreviosUpdateClock = state->Clock;
+	}
+	for (d = 0; (count > 1) && (d < state->Config.DispatcherCount); d++)
+	{
+		if (!ownsDispatcher(state, d))
+		{
+			continue;
+		}
+		if ((queueIndexRebuild(&state->Dispatchers[d].StaleIndex, state->Dispatchers[d].QueueLength) != 0) ||
+			(speedIndex && (speedIndexRebuild(&state->Dispatchers[d].StaleSpeedIndex,
+			state->Dispatchers[d].QueueLength) != 0)))
+		{
+			return(-1);
+		}
+		if (emptyHeap)
+		{
+			serverHeapRebuild(&state->Dispatchers[d].EmptyHeap);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function explains why the mailboxes of a parallel run have        =
+//=  failed: a window has more messages from one shard to another than the  =
+//=  receiver keeps, or there is not enough memory for them.                =
+//===========================================================================
+static void printMailboxError(void)
+{
+	printf("ERROR! The mailboxes keep at most %d messages from one shard to another in a window. "
+		"Shorten the window with --stale or --delay\n", MAILBOX_KEPT);
+}
+
+//===========================================================================
+//=  This function sends a report of a parallel run to the shards of its    =
+//=  receivers: the shard of the dispatcher, or every shard which has       =
+//=  dispatchers. The report reaches them after NetworkDelay, which is at   =
+//=  least one window, so they get it before its delivery time.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state of a shard                         =
+//=          serverID - reporting server                                    =
+//=          receiver - dispatcher of the report or ALL_DISPATCHERS         =
+//=          length   - reported queue length                               =
+//=  Returns: 0 on success, -1 if the mailboxes have failed                 =
+//===========================================================================
+static int postReport(SIMULATION_STATE *state, int serverID, int receiver, int length)
+{
+	MESSAGE message;  // Report
+	int     first;    // First shard which receives the report
+	int     last;     // Shard after the last receiver
+	int     shard;    // Shard counter
+
+	message.Time = state->Clock + state->Config.NetworkDelay;
+	message.ServiceTime = 0.0;
+	message.ReportClock = 0.0;
+	message.Type = reportMessage;
+	message.ServerID = serverID;
+	message.Dispatcher = receiver;
+	message.Class = 0;
+	message.Length = length;
+	first = (receiver == ALL_DISPATCHERS) ? 0 : receiver % state->Config.ShardCount;
+	last = (receiver == ALL_DISPATCHERS) ? state->Config.ShardCount : first + 1;
+	last = (last < state->Config.DispatcherCount) ? last : state->Config.DispatcherCount;
+
+	for (shard = first; shard < last; shard++)
+	{
+		if (mailboxSend(state->Mailboxes, state->Config.Shard, shard, &message) != 0)
+		{
+			printMailboxError();
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function sends the current queue length of the server to one or   =
+//=  all dispatchers. The report reaches them after NetworkDelay, so it may =
+//=  be out of date when it arrives. Every receiver counts as one message.  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - reporting server                                    =
+//=          receiver - dispatcher of the report or ALL_DISPATCHERS         =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int sendReport(SIMULATION_STATE *state, int serverID, int receiver)
+{
+	int length = state->Servers[serverID].Count;  // Reported queue length
+
+	state->Messages += (receiver == ALL_DISPATCHERS) ? state->Config.DispatcherCount : 1;
+	state->ReportedLength[serverID] = length;
+	if (state->Mailboxes != NULL)
+	{
+		return(postReport(state, serverID, receiver, length));
+	}
+	if ((serverQueuePush(&state->Reports, receiver) != 0) || (serverQueuePush(&state->Reports, serverID) != 0) ||
+		(serverQueuePush(&state->Reports, length) != 0))
+	{
+		printf("Not enough memory for the reports\n");
+		return(-1);
+	}
+
+	if (state->Config.NetworkDelay > 0.0)
+	{
+		scheduleEvent(&state->Events, state->Clock + state->Config.NetworkDelay, deliveryEvent, 1);
+		return(0);
+	}
+
+	return(deliverReports(state, 1));
+}
+
+//===========================================================================
+//=  This function is called after the queue length of the server has       =
+//=  changed. The server sends a report with every completed customer in    =
+//=  the piggyback mode (to the dispatcher of the customer only), and to    =
+//=  every dispatcher when its queue length has moved UpdateThreshold away  =
+//=  from the last report in the threshold mode.                            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - server whose queue length has changed               =
+//=          replyTo  - dispatcher of the customer who has left the server, =
+//=                     NO_DISPATCHER if a customer has arrived             =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int queueLengthChanged(SIMULATION_STATE *state, int serverID, int replyTo)
+{
+	int change;  // Change of the queue length since the last report
+
+	// A server which has left the pool does not report
+	if (serverID >= state->ActiveServers)
+	{
+		return(0);
+	}
+
+	if (state->Config.Update == piggybackUpdate)
+	{
+		if ((replyTo != NO_DISPATCHER) && usesQueueReports(&state->Config))
+		{
+			return(sendReport(state, serverID, replyTo));
+		}
+	}
+	else if (state->Config.Update == thresholdUpdate)
+	{
+		change = state->Servers[serverID].Count - state->ReportedLength[serverID];
+		if (((change >= state->Config.UpdateThreshold) || (-change >= state->Config.UpdateThreshold)) &&
+			usesQueueReports(&state->Config))
+		{
+			return(sendReport(state, serverID, ALL_DISPATCHERS));
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  Single server queue. This function puts the customer into the server   =
+//=  queue. If the server is idle the service starts at once and the        =
+//=  departure is scheduled. Otherwise the customer waits in the queue. A   =
+//=  server with QueueCapacity customers does not admit more. The service   =
+//=  demand of the admitted customer becomes its service time at the speed  =
+//=  of the server.                                                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - ID of the server for the customer                   =
+//=          jobIndex - customer                                            =
+//=  Returns: 0 on success, 1 if the queue is full, -1 if there is not      =
+//=           enough memory                                                 =
+//===========================================================================
+static int queueServer(SIMULATION_STATE *state, int serverID, int jobIndex)
+{
+	SERVER_QUEUE *queue = &state->Servers[serverID];  // Queue of the server
+
+	if ((state->Config.QueueCapacity > 0) && (queue->Count >= state->Config.QueueCapacity))
+	{
+		return(1);
+	}
+
+	accumulateQueueLength(state, serverID);
+	accumulateImbalance(state);
+
+	if (serverQueuePush(queue, jobIndex) != 0)
+	{
+		printf("Not enough memory for the queue of the Server %d\n", serverID + 1);
+		return(-1);
+	}
+	state->Pool.Jobs[jobIndex].ServiceTime /= state->Speed[serverID];
+	state->QueuedCustomers++;
+	state->LengthSquareSum += 2 * queue->Count - 1;
+	if ((queueIndexIncrement(&state->ServerIndex, serverID) != 0) ||
+		((state->Config.LoadBalancer == speedShortestQueuePolicy) &&
+		(speedIndexIncrement(&state->SpeedIndex, serverID) != 0)) ||
+		(queueLengthChanged(state, serverID, NO_DISPATCHER) != 0))
+	{
+		return(-1);
+	}
+
+	// Server was idle. Start the service
+	if (queue->Count == 1)
+	{
+		scheduleEvent(&state->Events, state->Clock + state->Pool.Jobs[jobIndex].ServiceTime, departureEvent, serverID);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function records the response time of a served customer in the    =
+//=  tables of the run length control.                                      =
+//===========================================================================
+void recordResponseTime(SIMULATION_STATE *state, double responseTime)
+{
+	state->DelayBatchCompleted = tableRecord(&state->DelayTable, responseTime);
+	state->BatchCompleted = percentileTableRecord(&state->ResponseTimes, responseTime);
+}
+
+//===========================================================================
+//=  This function tells whether the run length control stops the run after =
+//=  the last recorded customer. A run of fixed length stops after          =
+//=  RunLength customers, the others when the last customer has completed a =
+//=  batch and the desired ACCURACY is achieved.                            =
+//===========================================================================
+int runLengthReached(const SIMULATION_STATE *state)
+{
+	if (state->Config.RunLength > 0)
+	{
+		return(state->DelayTable.Count >= state->Config.RunLength);
+	}
+	if (state->Config.Percentile > 0.0)
+	{
+		// The batch percentiles only change when a batch is completed
+		return(state->BatchCompleted &&
+			percentileTableConverged(&state->ResponseTimes, state->Config.Accuracy, state->Config.CiLevel));
+	}
+
+	return(state->DelayBatchCompleted &&
+		tableConverged(&state->DelayTable, state->Config.Accuracy, state->Config.CiLevel));
+}
+
+//===========================================================================
+//=  This function logs the departure time and the response time of a       =
+//=  customer served by a shard of a parallel run. The log grows when it is =
+//=  full and is emptied at the end of every window.                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state of a shard                     =
+//=          responseTime - response time of the customer                   =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int logCompletion(SIMULATION_STATE *state, double responseTime)
+{
+	double *newCompletions;  // Reallocated log
+	int     newCapacity;     // Customers of the reallocated log
+
+	if (state->CompletionCount == state->CompletionCapacity)
+	{
+		newCapacity = (state->CompletionCapacity == 0) ? COMPLETION_CHUNK : 2 * state->CompletionCapacity;
+		newCompletions = (double *) realloc(state->Completions, 2 * sizeof(double) * newCapacity);
+		if (newCompletions == NULL)
+		{
+			printf("Not enough memory for the served customers\n");
+			return(-1);
+		}
+		state->Completions = newCompletions;
+		state->CompletionCapacity = newCapacity;
+	}
+
+	state->Completions[2 * state->CompletionCount] = state->Clock;
+	state->Completions[2 * state->CompletionCount + 1] = responseTime;
+	state->CompletionCount++;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function leaves the token of an idle server at Join-Idle-Queue of =
+//=  a random dispatcher. Only Join-Idle-Queue takes the tokens, so the     =
+//=  others do not draw for it.                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - idle active server without a token                  =
+//=  Returns: None                                                          =
+//===========================================================================
+static void leaveIdleToken(SIMULATION_STATE *state, int serverID)
+{
+	DISPATCHER *dispatcher = state->Dispatchers;  // Dispatcher which gets the idle token
+
+	if ((state->Config.DispatcherCount > 1) && (state->Config.LoadBalancer == joinIdleQueuePolicy))
+	{
+		dispatcher += randomInteger(&state->Random[decisionStream], 0, state->Config.DispatcherCount - 1);
+	}
+	dispatcher->IdleTokens[(dispatcher->IdleHead + dispatcher->IdleCount) % state->Config.NumberOfServers] =
+		serverID;
+	dispatcher->IdleCount++;
+	state->HasIdleToken[serverID] = 1;
+}
+
+//===========================================================================
+//=  This function is called when the server finishes the service of the    =
+//=  head customer. It releases the customer, updates the statistics and    =
+//=  the DelayTable, and starts the service of the next customer. A server  =
+//=  which has left the pool is not in the indexes, and it is switched off  =
+//=  when it has served its last customer.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - ID of the server                                    =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int releaseServer(SIMULATION_STATE *state, int serverID)
+{
+	SERVER_QUEUE      *queue = &state->Servers[serverID];                // Queue of the server
+	SERVER_STATISTICS *statistics = &state->ServerStatistics[serverID];  // Statistics of the server
+	PHASE_STATISTICS  *phase;                                            // Statistics of the phase of the customer
+	JOB               *job;                                              // Served customer
+	int                jobIndex;                                         // Index of the served customer
+	int                replyTo;                                          // Dispatcher of the served customer
+	int                active;                                           // Whether the server is in the pool
+	double             responseTime;                                     // Response time of the customer
+	double             waitingTime;                                      // Time the customer spent in the queue
+
+	accumulateQueueLength(state, serverID);
+	accumulateImbalance(state);
+
+	jobIndex = serverQueuePop(queue);
+	job = &state->Pool.Jobs[jobIndex];
+	replyTo = job->Dispatcher;
+	active = (serverID < state->ActiveServers);
+	if (active)
+	{
+		queueIndexDecrement(&state->ServerIndex, serverID);
+		if (state->Config.LoadBalancer == speedShortestQueuePolicy)
+		{
+			speedIndexDecrement(&state->SpeedIndex, serverID);
+		}
+		state->QueuedCustomers--;
+		state->LengthSquareSum -= 2 * queue->Count + 1;
+	}
+
+	// Calculate the response time for the customer. The service of the head
+	// customer has started when the previous one left, so the rest is waiting
+	responseTime = state->Clock - job->ArrivalTime;
+	waitingTime = responseTime - job->ServiceTime;
+	statistics->Completions++;
+	statistics->ServiceTimeSum += job->ServiceTime;
+	statistics->ResponseTimeSum += responseTime;
+	state->Classes[job->Class].Completions++;
+	state->Classes[job->Class].ResponseTimeSum += responseTime;
+	histogramRecord(&statistics->ResponseTimes, responseTime);
+	histogramRecord(&statistics->WaitingTimes, waitingTime);
+	histogramRecord(&state->WaitingTimes, waitingTime);
+	if (state->Phases != NULL)
+	{
+		phase = &state->Phases[job->Phase];
+		phase->Completions++;
+		phase->ResponseTimeSum += responseTime;
+		histogramRecord(&phase->ResponseTimes, responseTime);
+	}
+
+	// Record customer delay in the tables for the convergence test. A shard of
+	// a parallel run logs it, and the customers of all shards are recorded in
+	// the order of their departures at the end of the window
+	if (state->Mailboxes == NULL)
+	{
+		recordResponseTime(state, responseTime);
+	}
+	else if (logCompletion(state, responseTime) != 0)
+	{
+		return(-1);
+	}
+
+	releaseJob(&state->Pool, jobIndex);
+
+	// Start the service of the next customer
+	jobIndex = serverQueueHead(queue);
+	if (jobIndex != NO_JOB)
+	{
+		scheduleEvent(&state->Events, state->Clock + state->Pool.Jobs[jobIndex].ServiceTime, departureEvent, serverID);
+	}
+	// Server became idle. Report it to Join-Idle-Queue of a random dispatcher
+	else if (active && !state->HasIdleToken[serverID])
+	{
+		leaveIdleToken(state, serverID);
+	}
+	// A drained server has served its last customer and is switched off
+	else if (serverID >= state->ActiveServers + state->PendingServers)
+	{
+		accumulateServerTime(state);
+		state->DrainingServers--;
+	}
+
+	return(queueLengthChanged(state, serverID, replyTo));
+}
+
+//===========================================================================
+//=  This function chooses the server for one customer based on the chosen  =
+//=  load balancer. Batch Sampling chooses servers for the whole batch in   =
+//=  generateCustomer and is not handled here. DecisionBenchmark times the  =
+//=  load balancers through this function.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: ID of the chosen server, -1 if there is not enough memory     =
+//===========================================================================
+int chooseServer(SIMULATION_STATE *state)
+{
+	switch (state->Config.LoadBalancer)
+	{
+	case randomPolicy:
+		return(randomLoadBalancer(state));
+	case roundRobinPolicy:
+		return(roundRobinLoadBalancer(state));
+	case shortestQueuePolicy:
+		return(shortestQueueLoadBalancer(state));
+	case shortestQueueStalePolicy:
+		return(shortestQueueStaleLoadBalancer(state));
+	case improvedPolicy:
+		return(improvedLoadBalancer(state));
+	case powerOfDPolicy:
+		return(powerOfDLoadBalancer(state));
+	case joinIdleQueuePolicy:
+		return(joinIdleQueueLoadBalancer(state));
+	case predictivePolicy:
+		return(predictiveLoadBalancer(state));
+	case speedShortestQueuePolicy:
+		return(speedShortestQueueLoadBalancer(state));
+	case speedShortestQueueStalePolicy:
+		return(speedShortestQueueStaleLoadBalancer(state));
+	case speedImprovedPolicy:
+		return(speedImprovedLoadBalancer(state));
+	case speedPowerOfDPolicy:
+		return(speedPowerOfDLoadBalancer(state));
+	default:
+		return(-1);
+	}
+}
+
+//===========================================================================
+//=  This function counts the customer which reaches the server. It is a    =
+//=  collision if another dispatcher has sent a customer to the same server =
+//=  since the dispatcher of this one got the last report of the server,    =
+//=  i.e. the decision is made on a view which others have already made     =
+//=  stale. Only the balancers with the reports have such a view.           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state                                =
+//=          serverID     - server chosen for the customer                  =
+//=          dispatcherID - dispatcher of the customer                      =
+//=          reportClock  - clock of the last report of the server at the   =
+//=                         dispatcher when it has chosen the server        =
+//=          time         - time of the dispatch                            =
+//=  Returns: None                                                          =
+//===========================================================================
+static void recordEntry(SIMULATION_STATE *state, int serverID, int dispatcherID, double reportClock, double time)
+{
+	double foreignClock;  // Last customer from another dispatcher
+
+	state->ServerStatistics[serverID].Dispatches++;
+	foreignClock = (state->LastDispatcher[serverID] != dispatcherID) ? state->LastDispatchClock[serverID] :
+		state->ForeignDispatchClock[serverID];
+	if ((foreignClock > reportClock) && usesQueueReports(&state->Config))
+	{
+		state->Dispatchers[dispatcherID].Collisions++;
+	}
+
+	if (state->LastDispatcher[serverID] != dispatcherID)
+	{
+		state->ForeignDispatchClock[serverID] = state->LastDispatchClock[serverID];
+		state->LastDispatcher[serverID] = dispatcherID;
+	}
+	state->LastDispatchClock[serverID] = time;
+}
+
+//===========================================================================
+//=  This function counts the customer sent by the current dispatcher. The  =
+//=  customer of a parallel run is counted at the server when it reaches    =
+//=  the shard of the server.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - server chosen by the current dispatcher             =
+//=  Returns: None                                                          =
+//===========================================================================
+static void recordDispatch(SIMULATION_STATE *state, int serverID)
+{
+	DISPATCHER *dispatcher = state->Dispatcher;  // Current dispatcher
+
+	dispatcher->Dispatches++;
+	if (state->Mailboxes == NULL)
+	{
+		recordEntry(state, serverID, (int) (dispatcher - state->Dispatchers), dispatcher->ReportClock[serverID],
+			state->Clock);
+	}
+}
+
+//===========================================================================
+//=  This function queues the customer to the chosen server. If the queue   =
+//=  is full, the overload policy decides what happens to the customer:     =
+//=  it is dropped, passed to the shortest queue, or tries again later.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - server chosen by the load balancer                  =
+//=          jobIndex - customer                                            =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+static int admitCustomer(SIMULATION_STATE *state, int serverID, int jobIndex)
+{
+	JOB   *job = &state->Pool.Jobs[jobIndex];  // Customer
+	double backoff;                            // Mean delay of the retry
+	int    result;                             // Result of the queueing
+
+	result = queueServer(state, serverID, jobIndex);
+	if (result <= 0)
+	{
+		return(result);
+	}
+	state->ServerStatistics[serverID].Rejections++;
+
+	switch (state->Config.Overload)
+	{
+	case redirectOverload:
+		// The full server knows the real queue lengths and passes the customer on
+		serverID = queueIndexPickShortest(&state->ServerIndex, &state->Random[decisionStream]);
+		result = queueServer(state, serverID, jobIndex);
+		if (result <= 0)
+		{
+			state->Redirects++;
+			return(result);
+		}
+		break;
+	case retryOverload:
+		if (job->Retries < state->Config.MaxRetries)
+		{
+			// Random backoff, so the rejected customers do not come back together
+			backoff = state->Config.RetryDelay * (double) (1 << job->Retries);
+			job->Retries++;
+			state->Retries++;
+			scheduleEvent(&state->Events, state->Clock + randomExponential(&state->Random[delayStream], backoff),
+				retryEvent, jobIndex);
+			return(0);
+		}
+		break;
+	default:
+		break;
+	}
+
+	// The customer leaves without service
+	state->Drops++;
+	releaseJob(&state->Pool, jobIndex);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function sends a rejected customer to the server chosen by the    =
+//=  load balancer again. The customer comes back to its own dispatcher.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          jobIndex - customer                                            =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+static int retryCustomer(SIMULATION_STATE *state, int jobIndex)
+{
+	int nextServerID;  // ID of the server to queue the customer to
+
+	state->Dispatcher = &state->Dispatchers[state->Pool.Jobs[jobIndex].Dispatcher];
+	if (state->Config.LoadBalancer == batchSamplingPolicy)
+	{
+		batchSamplingLoadBalancer(state, state->BatchServerIDs, 1);
+		nextServerID = state->BatchServerIDs[0];
+	}
+	else
+	{
+		nextServerID = chooseServer(state);
+	}
+	if (nextServerID < 0)
+	{
+		return(-1);
+	}
+	recordDispatch(state, nextServerID);
+
+	return(admitCustomer(state, nextServerID, jobIndex));
+}
+
+//===========================================================================
+//=  This function sends the customer of a parallel run to the shard of the =
+//=  chosen server, which may be the own shard. The customer reaches the    =
+//=  server at its arrival time. The server counts the dispatch and its     =
+//=  collision when the message comes, so the message carries the clock of  =
+//=  the report which the decision was based on.                            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state of a shard                     =
+//=          serverID     - server chosen by the current dispatcher         =
+//=          serviceTime  - service demand of the customer                  =
+//=          requestClass - request class of the customer                   =
+//=  Returns: 0 on success, -1 if the mailboxes have failed                 =
+//===========================================================================
+static int postCustomer(SIMULATION_STATE *state, int serverID, double serviceTime, int requestClass)
+{
+	MESSAGE message;  // Customer
+
+	message.Time = state->Clock;
+	message.ServiceTime = serviceTime;
+	message.ReportClock = state->Dispatcher->ReportClock[serverID];
+	message.Type = customerMessage;
+	message.ServerID = serverID;
+	message.Dispatcher = (int) (state->Dispatcher - state->Dispatchers);
+	message.Class = requestClass;
+	message.Length = 0;
+
+	if (mailboxSend(state->Mailboxes, state->Config.Shard, serverShard(state, serverID), &message) != 0)
+	{
+		printMailboxError();
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function sends the customers which arrive at the current clock to =
+//=  the dispatcher to the servers chosen by its load balancer. It is the   =
+//=  dispatch point for the arrival process of the model and for customers  =
+//=  which are given from outside (see ExternalArrivals).                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state                                =
+//=          dispatcherID - dispatcher of the customers                     =
+//=          serviceTimes - service time of each customer                   =
+//=          classes      - request class of each customer from 0 to        =
+//=                         MAX_CLASSES - 1, NULL if all are class 0        =
+//=          count        - number of customers                             =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+static int dispatchGroup(SIMULATION_STATE *state, int dispatcherID, const double *serviceTimes, const int *classes,
+	int count)
+{
+	int jobIndex;      // New customer
+	int nextServerID;  // ID of the server to queue current customer to
+	int phase;         // Phase of the arrival rate
+	int i;             // Customer counter
+
+	state->Dispatcher = &state->Dispatchers[dispatcherID];
+	phase = (state->Phases != NULL) ? arrivalRatesPhase(&state->Rates) : 0;
+
+	// Batch Sampling places the whole batch at once
+	if (state->Config.LoadBalancer == batchSamplingPolicy)
+	{
+		batchSamplingLoadBalancer(state, state->BatchServerIDs, count);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		// New customer has arrived. Increment ArrivalCounter
+		state->ArrivalCounter++;
+		if (state->Phases != NULL)
+		{
+			state->Phases[phase].Arrivals++;
+		}
+
+		// Choose the server for the current customer based on the chosen load balancer
+		if (state->Config.LoadBalancer == batchSamplingPolicy)
+		{
+			nextServerID = state->BatchServerIDs[i];
+		}
+		else
+		{
+			nextServerID = chooseServer(state);
+		}
+		if (nextServerID < 0)
+		{
+			return(-1);
+		}
+		recordDispatch(state, nextServerID);
+
+		// The customer of a parallel run goes to the shard of the server
+		if (state->Mailboxes != NULL)
+		{
+			if (postCustomer(state, nextServerID, serviceTimes[i], (classes != NULL) ? classes[i] : 0) != 0)
+			{
+				return(-1);
+			}
+			continue;
+		}
+
+		jobIndex = allocateJob(&state->Pool);
+		if (jobIndex == NO_JOB)
+		{
+			printf("Not enough memory for the customers\n");
+			return(-1);
+		}
+		state->Pool.Jobs[jobIndex].ArrivalTime = state->Clock;
+		state->Pool.Jobs[jobIndex].ServiceTime = serviceTimes[i];
+		state->Pool.Jobs[jobIndex].Class = (classes != NULL) ? classes[i] : 0;
+		state->Pool.Jobs[jobIndex].Retries = 0;
+		state->Pool.Jobs[jobIndex].Dispatcher = dispatcherID;
+		state->Pool.Jobs[jobIndex].Phase = phase;
+
+		// Queue current customer to the chosen server
+		if (admitCustomer(state, nextServerID, jobIndex) != 0)
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function sends the customers given from outside at the current    =
+//=  clock. Groups of customers come to the dispatchers in turn.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state                                =
+//=          serviceTimes - service time of each customer                   =
+//=          classes      - request class of each customer from 0 to        =
+//=                         MAX_CLASSES - 1, NULL if all are class 0        =
+//=          count        - number of customers                             =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int dispatchCustomers(SIMULATION_STATE *state, const double *serviceTimes, const int *classes, int count)
+{
+	int dispatcherID;  // Dispatcher of the group
+
+	dispatcherID = (int) (state->ExternalGroups % state->Config.DispatcherCount);
+	state->ExternalGroups++;
+
+	return(dispatchGroup(state, dispatcherID, serviceTimes, classes, count));
+}
+
+//===========================================================================
+//=  This function generates a batch of BatchSize new customers (one        =
+//=  customer by default) at the dispatcher and dispatches them. Then it    =
+//=  schedules the next arrival of the dispatcher (see scheduleArrival).    =
+//=  The service demands of the batch come from the service distribution,   =
+//=  exponential by default. They are filled at once from the service       =
+//=  stream, so they do not depend on the other draws.                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - simulation state                                =
+//=          dispatcherID - dispatcher of the arrival                       =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+static int generateCustomer(SIMULATION_STATE *state, int dispatcherID)
+{
+	int batchSize = state->Config.BatchSize;  // Number of customers in the batch
+
+	// An arrival which was drawn again at a change of the rate has left its old event behind
+	if (state->Clock != state->Dispatchers[dispatcherID].NextArrivalClock)
+	{
+		return(0);
+	}
+
+	// Schedule the next batch
+	scheduleArrival(state, dispatcherID);
+
+	serviceFill(&state->Service, &state->Random[serviceStream], state->BatchServiceTimes, batchSize);
+
+	return(dispatchGroup(state, dispatcherID, state->BatchServiceTimes, NULL, batchSize));
+}
+
+//===========================================================================
+//=  This function takes the snapshot of the queue lengths of all servers   =
+//=  for every dispatcher and schedules the next update after StalePeriod   =
+//=  time. The dispatchers get the snapshot in one delivery, at once or     =
+//=  after NetworkDelay. The delivery rebuilds the stale index of every     =
+//=  dispatcher. Only the servers in the pool report.                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int updateInformation(SIMULATION_STATE *state)
+{
+	int last;  // Server after the last reporting one
+	int i;     // Iteration counter
+
+	last = (state->LastServer < state->ActiveServers) ? state->LastServer : state->ActiveServers;
+	scheduleEvent(&state->Events, state->Clock + state->Config.StalePeriod, updateEvent, 0);
+	state->Messages += (long long) (last - state->FirstServer) * state->Config.DispatcherCount;
+
+	for (i = state->FirstServer; i < last; i++)
+	{
+		state->ReportedLength[i] = state->Servers[i].Count;
+		if (state->Mailboxes != NULL)
+		{
+			if (postReport(state, i, ALL_DISPATCHERS, state->Servers[i].Count) != 0)
+			{
+				return(-1);
+			}
+			continue;
+		}
+		if ((serverQueuePush(&state->Reports, ALL_DISPATCHERS) != 0) || (serverQueuePush(&state->Reports, i) != 0) ||
+			(serverQueuePush(&state->Reports, state->Servers[i].Count) != 0))
+		{
+			printf("Not enough memory for the reports\n");
+			return(-1);
+		}
+	}
+
+	if (state->Mailboxes != NULL)
+	{
+		return(0);
+	}
+	if (state->Config.NetworkDelay > 0.0)
+	{
+		scheduleEvent(&state->Events, state->Clock + state->Config.NetworkDelay, deliveryEvent,
+			last - state->FirstServer);
+		return(0);
+	}
+
+	return(deliverReports(state, last - state->FirstServer));
+}
+
+//===========================================================================
+//=  This function sends the periodic report of one server and schedules    =
+//=  its next report. The period is uniform in StalePeriod * (1 +/-         =
+//=  UpdateJitter), so the servers do not report at the same time. A server =
+//=  out of the pool keeps its schedule but does not report.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - reporting server                                    =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int reportInformation(SIMULATION_STATE *state, int serverID)
+{
+	double period = state->Config.StalePeriod;  // Mean period of the reports
+	double jitter = state->Config.UpdateJitter;  // Relative jitter of the period
+
+	scheduleEvent(&state->Events, state->Clock + randomUniform(&state->Random[delayStream],
+		period * (1.0 - jitter), period * (1.0 + jitter)), reportEvent, serverID);
+	if (serverID >= state->ActiveServers)
+	{
+		return(0);
+	}
+
+	return(sendReport(state, serverID, ALL_DISPATCHERS));
+}
+
+//===========================================================================
+//=  This function records one telemetry sample of every server: its queue  =
+//=  length, whether it is busy, the customers sent to it since the last    =
+//=  sample, the error of the view of the first dispatcher and the total    =
+//=  response time of its served customers. The sample is written into the  =
+//=  ring buffer of the writer in place, so a sample of N servers costs one =
+//=  pass over the servers. Then it schedules the next sample at a random   =
+//=  time of the next interval.                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state with Telemetry                        =
+//=  Returns: None                                                          =
+//===========================================================================
+static void recordSample(SIMULATION_STATE *state)
+{
+	SERVER_STATISTICS *statistics;  // Statistics of the current server
+	TELEMETRY_SAMPLE   sample;      // Columns of the sample in the ring buffer
+	const int         *view;        // Queue lengths seen by the first dispatcher, NULL if it has no reports
+	int                i;           // Server counter
+
+	view = usesQueueReports(&state->Config) ? state->Dispatchers[0].QueueLength : NULL;
+	telemetryNextSample(state->Telemetry, state->Clock, &sample);
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		statistics = &state->ServerStatistics[i];
+		sample.Delay[i] = statistics->ResponseTimeSum;
+		sample.QueueLength[i] = state->Servers[i].Count;
+		sample.Dispatches[i] = (uint32_t) (statistics->Dispatches - statistics->SampledDispatches);
+		sample.Staleness[i] = (view != NULL) ? state->Servers[i].Count - view[i] : 0;
+		sample.Busy[i] = (uint8_t) (state->Servers[i].Count > 0);
+		statistics->SampledDispatches = statistics->Dispatches;
+	}
+	telemetryCommitSample(state->Telemetry);
+
+	state->SampleSlot += state->Telemetry->Header.Interval;
+	scheduleEvent(&state->Events, state->SampleSlot +
+		randomUniform(&state->SampleRandom, 0.0, state->Telemetry->Header.Interval), sampleEvent, 0);
+}
+
+//===========================================================================
+//=  This function makes the next change of the arrival rate and schedules  =
+//=  the change after it. The interarrival times are memoryless, so the     =
+//=  next arrival of every dispatcher is drawn again at the new rate. The   =
+//=  old arrival events stay in the event list and are void.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: None                                                          =
+//===========================================================================
+static void changeRate(SIMULATION_STATE *state)
+{
+	int d;  // Dispatcher counter
+
+	accumulateServerTime(state);
+	arrivalRatesAdvance(&state->Rates, state->Clock, &state->Random[loadStream]);
+	if (arrivalRatesNextChange(&state->Rates) < HUGE_VAL)
+	{
+		scheduleEvent(state->DispatcherList, arrivalRatesNextChange(&state->Rates), rateEvent, 0);
+	}
+
+	if (state->Config.ExternalArrivals)
+	{
+		return;
+	}
+	for (d = 0; d < state->Config.DispatcherCount; d++)
+	{
+		if (ownsDispatcher(state, d))
+		{
+			scheduleArrival(state, d);
+		}
+	}
+}
+
+//===========================================================================
+//=  This function puts the server after the last active one into the pool. =
+//=  It enters the index of the real queue lengths and the views of the     =
+//=  dispatchers with its current customers. A dispatcher with reports gets =
+//=  one from the new server at once, the others see it as empty. An idle   =
+//=  server leaves a token at Join-Idle-Queue.                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int addServer(SIMULATION_STATE *state)
+{
+	DISPATCHER *dispatcher;                                      // Current dispatcher
+	int         serverID = state->ActiveServers;                 // Added server
+	int         length = state->Servers[serverID].Count;         // Its number of customers
+	int         reports = usesQueueReports(&state->Config);      // Whether the servers send reports
+	int         speedIndex = usesStaleSpeedIndex(&state->Config);  // Whether the speed indexes of the views are kept
+	int         d;                                               // Dispatcher counter
+
+	accumulateImbalance(state);
+	if ((queueIndexAdd(&state->ServerIndex, serverID, length) != 0) ||
+		((state->Config.LoadBalancer == speedShortestQueuePolicy) &&
+		(speedIndexAdd(&state->SpeedIndex, serverID, length) != 0)))
+	{
+		printf("Not enough memory for the queue index\n");
+		return(-1);
+	}
+	state->QueuedCustomers += length;
+	state->LengthSquareSum += (long long) length * length;
+	state->ActiveServers++;
+
+	for (d = 0; d < state->Config.DispatcherCount; d++)
+	{
+		if (!ownsDispatcher(state, d))
+		{
+			continue;
+		}
+		dispatcher = &state->Dispatchers[d];
+		if (reports)
+		{
+			dispatcher->QueueLength[serverID] = length;
+			dispatcher->ReportClock[serverID] = state->Clock;
+			dispatcher->EmptyClock[serverID] = state->Clock + length / (state->Config.Mu * state->Speed[serverID]);
+			state->Messages++;
+		}
+		if ((queueIndexAdd(&dispatcher->StaleIndex, serverID, dispatcher->QueueLength[serverID]) != 0) ||
+			(speedIndex && (speedIndexAdd(&dispatcher->StaleSpeedIndex, serverID,
+			dispatcher->QueueLength[serverID]) != 0)))
+		{
+			printf("Not enough memory for the queue index\n");
+			return(-1);
+		}
+		if (usesEmptyHeap(&state->Config))
+		{
+			serverHeapAdd(&dispatcher->EmptyHeap, serverID);
+		}
+	}
+	state->ReportedLength[serverID] = length;
+
+	if ((length == 0) && !state->HasIdleToken[serverID])
+	{
+		leaveIdleToken(state, serverID);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function moves the element last of an array of servers to first   =
+//=  and the elements from first to last - 1 up by one.                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: array - values of all servers                                  =
+//=          size  - size of one value, at most sizeof(SERVER_STATISTICS)   =
+//=          first - new place of the element last                          =
+//=          last  - moved element                                          =
+//=  Returns: None                                                          =
+//===========================================================================
+static void rotateArray(void *array, size_t size, int first, int last)
+{
+	unsigned char *bytes = (unsigned char *) array;   // Values as bytes
+	unsigned char  moved[sizeof(SERVER_STATISTICS)];  // Value of the element last, the largest of a server
+
+	memcpy(moved, bytes + last * size, size);
+	memmove(bytes + (first + 1) * size, bytes + first * size, (last - first) * size);
+	memcpy(bytes + first * size, moved, size);
+}
+
+//===========================================================================
+//=  This function returns the ID of a server after rotateServers().        =
+//===========================================================================
+static int rotatedID(int serverID, int first, int last)
+{
+	if (serverID == last)
+	{
+		return(first);
+	}
+
+	return(((serverID >= first) && (serverID < last)) ? serverID + 1 : serverID);
+}
+
+//===========================================================================
+//=  This function gives the server last the ID first and moves the         =
+//=  servers from first to last - 1 up by one ID, with everything that      =
+//=  belongs to them: the queue, the statistics, the speed, the views of    =
+//=  the dispatchers, the events, the reports on the way and the idle       =
+//=  tokens. All of them must be out of the pool, so the indexes of the     =
+//=  active servers do not change. The autoscaler puts a draining server    =
+//=  in front of the pending ones this way.                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          first - new ID of the server last, at least ActiveServers      =
+//=          last  - moved server                                           =
+//=  Returns: None                                                          =
+//===========================================================================
+static void rotateServers(SIMULATION_STATE *state, int first, int last)
+{
+	DISPATCHER *dispatcher;  // Current dispatcher
+	EVENT      *event;       // Current event
+	int        *entry;       // Server of the current idle token or report on the way
+	int         d;           // Dispatcher counter
+	int         i;           // Server, event, report and token counter
+
+	rotateArray(state->Servers, sizeof(SERVER_QUEUE), first, last);
+	rotateArray(state->ServerStatistics, sizeof(SERVER_STATISTICS), first, last);
+	rotateArray(state->ReportedLength, sizeof(int), first, last);
+	rotateArray(state->Speed, sizeof(double), first, last);
+	rotateArray(state->HasIdleToken, sizeof(char), first, last);
+	rotateArray(state->LastDispatcher, sizeof(int), first, last);
+	rotateArray(state->LastDispatchClock, sizeof(double), first, last);
+	rotateArray(state->ForeignDispatchClock, sizeof(double), first, last);
+	rotateArray(state->ReadyClock, sizeof(double), first, last);
+	speedIndexRotate(&state->SpeedIndex, first, last);
+
+	for (d = 0; d < state->Config.DispatcherCount; d++)
+	{
+		dispatcher = &state->Dispatchers[d];
+		rotateArray(dispatcher->QueueLength, sizeof(int), first, last);
+		rotateArray(dispatcher->ReportClock, sizeof(double), first, last);
+		rotateArray(dispatcher->EmptyClock, sizeof(double), first, last);
+		speedIndexRotate(&dispatcher->StaleSpeedIndex, first, last);
+		for (i = 0; i < dispatcher->IdleCount; i++)
+		{
+			entry = &dispatcher->IdleTokens[(dispatcher->IdleHead + i) % state->Config.NumberOfServers];
+			*entry = rotatedID(*entry, first, last);
+		}
+	}
+
+	// The order of the events does not depend on their servers
+	for (i = 0; i < state->Events.Count; i++)
+	{
+		event = &state->Events.Heap[i];
+		if ((event->Type == departureEvent) || (event->Type == reportEvent) || (event->Type == provisionEvent))
+		{
+			event->ServerID = rotatedID(event->ServerID, first, last);
+		}
+	}
+	// Every report on the way is the dispatcher, the server and the queue length
+	for (i = 1; i < state->Reports.Count; i += 3)
+	{
+		entry = &state->Reports.Jobs[(state->Reports.Head + i) & state->Reports.Mask];
+		*entry = rotatedID(*entry, first, last);
+	}
+}
+
+//===========================================================================
+//=  This function starts a server after the active and the pending ones.   =
+//=  It takes customers after ProvisionDelay. A drained server which still  =
+//=  serves its customers is taken back first and at once: it moves in      =
+//=  front of the pending servers, which keep their order, so it does not   =
+//=  wait behind them.                                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state with a server out of the pool         =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int provisionServer(SIMULATION_STATE *state)
+{
+	int serverID = state->ActiveServers + state->PendingServers;  // Provisioned or reclaimed server
+	int drained = serverID;                                       // Draining server which is taken back
+
+	accumulateServerTime(state);
+	while ((state->DrainingServers > 0) && (drained < state->LastServer) && (state->Servers[drained].Count == 0))
+	{
+		drained++;
+	}
+	if ((state->DrainingServers > 0) && (drained < state->LastServer))
+	{
+		if (drained > state->ActiveServers)
+		{
+			rotateServers(state, state->ActiveServers, drained);
+		}
+		state->DrainingServers--;
+		state->Reclaims++;
+		return(addServer(state));
+	}
+
+	state->Provisions++;
+	state->PendingServers++;
+	state->ReadyClock[serverID] = state->Clock + state->Config.ProvisionDelay;
+	scheduleEvent(&state->Events, state->ReadyClock[serverID], provisionEvent, serverID);
+	if (billedServers(state) > state->PeakServers)
+	{
+		state->PeakServers = billedServers(state);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function cancels the last pending server. Its event becomes void. =
+//===========================================================================
+static void cancelServer(SIMULATION_STATE *state)
+{
+	int serverID = state->ActiveServers + state->PendingServers - 1;  // Canceled server
+
+	accumulateServerTime(state);
+	state->PendingServers--;
+	state->ReadyClock[serverID] = -1.0;
+	if (state->Servers[serverID].Count > 0)
+	{
+		state->DrainingServers++;
+	}
+}
+
+//===========================================================================
+//=  This function takes the last active server out of the pool. It serves  =
+//=  the customers in its queue and is switched off after the last one.     =
+//===========================================================================
+static void drainServer(SIMULATION_STATE *state)
+{
+	accumulateServerTime(state);
+	accumulateImbalance(state);
+	removeServer(state);
+	state->Drains++;
+	if (state->Servers[state->ActiveServers].Count > 0)
+	{
+		state->DrainingServers++;
+	}
+}
+
+//===========================================================================
+//=  This function puts the provisioned server into the pool when it is     =
+//=  ready. The servers are provisioned one after another with the same     =
+//=  delay, so the ready one is the first pending server. The event of a    =
+//=  canceled server is void.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state    - simulation state                                    =
+//=          serverID - provisioned server                                  =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int serverReady(SIMULATION_STATE *state, int serverID)
+{
+	if ((state->PendingServers == 0) || (serverID != state->ActiveServers) ||
+		(state->ReadyClock[serverID] != state->Clock))
+	{
+		return(0);
+	}
+
+	state->PendingServers--;
+	state->ReadyClock[serverID] = -1.0;
+
+	return(addServer(state));
+}
+
+//===========================================================================
+//=  This function is the autoscaler. Every ScaleInterval it measures the   =
+//=  arrival rate since its last decision and recommends the servers which  =
+//=  keep their utilization at TargetUtilization. It scales out at once:    =
+//=  new servers are provisioned and take customers after ProvisionDelay.   =
+//=  It scales in only to the largest recommendation of the last            =
+//=  SCALE_WINDOW decisions, so a short lull does not drain the servers     =
+//=  which the next burst needs. Pending servers are canceled before the    =
+//=  active ones are drained.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int scaleServers(SIMULATION_STATE *state)
+{
+	double rate;     // Measured arrival rate
+	int    target;   // Active and pending servers after the decision
+	int    current;  // Active and pending servers before the decision
+	int    i;        // Decision counter
+
+	scheduleEvent(&state->Events, state->Clock + state->Config.ScaleInterval, scaleEvent, 0);
+	rate = (state->ArrivalCounter - state->ScaleArrivals) / state->Config.ScaleInterval;
+	state->ScaleArrivals = state->ArrivalCounter;
+	target = recommendedServers(state, rate);
+	state->ScaleWindow[state->ScaleDecisions % SCALE_WINDOW] = target;
+	state->ScaleDecisions++;
+
+	current = state->ActiveServers + state->PendingServers;
+	if (target < current)
+	{
+		for (i = 0; (i < SCALE_WINDOW) && (i < state->ScaleDecisions); i++)
+		{
+			target = (state->ScaleWindow[i] > target) ? state->ScaleWindow[i] : target;
+		}
+		target = (target < current) ? target : current;
+	}
+
+	while (state->ActiveServers + state->PendingServers < target)
+	{
+		if (provisionServer(state) != 0)
+		{
+			return(-1);
+		}
+	}
+	while ((state->ActiveServers + state->PendingServers > target) && (state->PendingServers > 0))
+	{
+		cancelServer(state);
+	}
+	while (state->ActiveServers > target)
+	{
+		drainServer(state);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function takes the earliest event from the event list, advances   =
+//=  the clock and handles the event.                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=          list  - event list, Events or DispatcherEvents                 =
+//=          event - place to store the handled event                       =
+//=  Returns: 1 if the event was handled, 0 if the event list is empty,     =
+//=           -1 if the system is broken                                    =
+//===========================================================================
+static int handleNextEvent(SIMULATION_STATE *state, EVENT_LIST *list, EVENT *event)
+{
+	if (!nextEvent(list, event))
+	{
+		return(0);
+	}
+
+	state->Clock = event->Time;
+	state->EventCounter++;
+
+	if (event->Type == arrivalEvent)
+	{
+		return((generateCustomer(state, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == departureEvent)
+	{
+		return((releaseServer(state, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == retryEvent)
+	{
+		return((retryCustomer(state, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == reportEvent)
+	{
+		return((reportInformation(state, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == deliveryEvent)
+	{
+		return((deliverReports(state, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == sampleEvent)
+	{
+		recordSample(state);
+		return(1);
+	}
+	if (event->Type == entryEvent)
+	{
+		return((admitCustomer(state, state->Pool.Jobs[event->ServerID].ServerID, event->ServerID) == 0) ? 1 : -1);
+	}
+	if (event->Type == rateEvent)
+	{
+		changeRate(state);
+		return(1);
+	}
+	if (event->Type == scaleEvent)
+	{
+		return((scaleServers(state) == 0) ? 1 : -1);
+	}
+	if (event->Type == provisionEvent)
+	{
+		return((serverReady(state, event->ServerID) == 0) ? 1 : -1);
+	}
+
+	return((updateInformation(state) == 0) ? 1 : -1);
+}
+
+//===========================================================================
+//=  This function handles all events up to untilTime and then moves the    =
+//=  clock to untilTime. It is used when the customers are given from       =
+//=  outside: the caller advances the model to the arrival time and then    =
+//=  calls dispatchCustomers().                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - simulation state                                   =
+//=          untilTime - new clock of the simulation                        =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int advanceSimulation(SIMULATION_STATE *state, double untilTime)
+{
+	EVENT event;  // Handled event
+
+	while ((state->Events.Count > 0) && (state->Events.Heap[0].Time <= untilTime))
+	{
+		if (handleNextEvent(state, &state->Events, &event) < 0)
+		{
+			return(-1);
+		}
+	}
+	state->Clock = untilTime;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function takes the messages which have reached the shard of a     =
+//=  parallel run out of the rings of the mailboxes.                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state of a shard                            =
+//=  Returns: 0 on success, -1 if the mailboxes have failed                 =
+//===========================================================================
+static int collectMessages(SIMULATION_STATE *state)
+{
+	if (mailboxesCollect(state->Mailboxes, state->Config.Shard) != 0)
+	{
+		printMailboxError();
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function finds the earliest collected message of the given type   =
+//=  from all shards. Every shard sends its messages in time order, and     =
+//=  messages with the same time are taken in the order of their senders,   =
+//=  so the result of a parallel run does not depend on the timing of the   =
+//=  threads. The messages of the other type wait behind the ones taken.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state  - simulation state of a shard                           =
+//=          type   - message type                                          =
+//=          sender - place to store the shard which has sent the message   =
+//=  Returns: earliest message, NULL if there is none                       =
+//===========================================================================
+static const MESSAGE *earliestMessage(const SIMULATION_STATE *state, enum MESSAGE_TYPE type, int *sender)
+{
+	const MESSAGE *earliest = NULL;  // Earliest message so far
+	const MESSAGE *message;          // Oldest message of the current sender
+	int            shard;            // Sender counter
+
+	for (shard = 0; shard < state->Config.ShardCount; shard++)
+	{
+		message = mailboxPeek(state->Mailboxes, state->Config.Shard, shard);
+		if ((message != NULL) && (message->Type == (int) type) &&
+			((earliest == NULL) || (message->Time < earliest->Time)))
+		{
+			earliest = message;
+			*sender = shard;
+		}
+	}
+
+	return(earliest);
+}
+
+//===========================================================================
+//=  This function takes the reports which the shards have sent to the      =
+//=  dispatchers of this shard and schedules their deliveries. Reports with =
+//=  the same time, e.g. the snapshot of all servers, are delivered         =
+//=  together, so the indexes are rebuilt once as in the sequential engine. =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state of a shard                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int receiveReports(SIMULATION_STATE *state)
+{
+	const MESSAGE *message;     // Current report
+	double         time = 0.0;  // Time of the current delivery
+	int            count = 0;   // Reports of the current delivery
+	int            sender;      // Shard which has sent the report
+
+	if (collectMessages(state) != 0)
+	{
+		return(-1);
+	}
+
+	while ((message = earliestMessage(state, reportMessage, &sender)) != NULL)
+	{
+		if ((count > 0) && (message->Time != time))
+		{
+			scheduleEvent(&state->DispatcherEvents, time, deliveryEvent, count);
+			count = 0;
+		}
+		if ((serverQueuePush(&state->Reports, message->Dispatcher) != 0) ||
+			(serverQueuePush(&state->Reports, message->ServerID) != 0) ||
+			(serverQueuePush(&state->Reports, message->Length) != 0))
+		{
+			printf("Not enough memory for the reports\n");
+			return(-1);
+		}
+		time = message->Time;
+		count++;
+		mailboxPop(state->Mailboxes, state->Config.Shard, sender);
+	}
+	if (count > 0)
+	{
+		scheduleEvent(&state->DispatcherEvents, time, deliveryEvent, count);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function takes the customers which the dispatchers of all shards  =
+//=  have sent to the servers of this shard. Each customer gets a job and   =
+//=  enters its server at its arrival time.                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state of a shard                            =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+static int receiveCustomers(SIMULATION_STATE *state)
+{
+	const MESSAGE *message;   // Current customer
+	JOB           *job;       // Job of the customer
+	int            jobIndex;  // Index of the job
+	int            sender;    // Shard which has sent the customer
+
+	if (collectMessages(state) != 0)
+	{
+		return(-1);
+	}
+
+	while ((message = earliestMessage(state, customerMessage, &sender)) != NULL)
+	{
+		jobIndex = allocateJob(&state->Pool);
+		if (jobIndex == NO_JOB)
+		{
+			printf("Not enough memory for the customers\n");
+			return(-1);
+		}
+		job = &state->Pool.Jobs[jobIndex];
+		job->ArrivalTime = message->Time;
+		job->ServiceTime = message->ServiceTime;
+		job->Class = message->Class;
+		job->Retries = 0;
+		job->Dispatcher = message->Dispatcher;
+		job->Phase = 0;
+		job->ServerID = message->ServerID;
+		recordEntry(state, message->ServerID, message->Dispatcher, message->ReportClock, message->Time);
+		scheduleEvent(&state->Events, message->Time, entryEvent, jobIndex);
+		mailboxPop(state->Mailboxes, state->Config.Shard, sender);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function runs the dispatchers of a shard of a parallel run to the =
+//=  end of the window. The reports sent in the previous window are due in  =
+//=  this one at the earliest, so they are scheduled first. The customers   =
+//=  go to the mailboxes of the shards of their servers. The rings are      =
+//=  emptied every COLLECT_PERIOD events, so the senders rarely wait.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - simulation state of a shard                        =
+//=          untilTime - end of the window                                  =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int advanceDispatchers(SIMULATION_STATE *state, double untilTime)
+{
+	EVENT event;  // Handled event
+
+	if (receiveReports(state) != 0)
+	{
+		return(-1);
+	}
+
+	while ((state->DispatcherEvents.Count > 0) && (state->DispatcherEvents.Heap[0].Time <= untilTime))
+	{
+		if ((handleNextEvent(state, &state->DispatcherEvents, &event) < 0) ||
+			((state->EventCounter % COLLECT_PERIOD == 0) && (collectMessages(state) != 0)))
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function runs the servers of a shard of a parallel run to the end =
+//=  of the window, after every dispatcher has finished the window. The     =
+//=  customers of the window enter their servers, and the reports go to     =
+//=  the mailboxes of the shards of their dispatchers.                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - simulation state of a shard                        =
+//=          untilTime - end of the window                                  =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int advanceServers(SIMULATION_STATE *state, double untilTime)
+{
+	EVENT event;  // Handled event
+
+	if (receiveCustomers(state) != 0)
+	{
+		return(-1);
+	}
+
+	while ((state->Events.Count > 0) && (state->Events.Heap[0].Time <= untilTime))
+	{
+		if ((handleNextEvent(state, &state->Events, &event) < 0) ||
+			((state->EventCounter % COLLECT_PERIOD == 0) && (collectMessages(state) != 0)))
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function handles the events until every customer has been served  =
+//=  or dropped. It is used at the end of a finite workload, e.g. a trace.  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state                                       =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+static int drainSimulation(SIMULATION_STATE *state)
+{
+	EVENT event;  // Handled event
+
+	while (state->ArrivalCounter > state->DelayTable.Count + state->Drops)
+	{
+		if (handleNextEvent(state, &state->Events, &event) <= 0)
+		{
+			return(-1);
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function lets the run write telemetry samples. The time from the  =
+//=  current clock is cut into intervals of the writer, and every interval  =
+//=  has one sample at a uniformly random time within it. Snapshots and     =
+//=  report timers are often periodic, and samples at a fixed phase would   =
+//=  always see the view at the same age since its update. The times come   =
+//=  from their own stream, so the model draws the same numbers with and    =
+//=  without telemetry. Without a writer the model schedules no samples.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - initialized simulation state                       =
+//=          telemetry - opened writer with the servers of the run          =
+//=  Returns: None                                                          =
+//===========================================================================
+void simulationAttachTelemetry(SIMULATION_STATE *state, TELEMETRY_WRITER *telemetry)
+{
+	state->Telemetry = telemetry;
+	state->SampleSlot = state->Clock;
+	scheduleEvent(&state->Events, state->SampleSlot + randomUniform(&state->SampleRandom, 0.0,
+		telemetry->Header.Interval), sampleEvent, 0);
+}
+
+//===========================================================================
+//=  This function makes the state a shard of a parallel run, which sends   =
+//=  its customers and reports to the other shards through the mailboxes.   =
+//=  The state must be initialized with the ShardCount and Shard of the     =
+//=  run. The caller advances the dispatchers and the servers window by     =
+//=  window and records the logged customers (see ParallelSimulation).      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state     - initialized simulation state                       =
+//=          mailboxes - mailboxes of all shards of the run                 =
+//=  Returns: None                                                          =
+//===========================================================================
+void simulationAttachMailboxes(SIMULATION_STATE *state, MAILBOXES *mailboxes)
+{
+	state->Mailboxes = mailboxes;
+}
+
+//===========================================================================
+//=  This function closes the queue length and server time integrals at the =
+//=  current clock. It must be called before the statistics are printed.    =
+//===========================================================================
+void finishSimulation(SIMULATION_STATE *state)
+{
+	int i;  // Loop counter
+
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		accumulateQueueLength(state, i);
+	}
+	accumulateImbalance(state);
+	accumulateServerTime(state);
+}
+
+//===========================================================================
+//=  Main event loop. It handles the events one by one. The loop stops when =
+//=  the desired ACCURACY is achieved with the desired probability (or      =
+//=  after RunLength customers) or when the MAX_TIME of CPU time is spent.  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - initialized simulation state                           =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int runSimulation(SIMULATION_STATE *state)
+{
+	EVENT  event;       // Current event
+	double startClock;  // CPU clock at the start of the run
+	int    handled;     // Result of the event handling
+	int    result = 0;  // Result of the run
+
+	startClock = cpuClock();
+
+	while ((handled = handleNextEvent(state, &state->Events, &event)) != 0)
+	{
+		if (handled < 0)
+		{
+			result = -1;
+			break;
+		}
+
+		// Run length control
+		if ((event.Type == departureEvent) && runLengthReached(state))
+		{
+			state->Converged = 1;
+			break;
+		}
+
+		if ((state->EventCounter % CPU_CHECK_PERIOD == 0) &&
+			(cpuClock() - startClock > state->Config.MaxTime))
+		{
+			break;
+		}
+	}
+
+	finishSimulation(state);
+
+	state->CpuTime = cpuClock() - startClock;
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function replays the customers of the trace instead of the        =
+//=  arrival process. The time is shifted so that the first customer        =
+//=  arrives at 0. Customers with the same timestamp are dispatched         =
+//=  together (so Batch Sampling places them at once) in groups of at most  =
+//=  BatchSize. After the last customer the model runs until the system is  =
+//=  empty. The records are checked as they are read, since a trace may     =
+//=  come from another tool than the trace writer. The state must be        =
+//=  initialized with ExternalArrivals.                                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state        - initialized simulation state                    =
+//=          trace        - opened trace                                    =
+//=          maxCustomers - number of replayed customers, 0 for all         =
+//=  Returns: 0 on success, -1 if the system is broken                      =
+//===========================================================================
+int replayTrace(SIMULATION_STATE *state, const TRACE *trace, long long maxCustomers)
+{
+	const TRACE_RECORD *records = trace->Records;  // Customers of the trace
+	long long           count;                     // Number of replayed customers
+	long long           next = 0;                  // Next record
+	double              start;                     // Timestamp of the first customer
+	double              timestamp;                 // Timestamp of the current group
+	int                 classes[TRACE_BATCH];      // Classes of the current group
+	int                 groupLimit;                // Largest group dispatched at once
+	int                 groupSize;                 // Number of customers in the current group
+	double              startClock;                // CPU clock at the start of the replay
+	int                 result = 0;                // Result of the replay
+
+	if (trace->Header->NumberOfClasses > MAX_CLASSES)
+	{
+		printf("ERROR! Trace has %u request classes, at most %d are supported\n",
+			(unsigned int) trace->Header->NumberOfClasses, MAX_CLASSES);
+		return(-1);
+	}
+
+	count = trace->NumberOfRecords;
+	if ((maxCustomers > 0) && (maxCustomers < count))
+	{
+		count = maxCustomers;
+	}
+	groupLimit = (state->Config.BatchSize < TRACE_BATCH) ? state->Config.BatchSize : TRACE_BATCH;
+	start = (count > 0) ? records[0].Timestamp : 0.0;
+
+	startClock = cpuClock();
+
+	while (next < count)
+	{
+		timestamp = records[next].Timestamp;
+		if (!isfinite(timestamp))
+		{
+			printf("ERROR! Record %lld has the timestamp %g\n", next, timestamp);
+			result = -1;
+			break;
+		}
+		if (timestamp - start < state->Clock)
+		{
+			printf("ERROR! Timestamps of the trace decrease at record %lld\n", next);
+			result = -1;
+			break;
+		}
+
+		for (groupSize = 0; (groupSize < groupLimit) && (next < count) && (records[next].Timestamp == timestamp);
+			groupSize++, next++)
+		{
+			state->BatchServiceTimes[groupSize] = records[next].ServiceDemand;
+			classes[groupSize] = records[next].Class;
+			if (classes[groupSize] >= MAX_CLASSES)
+			{
+				printf("ERROR! Record %lld has request class %d\n", next, classes[groupSize]);
+				result = -1;
+				break;
+			}
+			if (!isfinite(state->BatchServiceTimes[groupSize]) || (state->BatchServiceTimes[groupSize] < 0.0))
+			{
+				printf("ERROR! Record %lld has the service demand %g\n", next, state->BatchServiceTimes[groupSize]);
+				result = -1;
+				break;
+			}
+		}
+		if (result != 0)
+		{
+			break;
+		}
+
+		// The arrival of the group is an event of the model
+		if ((advanceSimulation(state, timestamp - start) != 0) ||
+			(dispatchCustomers(state, state->BatchServiceTimes, classes, groupSize) != 0))
+		{
+			result = -1;
+			break;
+		}
+		state->EventCounter++;
+	}
+
+	if (result == 0)
+	{
+		// The whole workload is served, as at the end of a fixed length run
+		if (drainSimulation(state) == 0)
+		{
+			state->Converged = 1;
+		}
+		else
+		{
+			result = -1;
+		}
+	}
+
+	finishSimulation(state);
+
+	state->CpuTime = cpuClock() - startClock;
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function calculates the mean response time of the system as an    =
+//=  average of the servers response time (as the CSIM model does). Servers =
+//=  which have served nobody, e.g. never started by the autoscaler, are    =
+//=  left out.                                                              =
+//===========================================================================
+double meanServerResponseTime(const SIMULATION_STATE *state)
+{
+	double meanResponseTime = 0.0;  // Mean response time of the system
+	int    servers = 0;             // Servers with served customers
+	int    i;                       // Loop counter
+
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		if (state->ServerStatistics[i].Completions > 0)
+		{
+			meanResponseTime += state->ServerStatistics[i].ResponseTimeSum / state->ServerStatistics[i].Completions;
+			servers++;
+		}
+	}
+
+	return((servers > 0) ? meanResponseTime / servers : 0.0);
+}
+
+//===========================================================================
+//=  This function returns the time average of the billed servers: the      =
+//=  active, pending and draining ones.                                     =
+//===========================================================================
+double meanBilledServers(const SIMULATION_STATE *state)
+{
+	return((state->Clock > 0.0) ? state->ServerTime / state->Clock : (double) billedServers(state));
+}
+
+//===========================================================================
+//=  This function returns the response time statistic of the run which     =
+//=  the run length control works on: the mean response time or the chosen  =
+//=  Percentile. Replications pool this statistic.                          =
+//===========================================================================
+double responseTimeStatistic(const SIMULATION_STATE *state)
+{
+	if (state->Config.Percentile > 0.0)
+	{
+		return(histogramPercentile(&state->ResponseTimes.Total, state->Config.Percentile));
+	}
+
+	return(tableMean(&state->DelayTable));
+}
+
+//===========================================================================
+//=  This function returns the time average of the longest minus the        =
+//=  shortest queue length over the run.                                    =
+//===========================================================================
+double meanQueueSpread(const SIMULATION_STATE *state)
+{
+	double area = 0.0;  // Integral of the spread
+	double time = 0.0;  // Integrated time
+	int    i;           // Phase counter
+
+	for (i = 0; i < UPDATE_PHASES; i++)
+	{
+		area += state->SpreadArea[i];
+		time += state->PhaseTime[i];
+	}
+
+	return((time > 0.0) ? area / time : 0.0);
+}
+
+//===========================================================================
+//=  This function returns the fraction of the dispatched customers which   =
+//=  went to a server that another dispatcher had used since the last       =
+//=  report of the server (see recordDispatch).                             =
+//===========================================================================
+double collisionRate(const SIMULATION_STATE *state)
+{
+	long long dispatches = 0;  // Customers sent by all dispatchers
+	long long collisions = 0;  // Collisions of all dispatchers
+	int       i;               // Dispatcher counter
+
+	for (i = 0; i < state->Config.DispatcherCount; i++)
+	{
+		dispatches += state->Dispatchers[i].Dispatches;
+		collisions += state->Dispatchers[i].Collisions;
+	}
+
+	return((dispatches > 0) ? (double) collisions / dispatches : 0.0);
+}
+
+//===========================================================================
+//=  This function prints the name of the response time statistic, e.g.     =
+//=  "Mean response time" or "p99 response time".                           =
+//===========================================================================
+void printStatisticName(const SIMULATION_CONFIG *config)
+{
+	if (config->Percentile > 0.0)
+	{
+		printf("p%g response time", config->Percentile * 100.0);
+	}
+	else
+	{
+		printf("Mean response time");
+	}
+}
+
+//===========================================================================
+//=  This function prints the statistics of the run: the facility report    =
+//=  in the format close to CSIM report(), the response and waiting time    =
+//=  percentiles of each server and of the system, the dispatchers, the     =
+//=  queue imbalance, the mean response time and the speed of the engine in =
+//=  events per second.                                                     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state - simulation state after runSimulation()                 =
+//=  Returns: None                                                          =
+//===========================================================================
+void printReport(const SIMULATION_STATE *state)
+{
+	static const double      percentiles[] = { 0.5, 0.99, 0.999 };  // Percentiles in the report
+	const SERVER_STATISTICS *statistics;                           // Statistics of the current server
+	const DISPATCHER        *dispatcher;                           // Current dispatcher
+	const PHASE_STATISTICS  *phase;                                // Statistics of the current phase
+	const RATE_SCHEDULE     *schedule = &state->Rates.Schedule;    // Steps and bursts of the arrival rate
+	double                   halfWidth;                            // Half-width of the confidence interval
+	int                      found;                                // Whether a class or a rejection is found
+	int                      i;                                    // Loop counter
+	int                      j;                                    // Percentile counter
+
+	printf("Load balancer: %s\n", balancerName(state->Config.LoadBalancer));
+	if ((state->Config.Service != exponentialService) || (state->Config.NumberOfSpeeds > 0))
+	{
+		printf("Service demands: %s with the mean %.5f", serviceName(state->Config.Service), state->Service.Mean);
+		if ((state->Config.Service == hyperexponentialService) || (state->Config.Service == lognormalService))
+		{
+			printf(" and the variation %.3f", state->Service.Variation);
+		}
+		else if (state->Config.Service == paretoService)
+		{
+			printf(" and the shape %.3f", state->Service.Shape);
+		}
+		printf("\n");
+	}
+	if (state->Config.NumberOfSpeeds > 0)
+	{
+		printf("Server speeds in turn:");
+		for (i = 0; (i < state->Config.NumberOfSpeeds) && (i < state->Config.NumberOfServers); i++)
+		{
+			printf(" %.4f", state->Speed[i]);
+		}
+		printf("\n");
+	}
+	printf("Simulated time: %.3f\n\n", state->Clock);
+
+	printf("FACILITY SUMMARY\n");
+	printf("facility        service    util.    throughput  queue       response    compl\n");
+	printf("name            time                            length      time        count\n");
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		statistics = &state->ServerStatistics[i];
+		printf("Server %-8d %-10.5f %-8.5f %-11.5f %-11.5f %-11.5f %lld\n", i,
+			(statistics->Completions > 0) ? statistics->ServiceTimeSum / statistics->Completions : 0.0,
+			(state->Clock > 0.0) ? statistics->ServiceTimeSum / state->Clock : 0.0,
+			(state->Clock > 0.0) ? statistics->Completions / state->Clock : 0.0,
+			(state->Clock > 0.0) ? statistics->QueueLengthArea / state->Clock : 0.0,
+			(statistics->Completions > 0) ? statistics->ResponseTimeSum / statistics->Completions : 0.0,
+			statistics->Completions);
+	}
+
+	printf("\nRESPONSE TIME PERCENTILES\n");
+	printf("facility        response time                       waiting time\n");
+	printf("name            p50         p99         p99.9       p50         p99         p99.9\n");
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		printf("Server %-8d", i);
+		for (j = 0; j < 3; j++)
+		{
+			printf(" %-11.5f", histogramPercentile(&state->ServerStatistics[i].ResponseTimes, percentiles[j]));
+		}
+		for (j = 0; j < 3; j++)
+		{
+			printf(" %-11.5f", histogramPercentile(&state->ServerStatistics[i].WaitingTimes, percentiles[j]));
+		}
+		printf("\n");
+	}
+	printf("System         ");
+	for (j = 0; j < 3; j++)
+	{
+		printf(" %-11.5f", histogramPercentile(&state->ResponseTimes.Total, percentiles[j]));
+	}
+	for (j = 0; j < 3; j++)
+	{
+		printf(" %-11.5f", histogramPercentile(&state->WaitingTimes, percentiles[j]));
+	}
+	printf("\n");
+
+	// Classes are only reported if the workload has them
+	found = 0;
+	for (i = 1; i < MAX_CLASSES; i++)
+	{
+		if (state->Classes[i].Completions > 0)
+		{
+			found = 1;
+			break;
+		}
+	}
+	if (found)
+	{
+		printf("\nREQUEST CLASSES\n");
+		printf("class   compl       response time\n");
+		for (i = 0; i < MAX_CLASSES; i++)
+		{
+			if (state->Classes[i].Completions > 0)
+			{
+				printf("%-7d %-11lld %.5f\n", i, state->Classes[i].Completions,
+					state->Classes[i].ResponseTimeSum / state->Classes[i].Completions);
+			}
+		}
+	}
+
+	// Overload is only reported if some customer has found a full queue
+	found = 0;
+	for (i = 0; i < state->Config.NumberOfServers; i++)
+	{
+		if (state->ServerStatistics[i].Rejections > 0)
+		{
+			found = 1;
+			break;
+		}
+	}
+	if (found)
+	{
+		printf("\nOVERLOAD (capacity %d, %s)\n", state->Config.QueueCapacity, overloadName(state->Config.Overload));
+		printf("facility        rejected    rejection\n");
+		printf("name            count       rate\n");
+		for (i = 0; i < state->Config.NumberOfServers; i++)
+		{
+			statistics = &state->ServerStatistics[i];
+			printf("Server %-8d %-11lld %.5f\n", i, statistics->Rejections, (statistics->Rejections > 0) ?
+				(double) statistics->Rejections / (statistics->Completions + statistics->Rejections) : 0.0);
+		}
+		printf("Dropped: %lld (%.5f of the arrivals), redirected: %lld, retries: %lld\n", state->Drops,
+			(state->ArrivalCounter > 0) ? (double) state->Drops / state->ArrivalCounter : 0.0, state->Redirects,
+			state->Retries);
+		printf("Goodput: %.5f served customers per time unit, mean response time %.5f\n",
+			(state->Clock > 0.0) ? state->DelayTable.Count / state->Clock : 0.0, tableMean(&state->DelayTable));
+	}
+
+	// Dispatchers are only reported if there are several of them
+	if (state->Config.DispatcherCount > 1)
+	{
+		printf("\nDISPATCHERS\n");
+		printf("dispatcher      customers   collisions  collision\n");
+		printf("name                                    rate\n");
+		for (i = 0; i < state->Config.DispatcherCount; i++)
+		{
+			dispatcher = &state->Dispatchers[i];
+			printf("Dispatcher %-4d %-11lld", i, dispatcher->Dispatches);
+			if (usesQueueReports(&state->Config))
+			{
+				printf(" %-11lld %.5f", dispatcher->Collisions,
+					(dispatcher->Dispatches > 0) ? (double) dispatcher->Collisions / dispatcher->Dispatches : 0.0);
+			}
+			printf("\n");
+		}
+	}
+
+	// Phases are only reported if the arrival rate varies. A phase is a step of
+	// the schedule, and the same step again during a burst
+	if (state->Phases != NULL)
+	{
+		printf("\nLOAD PHASES\n");
+		printf("step        burst  time     arrival     mean        compl       response time\n");
+		printf("start              share    rate        servers                 mean        p50         p99         "
+			"p99.9\n");
+		for (i = 0; i < arrivalRatesPhaseCount(&state->Rates); i++)
+		{
+			phase = &state->Phases[i];
+			printf("%-11g %-6s %-8.5f %-11.5f %-11.3f %-11lld %-11.5f", schedule->Times[i % schedule->NumberOfSteps],
+				(i >= schedule->NumberOfSteps) ? "yes" : "no", (state->Clock > 0.0) ? phase->Time / state->Clock : 0.0,
+				(phase->Time > 0.0) ? phase->Arrivals / phase->Time : 0.0,
+				(phase->Time > 0.0) ? phase->ServerTime / phase->Time : 0.0, phase->Completions,
+				(phase->Completions > 0) ? phase->ResponseTimeSum / phase->Completions : 0.0);
+			for (j = 0; j < 3; j++)
+			{
+				printf(" %-11.5f", histogramPercentile(&phase->ResponseTimes, percentiles[j]));
+			}
+			printf("\n");
+		}
+	}
+
+	printf("\n");
+	printf("Total arrivals: %lld\n", state->ArrivalCounter);
+	if (state->Config.Autoscale || (state->Phases != NULL))
+	{
+		printf("Server time: %.3f server-hours at one second per time unit, %.3f servers on average, peak %d\n",
+			state->ServerTime / 3600.0, meanBilledServers(state), state->PeakServers);
+	}
+	if (state->Config.Autoscale)
+	{
+		printf("Autoscaler (target utilization %g, provision delay %g): %lld provisioned, %lld taken back while "
+			"draining, %lld drained, %d active at the end\n", state->Config.TargetUtilization,
+			state->Config.ProvisionDelay, state->Provisions, state->Reclaims, state->Drains, state->ActiveServers);
+	}
+	if (usesQueueReports(&state->Config))
+	{
+		printf("Load reports (%s, network delay %g): %lld, %.5f per customer, %.5f per time unit\n",
+			updateName(state->Config.Update), state->Config.NetworkDelay, state->Messages,
+			(state->ArrivalCounter > 0) ? (double) state->Messages / state->ArrivalCounter : 0.0,
+			(state->Clock > 0.0) ? state->Messages / state->Clock : 0.0);
+	}
+	printf("Queue imbalance: longest minus shortest queue %.3f, standard deviation %.3f (time averages)\n",
+		meanQueueSpread(state), (state->Clock > 0.0) ? sqrt(state->VarianceArea / state->Clock) : 0.0);
+	if (usesQueueReports(&state->Config) && (state->Config.Update == snapshotUpdate))
+	{
+		printf("Longest minus shortest queue by quarter of the update period:");
+		for (i = 0; i < UPDATE_PHASES; i++)
+		{
+			printf(" %.3f", (state->PhaseTime[i] > 0.0) ? state->SpreadArea[i] / state->PhaseTime[i] : 0.0);
+		}
+		printf("\n");
+	}
+	printf("Mean response time: %.6f\n", meanServerResponseTime(state));
+	halfWidth = tableHalfWidth(&state->DelayTable, state->Config.CiLevel);
+	if (halfWidth >= 0.0)
+	{
+		printf("Delay table mean: %.6f +/- %.6f (%.0f%% CI, %s)\n", tableMean(&state->DelayTable), halfWidth,
+			state->Config.CiLevel * 100.0, state->Converged ? "converged" : "not converged");
+		printf("Warm-up: %lld of %lld customers discarded (%.2f%%), lag-1 correlation of %d batch means %.3f\n",
+			state->DelayTable.Truncated, state->DelayTable.Count,
+			100.0 * state->DelayTable.Truncated / state->DelayTable.Count, state->DelayTable.CorrelationBatches,
+			state->DelayTable.Correlation);
+	}
+	halfWidth = percentileTableHalfWidth(&state->ResponseTimes, state->Config.CiLevel);
+	if (halfWidth >= 0.0)
+	{
+		printStatisticName(&state->Config);
+		printf(": %.6f +/- %.6f (%.0f%% CI, %s)\n", percentileTableValue(&state->ResponseTimes), halfWidth,
+			state->Config.CiLevel * 100.0, state->Converged ? "converged" : "not converged");
+	}
+	printf("Events processed: %lld\n", state->EventCounter);
+	printf("CPU time: %.3f s\n", state->CpuTime);
+	if (state->CpuTime > 0.0)
+	{
+		printf("Events per second: %.0f\n", state->EventCounter / state->CpuTime);
+	}
+}
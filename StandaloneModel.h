@@ -0,0 +1,298 @@
+#ifndef STANDALONE_MODEL_H
+#define STANDALONE_MODEL_H
+
+//----- Includes --------------------------------------------------------------
+#include "ArrivalRates.h"   // Arrival rate over time
+#include "EventEngine.h"    // Event list, job pool and server queues
+#include "Histogram.h"      // Streaming percentiles of the response time
+#include "Mailboxes.h"      // Messages between the shards of a parallel run
+#include "QueueIndex.h"     // Servers sorted by queue length
+#include "RandomStreams.h"  // Random number streams
+#include "ServiceTimes.h"   // Service demand distributions
+#include "Statistics.h"     // Delay table with run length control
+#include "Telemetry.h"      // Time series of the servers
+#include "Trace.h"          // Recorded workloads
+
+//----- Constants -------------------------------------------------------------
+#define NUMBER_OF_SERVERS  5     // Default number of servers in the system
+#define JOBS_PER_SERVER    4     // Initial jobs of the pool per server. The pool doubles when they are all in use
+#define STALE_PERIOD       10.0  // Default period of updating load balancer about the queue length of servers
+#define MAX_TIME           60.0  // Maximum simulation CPU time in seconds
+#define CI_LEVEL           0.95  // Confidence interval level
+#define ACCURACY           0.01  // Target accuracy
+#define NUMBER_OF_POLICIES 13    // Number of load balancers in enum BALANCER_TYPE
+#define SAMPLE_SIZE        2     // Default number of servers sampled by the sampling load balancers
+#define HISTOGRAM_UNIT     1e-4  // Finest bucket of the response time histograms in mean service times
+#define SERVER_PRECISION   5     // Precision of the histograms of each server, relative bucket width below 1/16
+#define MAX_CLASSES        16    // Number of request classes with separate statistics
+#define RETRY_DELAY        1.0   // Default mean backoff of the first retry of a rejected customer
+#define MAX_RETRIES        3     // Default number of retries before a rejected customer is dropped
+#define NUMBER_OF_UPDATES  4     // Number of dissemination modes in enum UPDATE_TYPE
+#define UPDATE_JITTER      0.5   // Default relative jitter of the periods of the per-server reports
+#define UPDATE_THRESHOLD   2     // Default change of the queue length which triggers a report
+#define PREDICTION_NOISE   0.0   // Default perturbation of the predicted backlogs. One dispatcher does not herd
+#define UPDATE_PHASES      4     // Parts of the update period with separate imbalance statistics
+#define NUMBER_OF_STREAMS  5     // Number of random streams in enum STREAM_TYPE
+#define SAMPLE_SUBSTREAM   0xFFFFFFFFu  // Substream of the telemetry sample times, beyond the streams of any shard
+#define MAX_SPEEDS         16    // Longest list of the server speeds
+#define TARGET_UTILIZATION 0.7   // Default utilization of the active servers which the autoscaler aims at
+#define SCALE_INTERVAL     10.0  // Default time between two decisions of the autoscaler
+#define PROVISION_DELAY    30.0  // Default time from the decision to add a server until it takes customers
+#define SCALE_WINDOW       6     // Decisions whose largest recommendation bounds a scale-in
+#define HEAP_SERVERS       32    // Least number of servers for which Predictive keeps a heap instead of a scan
+
+//------New types--------------------------------------------------------------
+enum BALANCER_TYPE  // Type of the load balancer
+{
+	randomPolicy,
+	roundRobinPolicy,
+	shortestQueuePolicy,
+	shortestQueueStalePolicy,
+	improvedPolicy,
+	powerOfDPolicy,                 // Shortest of SampleSize randomly sampled queues, JSQ(d)
+	joinIdleQueuePolicy,            // Idle servers leave tokens at the load balancer, JIQ
+	batchSamplingPolicy,            // SampleSize * BatchSize probes for a batch of BatchSize customers
+	predictivePolicy,               // Least backlog predicted from the last report, own dispatches and service since
+	speedShortestQueuePolicy,       // Least expected wait (queue length + 1) / speed on the real queues
+	speedShortestQueueStalePolicy,  // Least expected wait on the reported queues
+	speedImprovedPolicy,            // Improved with the expected wait instead of the queue length
+	speedPowerOfDPolicy             // Power-of-d Choices with the expected wait instead of the queue length
+};
+
+enum OVERLOAD_TYPE  // What happens to a customer who finds the chosen queue full
+{
+	rejectOverload,    // The customer is dropped
+	redirectOverload,  // The server passes the customer to the shortest queue, dropped if all queues are full
+	retryOverload      // The customer tries again after a random backoff which doubles with every retry
+};
+
+enum UPDATE_TYPE  // How the servers report their queue lengths to the load balancer
+{
+	snapshotUpdate,   // All servers report together every StalePeriod
+	jitterUpdate,     // Every server reports on its own after a period jittered around StalePeriod
+	piggybackUpdate,  // The server reports its queue length with every completed customer
+	thresholdUpdate   // The server reports when its queue length moves UpdateThreshold away from the last report
+};
+
+enum STREAM_TYPE  // Purpose of an independent random stream of the run
+{
+	arrivalStream,   // Interarrival times
+	serviceStream,   // Service times
+	decisionStream,  // Random choices and tie-breaking of the load balancers, dispatchers of the idle tokens
+	delayStream,     // Phases and periods of the reports, backoffs of the retries
+	loadStream       // Starts and ends of the bursts of the arrival rate
+};
+
+enum EVENT_TYPE  // Type of the simulation event
+{
+	arrivalEvent,    // New customer arrives to the load balancer. ServerID of the event is the dispatcher
+	departureEvent,  // Server finishes the service of the head customer
+	updateEvent,     // Load balancer receives queue lengths of the servers
+	retryEvent,      // Rejected customer comes back to the load balancer. ServerID of the event is the job
+	reportEvent,     // Server sends its periodic report with jitter
+	deliveryEvent,   // Reports reach the load balancer. ServerID of the event is the number of reports
+	sampleEvent,     // Telemetry records the state of every server
+	entryEvent,      // Customer of a parallel run reaches the chosen server. ServerID of the event is the job
+	rateEvent,       // Arrival rate changes: a step of the schedule, or a burst starts or ends
+	scaleEvent,      // Autoscaler compares the arrival rate with the active servers
+	provisionEvent   // Provisioned server is ready to take customers
+};
+
+typedef struct  // Parameters of one simulation run
+{
+	enum BALANCER_TYPE LoadBalancer;        // Chosen load balancer
+	int                NumberOfServers;     // Number of servers in the system
+	double             Lambda;              // Customers arrival rate
+	double             Mu;                  // Service rate of a server of the mean speed
+	double             StalePeriod;         // Period of updating load balancer about the queue length of servers
+	double             MaxTime;             // Maximum simulation CPU time in seconds
+	double             CiLevel;             // Confidence interval level
+	double             Accuracy;            // Target accuracy
+	unsigned long long Seed;                // Seed of the random stream
+	int                Stream;              // Index of the independent random stream (replication number)
+	long long          RunLength;           // Number of customers to serve. 0 means run length control
+	int                SampleSize;          // Number of servers sampled per customer (d of JSQ(d))
+	int                BatchSize;           // Number of customers arriving together
+	int                ExternalArrivals;    // Whether customers are given by dispatchCustomers() instead of the arrival process
+	double             Percentile;          // Response time percentile for the run length control, e.g. 0.99. 0 means the mean
+	int                QueueCapacity;       // Customers each server admits (waiting and in service). 0 means unbounded
+	enum OVERLOAD_TYPE Overload;            // What happens to a customer who finds the chosen queue full
+	double             RetryDelay;          // Mean backoff of the first retry
+	int                MaxRetries;          // Number of retries before the customer is dropped
+	enum UPDATE_TYPE   Update;              // How the servers report their queue lengths to the load balancer
+	double             UpdateJitter;        // Report periods are uniform in StalePeriod * (1 +/- UpdateJitter)
+	int                UpdateThreshold;     // Change of the queue length which triggers a report
+	double             NetworkDelay;        // Time a report takes to reach the load balancer
+	double             PredictionNoise;     // Perturbation of the predicted backlog in its standard deviations
+	int                DispatcherCount;     // Number of load balancers, each with its own arrivals and view
+	double             TelemetryInterval;   // Simulated time between two telemetry samples
+	enum SERVICE_TYPE  Service;             // Distribution of the service demands, with the mean 1 / Mu
+	double             ServiceVariation;    // Squared coefficient of variation of the hyperexponential and lognormal
+	double             ParetoShape;         // Shape of the Pareto service demands
+	const double      *EmpiricalValues;     // Service demands of the empirical distribution, scaled to the mean 1 / Mu
+	int                EmpiricalCount;      // Number of EmpiricalValues
+	double             Speeds[MAX_SPEEDS];  // Relative speeds given to the servers in turn, normalized to the mean 1
+	int                NumberOfSpeeds;      // Number of Speeds. 0 means that all servers have the rate Mu
+	int                ShardCount;          // Shards of a parallel run, one thread each. 0 means the sequential engine
+	int                Shard;               // Shard simulated by this state, from 0 to ShardCount - 1
+	RATE_SCHEDULE      Schedule;            // Factor of Lambda over time: steps of a schedule and random bursts
+	int                Autoscale;           // Whether an autoscaler adds and drains servers while the run goes on
+	int                MinServers;          // Fewest active servers of the autoscaler. NumberOfServers is the most
+	double             TargetUtilization;   // Utilization of the active servers which the autoscaler aims at
+	double             ScaleInterval;       // Time between two decisions of the autoscaler
+	double             ProvisionDelay;      // Time from the decision to add a server until it takes customers
+} SIMULATION_CONFIG;
+
+typedef struct  // Statistics of one server (analogue of CSIM facility statistics)
+{
+	long long Completions;        // Number of served customers
+	double    ServiceTimeSum;     // Total time the server was busy
+	double    ResponseTimeSum;    // Total response time of the served customers
+	double    QueueLengthArea;    // Integral of the number of customers at the server over time
+	double    LastChangeClock;    // Clock of the last change of the number of customers
+	HISTOGRAM ResponseTimes;      // Response time of the served customers
+	HISTOGRAM WaitingTimes;       // Time the served customers spent in the queue
+	long long Rejections;         // Number of customers who found the queue full
+	long long Dispatches;         // Number of customers sent to the server
+	long long SampledDispatches;  // Dispatches at the last telemetry sample
+} SERVER_STATISTICS;
+
+typedef struct  // Statistics of one request class
+{
+	long long Completions;      // Number of served customers of the class
+	double    ResponseTimeSum;  // Total response time of the served customers
+} CLASS_STATISTICS;
+
+typedef struct  // Statistics of one phase of the arrival rate: a step of the schedule, in a burst or not
+{
+	double    Time;             // Time spent in the phase
+	double    ServerTime;       // Integral of the billed servers over the time of the phase
+	long long Arrivals;         // Customers who arrived in the phase
+	long long Completions;      // Served customers who arrived in the phase
+	double    ResponseTimeSum;  // Total response time of these customers
+	HISTOGRAM ResponseTimes;    // Response time of these customers
+} PHASE_STATISTICS;
+
+typedef struct  // Front-end load balancer with its own arrivals and its own view of the servers
+{
+	int               *QueueLength;                // Queue length of each server as seen by the dispatcher
+	QUEUE_INDEX        StaleIndex;                 // Servers sorted by QueueLength
+	SPEED_INDEX        StaleSpeedIndex;            // Servers grouped by speed and sorted by QueueLength
+	double            *ReportClock;                // Clock of the last report of each server at the dispatcher
+	double            *EmptyClock;                 // Time when each server is expected to become idle (Predictive)
+	SERVER_HEAP        EmptyHeap;                  // Servers sorted by EmptyClock (Predictive without noise)
+	int               *IdleTokens;                 // Ring buffer of idle servers reported to Join-Idle-Queue
+	int                IdleHead;                   // Position of the oldest idle token
+	int                IdleCount;                  // Number of idle tokens
+	long long          RoundRobinServerIDCounter;  // Counter value for Round Robin load balancer
+	long long          Dispatches;                 // Number of customers sent by the dispatcher
+	long long          Collisions;                 // Customers sent to a server used by others since its report
+	double             NextArrivalClock;           // Time of the next arrival. An arrival event of another time is void
+} DISPATCHER;
+
+typedef struct  // Complete state of one simulation run
+{
+	SIMULATION_CONFIG  Config;                     // Parameters of the run
+	double             Clock;                      // Current simulation time
+	EVENT_LIST         Events;                     // Future event list
+	EVENT_LIST         DispatcherEvents;           // Arrivals and deliveries of a parallel run
+	EVENT_LIST        *DispatcherList;             // DispatcherEvents in a parallel run, Events otherwise
+	int                FirstServer;                // First server simulated by this state
+	int                LastServer;                 // Server after the last one simulated by this state
+	MAILBOXES         *Mailboxes;                  // Mailboxes between the shards of a parallel run, NULL if sequential
+	double            *Completions;                // Departure and response time of the customers served in the window
+	int                CompletionCount;            // Number of customers in Completions
+	int                CompletionCapacity;         // Allocated customers of Completions
+	JOB_POOL           Pool;                       // Pool of jobs for customers
+	SERVER_QUEUE      *Servers;                    // Queue of each server
+	SERVER_STATISTICS *ServerStatistics;           // Statistics of each server
+	DISPATCHER        *Dispatchers;                // Load balancers which share the servers
+	DISPATCHER        *Dispatcher;                 // Dispatcher of the current decision
+	long long          ExternalGroups;             // Groups of customers given by dispatchCustomers()
+	int               *ReportedLength;             // Queue length of each server in its last report
+	SERVER_QUEUE       Reports;                    // Reports on the way: dispatcher, server ID, queue length
+	long long          Messages;                   // Number of reports received by the dispatchers
+	QUEUE_INDEX        ServerIndex;                // Servers sorted by their real queue length
+	SPEED_INDEX        SpeedIndex;                 // Servers grouped by speed and sorted by their real queue length
+	double            *Speed;                      // Service rate of each server divided by Mu
+	SERVICE_TIMES      Service;                    // Distribution of the service demands
+	char              *HasIdleToken;               // Whether the server has a token at a dispatcher
+	int               *LastDispatcher;             // Dispatcher of the last customer sent to each server
+	double            *LastDispatchClock;          // Clock of the last customer sent to each server
+	double            *ForeignDispatchClock;       // Clock of the last customer sent by another than LastDispatcher
+	long long          QueuedCustomers;            // Number of customers at the servers
+	long long          LengthSquareSum;            // Sum of the squares of the queue lengths of the servers
+	double             ImbalanceClock;             // Clock of the last change of the queue lengths
+	double             SpreadArea[UPDATE_PHASES];  // Integral of the longest minus the shortest queue in each phase
+	double             PhaseTime[UPDATE_PHASES];   // Time spent in each part of the update period
+	double             VarianceArea;               // Integral of the variance of the queue lengths over time
+	int               *ProbeServerIDs;             // Servers sampled for the current decision
+	int               *ProbeLoad;                  // Load of each sampled server including this batch
+	int               *BatchServerIDs;             // Servers chosen for the customers of the current batch
+	double            *BatchServiceTimes;          // Service times of the customers of the current batch
+	long long          ArrivalCounter;             // Total number of customers arrivals
+	long long          Drops;                      // Number of customers who have left without service
+	long long          Redirects;                  // Number of customers passed on by a full server
+	long long          Retries;                    // Number of retries of rejected customers
+	double             PreviosUpdateClock;         // Clock of previous balancer acknowledgement of server queue length
+	ARRIVAL_RATES      Rates;                      // Factor of the arrival rate over time
+	PHASE_STATISTICS  *Phases;                     // Statistics of each phase of the rate, NULL if the rate is constant
+	int                ActiveServers;              // Servers which take customers, the first ones
+	int                PendingServers;             // Servers being provisioned, the ones after the active
+	int                DrainingServers;            // Servers out of the pool which still serve their customers
+	double            *ReadyClock;                 // Time when each pending server starts to take customers
+	double             ServerTime;                 // Integral of the billed servers over time
+	double             ServerClock;                // Clock of the last change of the billed servers or the phase
+	int                PeakServers;                // Largest number of billed servers
+	long long          Provisions;                 // Servers provisioned by the autoscaler
+	long long          Reclaims;                   // Draining servers which the autoscaler has taken back at once
+	long long          Drains;                     // Servers drained by the autoscaler
+	long long          ScaleArrivals;              // ArrivalCounter at the last decision of the autoscaler
+	long long          ScaleDecisions;             // Number of decisions of the autoscaler
+	int                ScaleWindow[SCALE_WINDOW];  // Recommendations of the last decisions of the autoscaler
+	RANDOM_STREAM      Random[NUMBER_OF_STREAMS];  // Random streams of the run, one for each purpose
+	DELAY_TABLE        DelayTable;                 // Response time of each customer
+	PERCENTILE_TABLE   ResponseTimes;              // Response time percentiles of the system
+	HISTOGRAM          WaitingTimes;               // Waiting time percentiles of the system
+	CLASS_STATISTICS   Classes[MAX_CLASSES];       // Statistics of each request class
+	int                BatchCompleted;             // Whether the last customer has completed a batch of ResponseTimes
+	int                DelayBatchCompleted;        // Whether the last customer has completed a batch of DelayTable
+	long long          EventCounter;               // Number of processed events
+	double             CpuTime;                    // CPU time spent in runSimulation() or replayTrace() in seconds
+	int                Converged;                  // Whether the run length control has stopped the run
+	TELEMETRY_WRITER  *Telemetry;                  // Writer of the time series of the servers, NULL if none
+	RANDOM_STREAM      SampleRandom;               // Stream of the telemetry sample times, unused by the model
+	double             SampleSlot;                 // Start of the interval of the next telemetry sample
+} SIMULATION_STATE;
+
+//----- Prototypes ------------------------------------------------------------
+void   defaultConfig(SIMULATION_CONFIG *config);
+int    simulationInit(SIMULATION_STATE *state, const SIMULATION_CONFIG *config);
+void   simulationFree(SIMULATION_STATE *state);
+int    runSimulation(SIMULATION_STATE *state);
+int    replayTrace(SIMULATION_STATE *state, const TRACE *trace, long long maxCustomers);
+int    advanceSimulation(SIMULATION_STATE *state, double untilTime);
+int    advanceDispatchers(SIMULATION_STATE *state, double untilTime);
+int    advanceServers(SIMULATION_STATE *state, double untilTime);
+void   recordResponseTime(SIMULATION_STATE *state, double responseTime);
+int    runLengthReached(const SIMULATION_STATE *state);
+int    dispatchCustomers(SIMULATION_STATE *state, const double *serviceTimes, const int *classes, int count);
+int    chooseServer(SIMULATION_STATE *state);
+void   finishSimulation(SIMULATION_STATE *state);
+double meanServerResponseTime(const SIMULATION_STATE *state);
+double meanBilledServers(const SIMULATION_STATE *state);
+double responseTimeStatistic(const SIMULATION_STATE *state);
+double meanQueueSpread(const SIMULATION_STATE *state);
+double collisionRate(const SIMULATION_STATE *state);
+void   printStatisticName(const SIMULATION_CONFIG *config);
+void   printReport(const SIMULATION_STATE *state);
+const char *balancerName(enum BALANCER_TYPE loadBalancer);
+const char *overloadName(enum OVERLOAD_TYPE overload);
+const char *updateName(enum UPDATE_TYPE update);
+int    usesQueueReports(const SIMULATION_CONFIG *config);
+int    usesStaleSpeedIndex(const SIMULATION_CONFIG *config);
+int    usesEmptyHeap(const SIMULATION_CONFIG *config);
+void   simulationAttachTelemetry(SIMULATION_STATE *state, TELEMETRY_WRITER *telemetry);
+void   simulationAttachMailboxes(SIMULATION_STATE *state, MAILBOXES *mailboxes);
+
+#endif
@@ -0,0 +1,1227 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>                 // Needed for I/O functions
+#include <stdlib.h>                // Needed for atoi(), atoll(), atof() and strtoull()
+#include <string.h>                // Needed for strcmp(), strtok() and strchr()
+#include "StandaloneModel.h"       // Standalone simulation model
+#include "Replications.h"          // Parallel independent replications
+#include "CommonRandomNumbers.h"  // All load balancers on common random numbers
+#include "Sweep.h"                 // Parameter sweep over a grid
+#include "ParallelSimulation.h"    // One run on the shards of several threads
+#include "Trace.h"                 // Replay of recorded workloads
+#include "MeanField.h"             // Mean-field limits of the load balancers
+
+//------New types--------------------------------------------------------------
+enum RUN_MODE  // What the program does
+{
+	singleRunMode,    // One long run with batch means run length control
+	replicationMode,  // Independent replications on all cores
+	crnMode,          // Several load balancers in lockstep on common random numbers
+	sweepMode,        // Grid of parameters, one run per point
+	traceMode,        // Customers of a trace file instead of the arrival process
+	parallelMode,     // The same run on the sequential engine and on shards of several thread counts
+	meanFieldMode,    // Steady state of the mean-field model instead of a simulation
+	checkMode         // Mean field against short simulations of several numbers of servers
+};
+
+//----- Prototypes ------------------------------------------------------------
+enum BALANCER_TYPE chooseBalancerDialog(void);
+int parseArguments(int argc, char *argv[], CRN_CONFIG *crnConfig, SWEEP_CONFIG *sweepConfig,
+	PARALLEL_CONFIG *parallelConfig, MEAN_FIELD_CHECK *check, const char **tracePath, const char **telemetryPath,
+	const char **servicePath, int *balancerChosen, enum RUN_MODE *mode);
+int parsePolicies(char *list, CRN_CONFIG *crnConfig);
+int parseShardCounts(char *list, PARALLEL_CONFIG *parallelConfig);
+int parseCheckSizes(char *list, MEAN_FIELD_CHECK *check);
+int parseSpeeds(char *list, SIMULATION_CONFIG *config);
+int parseSchedule(char *list, SIMULATION_CONFIG *config);
+int loadServiceTimes(SIMULATION_CONFIG *config, const char *servicePath, double **values);
+int startTelemetry(SIMULATION_STATE *state, TELEMETRY_WRITER *telemetry, const char *telemetryPath);
+int stopTelemetry(TELEMETRY_WRITER *telemetry, const char *telemetryPath);
+int singleRun(const SIMULATION_CONFIG *config, const char *telemetryPath);
+int replicationRun(const REPLICATION_CONFIG *config);
+int crnRun(const CRN_CONFIG *config);
+int sweepRun(SWEEP_CONFIG *config);
+int traceRun(const SIMULATION_CONFIG *config, const char *tracePath, const char *telemetryPath);
+int parallelRun(const PARALLEL_CONFIG *config);
+int meanFieldRun(const SIMULATION_CONFIG *config);
+int checkRun(const MEAN_FIELD_CHECK *check);
+
+//===========================================================================
+//=  Main program of the standalone simulation. It does the same as the     =
+//=  sim() function of the CSIM model but uses the built-in event list      =
+//=  engine, so it needs neither csim.h nor a process per customer. The     =
+//=  load balancer can be given on the command line, otherwise the user is  =
+//=  asked for it.                                                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int main(int argc, char *argv[])
+{
+	CRN_CONFIG          crnConfig;                        // Parameters of the run
+	REPLICATION_CONFIG *config = &crnConfig.Replication;  // Parameters of the replications
+	SWEEP_CONFIG        sweepConfig;                      // Parameters of the sweep
+	PARALLEL_CONFIG     parallelConfig;                   // Thread counts of the parallel mode
+	MEAN_FIELD_CHECK    check;                            // Server counts of the cross-check mode
+	const char         *tracePath = NULL;                 // Trace file of the trace mode
+	const char         *telemetryPath = NULL;             // Telemetry file, NULL if there is no telemetry
+	const char         *servicePath = NULL;               // File of the empirical service demands
+	double             *empiricalValues = NULL;           // Empirical service demands read from servicePath
+	enum RUN_MODE       mode;                             // What the program does
+	int                 balancerChosen;                   // Whether the load balancer is given on the command line
+	int                 result;                           // Result of the chosen mode
+
+	defaultReplicationConfig(config);
+	config->Simulation.RunLength = 0;
+	crnConfig.NumberOfPolicies = 0;
+	sweepConfig.OutputPath = "sweep.csv";
+	sweepConfig.CachePath = "sweep.cache";
+	sweepConfig.MeanField = 0;
+	parallelConfig.NumberOfRuns = 0;
+	check.NumberOfSizes = 0;
+	if ((parseArguments(argc, argv, &crnConfig, &sweepConfig, &parallelConfig, &check, &tracePath, &telemetryPath,
+		&servicePath, &balancerChosen, &mode) != 0) ||
+		(loadServiceTimes(&config->Simulation, servicePath, &empiricalValues) != 0))
+	{
+		return(1);
+	}
+
+	if (mode == crnMode)
+	{
+		result = crnRun(&crnConfig);
+	}
+	else if (mode == sweepMode)
+	{
+		sweepConfig.Simulation = config->Simulation;
+		sweepConfig.NumberOfThreads = config->NumberOfThreads;
+		result = sweepRun(&sweepConfig);
+	}
+	else
+	{
+		// Ask user about load balancing strategy if it is not given
+		if (!balancerChosen)
+		{
+			config->Simulation.LoadBalancer = chooseBalancerDialog();
+		}
+
+		if (mode == replicationMode)
+		{
+			result = replicationRun(config);
+		}
+		else if (mode == traceMode)
+		{
+			result = traceRun(&config->Simulation, tracePath, telemetryPath);
+		}
+		else if (mode == parallelMode)
+		{
+			parallelConfig.Simulation = config->Simulation;
+			result = parallelRun(&parallelConfig);
+		}
+		else if (mode == meanFieldMode)
+		{
+			result = meanFieldRun(&config->Simulation);
+		}
+		else if (mode == checkMode)
+		{
+			check.Simulation = config->Simulation;
+			result = checkRun(&check);
+		}
+		else
+		{
+			result = singleRun(&config->Simulation, telemetryPath);
+		}
+	}
+
+	free(empiricalValues);
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function reads the empirical service demands if a file is given   =
+//=  and checks the parameters of the service distribution once, before     =
+//=  any run.                                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config      - parameters of every run                          =
+//=          servicePath - file of the empirical service demands, or NULL   =
+//=          values      - place to store the demands which the caller      =
+//=                        frees, NULL if there is no file                  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int loadServiceTimes(SIMULATION_CONFIG *config, const char *servicePath, double **values)
+{
+	SERVICE_TIMES service;  // Distribution which is checked
+
+	*values = NULL;
+	if (servicePath != NULL)
+	{
+		if (serviceLoadValues(servicePath, values, &config->EmpiricalCount) != 0)
+		{
+			return(-1);
+		}
+		config->EmpiricalValues = *values;
+	}
+	if (serviceInit(&service, config->Service, 1.0 / config->Mu, config->ServiceVariation, config->ParetoShape,
+		config->EmpiricalValues, config->EmpiricalCount) != 0)
+	{
+		free(*values);
+		*values = NULL;
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function opens the telemetry file of the run and lets the run     =
+//=  write its samples there.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: state         - initialized simulation state                   =
+//=          telemetry     - place to store the writer                      =
+//=          telemetryPath - telemetry file, NULL if there is no telemetry  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int startTelemetry(SIMULATION_STATE *state, TELEMETRY_WRITER *telemetry, const char *telemetryPath)
+{
+	if (telemetryPath == NULL)
+	{
+		return(0);
+	}
+	if (telemetryWriterOpen(telemetry, telemetryPath, state->Config.NumberOfServers,
+		state->Config.TelemetryInterval) != 0)
+	{
+		return(-1);
+	}
+	simulationAttachTelemetry(state, telemetry);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function writes the remaining samples and closes the telemetry    =
+//=  file of the run.                                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: telemetry     - writer of startTelemetry()                     =
+//=          telemetryPath - telemetry file, NULL if there is no telemetry  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int stopTelemetry(TELEMETRY_WRITER *telemetry, const char *telemetryPath)
+{
+	long long stalls;  // Times the run has waited for the writer
+
+	if (telemetryPath == NULL)
+	{
+		return(0);
+	}
+	stalls = telemetry->Stalls;
+	if (telemetryWriterClose(telemetry) != 0)
+	{
+		return(-1);
+	}
+	printf("Telemetry: %llu samples written to %s, the run has waited for the writer %lld times\n",
+		(unsigned long long) telemetry->Header.NumberOfSamples, telemetryPath, stalls);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function does one long run with the run length control.           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config        - parameters of the run                          =
+//=          telemetryPath - telemetry file, NULL if there is no telemetry  =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int singleRun(const SIMULATION_CONFIG *config, const char *telemetryPath)
+{
+	SIMULATION_STATE state;      // State of the run
+	TELEMETRY_WRITER telemetry;  // Writer of the telemetry file
+	int              result;     // Result of the run
+
+	if (simulationInit(&state, config) != 0)
+	{
+		printf("Not enough memory for %d servers\n", config->NumberOfServers);
+		return(1);
+	}
+	if (startTelemetry(&state, &telemetry, telemetryPath) != 0)
+	{
+		simulationFree(&state);
+		return(1);
+	}
+
+	// Simulation has been started
+	printf("\n*** BEGIN SIMULATION *** \n");
+
+	result = runSimulation(&state);
+
+	// Print statistics
+	printf("\n");
+	printReport(&state);
+	if (stopTelemetry(&telemetry, telemetryPath) != 0)
+	{
+		result = -1;
+	}
+
+	// End of the simulation
+	printf("\n*** END SIMULATION *** \n");
+
+	simulationFree(&state);
+
+	return((result == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function runs independent replications on all threads and prints  =
+//=  the pooled confidence interval.                                        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the replication mode                    =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int replicationRun(const REPLICATION_CONFIG *config)
+{
+	REPLICATION_RESULT result;  // Pooled result
+	int                status;  // Result of the mode
+
+	printf("\n*** BEGIN SIMULATION *** \n");
+
+	status = runReplications(config, &result);
+	if ((status != 0) && (result.Values == NULL))
+	{
+		printf("Not enough memory for %d replications\n", config->MaxReplications);
+		return(1);
+	}
+	if (result.Broken)
+	{
+		printf("!!! ERROR !!!\n");
+		printf("System is broken in one of the replications\n");
+	}
+
+	printf("\n");
+	printReplicationReport(config, &result);
+	printf("\n*** END SIMULATION *** \n");
+
+	freeReplicationResult(&result);
+
+	return((status == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function evaluates several load balancers on common arrival and   =
+//=  service times and prints their paired differences with the baseline.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the common random numbers mode          =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int crnRun(const CRN_CONFIG *config)
+{
+	REPLICATION_RESULT result;  // Results of the replications
+	int                status;  // Result of the mode
+
+	printf("\n*** BEGIN SIMULATION *** \n");
+
+	status = runCommonRandomNumbers(config, &result);
+	if ((status != 0) && (result.Values == NULL))
+	{
+		printf("Not enough memory for %d replications\n", config->Replication.MaxReplications);
+		return(1);
+	}
+	if (result.Broken)
+	{
+		printf("!!! ERROR !!!\n");
+		printf("System is broken in one of the replications\n");
+	}
+
+	printf("\n");
+	printCommonRandomNumbersReport(config, &result);
+	printf("\n*** END SIMULATION *** \n");
+
+	freeReplicationResult(&result);
+
+	return((status == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function reads the grid and runs all its points in parallel.      =
+//=  The load balancer of the command line is used if the grid has no       =
+//=  policy axis.                                                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the sweep with GridPath                 =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int sweepRun(SWEEP_CONFIG *config)
+{
+	if (readSweepGrid(config) != 0)
+	{
+		return(1);
+	}
+
+	printf("\n*** BEGIN SWEEP *** \n");
+	if (runSweep(config) != 0)
+	{
+		return(1);
+	}
+	printf("\n*** END SWEEP *** \n");
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function replays the customers of a trace file and prints the     =
+//=  statistics of the run. Lambda and mu are not used. RunLength limits    =
+//=  the number of replayed customers.                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config        - parameters of the run                          =
+//=          tracePath     - trace file written by TraceConverter           =
+//=          telemetryPath - telemetry file, NULL if there is no telemetry  =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int traceRun(const SIMULATION_CONFIG *config, const char *tracePath, const char *telemetryPath)
+{
+	SIMULATION_CONFIG traceConfig = *config;  // Parameters of the replay
+	SIMULATION_STATE  state;                  // State of the run
+	TELEMETRY_WRITER  telemetry;              // Writer of the telemetry file
+	TRACE             trace;                  // Mapped trace file
+	int               result;                 // Result of the run
+
+	if (traceOpen(&trace, tracePath) != 0)
+	{
+		return(1);
+	}
+	if (trace.NumberOfRecords == 0)
+	{
+		printf("ERROR! Trace file %s has no customers\n", tracePath);
+		traceClose(&trace);
+		return(1);
+	}
+
+	// Customers with the same timestamp are dispatched together
+	traceConfig.ExternalArrivals = 1;
+	traceConfig.BatchSize = TRACE_BATCH;
+	if (simulationInit(&state, &traceConfig) != 0)
+	{
+		printf("Not enough memory for %d servers\n", traceConfig.NumberOfServers);
+		traceClose(&trace);
+		return(1);
+	}
+	if (startTelemetry(&state, &telemetry, telemetryPath) != 0)
+	{
+		simulationFree(&state);
+		traceClose(&trace);
+		return(1);
+	}
+
+	printf("\n*** BEGIN TRACE REPLAY *** \n");
+	printf("%lld customers in %s\n", trace.NumberOfRecords, tracePath);
+
+	result = replayTrace(&state, &trace, traceConfig.RunLength);
+
+	printf("\n");
+	printReport(&state);
+	if (stopTelemetry(&telemetry, telemetryPath) != 0)
+	{
+		result = -1;
+	}
+
+	printf("\n*** END TRACE REPLAY *** \n");
+
+	simulationFree(&state);
+	traceClose(&trace);
+
+	return((result == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function runs the model on the sequential engine and on the       =
+//=  shards of the given thread counts, and prints the speedup of every run =
+//=  with the check that its response time agrees with the first run.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the parallel mode                       =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int parallelRun(const PARALLEL_CONFIG *config)
+{
+	PARALLEL_RESULT results[MAX_SHARD_RUNS];  // Result of each run
+	double          lookahead;                // Length of the windows of the shards
+	int             i;                        // Run counter
+
+	// Check the parameters before the first run, which may be a long sequential one
+	for (i = 0; i < config->NumberOfRuns; i++)
+	{
+		if ((config->ShardCounts[i] > config->Simulation.NumberOfServers) ||
+			((config->ShardCounts[i] > 0) && (parallelLookahead(&config->Simulation, &lookahead) != 0)))
+		{
+			printf("ERROR! The run with %d threads is not possible\n", config->ShardCounts[i]);
+			return(1);
+		}
+	}
+
+	printf("\n*** BEGIN SIMULATION *** \n");
+
+	if (runParallelMode(config, results) != 0)
+	{
+		printf("!!! ERROR !!!\n");
+		printf("System is broken in one of the runs\n");
+		return(1);
+	}
+
+	printf("\n");
+	printParallelReport(config, results);
+	printf("\n*** END SIMULATION *** \n");
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function solves the mean-field model of the load balancer instead =
+//=  of simulating it and prints its steady state.                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the model                               =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int meanFieldRun(const SIMULATION_CONFIG *config)
+{
+	MEAN_FIELD_RESULT *result;  // Steady state of the model
+
+	result = (MEAN_FIELD_RESULT *) malloc(sizeof(MEAN_FIELD_RESULT));
+	if (result == NULL)
+	{
+		printf("Not enough memory for the mean field\n");
+		return(1);
+	}
+
+	printf("\n*** BEGIN MEAN FIELD *** \n");
+
+	if (meanFieldSolve(config, result) != 0)
+	{
+		free(result);
+		return(1);
+	}
+
+	printf("\n");
+	printMeanFieldReport(config, result);
+	printf("\n*** END MEAN FIELD *** \n");
+
+	free(result);
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function compares the mean field with short simulations of the    =
+//=  given numbers of servers.                                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: check - parameters of the cross-check mode                     =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int checkRun(const MEAN_FIELD_CHECK *check)
+{
+	printf("\n*** BEGIN SIMULATION *** \n\n");
+
+	if (runMeanFieldCheck(check) != 0)
+	{
+		printf("!!! ERROR !!!\n");
+		printf("The mean field or a simulation has failed\n");
+		return(1);
+	}
+
+	printf("\n*** END SIMULATION *** \n");
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a comma separated list of relative server speeds,  =
+//=  e.g. "1,1,1,2" for a fleet where every fourth server is twice as fast. =
+//=  The servers get the speeds in turn.                                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list   - list given on the command line. It is modified        =
+//=          config - configuration to fill                                 =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseSpeeds(char *list, SIMULATION_CONFIG *config)
+{
+	char *token;  // Current number of the list
+
+	config->NumberOfSpeeds = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		if (config->NumberOfSpeeds == MAX_SPEEDS)
+		{
+			printf("ERROR! At most %d speeds can be given\n", MAX_SPEEDS);
+			return(-1);
+		}
+		config->Speeds[config->NumberOfSpeeds] = atof(token);
+		if (config->Speeds[config->NumberOfSpeeds] <= 0.0)
+		{
+			printf("ERROR! Speeds must be positive\n");
+			return(-1);
+		}
+		config->NumberOfSpeeds++;
+	}
+
+	if (config->NumberOfSpeeds == 0)
+	{
+		printf("ERROR! The list of speeds is empty\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads the schedule of the arrival rate: a comma          =
+//=  separated list of steps, each the start time and the factor of lambda, =
+//=  e.g. "0:0.5,3600:1.5,7200:1" for a quiet first hour and a busy second  =
+//=  one. The schedule is checked with the other parameters.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list   - list given on the command line. It is modified        =
+//=          config - configuration to fill                                 =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseSchedule(char *list, SIMULATION_CONFIG *config)
+{
+	RATE_SCHEDULE *schedule = &config->Schedule;  // Schedule to fill
+	char          *token;                         // Current step of the list
+	char          *factor;                        // Factor of the current step
+
+	schedule->NumberOfSteps = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		if (schedule->NumberOfSteps == MAX_RATE_STEPS)
+		{
+			printf("ERROR! At most %d steps of the arrival rate can be given\n", MAX_RATE_STEPS);
+			return(-1);
+		}
+		factor = strchr(token, ':');
+		if (factor == NULL)
+		{
+			printf("ERROR! Step %s of the arrival rate must be time:factor\n", token);
+			return(-1);
+		}
+		schedule->Times[schedule->NumberOfSteps] = atof(token);
+		schedule->Factors[schedule->NumberOfSteps] = atof(factor + 1);
+		schedule->NumberOfSteps++;
+	}
+
+	if (schedule->NumberOfSteps == 0)
+	{
+		printf("ERROR! The schedule of the arrival rate is empty\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a comma separated list of load balancers, e.g.     =
+//=  "3,4,5". The first load balancer of the list is the baseline.          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list      - list given on the command line. It is modified     =
+//=          crnConfig - configuration to fill                              =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parsePolicies(char *list, CRN_CONFIG *crnConfig)
+{
+	char *token;   // Current number of the list
+	int   choice;  // Load balancer number given by the user
+	int   p;       // Load balancer counter
+
+	crnConfig->NumberOfPolicies = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		choice = atoi(token);
+		if ((choice < 1) || (choice > NUMBER_OF_POLICIES))
+		{
+			printf("ERROR! Load balancer must be from 1 to %d\n", NUMBER_OF_POLICIES);
+			return(-1);
+		}
+		for (p = 0; p < crnConfig->NumberOfPolicies; p++)
+		{
+			if (crnConfig->Policies[p] == (enum BALANCER_TYPE) (choice - 1))
+			{
+				printf("ERROR! Load balancer %d is listed twice\n", choice);
+				return(-1);
+			}
+		}
+		crnConfig->Policies[crnConfig->NumberOfPolicies++] = (enum BALANCER_TYPE) (choice - 1);
+	}
+
+	if (crnConfig->NumberOfPolicies < 2)
+	{
+		printf("ERROR! At least two load balancers must be compared\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a comma separated list of thread counts of the     =
+//=  parallel mode, e.g. "0,1,2,4". 0 stands for the sequential engine. The =
+//=  first run of the list is the reference of the others.                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list           - list given on the command line. It is modified=
+//=          parallelConfig - configuration to fill                         =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseShardCounts(char *list, PARALLEL_CONFIG *parallelConfig)
+{
+	char *token;  // Current number of the list
+	int   count;  // Thread count given by the user
+
+	parallelConfig->NumberOfRuns = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		count = atoi(token);
+		if ((count < 0) || (count > MAX_SHARDS) || (parallelConfig->NumberOfRuns == MAX_SHARD_RUNS))
+		{
+			printf("ERROR! Up to %d thread counts from 0 to %d can be given\n", MAX_SHARD_RUNS, MAX_SHARDS);
+			return(-1);
+		}
+		parallelConfig->ShardCounts[parallelConfig->NumberOfRuns++] = count;
+	}
+
+	if (parallelConfig->NumberOfRuns < 1)
+	{
+		printf("ERROR! At least one thread count must be given\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a comma separated list of the numbers of servers   =
+//=  of the cross-check of the mean field, e.g. "10,100,1000".              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list  - list given on the command line. It is modified         =
+//=          check - configuration to fill                                  =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseCheckSizes(char *list, MEAN_FIELD_CHECK *check)
+{
+	char *token;  // Current number of the list
+	int   count;  // Number of servers given by the user
+
+	check->NumberOfSizes = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		count = atoi(token);
+		if ((count < 1) || (check->NumberOfSizes == MAX_CHECK_SIZES))
+		{
+			printf("ERROR! Up to %d positive numbers of servers can be given\n", MAX_CHECK_SIZES);
+			return(-1);
+		}
+		check->ServerCounts[check->NumberOfSizes++] = count;
+	}
+
+	if (check->NumberOfSizes < 1)
+	{
+		printf("ERROR! At least one number of servers must be given\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads the parameters of the run from the command line.   =
+//=  Allowed options:                                                       =
+//=    --balancer N  load balancer from 1 to NUMBER_OF_POLICIES             =
+//=    --servers N   number of servers                                      =
+//=    --lambda X    customers arrival rate                                 =
+//=    --mu X        service rate of a server, the mean if speeds differ    =
+//=    --stale X     period of the queue length updates                     =
+//=    --seed N      seed of the random stream                              =
+//=    --replications K  run up to K independent replications in parallel   =
+//=    --threads T   number of threads for the replications                 =
+//=    --run-length N  customers served in one replication                  =
+//=    --d N         servers sampled per customer by the sampling balancers =
+//=    --batch N     customers arriving together                            =
+//=    --percentile P  control the run length by the P-th percentile of the =
+//=                  response time instead of the mean, e.g. 99             =
+//=    --crn L       compare the load balancers of the list L, e.g. 3,4,5,  =
+//=                  on common random numbers. The first is the baseline    =
+//=    --sweep FILE  run every point of the grid in FILE                    =
+//=    --output FILE results of the sweep, CSV or JSON lines (.json)        =
+//=    --cache FILE  results of the points computed before                  =
+//=    --trace FILE  replay the customers of FILE made by TraceConverter    =
+//=    --capacity N  customers admitted by each server, 0 for unbounded     =
+//=    --overload P  what happens to a customer who finds a full queue:     =
+//=                  Reject, Redirect or Retry                              =
+//=    --retry-delay X  mean backoff of the first retry                     =
+//=    --max-retries N  retries before the customer is dropped              =
+//=    --update M    how the servers report their queue lengths: Snapshot,  =
+//=                  Jitter, Piggyback or Threshold                         =
+//=    --jitter X    relative jitter of the periods of the Jitter reports   =
+//=    --threshold N change of the queue length which triggers a report     =
+//=    --delay X     time a report takes to reach the load balancer         =
+//=    --noise X     perturbation of the backlogs of the Predictive         =
+//=                  balancer in standard deviations, 0 for none            =
+//=    --dispatchers M  number of independent dispatchers, each with its    =
+//=                  own arrivals and its own view of the queues            =
+//=    --telemetry FILE write samples of every server to FILE, read by the  =
+//=                  TelemetryReader tool. Single runs and traces only      =
+//=    --telemetry-interval X  simulated time between two samples           =
+//=    --service D   distribution of the service demands: Exponential,      =
+//=                  Deterministic, Hyperexponential, Lognormal or Pareto   =
+//=    --scv X       squared coefficient of variation of the                =
+//=                  Hyperexponential and Lognormal demands                 =
+//=    --shape X     shape of the Pareto demands, greater than 1            =
+//=    --service-file FILE  empirical demands, one per line, scaled to the  =
+//=                  mean 1 / mu                                            =
+//=    --speeds L    relative speeds of the servers in turn, e.g. 1,1,1,2   =
+//=    --schedule L  factors of lambda over time as time:factor steps, e.g. =
+//=                  0:0.5,3600:1.5,7200:1                                  =
+//=    --schedule-period X  repeat the schedule every X, e.g. 86400 for a   =
+//=                  diurnal curve                                          =
+//=    --burst-length X  mean duration of random bursts, 0 for none         =
+//=    --burst-gap X mean time between the bursts                           =
+//=    --burst-factor X  factor of the arrival rate during a burst          =
+//=    --autoscale 1 add and drain servers while the run goes on, up to     =
+//=                  --servers                                              =
+//=    --target X    utilization which the autoscaler aims at               =
+//=    --min-servers N  fewest servers the autoscaler keeps                 =
+//=    --scale-interval X  time between two decisions of the autoscaler     =
+//=    --provision-delay X  time until a new server takes customers         =
+//=    --shards L    run on the shards of each thread count of the list,    =
+//=                  e.g. 0,1,2,4, where 0 is the sequential engine         =
+//=    --mean-field 1  solve the mean-field model instead of simulating,    =
+//=                  also for every point of a sweep                        =
+//=    --mean-field-check L  compare the mean field with simulations of     =
+//=                  each number of servers of the list, e.g. 10,100,1000,  =
+//=                  at the utilization of --servers, --lambda and --mu     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv       - command line arguments                      =
+//=          crnConfig        - configuration to fill                       =
+//=          sweepConfig      - paths of the sweep files to fill            =
+//=          parallelConfig   - thread counts of the parallel mode to fill  =
+//=          check            - server counts of the cross-check to fill    =
+//=          tracePath        - set to the trace file of the trace mode     =
+//=          telemetryPath    - set to the telemetry file if it is given    =
+//=          servicePath      - set to the file of the empirical demands    =
+//=          balancerChosen   - set to 1 if the load balancer is given      =
+//=          mode             - set to the chosen mode                      =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseArguments(int argc, char *argv[], CRN_CONFIG *crnConfig, SWEEP_CONFIG *sweepConfig,
+	PARALLEL_CONFIG *parallelConfig, MEAN_FIELD_CHECK *check, const char **tracePath, const char **telemetryPath,
+	const char **servicePath, int *balancerChosen, enum RUN_MODE *mode)
+{
+	REPLICATION_CONFIG *replicationConfig = &crnConfig->Replication;  // Parameters of the replications
+	SIMULATION_CONFIG  *config = &replicationConfig->Simulation;      // Parameters of every run
+	int                 i;                                            // Argument counter
+	int                 choice;                                       // Load balancer number given by the user
+	int                 meanField = 0;                                // Whether the mean field replaces the runs
+	ARRIVAL_RATES       rates;                                        // Arrival rate which checks the schedule
+	RANDOM_STREAM       stream;                                       // Stream of the bursts of the check
+
+	*balancerChosen = 0;
+	*mode = singleRunMode;
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--balancer") == 0)
+		{
+			choice = atoi(argv[i + 1]);
+			if ((choice < 1) || (choice > NUMBER_OF_POLICIES))
+			{
+				printf("ERROR! Load balancer must be from 1 to %d\n", NUMBER_OF_POLICIES);
+				return(-1);
+			}
+			config->LoadBalancer = (enum BALANCER_TYPE) (choice - 1);
+			*balancerChosen = 1;
+		}
+		else if (strcmp(argv[i], "--servers") == 0)
+		{
+			config->NumberOfServers = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--lambda") == 0)
+		{
+			config->Lambda = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--mu") == 0)
+		{
+			config->Mu = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--stale") == 0)
+		{
+			config->StalePeriod = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0)
+		{
+			config->Seed = strtoull(argv[i + 1], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--replications") == 0)
+		{
+			replicationConfig->MaxReplications = atoi(argv[i + 1]);
+			if (*mode == singleRunMode)
+			{
+				*mode = replicationMode;
+			}
+		}
+		else if (strcmp(argv[i], "--percentile") == 0)
+		{
+			config->Percentile = atof(argv[i + 1]) / 100.0;
+			if ((config->Percentile <= 0.0) || (config->Percentile >= 1.0))
+			{
+				printf("ERROR! Percentile must be between 0 and 100\n");
+				return(-1);
+			}
+		}
+		else if (strcmp(argv[i], "--sweep") == 0)
+		{
+			sweepConfig->GridPath = argv[i + 1];
+			*mode = sweepMode;
+		}
+		else if (strcmp(argv[i], "--output") == 0)
+		{
+			sweepConfig->OutputPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--cache") == 0)
+		{
+			sweepConfig->CachePath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--trace") == 0)
+		{
+			*tracePath = argv[i + 1];
+			*mode = traceMode;
+		}
+		else if (strcmp(argv[i], "--capacity") == 0)
+		{
+			config->QueueCapacity = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--overload") == 0)
+		{
+			for (choice = rejectOverload; choice <= retryOverload; choice++)
+			{
+				if (strcmp(argv[i + 1], overloadName((enum OVERLOAD_TYPE) choice)) == 0)
+				{
+					break;
+				}
+			}
+			if (choice > retryOverload)
+			{
+				printf("ERROR! Overload policy must be Reject, Redirect or Retry\n");
+				return(-1);
+			}
+			config->Overload = (enum OVERLOAD_TYPE) choice;
+		}
+		else if (strcmp(argv[i], "--retry-delay") == 0)
+		{
+			config->RetryDelay = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--max-retries") == 0)
+		{
+			config->MaxRetries = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--update") == 0)
+		{
+			for (choice = snapshotUpdate; choice <= thresholdUpdate; choice++)
+			{
+				if (strcmp(argv[i + 1], updateName((enum UPDATE_TYPE) choice)) == 0)
+				{
+					break;
+				}
+			}
+			if (choice > thresholdUpdate)
+			{
+				printf("ERROR! Update mode must be Snapshot, Jitter, Piggyback or Threshold\n");
+				return(-1);
+			}
+			config->Update = (enum UPDATE_TYPE) choice;
+		}
+		else if (strcmp(argv[i], "--jitter") == 0)
+		{
+			config->UpdateJitter = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--threshold") == 0)
+		{
+			config->UpdateThreshold = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--delay") == 0)
+		{
+			config->NetworkDelay = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--noise") == 0)
+		{
+			config->PredictionNoise = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--dispatchers") == 0)
+		{
+			config->DispatcherCount = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--telemetry") == 0)
+		{
+			*telemetryPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--telemetry-interval") == 0)
+		{
+			config->TelemetryInterval = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--service") == 0)
+		{
+			for (choice = exponentialService; choice <= paretoService; choice++)
+			{
+				if (strcmp(argv[i + 1], serviceName((enum SERVICE_TYPE) choice)) == 0)
+				{
+					break;
+				}
+			}
+			if (choice > paretoService)
+			{
+				printf("ERROR! Service distribution must be Exponential, Deterministic, Hyperexponential, Lognormal "
+					"or Pareto\n");
+				return(-1);
+			}
+			config->Service = (enum SERVICE_TYPE) choice;
+		}
+		else if (strcmp(argv[i], "--scv") == 0)
+		{
+			config->ServiceVariation = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--shape") == 0)
+		{
+			config->ParetoShape = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--service-file") == 0)
+		{
+			*servicePath = argv[i + 1];
+			config->Service = empiricalService;
+		}
+		else if (strcmp(argv[i], "--speeds") == 0)
+		{
+			if (parseSpeeds(argv[i + 1], config) != 0)
+			{
+				return(-1);
+			}
+		}
+		else if (strcmp(argv[i], "--schedule") == 0)
+		{
+			if (parseSchedule(argv[i + 1], config) != 0)
+			{
+				return(-1);
+			}
+		}
+		else if (strcmp(argv[i], "--schedule-period") == 0)
+		{
+			config->Schedule.Period = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--burst-length") == 0)
+		{
+			config->Schedule.BurstLength = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--burst-gap") == 0)
+		{
+			config->Schedule.BurstGap = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--burst-factor") == 0)
+		{
+			config->Schedule.BurstFactor = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--autoscale") == 0)
+		{
+			config->Autoscale = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--target") == 0)
+		{
+			config->TargetUtilization = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--min-servers") == 0)
+		{
+			config->MinServers = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--scale-interval") == 0)
+		{
+			config->ScaleInterval = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--provision-delay") == 0)
+		{
+			config->ProvisionDelay = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--crn") == 0)
+		{
+			if (parsePolicies(argv[i + 1], crnConfig) != 0)
+			{
+				return(-1);
+			}
+			*mode = crnMode;
+		}
+		else if (strcmp(argv[i], "--shards") == 0)
+		{
+			if (parseShardCounts(argv[i + 1], parallelConfig) != 0)
+			{
+				return(-1);
+			}
+			*mode = parallelMode;
+		}
+		else if (strcmp(argv[i], "--mean-field") == 0)
+		{
+			meanField = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--mean-field-check") == 0)
+		{
+			if (parseCheckSizes(argv[i + 1], check) != 0)
+			{
+				return(-1);
+			}
+			*mode = checkMode;
+		}
+		else if (strcmp(argv[i], "--threads") == 0)
+		{
+			replicationConfig->NumberOfThreads = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--run-length") == 0)
+		{
+			config->RunLength = atoll(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--d") == 0)
+		{
+			config->SampleSize = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--batch") == 0)
+		{
+			config->BatchSize = atoi(argv[i + 1]);
+		}
+		else
+		{
+			printf("ERROR! Unknown option %s\n", argv[i]);
+			return(-1);
+		}
+	}
+
+	if (i < argc)
+	{
+		printf("ERROR! Option %s needs a value\n", argv[i]);
+		return(-1);
+	}
+	if ((config->NumberOfServers < 1) || (config->Lambda <= 0.0) || (config->Mu <= 0.0) ||
+		(config->StalePeriod <= 0.0))
+	{
+		printf("ERROR! Number of servers, lambda, mu and stale period must be positive\n");
+		return(-1);
+	}
+	if ((config->SampleSize < 1) || (config->BatchSize < 1) || (config->DispatcherCount < 1))
+	{
+		printf("ERROR! Sample size, batch size and number of dispatchers must be positive\n");
+		return(-1);
+	}
+	if ((config->QueueCapacity < 0) || (config->RetryDelay <= 0.0) || (config->MaxRetries < 0) ||
+		(config->MaxRetries > 30))
+	{
+		printf("ERROR! Capacity must not be negative, retry delay must be positive, retries from 0 to 30\n");
+		return(-1);
+	}
+	if ((config->UpdateJitter < 0.0) || (config->UpdateJitter >= 1.0) || (config->UpdateThreshold < 1) ||
+		(config->NetworkDelay < 0.0) || (config->PredictionNoise < 0.0))
+	{
+		printf("ERROR! Jitter must be from 0 to 1, threshold must be positive, delay and noise must not be "
+			"negative\n");
+		return(-1);
+	}
+	if ((config->TelemetryInterval <= 0.0) ||
+		((*telemetryPath != NULL) && (*mode != singleRunMode) && (*mode != traceMode)))
+	{
+		printf("ERROR! Telemetry interval must be positive, telemetry is written by single runs and traces only\n");
+		return(-1);
+	}
+	if ((replicationConfig->MaxReplications < 2) || (replicationConfig->NumberOfThreads < 1) ||
+		(config->RunLength < 0))
+	{
+		printf("ERROR! Replications must be at least 2, threads and run length must be positive\n");
+		return(-1);
+	}
+	if (config->Autoscale && ((config->MinServers < 1) || (config->MinServers > config->NumberOfServers) ||
+		(config->TargetUtilization <= 0.0) || (config->TargetUtilization > 1.0) || (config->ScaleInterval <= 0.0) ||
+		(config->ProvisionDelay < 0.0)))
+	{
+		printf("ERROR! The autoscaler needs from 1 to --servers servers, a target utilization from 0 to 1, a "
+			"positive interval and a delay which is not negative\n");
+		return(-1);
+	}
+
+	// The schedule is checked once, before any run. A trace brings its own arrivals
+	randomStreamInit(&stream, config->Seed);
+	if (arrivalRatesInit(&rates, &config->Schedule, &stream) != 0)
+	{
+		return(-1);
+	}
+	if (scheduleVaries(&config->Schedule) && (*mode == traceMode))
+	{
+		printf("ERROR! The arrival rate of a trace is given by its timestamps\n");
+		return(-1);
+	}
+
+	// The mean field replaces a single run or the runs of the sweep points
+	if (meanField && (*mode == singleRunMode))
+	{
+		*mode = meanFieldMode;
+	}
+	else if (meanField && (*mode == sweepMode))
+	{
+		sweepConfig->MeanField = 1;
+	}
+	else if (meanField)
+	{
+		printf("ERROR! The mean field replaces a single run or the runs of a sweep only\n");
+		return(-1);
+	}
+
+	if (replicationConfig->MinReplications > replicationConfig->MaxReplications)
+	{
+		replicationConfig->MinReplications = replicationConfig->MaxReplications;
+	}
+
+	// Replications always have a fixed length. Sweep points are single runs
+	if (((*mode == replicationMode) || (*mode == crnMode)) && (config->RunLength == 0))
+	{
+		config->RunLength = REPLICATION_LENGTH;
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function asks the user what type of the Load Balancer does he     =
+//=  want. Allowable types are listed in the enum BALANCER_TYPE.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: None                                                           =
+//=  Returns: chosen load balancer                                          =
+//===========================================================================
+enum BALANCER_TYPE chooseBalancerDialog(void)
+{
+	int userChoice = 0;  // The number entered by user is stored here
+	int i;               // Loop counter
+
+	// Ask user what balancer does he want
+	printf("Choose workload balancing strategy for the system. Press:\n");
+	for (i = 0; i < NUMBER_OF_POLICIES; i++)
+	{
+		printf("  %d - for %s balancing strategy\n", i + 1, balancerName((enum BALANCER_TYPE) i));
+	}
+
+	// Read the choice while it is not allowable
+	while ((userChoice < 1) || (userChoice > NUMBER_OF_POLICIES))
+	{
+		printf("Your choice: ");
+		if (scanf("%d", &userChoice) != 1)
+		{
+			// Not a number. Skip the rest of the line
+			do
+			{
+				i = getchar();
+			} while ((i != '\n') && (i != EOF));
+			if (i == EOF)
+			{
+				exit(1);
+			}
+			userChoice = 0;
+		}
+
+		// Error message the choice is bad
+		if ((userChoice < 1) || (userChoice > NUMBER_OF_POLICIES))
+		{
+			printf("ERROR! Your choice is not appropriate. Try again please.\n");
+		}
+	}
+
+	// "-1" because records in the enum start from 0
+	return((enum BALANCER_TYPE) (userChoice - 1));
+}
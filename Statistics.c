@@ -0,0 +1,377 @@
+//----- Includes --------------------------------------------------------------
+#include <math.h>        // Needed for sqrt() and log()
+#include "Statistics.h"  // Delay table type and prototypes
+
+//===========================================================================
+//=  This function makes the table empty.                                   =
+//===========================================================================
+void tableInit(DELAY_TABLE *table)
+{
+	table->Count = 0;
+	table->Sum = 0.0;
+	table->SumSquares = 0.0;
+	table->Min = 0.0;
+	table->Max = 0.0;
+	table->NumberOfBatches = 0;
+	table->BatchSize = MSER_BATCH_SIZE;
+	table->CurrentBatchSum = 0.0;
+	table->CurrentBatchCount = 0;
+	table->Truncated = 0;
+	table->TruncatedMean = 0.0;
+	table->StandardError = -1.0;
+	table->IntervalBatches = 0;
+	table->Correlation = 0.0;
+	table->CorrelationBatches = 0;
+}
+
+//===========================================================================
+//=  This function groups consecutive batch means into larger batches and   =
+//=  returns the mean, the variance and the lag-1 autocorrelation of the    =
+//=  larger batch means.                                                    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: batchMeans  - means of equal batches in time order             =
+//=          groups      - number of larger batches                         =
+//=          groupSize   - batches in one larger batch                      =
+//=          mean        - place to store the mean                          =
+//=          variance    - place to store the variance                      =
+//=          correlation - place to store the lag-1 autocorrelation         =
+//=  Returns: None                                                          =
+//===========================================================================
+static void groupStatistics(const double *batchMeans, int groups, int groupSize, double *mean, double *variance,
+	double *correlation)
+{
+	double groupMean;       // Mean of the current larger batch
+	double previous = 0.0;  // Deviation of the previous larger batch
+	double squares = 0.0;   // Sum of squared deviations
+	double products = 0.0;  // Sum of products of neighbouring deviations
+	double sum = 0.0;       // Sum of the batch means
+	int    i;               // Larger batch counter
+	int    j;               // Batch counter in the larger batch
+
+	for (i = 0; i < groups * groupSize; i++)
+	{
+		sum += batchMeans[i];
+	}
+	*mean = sum / (groups * groupSize);
+
+	for (i = 0; i < groups; i++)
+	{
+		groupMean = 0.0;
+		for (j = 0; j < groupSize; j++)
+		{
+			groupMean += batchMeans[i * groupSize + j];
+		}
+		groupMean = groupMean / groupSize - *mean;
+		squares += groupMean * groupMean;
+		if (i > 0)
+		{
+			products += previous * groupMean;
+		}
+		previous = groupMean;
+	}
+
+	*variance = squares / (groups - 1);
+	*correlation = (squares > 0.0) ? products / squares : 0.0;
+}
+
+//===========================================================================
+//=  This function finds the end of the warm-up with the MSER rule and      =
+//=  estimates the standard error of the mean of the rest of the run. MSER  =
+//=  discards the first d batches where d minimizes the squared standard    =
+//=  error of the remaining batch means, sum((Z - mean)^2) / (k - d)^2, for =
+//=  d up to k / 2. A minimum at k / 2 means the warm-up is longer than the =
+//=  run so far. The batches after the warm-up are grouped into BATCH_COUNT =
+//=  to 2 * BATCH_COUNT - 1 interval batches for the confidence interval.   =
+//=  Their independence is checked on batches CORRELATION_SPLIT times       =
+//=  shorter: if those are uncorrelated, the longer ones are too, and the   =
+//=  test has CORRELATION_SPLIT times more batches to look at.              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table - delay table whose batch has just been completed        =
+//=  Returns: None                                                          =
+//===========================================================================
+static void analyzeTable(DELAY_TABLE *table)
+{
+	int    batches = table->NumberOfBatches;  // Number of completed batches
+	double suffixSum = 0.0;                   // Sum of the batch means after the current one
+	double suffixSquares = 0.0;               // Sum of their squares
+	double mser;                              // Criterion of the current truncation point
+	double bestMser = 0.0;                    // Smallest criterion
+	int    warmUp = 0;                        // Number of batches of the warm-up
+	int    groupSize;                         // Batches in one interval batch
+	int    groups;                            // Number of interval batches
+	double mean;                              // Mean after the warm-up
+	double variance;                          // Variance of the interval batch means
+	double correlation;                       // Lag-1 autocorrelation of the interval batch means
+	int    i;                                 // Batch counter
+
+	table->StandardError = -1.0;
+	if (batches < 2 * BATCH_COUNT * CORRELATION_SPLIT)
+	{
+		return;
+	}
+
+	for (i = batches - 1; i >= 0; i--)
+	{
+		suffixSum += table->BatchMeans[i];
+		suffixSquares += table->BatchMeans[i] * table->BatchMeans[i];
+		if (i <= batches / 2)
+		{
+			mser = (suffixSquares - suffixSum * suffixSum / (batches - i)) / ((double) (batches - i) * (batches - i));
+			if ((i == batches / 2) || (mser <= bestMser))
+			{
+				bestMser = mser;
+				warmUp = i;
+			}
+		}
+	}
+	if (warmUp == batches / 2)
+	{
+		return;
+	}
+
+	// The interval batches start after the warm-up, so the batches completed
+	// later do not change them until a new interval batch is complete
+	groupSize = (batches - warmUp) / (BATCH_COUNT * CORRELATION_SPLIT) * CORRELATION_SPLIT;
+	groups = (batches - warmUp) / groupSize;
+
+	groupStatistics(table->BatchMeans + warmUp, groups * CORRELATION_SPLIT, groupSize / CORRELATION_SPLIT, &mean,
+		&variance, &correlation);
+	table->Correlation = correlation;
+	table->CorrelationBatches = groups * CORRELATION_SPLIT;
+	groupStatistics(table->BatchMeans + warmUp, groups, groupSize, &mean, &variance, &correlation);
+	table->StandardError = sqrt(variance / groups);
+	table->IntervalBatches = groups;
+
+	// The mean includes the batches after the last interval batch
+	mean = 0.0;
+	for (i = warmUp; i < batches; i++)
+	{
+		mean += table->BatchMeans[i];
+	}
+	table->Truncated = warmUp * table->BatchSize;
+	table->TruncatedMean = mean / (batches - warmUp);
+}
+
+//===========================================================================
+//=  This function records the observation in the table. Observations are   =
+//=  grouped into batches of MSER_BATCH_SIZE. When there are MAX_BATCHES    =
+//=  batches the neighbouring batches are merged and the batch size is      =
+//=  doubled, so the table uses constant memory however long the run is.    =
+//=  The warm-up and the confidence interval are computed again whenever a  =
+//=  batch is completed. It is the analogue of CSIM record().               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table - delay table                                            =
+//=          value - observation                                            =
+//=  Returns: 1 if the observation has completed a batch, 0 otherwise       =
+//===========================================================================
+int tableRecord(DELAY_TABLE *table, double value)
+{
+	int i;  // Loop counter
+
+	if ((table->Count == 0) || (value < table->Min))
+	{
+		table->Min = value;
+	}
+	if ((table->Count == 0) || (value > table->Max))
+	{
+		table->Max = value;
+	}
+	table->Count++;
+	table->Sum += value;
+	table->SumSquares += value * value;
+
+	// Add the observation to the current batch
+	table->CurrentBatchSum += value;
+	table->CurrentBatchCount++;
+	if (table->CurrentBatchCount < table->BatchSize)
+	{
+		return(0);
+	}
+
+	// The batch is complete
+	table->BatchMeans[table->NumberOfBatches++] = table->CurrentBatchSum / table->BatchSize;
+	table->CurrentBatchSum = 0.0;
+	table->CurrentBatchCount = 0;
+	analyzeTable(table);
+
+	// Merge the neighbouring batches if there is no place for the next one
+	if (table->NumberOfBatches == MAX_BATCHES)
+	{
+		for (i = 0; i < MAX_BATCHES / 2; i++)
+		{
+			table->BatchMeans[i] = (table->BatchMeans[2 * i] + table->BatchMeans[2 * i + 1]) / 2.0;
+		}
+		table->NumberOfBatches = MAX_BATCHES / 2;
+		table->BatchSize *= 2;
+	}
+
+	return(1);
+}
+
+//===========================================================================
+//=  This function returns the mean of the observations after the warm-up,  =
+//=  or the mean of all observations if the warm-up is not known yet.       =
+//===========================================================================
+double tableMean(const DELAY_TABLE *table)
+{
+	if (table->StandardError >= 0.0)
+	{
+		return(table->TruncatedMean);
+	}
+
+	return((table->Count > 0) ? table->Sum / table->Count : 0.0);
+}
+
+//===========================================================================
+//=  This function calculates the half-width of the confidence interval of  =
+//=  the mean after the warm-up. The interval batch means are treated as    =
+//=  independent observations.                                              =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table   - delay table                                          =
+//=          ciLevel - confidence level                                     =
+//=  Returns: half-width of the confidence interval or a negative value if  =
+//=           there are not enough batches after the warm-up                =
+//===========================================================================
+double tableHalfWidth(const DELAY_TABLE *table, double ciLevel)
+{
+	if (table->StandardError < 0.0)
+	{
+		return(-1.0);
+	}
+
+	return(studentTQuantile(0.5 + ciLevel / 2.0, table->IntervalBatches - 1) * table->StandardError);
+}
+
+//===========================================================================
+//=  This function checks whether the desired relative accuracy of the      =
+//=  mean is achieved with the desired probability. It is the analogue of   =
+//=  the convergence test of CSIM table_run_length(). The interval batches  =
+//=  must also pass the test of independence: a lag-1 autocorrelation       =
+//=  which is significant at ciLevel means the batches are too short and    =
+//=  the interval too narrow.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: table    - delay table                                         =
+//=          accuracy - target relative half-width of the interval          =
+//=          ciLevel  - confidence level                                    =
+//=  Returns: 1 if the table has converged, 0 otherwise                     =
+//===========================================================================
+int tableConverged(const DELAY_TABLE *table, double accuracy, double ciLevel)
+{
+	double halfWidth;  // Half-width of the confidence interval
+
+	halfWidth = tableHalfWidth(table, ciLevel);
+	if (halfWidth < 0.0)
+	{
+		return(0);
+	}
+	if (table->Correlation * sqrt((double) table->CorrelationBatches) >
+		studentTQuantile(ciLevel, table->CorrelationBatches - 1))
+	{
+		return(0);
+	}
+
+	return(halfWidth <= accuracy * tableMean(table));
+}
+
+//===========================================================================
+//=  This function calculates the mean of independent observations and the  =
+//=  half-width of its Student t confidence interval. It is used to pool    =
+//=  the means of independent replications.                                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: values  - observations                                         =
+//=          count   - number of observations                               =
+//=          ciLevel - confidence level                                     =
+//=          mean    - place to store the mean                              =
+//=  Returns: half-width of the confidence interval or a negative value if  =
+//=           there are less than two observations                          =
+//===========================================================================
+double sampleHalfWidth(const double *values, int count, double ciLevel, double *mean)
+{
+	double sum = 0.0;       // Sum of the observations
+	double variance = 0.0;  // Variance of the observations
+	int    i;               // Loop counter
+
+	for (i = 0; i < count; i++)
+	{
+		sum += values[i];
+	}
+	*mean = (count > 0) ? sum / count : 0.0;
+	if (count < 2)
+	{
+		return(-1.0);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		variance += (values[i] - *mean) * (values[i] - *mean);
+	}
+	variance /= count - 1;
+
+	return(studentTQuantile(0.5 + ciLevel / 2.0, count - 1) * sqrt(variance / count));
+}
+
+//===========================================================================
+//=  This function returns the quantile of the standard normal distribution =
+//=  (Acklam's rational approximation, relative error below 1.2e-9).        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: probability - probability from (0, 1)                          =
+//=  Returns: quantile                                                      =
+//===========================================================================
+static double normalQuantile(double probability)
+{
+	static const double a[] = { -3.969683028665376e+01,  2.209460984245205e+02,
+	                            -2.759285104469687e+02,  1.383577518672690e+02,
+	                            -3.066479806614716e+01,  2.506628277459239e+00 };
+	static const double b[] = { -5.447609879822406e+01,  1.615858368580409e+02,
+	                            -1.556989798598866e+02,  6.680131188771972e+01,
+	                            -1.328068155288572e+01 };
+	static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+	                            -2.400758277161838e+00, -2.549732539343734e+00,
+	                             4.374664141464968e+00,  2.938163982698783e+00 };
+	static const double d[] = {  7.784695709041462e-03,  3.224671290700398e-01,
+	                             2.445134137142996e+00,  3.754408661907416e+00 };
+	double q;  // Distance from the center or tail variable
+	double r;  // Square of q
+
+	if (probability < 0.02425)
+	{
+		q = sqrt(-2.0 * log(probability));
+		return((((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+			((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0));
+	}
+	if (probability > 1.0 - 0.02425)
+	{
+		q = sqrt(-2.0 * log(1.0 - probability));
+		return(-(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+			((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0));
+	}
+
+	q = probability - 0.5;
+	r = q * q;
+	return((((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+		(((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0));
+}
+
+//===========================================================================
+//=  This function returns the quantile of the Student t distribution. It   =
+//=  uses the Cornish-Fisher expansion around the normal quantile, which is =
+//=  accurate to three digits for 5 or more degrees of freedom.             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: probability      - probability from (0, 1)                     =
+//=          degreesOfFreedom - degrees of freedom                          =
+//=  Returns: quantile                                                      =
+//===========================================================================
+double studentTQuantile(double probability, int degreesOfFreedom)
+{
+	double z;   // Normal quantile
+	double z2;  // Square of z
+	double n;   // Degrees of freedom as double
+
+	z = normalQuantile(probability);
+	z2 = z * z;
+	n = (double) degreesOfFreedom;
+
+	return(z + z * (z2 + 1.0) / (4.0 * n) +
+		z * ((5.0 * z2 + 16.0) * z2 + 3.0) / (96.0 * n * n) +
+		z * (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) / (384.0 * n * n * n));
+}
@@ -0,0 +1,41 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+//----- Constants -------------------------------------------------------------
+#define BATCH_COUNT        20    // Number of batches used for the confidence interval
+#define INITIAL_BATCH_SIZE 16    // Number of observations in a batch at the start of the run
+#define MSER_BATCH_SIZE    5     // Observations in a batch of the delay table at the start of the run (MSER-5)
+#define MAX_BATCHES        1024  // Batch means kept by the delay table. Neighbouring batches are merged when it is full
+#define CORRELATION_SPLIT  4     // Interval batches are split into this many batches for the test of independence
+
+//------New types--------------------------------------------------------------
+typedef struct  // Table of observations with warm-up truncation and batch means run length control
+{
+	long long Count;                    // Number of recorded observations
+	double    Sum;                      // Sum of recorded observations
+	double    SumSquares;               // Sum of squares of recorded observations
+	double    Min;                      // Minimum recorded observation
+	double    Max;                      // Maximum recorded observation
+	double    BatchMeans[MAX_BATCHES];  // Means of the completed batches in time order
+	int       NumberOfBatches;          // Number of completed batches
+	long long BatchSize;                // Current number of observations in a batch
+	double    CurrentBatchSum;          // Sum of the observations in the current batch
+	long long CurrentBatchCount;        // Number of observations in the current batch
+	long long Truncated;                // Observations discarded as the warm-up by the last analysis
+	double    TruncatedMean;            // Mean of the observations after the warm-up
+	double    StandardError;            // Standard error of TruncatedMean. Negative if there are not enough batches
+	int       IntervalBatches;          // Number of batches of the confidence interval after the warm-up
+	double    Correlation;              // Lag-1 autocorrelation of the batches of the test of independence
+	int       CorrelationBatches;       // Number of batches of the test of independence
+} DELAY_TABLE;
+
+//----- Prototypes ------------------------------------------------------------
+void   tableInit(DELAY_TABLE *table);
+int    tableRecord(DELAY_TABLE *table, double value);
+double tableMean(const DELAY_TABLE *table);
+double tableHalfWidth(const DELAY_TABLE *table, double ciLevel);
+int    tableConverged(const DELAY_TABLE *table, double accuracy, double ciLevel);
+double sampleHalfWidth(const double *values, int count, double ciLevel, double *mean);
+double studentTQuantile(double probability, int degreesOfFreedom);
+
+#endif
@@ -0,0 +1,820 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>         // Needed for I/O functions
+#include <stdlib.h>        // Needed for malloc(), calloc(), free() and strtod()
+#include <string.h>        // Needed for string functions and memcpy()
+#include <pthread.h>       // Needed for the worker threads
+#include "Sweep.h"         // Parameter sweep types and prototypes
+#include "Replications.h"  // Needed for wallClock()
+#include "MeanField.h"     // Mean-field solver of the points
+
+//----- Constants -------------------------------------------------------------
+#define MAX_LINE_LENGTH 8192  // Longest line of the grid and cache files
+#define MAX_KEY_LENGTH  4096  // Longest cache key of a grid point
+
+//------New types--------------------------------------------------------------
+typedef struct  // One point of the grid and its result
+{
+	SIMULATION_CONFIG Config;               // Parameters of the point
+	double            Utilization;          // Server utilization of the point
+	char              Key[MAX_KEY_LENGTH];  // Parameters which change the result. Key of the cache
+	int               Source;               // Earlier point with the same key whose result is reused, or this point
+	int               Cached;               // Whether the result is read from the cache
+	int               MeanField;            // Whether the point is solved by the mean field
+	double            Mean;                 // Mean response time
+	double            HalfWidth;            // Half-width of the confidence interval of the mean
+	double            Percentiles[3];       // p50, p99 and p99.9 of the response time
+	long long         Customers;            // Number of served customers
+	long long         Drops;                // Number of customers who have left without service
+	double            Goodput;              // Served customers per time unit
+	long long         Messages;             // Number of load reports sent to the load balancer
+	double            MessageRate;          // Load reports per time unit
+	double            CollisionRate;        // Fraction of the customers sent on a view stale by other dispatchers
+	double            Spread;               // Time average of the longest minus the shortest queue
+	long long         EventCounter;         // Number of processed events
+	double            EventsPerSecond;      // Speed of the engine
+	double            ServerTime;           // Time integral of the servers which are paid for
+	double            MeanServers;          // Servers which are paid for on average
+	int               Converged;            // Whether the run length control has stopped the run
+	int               Broken;               // Whether the system is broken
+} SWEEP_POINT;
+
+typedef struct  // State shared by the worker threads
+{
+	SWEEP_POINT    *Points;          // Points of the grid
+	int             NumberOfPoints;  // Number of points
+	FILE           *Cache;           // Cache opened for appending, NULL if it cannot be written
+	pthread_mutex_t Mutex;           // Protects all fields below, the cache and the progress output
+	int             NextPoint;       // Index of the next point to check
+	int             Finished;        // Number of computed points
+	int             ToCompute;       // Number of points which are not cached
+} SWEEP_POOL;
+
+//===========================================================================
+//=  This function reads a comma separated list of values of a grid axis.   =
+//=  An element can be a single value or a range start:stop:step, e.g.      =
+//=  "0.1:0.9:0.1" gives 0.1, 0.2 ... 0.9.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: list       - list from the grid file. It is modified           =
+//=          values     - place to store the values                         =
+//=          count      - place to store the number of values               =
+//=          lineNumber - line of the grid file for the error messages      =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+static int parseValues(char *list, double *values, int *count, int lineNumber)
+{
+	char  *token;  // Current element of the list
+	char  *end;    // End of the parsed number
+	double start;  // First value of the range
+	double stop;   // Last value of the range
+	double step;   // Step of the range
+	int    i;      // Step counter
+
+	*count = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+	{
+		start = strtod(token, &end);
+		if (end == token)
+		{
+			printf("ERROR! Line %d: %s is not a number\n", lineNumber, token);
+			return(-1);
+		}
+		stop = start;
+		step = 1.0;
+		if (*end == ':')
+		{
+			stop = strtod(end + 1, &end);
+			if (*end != ':')
+			{
+				printf("ERROR! Line %d: range must be start:stop:step\n", lineNumber);
+				return(-1);
+			}
+			step = strtod(end + 1, &end);
+			if (step <= 0.0)
+			{
+				printf("ERROR! Line %d: step of the range must be positive\n", lineNumber);
+				return(-1);
+			}
+		}
+
+		// Values are start + i * step, so the error does not accumulate
+		for (i = 0; start + i * step <= stop + step * 1e-9; i++)
+		{
+			if (*count == MAX_GRID_VALUES)
+			{
+				printf("ERROR! Line %d: more than %d values\n", lineNumber, MAX_GRID_VALUES);
+				return(-1);
+			}
+			values[(*count)++] = start + i * step;
+		}
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads the grid file. Every line is "axis = values",      =
+//=  where the axis is utilization, servers, stale, policy, update (the     =
+//=  dissemination modes from 1 to NUMBER_OF_UPDATES) or dispatchers, and   =
+//=  # starts a comment. An axis which is not given has the single value of =
+//=  the Simulation parameters.                                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - sweep configuration with GridPath and Simulation      =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int readSweepGrid(SWEEP_CONFIG *config)
+{
+	FILE  *file;                      // Grid file
+	char   line[MAX_LINE_LENGTH];     // Current line
+	char  *name;                      // Axis name
+	char  *list;                      // Values of the axis
+	char  *end;                       // End of the axis name
+	double values[MAX_GRID_VALUES];   // Values of the current axis
+	int    count;                     // Number of values of the current axis
+	int    lineNumber = 0;            // Number of the current line
+	int    i;                         // Value counter
+	int    j;                         // Policy counter
+
+	config->NumberOfUtilizations = 0;
+	config->NumberOfServerCounts = 0;
+	config->NumberOfStalePeriods = 0;
+	config->NumberOfPolicies = 0;
+	config->NumberOfUpdates = 0;
+	config->NumberOfDispatcherCounts = 0;
+
+	file = fopen(config->GridPath, "r");
+	if (file == NULL)
+	{
+		printf("ERROR! Cannot open the grid file %s\n", config->GridPath);
+		return(-1);
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		lineNumber++;
+		if ((end = strchr(line, '#')) != NULL)
+		{
+			*end = '\0';
+		}
+		name = line + strspn(line, " \t\r\n");
+		if (*name == '\0')
+		{
+			continue;
+		}
+		list = strchr(name, '=');
+		if (list == NULL)
+		{
+			printf("ERROR! Line %d: expected axis = values\n", lineNumber);
+			fclose(file);
+			return(-1);
+		}
+		*list++ = '\0';
+		end = list - 1;
+		while ((end > name) && ((end[-1] == ' ') || (end[-1] == '\t')))
+		{
+			end--;
+		}
+		*end = '\0';
+
+		if (((strcmp(name, "utilization") == 0) && (config->NumberOfUtilizations > 0)) ||
+			((strcmp(name, "servers") == 0) && (config->NumberOfServerCounts > 0)) ||
+			((strcmp(name, "stale") == 0) && (config->NumberOfStalePeriods > 0)) ||
+			((strcmp(name, "policy") == 0) && (config->NumberOfPolicies > 0)) ||
+			((strcmp(name, "update") == 0) && (config->NumberOfUpdates > 0)) ||
+			((strcmp(name, "dispatchers") == 0) && (config->NumberOfDispatcherCounts > 0)))
+		{
+			printf("ERROR! Line %d: axis %s is given twice\n", lineNumber, name);
+			fclose(file);
+			return(-1);
+		}
+		if (parseValues(list, values, &count, lineNumber) != 0)
+		{
+			fclose(file);
+			return(-1);
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			if (strcmp(name, "utilization") == 0)
+			{
+				if (values[i] <= 0.0)
+				{
+					printf("ERROR! Line %d: utilization must be positive\n", lineNumber);
+					fclose(file);
+					return(-1);
+				}
+				config->Utilizations[config->NumberOfUtilizations++] = values[i];
+			}
+			else if (strcmp(name, "servers") == 0)
+			{
+				if ((values[i] < 1.0) || (values[i] != (int) values[i]))
+				{
+					printf("ERROR! Line %d: number of servers must be a positive integer\n", lineNumber);
+					fclose(file);
+					return(-1);
+				}
+				config->ServerCounts[config->NumberOfServerCounts++] = (int) values[i];
+			}
+			else if (strcmp(name, "stale") == 0)
+			{
+				if (values[i] <= 0.0)
+				{
+					printf("ERROR! Line %d: stale period must be positive\n", lineNumber);
+					fclose(file);
+					return(-1);
+				}
+				config->StalePeriods[config->NumberOfStalePeriods++] = values[i];
+			}
+			else if (strcmp(name, "policy") == 0)
+			{
+				if ((values[i] < 1.0) || (values[i] > NUMBER_OF_POLICIES) || (values[i] != (int) values[i]) ||
+					(config->NumberOfPolicies == NUMBER_OF_POLICIES))
+				{
+					printf("ERROR! Line %d: policies must be different integers from 1 to %d\n", lineNumber,
+						NUMBER_OF_POLICIES);
+					fclose(file);
+					return(-1);
+				}
+				for (j = 0; j < config->NumberOfPolicies; j++)
+				{
+					if (config->Policies[j] == (enum BALANCER_TYPE) ((int) values[i] - 1))
+					{
+						printf("ERROR! Line %d: policy %d is listed twice\n", lineNumber, (int) values[i]);
+						fclose(file);
+						return(-1);
+					}
+				}
+				config->Policies[config->NumberOfPolicies++] = (enum BALANCER_TYPE) ((int) values[i] - 1);
+			}
+			else if (strcmp(name, "update") == 0)
+			{
+				if ((values[i] < 1.0) || (values[i] > NUMBER_OF_UPDATES) || (values[i] != (int) values[i]) ||
+					(config->NumberOfUpdates == NUMBER_OF_UPDATES))
+				{
+					printf("ERROR! Line %d: update modes must be different integers from 1 to %d\n", lineNumber,
+						NUMBER_OF_UPDATES);
+					fclose(file);
+					return(-1);
+				}
+				for (j = 0; j < config->NumberOfUpdates; j++)
+				{
+					if (config->Updates[j] == (enum UPDATE_TYPE) ((int) values[i] - 1))
+					{
+						printf("ERROR! Line %d: update mode %d is listed twice\n", lineNumber, (int) values[i]);
+						fclose(file);
+						return(-1);
+					}
+				}
+				config->Updates[config->NumberOfUpdates++] = (enum UPDATE_TYPE) ((int) values[i] - 1);
+			}
+			else if (strcmp(name, "dispatchers") == 0)
+			{
+				if ((values[i] < 1.0) || (values[i] != (int) values[i]))
+				{
+					printf("ERROR! Line %d: number of dispatchers must be a positive integer\n", lineNumber);
+					fclose(file);
+					return(-1);
+				}
+				config->DispatcherCounts[config->NumberOfDispatcherCounts++] = (int) values[i];
+			}
+			else
+			{
+				printf("ERROR! Line %d: unknown axis %s\n", lineNumber, name);
+				fclose(file);
+				return(-1);
+			}
+		}
+	}
+	fclose(file);
+
+	// Axes which are not given have the value of the command line
+	if (config->NumberOfUtilizations == 0)
+	{
+		config->Utilizations[config->NumberOfUtilizations++] = config->Simulation.Lambda /
+			(config->Simulation.NumberOfServers * config->Simulation.Mu);
+	}
+	if (config->NumberOfServerCounts == 0)
+	{
+		config->ServerCounts[config->NumberOfServerCounts++] = config->Simulation.NumberOfServers;
+	}
+	if (config->NumberOfStalePeriods == 0)
+	{
+		config->StalePeriods[config->NumberOfStalePeriods++] = config->Simulation.StalePeriod;
+	}
+	if (config->NumberOfPolicies == 0)
+	{
+		config->Policies[config->NumberOfPolicies++] = config->Simulation.LoadBalancer;
+	}
+	if (config->NumberOfUpdates == 0)
+	{
+		config->Updates[config->NumberOfUpdates++] = config->Simulation.Update;
+	}
+	if (config->NumberOfDispatcherCounts == 0)
+	{
+		config->DispatcherCounts[config->NumberOfDispatcherCounts++] = config->Simulation.DispatcherCount;
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function writes the parameters which change the result of the     =
+//=  point into its key. The stale period and the dissemination mode only   =
+//=  matter for the load balancers with stale information, and the stale    =
+//=  period only for the periodic reports, so the other points share the    =
+//=  result of all stale periods. The empirical service demands are         =
+//=  described by their number and sum. Mean-field points have their own    =
+//=  keys, so they never take the result of a simulation. The time-varying  =
+//=  load and the autoscaler add to the key only when they are used, so the =
+//=  keys of a constant load stay as they were.                             =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config    - parameters of the point                            =
+//=          meanField - whether the point is solved by the mean field      =
+//=          key       - place to store the key                             =
+//=  Returns: None                                                          =
+//===========================================================================
+static void pointKey(const SIMULATION_CONFIG *config, int meanField, char *key)
+{
+	char   speeds[MAX_KEY_LENGTH / 4];  // Speeds of the servers
+	char   load[MAX_KEY_LENGTH / 2];    // Schedule of the arrival rate and the autoscaler
+	double empiricalSum = 0.0;          // Sum of the empirical service demands
+	int    usesReports;                 // Whether the load balancer gets the load reports
+	int    usesStalePeriod;             // Whether the servers report periodically
+	int    length = 0;                  // Length of speeds
+	int    loadLength = 0;              // Length of load
+	int    i;                           // Speed, demand and step counter
+
+	usesReports = usesQueueReports(config);
+	usesStalePeriod = usesReports && ((config->Update == snapshotUpdate) || (config->Update == jitterUpdate));
+	speeds[0] = '\0';
+	for (i = 0; i < config->NumberOfSpeeds; i++)
+	{
+		length += snprintf(speeds + length, sizeof(speeds) - length, (i == 0) ? "%.17g" : ",%.17g", config->Speeds[i]);
+	}
+	for (i = 0; i < config->EmpiricalCount; i++)
+	{
+		empiricalSum += config->EmpiricalValues[i];
+	}
+	load[0] = '\0';
+	if (scheduleVaries(&config->Schedule))
+	{
+		loadLength += snprintf(load, sizeof(load), " schedule=");
+		for (i = 0; i < config->Schedule.NumberOfSteps; i++)
+		{
+			loadLength += snprintf(load + loadLength, sizeof(load) - loadLength, (i == 0) ? "%.17g:%.17g" :
+				",%.17g:%.17g", config->Schedule.Times[i], config->Schedule.Factors[i]);
+		}
+		loadLength += snprintf(load + loadLength, sizeof(load) - loadLength,
+			" period=%.17g burst=%.17g:%.17g:%.17g", config->Schedule.Period, config->Schedule.BurstLength,
+			config->Schedule.BurstGap, config->Schedule.BurstFactor);
+	}
+	if (config->Autoscale)
+	{
+		snprintf(load + loadLength, sizeof(load) - loadLength, " autoscale=%.17g:%d:%.17g:%.17g",
+			config->TargetUtilization, config->MinServers, config->ScaleInterval, config->ProvisionDelay);
+	}
+	snprintf(key, MAX_KEY_LENGTH, "%spolicy=%d servers=%d lambda=%.17g mu=%.17g stale=%.17g seed=%llu "
+		"run-length=%lld percentile=%.17g accuracy=%.17g ci=%.17g d=%d batch=%d capacity=%d overload=%d "
+		"retry-delay=%.17g retries=%d update=%d jitter=%.17g threshold=%d delay=%.17g noise=%.17g dispatchers=%d "
+		"warm-up=mser5 random=philox service=%d scv=%.17g shape=%.17g empirical=%d:%.17g speeds=%s%s",
+		meanField ? "mean-field " : "", config->LoadBalancer + 1, config->NumberOfServers, config->Lambda, config->Mu,
+		usesStalePeriod ? config->StalePeriod : 0.0, config->Seed, config->RunLength, config->Percentile,
+		config->Accuracy, config->CiLevel, config->SampleSize, config->BatchSize, config->QueueCapacity,
+		config->Overload, config->RetryDelay, config->MaxRetries, usesReports ? config->Update + 1 : 0,
+		(usesReports && (config->Update == jitterUpdate)) ? config->UpdateJitter : 0.0,
+		(usesReports && (config->Update == thresholdUpdate)) ? config->UpdateThreshold : 0,
+		usesReports ? config->NetworkDelay : 0.0,
+		(config->LoadBalancer == predictivePolicy) ? config->PredictionNoise : 0.0, config->DispatcherCount,
+		config->Service + 1,
+		((config->Service == hyperexponentialService) || (config->Service == lognormalService)) ?
+		config->ServiceVariation : 0.0, (config->Service == paretoService) ? config->ParetoShape : 0.0,
+		(config->Service == empiricalService) ? config->EmpiricalCount : 0, empiricalSum, speeds, load);
+}
+
+//===========================================================================
+//=  This function reads the results of the points which are in the cache.  =
+//=  Every line of the cache is the key, a tab and the result. Lines of     =
+//=  points which have not converged or are broken are skipped, so such a   =
+//=  point is computed again.                                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: path   - cache file. It may not exist                          =
+//=          points - points of the grid                                    =
+//=          count  - number of points                                      =
+//=  Returns: number of points found in the cache                           =
+//===========================================================================
+static int loadCache(const char *path, SWEEP_POINT *points, int count)
+{
+	FILE        *file;                   // Cache file
+	char         line[MAX_LINE_LENGTH];  // Current line
+	char        *values;                 // Result part of the line
+	SWEEP_POINT *point;                  // Current point
+	SWEEP_POINT  result;                 // Point with the result of the line
+	int          found = 0;              // Number of points found in the cache
+	int          i;                      // Point counter
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return(0);
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		values = strchr(line, '\t');
+		if (values == NULL)
+		{
+			continue;
+		}
+		*values++ = '\0';
+
+		for (i = 0; i < count; i++)
+		{
+			point = &points[i];
+			if ((point->Source != i) || point->Cached || (strcmp(point->Key, line) != 0))
+			{
+				continue;
+			}
+			result = *point;
+			if ((sscanf(values, "%lf %lf %lf %lf %lf %lld %lld %lf %lld %lf %lld %lf %lf %lf %d %d %lf %lf",
+				&result.Mean, &result.HalfWidth, &result.Percentiles[0], &result.Percentiles[1],
+				&result.Percentiles[2], &result.Customers, &result.EventCounter, &result.EventsPerSecond,
+				&result.Drops, &result.Goodput, &result.Messages, &result.MessageRate, &result.CollisionRate,
+				&result.Spread, &result.Converged, &result.Broken, &result.ServerTime, &result.MeanServers) == 18) &&
+				result.Converged && !result.Broken)
+			{
+				*point = result;
+				point->Cached = 1;
+				found++;
+			}
+		}
+	}
+	fclose(file);
+
+	return(found);
+}
+
+//===========================================================================
+//=  This function runs the simulation of one point with the run length     =
+//=  control of the Simulation parameters.                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: point - point to compute                                       =
+//=  Returns: None                                                          =
+//===========================================================================
+static void computePoint(SWEEP_POINT *point)
+{
+	static const double percentiles[3] = { 0.5, 0.99, 0.999 };  // Reported percentiles
+	SIMULATION_STATE    state;                                  // State of the run
+	int                 i;                                      // Percentile counter
+
+	if (simulationInit(&state, &point->Config) != 0)
+	{
+		point->Broken = 1;
+		return;
+	}
+
+	point->Broken = (runSimulation(&state) != 0);
+	point->Mean = tableMean(&state.DelayTable);
+	point->HalfWidth = tableHalfWidth(&state.DelayTable, point->Config.CiLevel);
+	for (i = 0; i < 3; i++)
+	{
+		point->Percentiles[i] = histogramPercentile(&state.ResponseTimes.Total, percentiles[i]);
+	}
+	point->Customers = state.DelayTable.Count;
+	point->Drops = state.Drops;
+	point->Goodput = (state.Clock > 0.0) ? state.DelayTable.Count / state.Clock : 0.0;
+	point->Messages = state.Messages;
+	point->MessageRate = (state.Clock > 0.0) ? state.Messages / state.Clock : 0.0;
+	point->CollisionRate = collisionRate(&state);
+	point->Spread = meanQueueSpread(&state);
+	point->EventCounter = state.EventCounter;
+	point->EventsPerSecond = (state.CpuTime > 0.0) ? state.EventCounter / state.CpuTime : 0.0;
+	point->Converged = state.Converged;
+	point->ServerTime = state.ServerTime;
+	point->MeanServers = meanBilledServers(&state);
+
+	simulationFree(&state);
+}
+
+//===========================================================================
+//=  This function solves the mean field of one point. The steps of the     =
+//=  integration take the place of the events, and a point without a mean   =
+//=  field is broken.                                                       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: point - point to compute                                       =
+//=  Returns: None                                                          =
+//===========================================================================
+static void solvePoint(SWEEP_POINT *point)
+{
+	MEAN_FIELD_RESULT *result;  // Steady state of the point
+
+	result = (MEAN_FIELD_RESULT *) malloc(sizeof(MEAN_FIELD_RESULT));
+	if ((result == NULL) || (meanFieldSolve(&point->Config, result) != 0))
+	{
+		point->Broken = 1;
+		free(result);
+		return;
+	}
+
+	point->Mean = result->MeanResponseTime;
+	point->HalfWidth = 0.0;
+	memcpy(point->Percentiles, result->Percentiles, sizeof(point->Percentiles));
+	point->Goodput = point->Config.Lambda * (1.0 - result->LossRate);
+	point->EventCounter = result->Steps;
+	point->EventsPerSecond = (result->SolveTime > 0.0) ? result->Steps / result->SolveTime : 0.0;
+	point->Converged = result->Converged;
+	point->ServerTime = 0.0;
+	point->MeanServers = point->Config.NumberOfServers;
+
+	free(result);
+}
+
+//===========================================================================
+//=  Worker thread. It takes the next point which is neither cached nor a   =
+//=  duplicate, computes it and stores the result in the cache. Only the    =
+//=  converged points are cached: a point stopped by MAX_TIME depends on    =
+//=  the speed of the machine, and a broken point has failed to allocate    =
+//=  its memory or has no mean field, so both are computed again next time. =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argument - sweep pool shared by the threads                    =
+//=  Returns: NULL                                                          =
+//===========================================================================
+static void *sweepWorker(void *argument)
+{
+	SWEEP_POOL  *pool = (SWEEP_POOL *) argument;  // Shared state
+	SWEEP_POINT *point;                           // Current point
+	int          index;                           // Index of the current point
+
+	while (1)
+	{
+		// Take the next point to compute
+		pthread_mutex_lock(&pool->Mutex);
+		while ((pool->NextPoint < pool->NumberOfPoints) &&
+			((pool->Points[pool->NextPoint].Source != pool->NextPoint) || pool->Points[pool->NextPoint].Cached))
+		{
+			pool->NextPoint++;
+		}
+		if (pool->NextPoint >= pool->NumberOfPoints)
+		{
+			pthread_mutex_unlock(&pool->Mutex);
+			break;
+		}
+		index = pool->NextPoint++;
+		pthread_mutex_unlock(&pool->Mutex);
+
+		point = &pool->Points[index];
+		if (point->MeanField)
+		{
+			solvePoint(point);
+		}
+		else
+		{
+			computePoint(point);
+		}
+
+		// Store the result and report the progress
+		pthread_mutex_lock(&pool->Mutex);
+		pool->Finished++;
+		if ((pool->Cache != NULL) && point->Converged && !point->Broken)
+		{
+			fprintf(pool->Cache, "%s\t%.17g %.17g %.17g %.17g %.17g %lld %lld %.17g %lld %.17g %lld %.17g %.17g "
+				"%.17g %d %d %.17g %.17g\n", point->Key, point->Mean, point->HalfWidth, point->Percentiles[0],
+				point->Percentiles[1], point->Percentiles[2], point->Customers, point->EventCounter,
+				point->EventsPerSecond, point->Drops, point->Goodput, point->Messages, point->MessageRate,
+				point->CollisionRate, point->Spread, point->Converged, point->Broken, point->ServerTime,
+				point->MeanServers);
+			fflush(pool->Cache);
+		}
+		printf("[%d/%d] %s, %d servers, utilization %.3f: %s %.6f\n", pool->Finished, pool->ToCompute,
+			balancerName(point->Config.LoadBalancer), point->Config.NumberOfServers, point->Utilization,
+			point->Broken ? "broken, mean response time" : "mean response time", point->Mean);
+		pthread_mutex_unlock(&pool->Mutex);
+	}
+
+	return(NULL);
+}
+
+//===========================================================================
+//=  This function writes one row per point: CSV with a header, or JSON     =
+//=  lines (one object per line) if the output file ends with .json.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: path   - output file                                           =
+//=          points - computed points of the grid                           =
+//=          count  - number of points                                      =
+//=  Returns: 0 on success, -1 if the file cannot be written                =
+//===========================================================================
+static int writeResults(const char *path, const SWEEP_POINT *points, int count)
+{
+	FILE              *file;     // Output file
+	const SWEEP_POINT *point;    // Current point
+	size_t             length;   // Length of the path
+	int                json;     // Whether the output is JSON lines
+	int                i;        // Point counter
+
+	file = fopen(path, "w");
+	if (file == NULL)
+	{
+		printf("ERROR! Cannot write the output file %s\n", path);
+		return(-1);
+	}
+
+	length = strlen(path);
+	json = (length >= 5) && (strcmp(path + length - 5, ".json") == 0);
+	if (!json)
+	{
+		fprintf(file, "policy,policy_name,update,update_name,dispatchers,servers,utilization,lambda,mu,stale,mean,"
+			"half_width,p50,p99,p999,customers,dropped,goodput,messages,message_rate,collision_rate,spread,events,"
+			"events_per_second,server_time,mean_servers,converged,broken,cached\n");
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		point = &points[i];
+		fprintf(file, json ?
+			"{\"policy\":%d,\"policy_name\":\"%s\",\"update\":%d,\"update_name\":\"%s\",\"dispatchers\":%d,"
+			"\"servers\":%d,\"utilization\":%.6g,\"lambda\":%.6g,\"mu\":%.6g,\"stale\":%.6g,\"mean\":%.9g,"
+			"\"half_width\":%.9g,\"p50\":%.9g,\"p99\":%.9g,\"p999\":%.9g,\"customers\":%lld,\"dropped\":%lld,"
+			"\"goodput\":%.9g,\"messages\":%lld,\"message_rate\":%.9g,\"collision_rate\":%.9g,\"spread\":%.9g,"
+			"\"events\":%lld,\"events_per_second\":%.0f,\"server_time\":%.9g,\"mean_servers\":%.9g,"
+			"\"converged\":%d,\"broken\":%d,\"cached\":%d}\n" :
+			"%d,\"%s\",%d,\"%s\",%d,%d,%.6g,%.6g,%.6g,%.6g,%.9g,%.9g,%.9g,%.9g,%.9g,%lld,%lld,%.9g,%lld,%.9g,%.9g,"
+			"%.9g,%lld,%.0f,%.9g,%.9g,%d,%d,%d\n",
+			point->Config.LoadBalancer + 1, balancerName(point->Config.LoadBalancer), point->Config.Update + 1,
+			updateName(point->Config.Update), point->Config.DispatcherCount, point->Config.NumberOfServers,
+			point->Utilization, point->Config.Lambda, point->Config.Mu, point->Config.StalePeriod, point->Mean,
+			point->HalfWidth, point->Percentiles[0], point->Percentiles[1], point->Percentiles[2], point->Customers,
+			point->Drops, point->Goodput, point->Messages, point->MessageRate, point->CollisionRate, point->Spread,
+			point->EventCounter, point->EventsPerSecond, point->ServerTime, point->MeanServers, point->Converged,
+			point->Broken, point->Cached);
+	}
+
+	if (fclose(file) != 0)
+	{
+		printf("ERROR! Cannot write the output file %s\n", path);
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function runs every point of the grid. The points run in          =
+//=  parallel on NumberOfThreads threads. Points in the cache and points    =
+//=  with the same key as an earlier point are not computed again. All      =
+//=  points use the same random stream, so the curves are smooth.           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the sweep                               =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int runSweep(const SWEEP_CONFIG *config)
+{
+	SWEEP_POOL   pool;          // State shared by the worker threads
+	SWEEP_POINT *point;         // Current point
+	pthread_t   *threads;       // Worker threads
+	double       startTime;     // Wall clock at the start of the sweep
+	int          cached;        // Number of points found in the cache
+	int          started = 0;   // Number of started threads
+	int          result;        // Result of the sweep
+	int          rest;          // Point index without the axes taken so far
+	int          p;             // Policy counter
+	int          m;             // Update mode counter
+	int          d;             // Dispatcher count counter
+	int          s;             // Server count counter
+	int          t;             // Stale period counter
+	int          u;             // Utilization counter
+	int          i;             // Point counter
+	int          j;             // Earlier point counter
+
+	pool.NumberOfPoints = config->NumberOfPolicies * config->NumberOfUpdates * config->NumberOfDispatcherCounts *
+		config->NumberOfServerCounts * config->NumberOfStalePeriods * config->NumberOfUtilizations;
+	pool.Points = (SWEEP_POINT *) calloc(pool.NumberOfPoints, sizeof(SWEEP_POINT));
+	threads = (pthread_t *) calloc(config->NumberOfThreads, sizeof(pthread_t));
+	if ((pool.Points == NULL) || (threads == NULL))
+	{
+		printf("Not enough memory for %d points\n", pool.NumberOfPoints);
+		free(pool.Points);
+		free(threads);
+		return(-1);
+	}
+
+	// The point index is split into the axes from the innermost one. Utilization is
+	// the innermost axis, so each curve of the delay against the load is contiguous
+	for (i = 0; i < pool.NumberOfPoints; i++)
+	{
+		rest = i;
+		u = rest % config->NumberOfUtilizations;
+		rest /= config->NumberOfUtilizations;
+		t = rest % config->NumberOfStalePeriods;
+		rest /= config->NumberOfStalePeriods;
+		s = rest % config->NumberOfServerCounts;
+		rest /= config->NumberOfServerCounts;
+		d = rest % config->NumberOfDispatcherCounts;
+		rest /= config->NumberOfDispatcherCounts;
+		m = rest % config->NumberOfUpdates;
+		p = rest / config->NumberOfUpdates;
+
+		point = &pool.Points[i];
+		point->Config = config->Simulation;
+		point->Config.LoadBalancer = config->Policies[p];
+		point->Config.Update = config->Updates[m];
+		point->Config.DispatcherCount = config->DispatcherCounts[d];
+		point->Config.NumberOfServers = config->ServerCounts[s];
+		point->Config.StalePeriod = config->StalePeriods[t];
+		point->Config.Lambda = config->Utilizations[u] * config->ServerCounts[s] * config->Simulation.Mu;
+		point->Config.Stream = 0;
+		point->Utilization = config->Utilizations[u];
+		point->MeanField = config->MeanField;
+		pointKey(&point->Config, point->MeanField, point->Key);
+		point->Source = i;
+		for (j = 0; j < i; j++)
+		{
+			if (strcmp(pool.Points[j].Key, point->Key) == 0)
+			{
+				point->Source = j;
+				break;
+			}
+		}
+	}
+
+	cached = loadCache(config->CachePath, pool.Points, pool.NumberOfPoints);
+	pool.ToCompute = 0;
+	for (i = 0; i < pool.NumberOfPoints; i++)
+	{
+		if ((pool.Points[i].Source == i) && !pool.Points[i].Cached)
+		{
+			pool.ToCompute++;
+		}
+	}
+	printf("Points: %d, cached: %d, to compute: %d, threads: %d\n", pool.NumberOfPoints, cached, pool.ToCompute,
+		config->NumberOfThreads);
+
+	pool.Cache = fopen(config->CachePath, "a");
+	if (pool.Cache == NULL)
+	{
+		printf("WARNING! Cannot write the cache file %s. Results will not be cached\n", config->CachePath);
+	}
+	pool.NextPoint = 0;
+	pool.Finished = 0;
+	pthread_mutex_init(&pool.Mutex, NULL);
+	startTime = wallClock();
+
+	for (i = 0; i < config->NumberOfThreads; i++)
+	{
+		if (pthread_create(&threads[i], NULL, sweepWorker, &pool) == 0)
+		{
+			started++;
+		}
+	}
+	// If no thread could be started run the points in this thread
+	if (started == 0)
+	{
+		sweepWorker(&pool);
+	}
+	for (i = 0; i < started; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	pthread_mutex_destroy(&pool.Mutex);
+	if (pool.Cache != NULL)
+	{
+		fclose(pool.Cache);
+	}
+
+	// Duplicates take the result of their source point
+	for (i = 0; i < pool.NumberOfPoints; i++)
+	{
+		point = &pool.Points[i];
+		if (point->Source != i)
+		{
+			j = point->Source;
+			point->Mean = pool.Points[j].Mean;
+			point->HalfWidth = pool.Points[j].HalfWidth;
+			memcpy(point->Percentiles, pool.Points[j].Percentiles, sizeof(point->Percentiles));
+			point->Customers = pool.Points[j].Customers;
+			point->Drops = pool.Points[j].Drops;
+			point->Goodput = pool.Points[j].Goodput;
+			point->Messages = pool.Points[j].Messages;
+			point->MessageRate = pool.Points[j].MessageRate;
+			point->CollisionRate = pool.Points[j].CollisionRate;
+			point->Spread = pool.Points[j].Spread;
+			point->EventCounter = pool.Points[j].EventCounter;
+			point->EventsPerSecond = pool.Points[j].EventsPerSecond;
+			point->ServerTime = pool.Points[j].ServerTime;
+			point->MeanServers = pool.Points[j].MeanServers;
+			point->Converged = pool.Points[j].Converged;
+			point->Broken = pool.Points[j].Broken;
+			point->Cached = pool.Points[j].Cached;
+		}
+	}
+
+	result = writeResults(config->OutputPath, pool.Points, pool.NumberOfPoints);
+	if (result == 0)
+	{
+		printf("Results of %d points are written to %s in %.3f s\n", pool.NumberOfPoints, config->OutputPath,
+			wallClock() - startTime);
+	}
+
+	free(pool.Points);
+	free(threads);
+
+	return(result);
+}
@@ -0,0 +1,37 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+//----- Includes --------------------------------------------------------------
+#include "StandaloneModel.h"  // Simulation model
+
+//----- Constants -------------------------------------------------------------
+#define MAX_GRID_VALUES 256  // Maximum number of values of one grid axis
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the parameter sweep
+{
+	SIMULATION_CONFIG  Simulation;                         // Parameters shared by all grid points
+	int                NumberOfThreads;                    // Number of worker threads
+	const char        *GridPath;                           // File with the grid
+	const char        *OutputPath;                         // Output file. JSON lines if it ends with .json, CSV otherwise
+	const char        *CachePath;                          // File with the results of the points computed before
+	double             Utilizations[MAX_GRID_VALUES];      // Server utilizations. lambda = utilization * servers * mu
+	int                NumberOfUtilizations;               // Number of utilizations
+	int                ServerCounts[MAX_GRID_VALUES];      // Numbers of servers
+	int                NumberOfServerCounts;               // Number of numbers of servers
+	double             StalePeriods[MAX_GRID_VALUES];      // Periods of the queue length updates
+	int                NumberOfStalePeriods;               // Number of stale periods
+	enum BALANCER_TYPE Policies[NUMBER_OF_POLICIES];       // Load balancers
+	int                NumberOfPolicies;                   // Number of load balancers
+	enum UPDATE_TYPE   Updates[NUMBER_OF_UPDATES];         // Dissemination modes of the queue lengths
+	int                NumberOfUpdates;                    // Number of dissemination modes
+	int                DispatcherCounts[MAX_GRID_VALUES];  // Numbers of dispatchers
+	int                NumberOfDispatcherCounts;           // Number of numbers of dispatchers
+	int                MeanField;                          // Whether the points are solved by the mean field instead
+} SWEEP_CONFIG;
+
+//----- Prototypes ------------------------------------------------------------
+int readSweepGrid(SWEEP_CONFIG *config);
+int runSweep(const SWEEP_CONFIG *config);
+
+#endif
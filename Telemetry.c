@@ -0,0 +1,364 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>      // Needed for I/O functions
+#include <stdlib.h>     // Needed for malloc() and free()
+#include <string.h>     // Needed for memcmp() and memcpy()
+#include "Telemetry.h"  // Telemetry types and prototypes
+
+//===========================================================================
+//=  This function allocates the columns of a number of samples.            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: columns         - place to store the columns                   =
+//=          samples         - number of samples                            =
+//=          numberOfServers - number of values of a sample in each column  =
+//=  Returns: 0 on success, -1 if there is not enough memory                =
+//===========================================================================
+int telemetryAllocateColumns(TELEMETRY_SAMPLE *columns, int samples, int numberOfServers)
+{
+	size_t values = (size_t) samples * (size_t) numberOfServers;  // Values of each column
+
+	columns->Time = (double *) malloc(samples * sizeof(double));
+	columns->Delay = (double *) malloc(values * sizeof(double));
+	columns->QueueLength = (int32_t *) malloc(values * sizeof(int32_t));
+	columns->Dispatches = (uint32_t *) malloc(values * sizeof(uint32_t));
+	columns->Staleness = (int32_t *) malloc(values * sizeof(int32_t));
+	columns->Busy = (uint8_t *) malloc(values * sizeof(uint8_t));
+	if ((columns->Time == NULL) || (columns->Delay == NULL) || (columns->QueueLength == NULL) ||
+		(columns->Dispatches == NULL) || (columns->Staleness == NULL) || (columns->Busy == NULL))
+	{
+		telemetryFreeColumns(columns);
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function frees the columns of telemetryAllocateColumns().         =
+//===========================================================================
+void telemetryFreeColumns(TELEMETRY_SAMPLE *columns)
+{
+	free(columns->Time);
+	free(columns->Delay);
+	free(columns->QueueLength);
+	free(columns->Dispatches);
+	free(columns->Staleness);
+	free(columns->Busy);
+	columns->Time = NULL;
+	columns->Delay = NULL;
+	columns->QueueLength = NULL;
+	columns->Dispatches = NULL;
+	columns->Staleness = NULL;
+	columns->Busy = NULL;
+}
+
+//===========================================================================
+//=  This function writes samples of the ring buffer as one chunk. The      =
+//=  samples of a chunk are never split by the end of the ring buffer, so   =
+//=  every column of the chunk is written from memory in one piece.         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - writer of the file                                    =
+//=          first  - slot of the first sample of the chunk                 =
+//=          count  - number of samples of the chunk                        =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+static int writeChunk(TELEMETRY_WRITER *writer, int first, int count)
+{
+	const TELEMETRY_SAMPLE *ring = &writer->Ring;                               // Columns of the ring buffer
+	size_t                  servers = (size_t) writer->Header.NumberOfServers;  // Values of a sample
+	size_t                  offset = (size_t) first * servers;                  // First value of the chunk
+	size_t                  values = (size_t) count * servers;                  // Values of each column
+	uint32_t                prefix[2] = { (uint32_t) count, 0 };                // Beginning of the chunk
+
+	if ((fwrite(prefix, sizeof(prefix), 1, writer->File) != 1) ||
+		(fwrite(ring->Time + first, sizeof(double), (size_t) count, writer->File) != (size_t) count) ||
+		(fwrite(ring->Delay + offset, sizeof(double), values, writer->File) != values) ||
+		(fwrite(ring->QueueLength + offset, sizeof(int32_t), values, writer->File) != values) ||
+		(fwrite(ring->Dispatches + offset, sizeof(uint32_t), values, writer->File) != values) ||
+		(fwrite(ring->Staleness + offset, sizeof(int32_t), values, writer->File) != values) ||
+		(fwrite(ring->Busy + offset, sizeof(uint8_t), values, writer->File) != values))
+	{
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  Writer thread. It waits until a chunk of the ring buffer is complete,  =
+//=  writes it out of the lock and frees its slots. When the file is        =
+//=  closed, it writes the last, partial chunk and stops. After an error    =
+//=  the chunks are only freed, so the simulation never waits for ever.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argument - telemetry writer                                    =
+//=  Returns: NULL                                                          =
+//===========================================================================
+static void *telemetryWorker(void *argument)
+{
+	TELEMETRY_WRITER *writer = (TELEMETRY_WRITER *) argument;  // Shared state
+	int               first;                                   // Slot of the first sample of the chunk
+	int               count;                                   // Number of samples of the chunk
+	int               failed;                                  // Whether the chunk could not be written
+
+	while (1)
+	{
+		pthread_mutex_lock(&writer->Mutex);
+		while ((writer->Recorded - writer->Written < TELEMETRY_CHUNK) && !writer->Closing)
+		{
+			pthread_cond_wait(&writer->ChunkReady, &writer->Mutex);
+		}
+		count = (int) ((writer->Recorded - writer->Written < TELEMETRY_CHUNK) ?
+			writer->Recorded - writer->Written : TELEMETRY_CHUNK);
+		first = (int) (writer->Written % TELEMETRY_SLOTS);
+		failed = writer->Error;
+		pthread_mutex_unlock(&writer->Mutex);
+		if (count == 0)
+		{
+			break;
+		}
+
+		if (!failed)
+		{
+			failed = (writeChunk(writer, first, count) != 0);
+		}
+
+		pthread_mutex_lock(&writer->Mutex);
+		writer->Written += count;
+		writer->Error = failed;
+		pthread_cond_signal(&writer->ChunkWritten);
+		pthread_mutex_unlock(&writer->Mutex);
+	}
+
+	return(NULL);
+}
+
+//===========================================================================
+//=  This function creates the telemetry file, allocates the ring buffer    =
+//=  and starts the writer thread.                                          =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer          - place to store the writer                    =
+//=          path            - telemetry file                               =
+//=          numberOfServers - number of servers of every sample            =
+//=          interval        - simulated time between two samples           =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int telemetryWriterOpen(TELEMETRY_WRITER *writer, const char *path, int numberOfServers, double interval)
+{
+	memcpy(writer->Header.Magic, TELEMETRY_MAGIC, sizeof(writer->Header.Magic));
+	writer->Header.ByteOrder = TELEMETRY_BYTE_ORDER;
+	writer->Header.NumberOfServers = (uint32_t) numberOfServers;
+	writer->Header.Interval = interval;
+	writer->Header.NumberOfSamples = 0;
+	writer->Filled = 0;
+	writer->Recorded = 0;
+	writer->Written = 0;
+	writer->Stalls = 0;
+	writer->Closing = 0;
+	writer->Error = 0;
+
+	if (telemetryAllocateColumns(&writer->Ring, TELEMETRY_SLOTS, numberOfServers) != 0)
+	{
+		printf("ERROR! Not enough memory for the telemetry of %d servers\n", numberOfServers);
+		return(-1);
+	}
+	writer->File = fopen(path, "wb");
+	if (writer->File == NULL)
+	{
+		printf("ERROR! Cannot create the telemetry file %s\n", path);
+		telemetryFreeColumns(&writer->Ring);
+		return(-1);
+	}
+	if (fwrite(&writer->Header, sizeof(writer->Header), 1, writer->File) != 1)
+	{
+		printf("ERROR! Cannot write the telemetry file %s\n", path);
+		fclose(writer->File);
+		telemetryFreeColumns(&writer->Ring);
+		return(-1);
+	}
+
+	pthread_mutex_init(&writer->Mutex, NULL);
+	pthread_cond_init(&writer->ChunkReady, NULL);
+	pthread_cond_init(&writer->ChunkWritten, NULL);
+	if (pthread_create(&writer->Thread, NULL, telemetryWorker, writer) != 0)
+	{
+		printf("ERROR! Cannot start the telemetry writer\n");
+		pthread_mutex_destroy(&writer->Mutex);
+		pthread_cond_destroy(&writer->ChunkReady);
+		pthread_cond_destroy(&writer->ChunkWritten);
+		fclose(writer->File);
+		telemetryFreeColumns(&writer->Ring);
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function gives the slot of the next sample in the ring buffer.    =
+//=  The caller fills every column of the sample in place and then calls    =
+//=  telemetryCommitSample(). Only the first sample of a chunk takes the    =
+//=  lock, and it waits only if the writer is a whole ring buffer behind.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - opened writer                                         =
+//=          time   - simulated time of the sample                          =
+//=          sample - place to store the columns of the slot                =
+//=  Returns: None                                                          =
+//===========================================================================
+void telemetryNextSample(TELEMETRY_WRITER *writer, double time, TELEMETRY_SAMPLE *sample)
+{
+	size_t offset;  // First value of the slot
+	int    slot;    // Slot of the sample
+
+	if (writer->Filled % TELEMETRY_CHUNK == 0)
+	{
+		pthread_mutex_lock(&writer->Mutex);
+		while (writer->Filled - writer->Written > TELEMETRY_SLOTS - TELEMETRY_CHUNK)
+		{
+			writer->Stalls++;
+			pthread_cond_wait(&writer->ChunkWritten, &writer->Mutex);
+		}
+		pthread_mutex_unlock(&writer->Mutex);
+	}
+
+	slot = (int) (writer->Filled % TELEMETRY_SLOTS);
+	offset = (size_t) slot * writer->Header.NumberOfServers;
+	writer->Ring.Time[slot] = time;
+	sample->Time = writer->Ring.Time + slot;
+	sample->Delay = writer->Ring.Delay + offset;
+	sample->QueueLength = writer->Ring.QueueLength + offset;
+	sample->Dispatches = writer->Ring.Dispatches + offset;
+	sample->Staleness = writer->Ring.Staleness + offset;
+	sample->Busy = writer->Ring.Busy + offset;
+}
+
+//===========================================================================
+//=  This function completes the sample of telemetryNextSample(). The last  =
+//=  sample of a chunk hands the chunk to the writer thread.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - opened writer                                         =
+//=  Returns: None                                                          =
+//===========================================================================
+void telemetryCommitSample(TELEMETRY_WRITER *writer)
+{
+	writer->Filled++;
+	if (writer->Filled % TELEMETRY_CHUNK == 0)
+	{
+		pthread_mutex_lock(&writer->Mutex);
+		writer->Recorded = writer->Filled;
+		pthread_cond_signal(&writer->ChunkReady);
+		pthread_mutex_unlock(&writer->Mutex);
+	}
+}
+
+//===========================================================================
+//=  This function writes the remaining samples, stops the writer thread,   =
+//=  writes the final header and closes the telemetry file.                 =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - opened writer                                         =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int telemetryWriterClose(TELEMETRY_WRITER *writer)
+{
+	int result = 0;  // Result of the writing
+
+	pthread_mutex_lock(&writer->Mutex);
+	writer->Recorded = writer->Filled;
+	writer->Closing = 1;
+	pthread_cond_signal(&writer->ChunkReady);
+	pthread_mutex_unlock(&writer->Mutex);
+	pthread_join(writer->Thread, NULL);
+	pthread_mutex_destroy(&writer->Mutex);
+	pthread_cond_destroy(&writer->ChunkReady);
+	pthread_cond_destroy(&writer->ChunkWritten);
+
+	writer->Header.NumberOfSamples = (uint64_t) writer->Written;
+	if (writer->Error || (fseek(writer->File, 0, SEEK_SET) != 0) ||
+		(fwrite(&writer->Header, sizeof(writer->Header), 1, writer->File) != 1))
+	{
+		result = -1;
+	}
+	if (fclose(writer->File) != 0)
+	{
+		result = -1;
+	}
+	writer->File = NULL;
+	telemetryFreeColumns(&writer->Ring);
+
+	if (result != 0)
+	{
+		printf("ERROR! Cannot write the telemetry file\n");
+	}
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function reads and checks the header of a telemetry file. The     =
+//=  file must have been written on a machine with the same byte order.     =
+//=-------------------------------------------------------------------------=
+//=  Inputs: file   - telemetry file opened for reading                     =
+//=          header - place to store the header                             =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int telemetryReadHeader(FILE *file, TELEMETRY_HEADER *header)
+{
+	if ((fread(header, sizeof(TELEMETRY_HEADER), 1, file) != 1) ||
+		(memcmp(header->Magic, TELEMETRY_MAGIC, sizeof(header->Magic)) != 0))
+	{
+		printf("ERROR! This is not a telemetry file\n");
+		return(-1);
+	}
+	if (header->ByteOrder != TELEMETRY_BYTE_ORDER)
+	{
+		printf("ERROR! The telemetry file was written on a machine with another byte order\n");
+		return(-1);
+	}
+	if ((header->NumberOfServers == 0) || (header->Interval <= 0.0))
+	{
+		printf("ERROR! The telemetry file has no servers or no sampling interval\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads the next chunk of a telemetry file.                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: file   - telemetry file after its header or a previous chunk   =
+//=          header - header of the file                                    =
+//=          chunk  - columns for TELEMETRY_CHUNK samples, allocated by     =
+//=                   telemetryAllocateColumns()                            =
+//=  Returns: number of samples of the chunk, 0 at the end of the file,     =
+//=           -1 on error                                                   =
+//===========================================================================
+int telemetryReadChunk(FILE *file, const TELEMETRY_HEADER *header, TELEMETRY_SAMPLE *chunk)
+{
+	uint32_t prefix[2];  // Number of samples and 0
+	size_t   count;      // Number of samples of the chunk
+	size_t   values;     // Values of each column
+
+	if (fread(prefix, sizeof(prefix), 1, file) != 1)
+	{
+		return(0);
+	}
+	if ((prefix[0] == 0) || (prefix[0] > TELEMETRY_CHUNK) || (prefix[1] != 0))
+	{
+		printf("ERROR! Broken chunk in the telemetry file\n");
+		return(-1);
+	}
+
+	count = prefix[0];
+	values = count * header->NumberOfServers;
+	if ((fread(chunk->Time, sizeof(double), count, file) != count) ||
+		(fread(chunk->Delay, sizeof(double), values, file) != values) ||
+		(fread(chunk->QueueLength, sizeof(int32_t), values, file) != values) ||
+		(fread(chunk->Dispatches, sizeof(uint32_t), values, file) != values) ||
+		(fread(chunk->Staleness, sizeof(int32_t), values, file) != values) ||
+		(fread(chunk->Busy, sizeof(uint8_t), values, file) != values))
+	{
+		printf("ERROR! The telemetry file is truncated\n");
+		return(-1);
+	}
+
+	return((int) count);
+}
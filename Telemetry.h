@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>    // Needed for FILE
+#include <stdint.h>   // Needed for the fixed width integers of the file format
+#include <pthread.h>  // Needed for the writer thread
+
+//----- Constants -------------------------------------------------------------
+#define TELEMETRY_MAGIC      "LBTELEM1"  // First bytes of every telemetry file
+#define TELEMETRY_BYTE_ORDER 0x01020304  // Written in the byte order of the machine which has written the file
+#define TELEMETRY_CHUNK      8           // Samples written together as one columnar chunk
+#define TELEMETRY_SLOTS      32          // Samples in the ring buffer, a multiple of TELEMETRY_CHUNK
+#define TELEMETRY_INTERVAL   1.0         // Default simulated time between two samples
+
+//------New types--------------------------------------------------------------
+typedef struct  // Beginning of the telemetry file. The chunks follow it. 32 bytes
+{
+	char     Magic[8];         // TELEMETRY_MAGIC without the terminating zero
+	uint32_t ByteOrder;        // TELEMETRY_BYTE_ORDER
+	uint32_t NumberOfServers;  // Values of every column in one sample
+	double   Interval;         // Simulated time between two samples
+	uint64_t NumberOfSamples;  // Number of samples in the file
+} TELEMETRY_HEADER;
+
+// A chunk is a uint32_t number of samples S and a uint32_t 0, followed by
+// the columns of its S samples, each of them sample by sample and server by
+// server within a sample: double Time[S], double Delay[S][N],
+// int32_t QueueLength[S][N], uint32_t Dispatches[S][N], int32_t Staleness[S][N]
+// and uint8_t Busy[S][N]. The widest columns come first, so every column of
+// a mapped chunk is aligned. Only the last chunk may have fewer samples
+typedef struct  // Columns of one sample, or of a chunk of samples when it is read
+{
+	double   *Time;         // Simulated time of the sample
+	double   *Delay;        // Total response time of the customers served by each server so far
+	int32_t  *QueueLength;  // Customers at each server, waiting and in service
+	uint32_t *Dispatches;   // Customers sent to each server since the previous sample
+	int32_t  *Staleness;    // Queue length minus its length in the view of the first dispatcher
+	uint8_t  *Busy;         // Whether each server is serving a customer
+} TELEMETRY_SAMPLE;
+
+typedef struct  // Telemetry file being written. The samples go to a ring buffer which a thread writes out
+{
+	FILE            *File;             // Output file
+	TELEMETRY_HEADER Header;           // Header rewritten when the file is closed
+	TELEMETRY_SAMPLE Ring;             // Columns of all TELEMETRY_SLOTS samples of the ring buffer
+	long long        Filled;           // Number of samples filled by the simulation, only seen by it
+	pthread_t        Thread;           // Writer thread
+	pthread_mutex_t  Mutex;            // Protects all fields below
+	pthread_cond_t   ChunkReady;       // Signals the writer that a chunk is complete or the file is closed
+	pthread_cond_t   ChunkWritten;     // Signals the simulation that a chunk of the ring buffer is free
+	long long        Recorded;         // Number of samples given to the ring buffer
+	long long        Written;          // Number of samples written to the file
+	long long        Stalls;           // Times the simulation has waited for a free chunk
+	int              Closing;          // Whether the last, partial chunk must be written
+	int              Error;            // Whether writing has failed
+} TELEMETRY_WRITER;
+
+//----- Prototypes ------------------------------------------------------------
+int  telemetryAllocateColumns(TELEMETRY_SAMPLE *columns, int samples, int numberOfServers);
+void telemetryFreeColumns(TELEMETRY_SAMPLE *columns);
+int  telemetryWriterOpen(TELEMETRY_WRITER *writer, const char *path, int numberOfServers, double interval);
+void telemetryNextSample(TELEMETRY_WRITER *writer, double time, TELEMETRY_SAMPLE *sample);
+void telemetryCommitSample(TELEMETRY_WRITER *writer);
+int  telemetryWriterClose(TELEMETRY_WRITER *writer);
+int  telemetryReadHeader(FILE *file, TELEMETRY_HEADER *header);
+int  telemetryReadChunk(FILE *file, const TELEMETRY_HEADER *header, TELEMETRY_SAMPLE *chunk);
+
+#endif
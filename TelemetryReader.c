@@ -0,0 +1,284 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>      // Needed for I/O functions
+#include <stdlib.h>     // Needed for atoi(), calloc() and free()
+#include <string.h>     // Needed for strcmp()
+#include "Telemetry.h"  // Telemetry file format
+
+//------New types--------------------------------------------------------------
+enum READER_MODE  // What the reader prints
+{
+	systemRows,     // One row per sample with the statistics over all servers
+	serverRows,     // One row per sample with the values of one server
+	serverSummary   // One row per server with its statistics over all samples
+};
+
+typedef struct  // Parameters of the reader
+{
+	const char      *InputPath;  // Telemetry file
+	enum READER_MODE Mode;       // What the reader prints
+	int              ServerID;   // Server of the serverRows mode
+} READER_CONFIG;
+
+typedef struct  // Statistics of one server over all samples
+{
+	double    BusySum;         // Sum of the busy flags
+	double    QueueSum;        // Sum of the queue lengths
+	double    StalenessSum;    // Sum of the absolute errors of the view
+	long long Dispatches;      // Customers sent to the server
+	int       MaxQueueLength;  // Longest queue of the samples
+	double    Delay;           // Total response time at the last sample
+} SERVER_SUMMARY;
+
+//----- Prototypes ------------------------------------------------------------
+int parseArguments(int argc, char *argv[], READER_CONFIG *config);
+int readTelemetry(const READER_CONFIG *config);
+void printSystemRow(const TELEMETRY_SAMPLE *chunk, int sample, int numberOfServers);
+void printServerRow(const TELEMETRY_SAMPLE *chunk, int sample, int numberOfServers, int serverID);
+
+//===========================================================================
+//=  Main program of the telemetry reader. It reads the columnar telemetry  =
+//=  file which the standalone simulation writes with --telemetry and       =
+//=  prints it as CSV.                                                      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int main(int argc, char *argv[])
+{
+	READER_CONFIG config;  // Parameters of the reader
+
+	if (parseArguments(argc, argv, &config) != 0)
+	{
+		printf("Usage: TelemetryReader FILE [--server N | --summary 1]\n");
+		return(1);
+	}
+
+	return((readTelemetry(&config) == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function reads the command line. Options:                         =
+//=    --server N   one row per sample with the values of server N, from 0  =
+//=    --summary 1  one row per server with its statistics over the run     =
+//=  Without options the reader prints one row per sample with the          =
+//=  statistics over all servers.                                           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=          config     - place to store the parameters                     =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseArguments(int argc, char *argv[], READER_CONFIG *config)
+{
+	int i;  // Argument counter
+
+	if (argc < 2)
+	{
+		return(-1);
+	}
+	config->InputPath = argv[1];
+	config->Mode = systemRows;
+	config->ServerID = 0;
+
+	for (i = 2; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--server") == 0)
+		{
+			config->Mode = serverRows;
+			config->ServerID = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--summary") == 0)
+		{
+			config->Mode = (atoi(argv[i + 1]) != 0) ? serverSummary : config->Mode;
+		}
+		else
+		{
+			printf("ERROR! Unknown option %s\n", argv[i]);
+			return(-1);
+		}
+	}
+	if (i < argc)
+	{
+		printf("ERROR! Option %s needs a value\n", argv[i]);
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function prints one sample as the statistics over all servers:    =
+//=  mean and longest queue, fraction of busy servers, dispatches, mean     =
+//=  and largest absolute error of the view, and the total response time.   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: chunk           - columns of the chunk                         =
+//=          sample          - sample of the chunk                          =
+//=          numberOfServers - number of servers                            =
+//=  Returns: None                                                          =
+//===========================================================================
+void printSystemRow(const TELEMETRY_SAMPLE *chunk, int sample, int numberOfServers)
+{
+	size_t    offset = (size_t) sample * (size_t) numberOfServers;  // First value of the sample
+	long long queueSum = 0;                                          // Customers at all servers
+	long long stalenessSum = 0;                                      // Sum of the absolute errors of the view
+	long long dispatches = 0;                                        // Customers sent since the previous sample
+	double    delay = 0.0;                                           // Total response time of all servers
+	int       busy = 0;                                              // Number of busy servers
+	int       maxQueueLength = 0;                                    // Longest queue
+	int       maxStaleness = 0;                                      // Largest absolute error of the view
+	int       staleness;                                             // Absolute error of the current server
+	int       i;                                                     // Server counter
+
+	for (i = 0; i < numberOfServers; i++)
+	{
+		queueSum += chunk->QueueLength[offset + i];
+		maxQueueLength = (chunk->QueueLength[offset + i] > maxQueueLength) ? chunk->QueueLength[offset + i] :
+			maxQueueLength;
+		busy += chunk->Busy[offset + i];
+		dispatches += chunk->Dispatches[offset + i];
+		staleness = (chunk->Staleness[offset + i] < 0) ? -chunk->Staleness[offset + i] : chunk->Staleness[offset + i];
+		stalenessSum += staleness;
+		maxStaleness = (staleness > maxStaleness) ? staleness : maxStaleness;
+		delay += chunk->Delay[offset + i];
+	}
+
+	printf("%.6f,%.4f,%d,%.4f,%lld,%.4f,%d,%.6f\n", chunk->Time[sample], (double) queueSum / numberOfServers,
+		maxQueueLength, (double) busy / numberOfServers, dispatches, (double) stalenessSum / numberOfServers,
+		maxStaleness, delay);
+}
+
+//===========================================================================
+//=  This function prints the values of one server in one sample.           =
+//=-------------------------------------------------------------------------=
+//=  Inputs: chunk           - columns of the chunk                         =
+//=          sample          - sample of the chunk                          =
+//=          numberOfServers - number of servers                            =
+//=          serverID        - printed server                               =
+//=  Returns: None                                                          =
+//===========================================================================
+void printServerRow(const TELEMETRY_SAMPLE *chunk, int sample, int numberOfServers, int serverID)
+{
+	size_t value = (size_t) sample * (size_t) numberOfServers + (size_t) serverID;  // Value of the server
+
+	printf("%.6f,%d,%d,%u,%d,%.6f\n", chunk->Time[sample], (int) chunk->QueueLength[value],
+		(int) chunk->Busy[value], (unsigned int) chunk->Dispatches[value], (int) chunk->Staleness[value],
+		chunk->Delay[value]);
+}
+
+//===========================================================================
+//=  This function reads the telemetry file chunk by chunk and prints it.   =
+//=  Only one chunk is in memory at a time, so files of any length can be   =
+//=  read.                                                                  =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the reader                              =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int readTelemetry(const READER_CONFIG *config)
+{
+	FILE             *file;              // Telemetry file
+	TELEMETRY_HEADER  header;            // Header of the file
+	TELEMETRY_SAMPLE  chunk;             // Columns of the current chunk
+	SERVER_SUMMARY   *summaries = NULL;  // Statistics of each server in the summary mode
+	SERVER_SUMMARY   *summary;           // Statistics of the current server
+	size_t            value;             // Value of the current server and sample
+	long long         samples = 0;       // Number of read samples
+	int               numberOfServers;   // Number of servers
+	int               count;             // Samples of the current chunk
+	int               result = 0;        // Result of the reading
+	int               s;                 // Sample counter
+	int               i;                 // Server counter
+
+	file = fopen(config->InputPath, "rb");
+	if (file == NULL)
+	{
+		printf("ERROR! Cannot open the telemetry file %s\n", config->InputPath);
+		return(-1);
+	}
+	if (telemetryReadHeader(file, &header) != 0)
+	{
+		fclose(file);
+		return(-1);
+	}
+	numberOfServers = (int) header.NumberOfServers;
+	if ((config->Mode == serverRows) && ((config->ServerID < 0) || (config->ServerID >= numberOfServers)))
+	{
+		printf("ERROR! Server must be from 0 to %d\n", numberOfServers - 1);
+		fclose(file);
+		return(-1);
+	}
+	if (config->Mode == serverSummary)
+	{
+		summaries = (SERVER_SUMMARY *) calloc(numberOfServers, sizeof(SERVER_SUMMARY));
+	}
+	if ((telemetryAllocateColumns(&chunk, TELEMETRY_CHUNK, numberOfServers) != 0) ||
+		((config->Mode == serverSummary) && (summaries == NULL)))
+	{
+		printf("ERROR! Not enough memory for %d servers\n", numberOfServers);
+		free(summaries);
+		fclose(file);
+		return(-1);
+	}
+
+	printf("# %s: %llu samples of %d servers every %g time units\n", config->InputPath,
+		(unsigned long long) header.NumberOfSamples, numberOfServers, header.Interval);
+	if (config->Mode == systemRows)
+	{
+		printf("time,mean_queue,max_queue,utilization,dispatches,mean_staleness,max_staleness,delay\n");
+	}
+	else if (config->Mode == serverRows)
+	{
+		printf("time,queue,busy,dispatches,staleness,delay\n");
+	}
+
+	while ((count = telemetryReadChunk(file, &header, &chunk)) > 0)
+	{
+		for (s = 0; s < count; s++)
+		{
+			if (config->Mode == systemRows)
+			{
+				printSystemRow(&chunk, s, numberOfServers);
+			}
+			else if (config->Mode == serverRows)
+			{
+				printServerRow(&chunk, s, numberOfServers, config->ServerID);
+			}
+			else
+			{
+				for (i = 0; i < numberOfServers; i++)
+				{
+					summary = &summaries[i];
+					value = (size_t) s * (size_t) numberOfServers + (size_t) i;
+					summary->BusySum += chunk.Busy[value];
+					summary->QueueSum += chunk.QueueLength[value];
+					summary->StalenessSum += (chunk.Staleness[value] < 0) ? -chunk.Staleness[value] :
+						chunk.Staleness[value];
+					summary->Dispatches += chunk.Dispatches[value];
+					summary->MaxQueueLength = (chunk.QueueLength[value] > summary->MaxQueueLength) ?
+						chunk.QueueLength[value] : summary->MaxQueueLength;
+					summary->Delay = chunk.Delay[value];
+				}
+			}
+		}
+		samples += count;
+	}
+	if (count < 0)
+	{
+		result = -1;
+	}
+
+	if ((config->Mode == serverSummary) && (samples > 0))
+	{
+		printf("server,utilization,mean_queue,max_queue,dispatches,mean_staleness,delay\n");
+		for (i = 0; i < numberOfServers; i++)
+		{
+			summary = &summaries[i];
+			printf("%d,%.4f,%.4f,%d,%lld,%.4f,%.6f\n", i, summary->BusySum / samples, summary->QueueSum / samples,
+				summary->MaxQueueLength, summary->Dispatches, summary->StalenessSum / samples, summary->Delay);
+		}
+	}
+
+	telemetryFreeColumns(&chunk);
+	free(summaries);
+	fclose(file);
+
+	return(result);
+}
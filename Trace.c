@@ -0,0 +1,230 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>     // Needed for I/O functions and remove()
+#include <math.h>      // Needed for isfinite()
+#include <string.h>    // Needed for memcmp() and memcpy()
+#include <fcntl.h>     // Needed for open()
+#include <unistd.h>    // Needed for close()
+#include <sys/mman.h>  // Needed for mmap()
+#include <sys/stat.h>  // Needed for fstat()
+#include "Trace.h"     // Trace types and prototypes
+
+//===========================================================================
+//=  This function maps a trace file into memory and checks its header. The =
+//=  records are read straight from the mapping, so a trace of any length   =
+//=  needs no buffers. The file must have been written on a machine with    =
+//=  the same byte order.                                                   =
+//=-------------------------------------------------------------------------=
+//=  Inputs: trace - place to store the mapped trace                        =
+//=          path  - trace file written by traceWriterOpen() and the        =
+//=                  TraceConverter tool                                    =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int traceOpen(TRACE *trace, const char *path)
+{
+	struct stat         status;   // Size of the file
+	const TRACE_HEADER *header;   // Header of the file
+	int                 file;     // Descriptor of the file
+	void               *mapping;  // Mapped file
+
+	trace->Mapping = NULL;
+	file = open(path, O_RDONLY);
+	if (file < 0)
+	{
+		printf("ERROR! Cannot open the trace file %s\n", path);
+		return(-1);
+	}
+	if ((fstat(file, &status) != 0) || ((size_t) status.st_size < sizeof(TRACE_HEADER)))
+	{
+		printf("ERROR! %s is not a trace file\n", path);
+		close(file);
+		return(-1);
+	}
+
+	mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED)
+	{
+		printf("ERROR! Cannot map the trace file %s\n", path);
+		return(-1);
+	}
+	trace->Mapping = mapping;
+	trace->MappedSize = (size_t) status.st_size;
+
+	// The replay reads the records once from the start to the end
+	posix_madvise(mapping, trace->MappedSize, POSIX_MADV_SEQUENTIAL);
+
+	header = (const TRACE_HEADER *) mapping;
+	if (memcmp(header->Magic, TRACE_MAGIC, sizeof(header->Magic)) != 0)
+	{
+		printf("ERROR! %s is not a trace file\n", path);
+		traceClose(trace);
+		return(-1);
+	}
+	if ((header->ByteOrder != TRACE_BYTE_ORDER) || (header->RecordSize != sizeof(TRACE_RECORD)))
+	{
+		printf("ERROR! Trace file %s is written on a machine with another byte order or record format\n", path);
+		traceClose(trace);
+		return(-1);
+	}
+	if ((header->NumberOfRecords > (trace->MappedSize - sizeof(TRACE_HEADER)) / sizeof(TRACE_RECORD)) ||
+		(trace->MappedSize != sizeof(TRACE_HEADER) + header->NumberOfRecords * sizeof(TRACE_RECORD)))
+	{
+		printf("ERROR! Trace file %s is truncated\n", path);
+		traceClose(trace);
+		return(-1);
+	}
+
+	trace->Header = header;
+	trace->Records = (const TRACE_RECORD *) (header + 1);
+	trace->NumberOfRecords = (long long) header->NumberOfRecords;
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function unmaps the trace file.                                   =
+//===========================================================================
+void traceClose(TRACE *trace)
+{
+	if (trace->Mapping != NULL)
+	{
+		munmap(trace->Mapping, trace->MappedSize);
+	}
+	trace->Mapping = NULL;
+	trace->Header = NULL;
+	trace->Records = NULL;
+	trace->NumberOfRecords = 0;
+}
+
+//===========================================================================
+//=  This function creates a trace file. The header is written again with   =
+//=  the number of records when the file is closed.                         =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - place to store the state of the writer                =
+//=          path   - trace file                                            =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int traceWriterOpen(TRACE_WRITER *writer, const char *path)
+{
+	memset(&writer->Header, 0, sizeof(writer->Header));
+	memcpy(writer->Header.Magic, TRACE_MAGIC, sizeof(writer->Header.Magic));
+	writer->Header.ByteOrder = TRACE_BYTE_ORDER;
+	writer->Header.RecordSize = sizeof(TRACE_RECORD);
+	writer->Last = 0.0;
+
+	writer->File = fopen(path, "wb");
+	if (writer->File == NULL)
+	{
+		printf("ERROR! Cannot create the trace file %s\n", path);
+		return(-1);
+	}
+	if (fwrite(&writer->Header, sizeof(writer->Header), 1, writer->File) != 1)
+	{
+		printf("ERROR! Cannot write the trace file %s\n", path);
+		fclose(writer->File);
+		writer->File = NULL;
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function appends one customer to the trace file. It refuses the   =
+//=  same records as the replay: a timestamp or service demand which is     =
+//=  not a finite number, and a negative one.                               =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer        - opened writer                                  =
+//=          timestamp     - arrival time, not less than the previous one   =
+//=          serviceDemand - service time of the customer                   =
+//=          requestClass  - request class from 0 to TRACE_MAX_CLASS        =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int traceWriterAppend(TRACE_WRITER *writer, double timestamp, double serviceDemand, int requestClass)
+{
+	TRACE_RECORD record;  // New record
+
+	if (!isfinite(timestamp) || (timestamp < 0.0))
+	{
+		printf("ERROR! Timestamp %g is not a finite number of at least 0\n", timestamp);
+		return(-1);
+	}
+	if ((writer->Header.NumberOfRecords > 0) && (timestamp < writer->Last))
+	{
+		printf("ERROR! Timestamp %g is less than the previous timestamp %g\n", timestamp, writer->Last);
+		return(-1);
+	}
+	if (!isfinite((float) serviceDemand) || (serviceDemand < 0.0))
+	{
+		printf("ERROR! Service demand %g is not a finite number of at least 0\n", serviceDemand);
+		return(-1);
+	}
+	if ((requestClass < 0) || (requestClass > TRACE_MAX_CLASS))
+	{
+		printf("ERROR! Request class must be from 0 to %d\n", TRACE_MAX_CLASS);
+		return(-1);
+	}
+
+	record.Timestamp = timestamp;
+	record.ServiceDemand = (float) serviceDemand;
+	record.Class = (uint16_t) requestClass;
+	record.Reserved = 0;
+	if (fwrite(&record, sizeof(record), 1, writer->File) != 1)
+	{
+		printf("ERROR! Cannot write the trace file\n");
+		return(-1);
+	}
+
+	writer->Last = timestamp;
+	writer->Header.NumberOfRecords++;
+	if ((uint32_t) requestClass >= writer->Header.NumberOfClasses)
+	{
+		writer->Header.NumberOfClasses = (uint32_t) requestClass + 1;
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function writes the final header and closes the trace file.       =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - opened writer                                         =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int traceWriterClose(TRACE_WRITER *writer)
+{
+	int result = 0;  // Result of the writing
+
+	if ((fseek(writer->File, 0, SEEK_SET) != 0) ||
+		(fwrite(&writer->Header, sizeof(writer->Header), 1, writer->File) != 1))
+	{
+		result = -1;
+	}
+	if (fclose(writer->File) != 0)
+	{
+		result = -1;
+	}
+	writer->File = NULL;
+
+	if (result != 0)
+	{
+		printf("ERROR! Cannot write the trace file\n");
+	}
+
+	return(result);
+}
+
+//===========================================================================
+//=  This function closes a trace file which could not be written to the    =
+//=  end and deletes it, so no valid but truncated trace is left behind.    =
+//=-------------------------------------------------------------------------=
+//=  Inputs: writer - opened writer                                         =
+//=          path   - trace file of traceWriterOpen()                       =
+//=  Returns: None                                                          =
+//===========================================================================
+void traceWriterDiscard(TRACE_WRITER *writer, const char *path)
+{
+	fclose(writer->File);
+	writer->File = NULL;
+	remove(path);
+}
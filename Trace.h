@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>   // Needed for FILE and size_t
+#include <stdint.h>  // Needed for the fixed width integers of the file format
+
+//----- Constants -------------------------------------------------------------
+#define TRACE_MAGIC      "LBTRACE1"  // First bytes of every trace file
+#define TRACE_BYTE_ORDER 0x01020304  // Written in the byte order of the machine which has written the trace
+#define TRACE_BATCH      64          // Maximum number of customers of one timestamp dispatched at once
+#define TRACE_MAX_CLASS  65535       // Largest request class of the file format
+
+//------New types--------------------------------------------------------------
+typedef struct  // One customer of the trace. 16 bytes
+{
+	double   Timestamp;      // Arrival time of the customer. Timestamps never decrease
+	float    ServiceDemand;  // Service time of the customer
+	uint16_t Class;          // Request class of the customer
+	uint16_t Reserved;       // Always 0
+} TRACE_RECORD;
+
+typedef struct  // Beginning of the trace file. The records follow it. 32 bytes
+{
+	char     Magic[8];         // TRACE_MAGIC without the terminating zero
+	uint32_t ByteOrder;        // TRACE_BYTE_ORDER
+	uint32_t RecordSize;       // sizeof(TRACE_RECORD)
+	uint64_t NumberOfRecords;  // Number of records in the file
+	uint32_t NumberOfClasses;  // Largest class plus one
+	uint32_t Reserved;         // Always 0
+} TRACE_HEADER;
+
+typedef struct  // Trace file mapped into memory
+{
+	const TRACE_HEADER *Header;           // Header of the file
+	const TRACE_RECORD *Records;          // Records of the file
+	long long           NumberOfRecords;  // Number of records
+	size_t              MappedSize;       // Size of the mapping
+	void               *Mapping;          // Start of the mapping
+} TRACE;
+
+typedef struct  // Trace file being written
+{
+	FILE        *File;    // Output file
+	TRACE_HEADER Header;  // Header rewritten when the file is closed
+	double       Last;    // Timestamp of the last record
+} TRACE_WRITER;
+
+//----- Prototypes ------------------------------------------------------------
+int  traceOpen(TRACE *trace, const char *path);
+void traceClose(TRACE *trace);
+int  traceWriterOpen(TRACE_WRITER *writer, const char *path);
+int  traceWriterAppend(TRACE_WRITER *writer, double timestamp, double serviceDemand, int requestClass);
+int  traceWriterClose(TRACE_WRITER *writer);
+void traceWriterDiscard(TRACE_WRITER *writer, const char *path);
+
+#endif
@@ -0,0 +1,255 @@
+//----- Includes --------------------------------------------------------------
+#include <stdio.h>   // Needed for I/O functions
+#include <stdlib.h>  // Needed for atoi() and strtod()
+#include <string.h>  // Needed for strcmp() and strchr()
+#include "Trace.h"   // Trace file format
+
+//----- Constants -------------------------------------------------------------
+#define MAX_LINE_LENGTH 4096  // Longest line of the CSV file
+#define MAX_COLUMNS     256   // Largest number of columns of the CSV file
+
+//------New types--------------------------------------------------------------
+typedef struct  // Parameters of the conversion
+{
+	const char *InputPath;      // CSV file
+	const char *OutputPath;     // Trace file
+	int         TimeColumn;     // Column of the arrival time, from 1
+	int         ServiceColumn;  // Column of the service time, from 1
+	int         ClassColumn;    // Column of the request class, from 1. 0 if all customers are class 0
+	double      TimeScale;      // Arrival times are multiplied by it
+	double      ServiceScale;   // Service times are multiplied by it
+	int         SkipHeader;     // Whether the first line is a header
+} CONVERTER_CONFIG;
+
+//----- Prototypes ------------------------------------------------------------
+int parseArguments(int argc, char *argv[], CONVERTER_CONFIG *config);
+int readColumn(char **fields, int numberOfFields, int column, double *value);
+int convert(const CONVERTER_CONFIG *config);
+
+//===========================================================================
+//=  Main program of the trace converter. It reads a CSV log of arrival     =
+//=  times and service times and writes the binary trace which the          =
+//=  standalone simulation replays with --trace.                            =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=  Returns: 0 on success, 1 on error                                      =
+//===========================================================================
+int main(int argc, char *argv[])
+{
+	CONVERTER_CONFIG config;  // Parameters of the conversion
+
+	if (parseArguments(argc, argv, &config) != 0)
+	{
+		printf("Usage: TraceConverter INPUT.csv OUTPUT.trace [--time N] [--service N] [--class N]\n");
+		printf("       [--scale-time X] [--scale-service X] [--header 1]\n");
+		return(1);
+	}
+
+	return((convert(&config) == 0) ? 0 : 1);
+}
+
+//===========================================================================
+//=  This function reads the command line. Options:                         =
+//=    --time N          column of the arrival time (1 by default)          =
+//=    --service N       column of the service time (2 by default)          =
+//=    --class N         column of the request class (none by default)      =
+//=    --scale-time X    multiply the arrival times by X, e.g. 0.001 for ms =
+//=    --scale-service X multiply the service times by X                    =
+//=    --header 1        skip the first line                                =
+//=-------------------------------------------------------------------------=
+//=  Inputs: argc, argv - command line arguments                            =
+//=          config     - place to store the parameters                     =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int parseArguments(int argc, char *argv[], CONVERTER_CONFIG *config)
+{
+	int i;  // Argument counter
+
+	if (argc < 3)
+	{
+		return(-1);
+	}
+	config->InputPath = argv[1];
+	config->OutputPath = argv[2];
+	config->TimeColumn = 1;
+	config->ServiceColumn = 2;
+	config->ClassColumn = 0;
+	config->TimeScale = 1.0;
+	config->ServiceScale = 1.0;
+	config->SkipHeader = 0;
+
+	for (i = 3; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--time") == 0)
+		{
+			config->TimeColumn = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--service") == 0)
+		{
+			config->ServiceColumn = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--class") == 0)
+		{
+			config->ClassColumn = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--scale-time") == 0)
+		{
+			config->TimeScale = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--scale-service") == 0)
+		{
+			config->ServiceScale = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--header") == 0)
+		{
+			config->SkipHeader = atoi(argv[i + 1]);
+		}
+		else
+		{
+			printf("ERROR! Unknown option %s\n", argv[i]);
+			return(-1);
+		}
+	}
+
+	if (i < argc)
+	{
+		printf("ERROR! Option %s needs a value\n", argv[i]);
+		return(-1);
+	}
+	if ((config->TimeColumn < 1) || (config->TimeColumn > MAX_COLUMNS) || (config->ServiceColumn < 1) ||
+		(config->ServiceColumn > MAX_COLUMNS) || (config->ClassColumn < 0) || (config->ClassColumn > MAX_COLUMNS))
+	{
+		printf("ERROR! Columns must be from 1 to %d\n", MAX_COLUMNS);
+		return(-1);
+	}
+	if ((config->TimeScale <= 0.0) || (config->ServiceScale <= 0.0))
+	{
+		printf("ERROR! Scales must be positive\n");
+		return(-1);
+	}
+
+	return(0);
+}
+
+//===========================================================================
+//=  This function reads a number from a column of the current line.        =
+//=-------------------------------------------------------------------------=
+//=  Inputs: fields         - fields of the line                            =
+//=          numberOfFields - number of fields                              =
+//=          column         - column from 1                                 =
+//=          value          - place to store the number                     =
+//=  Returns: 0 on success, -1 if the field is missing or not a number      =
+//===========================================================================
+int readColumn(char **fields, int numberOfFields, int column, double *value)
+{
+	char *end;  // End of the parsed number
+
+	if (column > numberOfFields)
+	{
+		return(-1);
+	}
+	*value = strtod(fields[column - 1], &end);
+	while ((*end == ' ') || (*end == '\t') || (*end == '\r') || (*end == '\n'))
+	{
+		end++;
+	}
+
+	return(((end == fields[column - 1]) || (*end != '\0')) ? -1 : 0);
+}
+
+//===========================================================================
+//=  This function converts the CSV file into the trace file. Empty lines   =
+//=  and lines starting with # are skipped. Arrival times must not          =
+//=  decrease. On an error, or without any customer, the trace file is      =
+//=  deleted, so a replay never takes a part of the log for the whole.      =
+//=-------------------------------------------------------------------------=
+//=  Inputs: config - parameters of the conversion                          =
+//=  Returns: 0 on success, -1 on error                                     =
+//===========================================================================
+int convert(const CONVERTER_CONFIG *config)
+{
+	FILE        *input;                  // CSV file
+	TRACE_WRITER writer;                 // Trace file
+	char         line[MAX_LINE_LENGTH];  // Current line
+	char        *fields[MAX_COLUMNS];    // Fields of the current line
+	char        *separator;              // Next comma of the line
+	int          numberOfFields;         // Number of fields of the current line
+	int          lineNumber = 0;         // Number of the current line
+	double       timestamp;              // Arrival time of the customer
+	double       serviceDemand;          // Service time of the customer
+	double       requestClass = 0.0;     // Request class of the customer
+	int          result = 0;             // Result of the conversion
+
+	input = fopen(config->InputPath, "r");
+	if (input == NULL)
+	{
+		printf("ERROR! Cannot open %s\n", config->InputPath);
+		return(-1);
+	}
+	if (traceWriterOpen(&writer, config->OutputPath) != 0)
+	{
+		fclose(input);
+		return(-1);
+	}
+
+	while (fgets(line, sizeof(line), input) != NULL)
+	{
+		lineNumber++;
+		if (((lineNumber == 1) && config->SkipHeader) || (line[0] == '#') || (line[0] == '\n') ||
+			(line[0] == '\r'))
+		{
+			continue;
+		}
+
+		// Split the line at the commas
+		numberOfFields = 0;
+		fields[numberOfFields++] = line;
+		while ((numberOfFields < MAX_COLUMNS) && ((separator = strchr(fields[numberOfFields - 1], ',')) != NULL))
+		{
+			*separator = '\0';
+			fields[numberOfFields++] = separator + 1;
+		}
+
+		if ((readColumn(fields, numberOfFields, config->TimeColumn, &timestamp) != 0) ||
+			(readColumn(fields, numberOfFields, config->ServiceColumn, &serviceDemand) != 0) ||
+			((config->ClassColumn > 0) &&
+				(readColumn(fields, numberOfFields, config->ClassColumn, &requestClass) != 0)))
+		{
+			printf("ERROR! Line %d: missing or wrong number\n", lineNumber);
+			result = -1;
+			break;
+		}
+		if (traceWriterAppend(&writer, timestamp * config->TimeScale, serviceDemand * config->ServiceScale,
+			(int) requestClass) != 0)
+		{
+			printf("ERROR! Line %d is wrong\n", lineNumber);
+			result = -1;
+			break;
+		}
+	}
+
+	fclose(input);
+	if ((result == 0) && (writer.Header.NumberOfRecords == 0))
+	{
+		printf("ERROR! %s has no customers\n", config->InputPath);
+		result = -1;
+	}
+	if (result != 0)
+	{
+		traceWriterDiscard(&writer, config->OutputPath);
+		return(-1);
+	}
+	if (traceWriterClose(&writer) != 0)
+	{
+		remove(config->OutputPath);
+		result = -1;
+	}
+	if (result == 0)
+	{
+		printf("%llu customers of %u request classes are written to %s\n",
+			(unsigned long long) writer.Header.NumberOfRecords, (unsigned int) writer.Header.NumberOfClasses,
+			config->OutputPath);
+	}
+
+	return(result);
+}